@@ -19,6 +19,7 @@
 #define EdDSA_SECONDS   PKEY_SECONDS
 #define SM2_SECONDS     PKEY_SECONDS
 #define FFDH_SECONDS    PKEY_SECONDS
+#define KDF_SECONDS     PKEY_SECONDS
 
 /* We need to use some deprecated APIs */
 #define OPENSSL_SUPPRESS_DEPRECATED
@@ -33,6 +34,7 @@
 #include <openssl/rand.h>
 #include <openssl/err.h>
 #include <openssl/evp.h>
+#include <openssl/kdf.h>
 #include <openssl/objects.h>
 #include <openssl/core_names.h>
 #include <openssl/async.h>
@@ -57,6 +59,7 @@
 # include <openssl/dh.h>
 #endif
 #include <openssl/x509.h>
+#include <openssl/pem.h>
 #include <openssl/dsa.h>
 #include "./testdsa.h"
 #include <openssl/modes.h>
@@ -93,6 +96,7 @@ typedef struct openssl_speed_sec_st {
     int eddsa;
     int sm2;
     int ffdh;
+    int kdf;
 } openssl_speed_sec_t;
 
 static volatile int run = 0;
@@ -104,6 +108,10 @@ static double Time_F(int s);
 static void print_message(const char *s, long num, int length, int tm);
 static void pkey_print_message(const char *str, const char *str2,
                                long num, unsigned int bits, int sec);
+#ifndef OPENSSL_NO_ARGON2
+static void kdf_print_message(const char *str, long num, unsigned int kib,
+                              int tm);
+#endif
 static void print_result(int alg, int run_no, int count, double time_used);
 #ifndef NO_FORK
 static int do_multi(int multi, int size_num);
@@ -210,7 +218,8 @@ typedef enum OPTION_choice {
     OPT_COMMON,
     OPT_ELAPSED, OPT_EVP, OPT_HMAC, OPT_DECRYPT, OPT_ENGINE, OPT_MULTI,
     OPT_MR, OPT_MB, OPT_MISALIGN, OPT_ASYNCJOBS, OPT_R_ENUM, OPT_PROV_ENUM,
-    OPT_PRIMES, OPT_SECONDS, OPT_BYTES, OPT_AEAD, OPT_CMAC
+    OPT_PRIMES, OPT_SECONDS, OPT_BYTES, OPT_AEAD, OPT_CMAC, OPT_DECODE,
+    OPT_ERRORS
 } OPTION_CHOICE;
 
 const OPTIONS speed_options[] = {
@@ -219,7 +228,7 @@ const OPTIONS speed_options[] = {
     OPT_SECTION("General"),
     {"help", OPT_HELP, '-', "Display this summary"},
     {"mb", OPT_MB, '-',
-     "Enable (tls1>=1) multi-block mode on EVP-named cipher"},
+     "Enable (tls1>=1) multi-block mode on EVP-named cipher or batched EVP-named digest"},
     {"mr", OPT_MR, '-', "Produce machine readable output"},
 #ifndef NO_FORK
     {"multi", OPT_MULTI, 'p', "Run benchmarks in parallel"},
@@ -241,6 +250,8 @@ const OPTIONS speed_options[] = {
      "Time decryption instead of encryption (only EVP)"},
     {"aead", OPT_AEAD, '-',
      "Benchmark EVP-named AEAD cipher in TLS-like sequence"},
+    {"decode", OPT_DECODE, '-', "Time decoding of PEM PKCS#8 private keys"},
+    {"errors", OPT_ERRORS, '-', "Time recording and discarding errors"},
 
     OPT_SECTION("Timing"),
     {"elapsed", OPT_ELAPSED, '-',
@@ -363,6 +374,17 @@ static const OPT_PAIR ffdh_choices[FFDH_NUM] = {
 static double ffdh_results[FFDH_NUM][1];  /* 1 op: derivation */
 #endif /* OPENSSL_NO_DH */
 
+#ifndef OPENSSL_NO_ARGON2
+enum { R_ARGON2D, R_ARGON2I, R_ARGON2ID, ARGON2_NUM };
+static const OPT_PAIR argon2_choices[ARGON2_NUM] = {
+    {"argon2d", R_ARGON2D},
+    {"argon2i", R_ARGON2I},
+    {"argon2id", R_ARGON2ID}
+};
+
+static double argon2_results[ARGON2_NUM][1];  /* 1 op: derivation */
+#endif /* OPENSSL_NO_ARGON2 */
+
 enum ec_curves_t {
     R_EC_P160, R_EC_P192, R_EC_P224, R_EC_P256, R_EC_P384, R_EC_P521,
 #ifndef OPENSSL_NO_EC2M
@@ -484,10 +506,119 @@ typedef struct loopargs_st {
     EVP_PKEY_CTX *ffdh_ctx[FFDH_NUM];
     unsigned char *secret_ff_a;
     unsigned char *secret_ff_b;
+#endif
+#ifndef OPENSSL_NO_ARGON2
+    EVP_KDF_CTX *argon2_ctx[ARGON2_NUM];
 #endif
     EVP_CIPHER_CTX *ctx;
     EVP_MAC_CTX *mctx;
 } loopargs_t;
+/*
+ * Measure what it costs to record errors that are discarded again, which is
+ * what probing code does on every miss.  The last two cases do the same
+ * failed digest lookup, first with its errors recorded and popped and then
+ * through EVP_PKEY_digestsign_supports_digest(), which does not record them.
+ */
+#define ERRORS_SPEED_MD "NO-SUCH-DIGEST"
+
+static int errors_speed_raise(EVP_PKEY *pkey)
+{
+    ERR_raise(ERR_LIB_EVP, ERR_R_PASSED_INVALID_ARGUMENT);
+    return 1;
+}
+
+static int errors_speed_raise_data(EVP_PKEY *pkey)
+{
+    ERR_raise_data(ERR_LIB_EVP, ERR_R_PASSED_INVALID_ARGUMENT,
+                   "name=%s", ERRORS_SPEED_MD);
+    return 1;
+}
+
+static int errors_speed_md_fetch(EVP_PKEY *pkey)
+{
+    EVP_MD *md = EVP_MD_fetch(app_get0_libctx(), ERRORS_SPEED_MD,
+                              app_get0_propq());
+
+    EVP_MD_free(md);
+    return md == NULL;
+}
+
+static int errors_speed_sign_init(EVP_PKEY *pkey)
+{
+    EVP_MD_CTX *ctx = EVP_MD_CTX_new();
+    int ret;
+
+    ret = ctx != NULL
+        && EVP_DigestSignInit_ex(ctx, NULL, ERRORS_SPEED_MD,
+                                 app_get0_libctx(), app_get0_propq(),
+                                 pkey, NULL) <= 0;
+    EVP_MD_CTX_free(ctx);
+    return ret;
+}
+
+static int errors_speed_supports_digest(EVP_PKEY *pkey)
+{
+    return EVP_PKEY_digestsign_supports_digest(pkey, app_get0_libctx(),
+                                               ERRORS_SPEED_MD,
+                                               app_get0_propq()) <= 0;
+}
+
+static void errors_speed(int tm)
+{
+    static const struct {
+        const char *name;
+        int (*f)(EVP_PKEY *pkey);
+    } cases[] = {
+        { "ERR_raise", errors_speed_raise },
+        { "ERR_raise_data", errors_speed_raise_data },
+        { "failed EVP_MD_fetch", errors_speed_md_fetch },
+        { "failed EVP_DigestSignInit_ex", errors_speed_sign_init },
+        { "failed EVP_PKEY_digestsign_supports_digest",
+          errors_speed_supports_digest }
+    };
+    EVP_PKEY *pkey;
+    long count;
+    size_t k;
+    double d;
+
+    pkey = EVP_PKEY_Q_keygen(app_get0_libctx(), app_get0_propq(),
+                             "EC", "P-256");
+    if (pkey == NULL) {
+        BIO_printf(bio_err, "Failed to create an EC P-256 key\n");
+        ERR_print_errors(bio_err);
+        return;
+    }
+
+    for (k = 0; k < OSSL_NELEM(cases); k++) {
+        BIO_printf(bio_err, "Doing %s + ERR_pop_to_mark for %ds: ",
+                   cases[k].name, tm);
+        (void)BIO_flush(bio_err);
+        ERR_set_mark();
+        run = 1;
+        alarm(tm);
+        Time_F(START);
+        for (count = 0; run; count++) {
+            if (!cases[k].f(pkey)) {
+                ERR_clear_last_mark();
+                BIO_printf(bio_err, "Unexpected result\n");
+                ERR_print_errors(bio_err);
+                count = 0;
+                break;
+            }
+            ERR_pop_to_mark();
+            ERR_set_mark();
+        }
+        d = Time_F(STOP);
+        ERR_pop_to_mark();
+        if (count == 0)
+            continue;
+        BIO_printf(bio_err, "%ld %s in %.2fs\n", count, cases[k].name, d);
+        printf("%s + ERR_pop_to_mark: %.1f ns\n", cases[k].name,
+               d * 1e9 / count);
+    }
+    EVP_PKEY_free(pkey);
+}
+
 static int run_benchmark(int async_jobs, int (*loop_function) (void *),
                          loopargs_t * loopargs);
 
@@ -561,6 +692,35 @@ static int EVP_Digest_md_loop(void *args)
     return EVP_Digest_loop(evp_md_name, D_EVP, args);
 }
 
+#define MB_DIGEST_NUM 8
+
+/* Hashes MB_DIGEST_NUM messages of the current length per call */
+static int EVP_Digest_many_loop(void *args)
+{
+    loopargs_t *tempargs = *(loopargs_t **) args;
+    const unsigned char *data[MB_DIGEST_NUM];
+    size_t lens[MB_DIGEST_NUM];
+    unsigned char digests[MB_DIGEST_NUM * EVP_MAX_MD_SIZE];
+    int count, i;
+    EVP_MD *md = NULL;
+
+    if (!opt_md_silent(evp_md_name, &md))
+        return -1;
+    for (i = 0; i < MB_DIGEST_NUM; i++) {
+        data[i] = tempargs->buf;
+        lens[i] = (size_t)lengths[testnum];
+    }
+    for (count = 0; COND(c[D_EVP][testnum]); count += MB_DIGEST_NUM) {
+        if (!EVP_Digest_many(data, lens, MB_DIGEST_NUM, digests,
+                             sizeof(digests), md)) {
+            count = -1;
+            break;
+        }
+    }
+    EVP_MD_free(md);
+    return count;
+}
+
 static int EVP_Digest_MD2_loop(void *args)
 {
     return EVP_Digest_loop("md2", D_MD2, args);
@@ -881,6 +1041,28 @@ static int FFDH_derive_key_loop(void *args)
 }
 #endif /* OPENSSL_NO_DH */
 
+#ifndef OPENSSL_NO_ARGON2
+static long argon2_c[ARGON2_NUM][1];
+
+static int Argon2_derive_loop(void *args)
+{
+    loopargs_t *tempargs = *(loopargs_t **) args;
+    EVP_KDF_CTX *kctx = tempargs->argon2_ctx[testnum];
+    unsigned char *out = tempargs->buf;
+    int count;
+
+    for (count = 0; COND(argon2_c[testnum][0]); count++) {
+        if (EVP_KDF_derive(kctx, out, 32, NULL) <= 0) {
+            BIO_printf(bio_err, "Argon2 derivation failure\n");
+            ERR_print_errors(bio_err);
+            count = -1;
+            break;
+        }
+    }
+    return count;
+}
+#endif /* OPENSSL_NO_ARGON2 */
+
 static long dsa_c[DSA_NUM][2];
 static int DSA_sign_loop(void *args)
 {
@@ -1097,6 +1279,122 @@ static int SM2_verify_loop(void *args)
 }
 #endif                         /* OPENSSL_NO_SM2 */
 
+static int ASYNC_switch_loop(void *args)
+{
+    long *count = *(long **)args;
+
+    for (*count = 0; run; (*count)++)
+        if (!ASYNC_pause_job())
+            return 0;
+    return 1;
+}
+
+/*
+ * Measure the cost of pausing and resuming an ASYNC job, i.e. the overhead
+ * that async mode adds to every operation that waits on an offload engine.
+ */
+static void async_switch_speed(ASYNC_WAIT_CTX *wait_ctx, int tm)
+{
+    ASYNC_JOB *job = NULL;
+    long count = 0, *countp = &count;
+    int ret, job_ret = 0;
+    double d;
+
+    BIO_printf(bio_err, "Doing ASYNC job pause/resume for %ds: ", tm);
+    (void)BIO_flush(bio_err);
+    run = 1;
+    alarm(tm);
+    Time_F(START);
+    do {
+        ret = ASYNC_start_job(&job, wait_ctx, &job_ret, ASYNC_switch_loop,
+                              &countp, sizeof(countp));
+    } while (ret == ASYNC_PAUSE);
+    d = Time_F(STOP);
+    if (ret != ASYNC_FINISH || !job_ret) {
+        BIO_printf(bio_err, "Failure in the job\n");
+        ERR_print_errors(bio_err);
+        return;
+    }
+    BIO_printf(bio_err, "%ld ASYNC job pause/resume's in %.2fs\n", count, d);
+    if (count > 0)
+        printf("ASYNC job pause/resume: %.1f ns\n", d * 1e9 / count);
+}
+
+/*
+ * Measure loading a PEM encoded PKCS#8 private key, i.e. running the decoder
+ * chain from PEM through PrivateKeyInfo to the key, for a few key types.
+ */
+static void pkcs8_decode_speed(int tm)
+{
+    static const struct {
+        const char *name;
+        const char *keytype;
+        const char *group;
+    } keys[] = {
+        { "rsa2048", "RSA", NULL },
+        { "ecdsap256", "EC", "P-256" },
+        { "ed25519", "ED25519", NULL }
+    };
+    EVP_PKEY_CTX *ctx;
+    EVP_PKEY *pkey, *key;
+    BIO *mem, *in;
+    char *pem;
+    long pemlen, count;
+    size_t k;
+    double d;
+
+    for (k = 0; k < OSSL_NELEM(keys); k++) {
+        pkey = NULL;
+        mem = NULL;
+        ctx = EVP_PKEY_CTX_new_from_name(app_get0_libctx(), keys[k].keytype,
+                                         app_get0_propq());
+        if (ctx == NULL
+                || EVP_PKEY_keygen_init(ctx) <= 0
+                || (keys[k].group != NULL
+                    && EVP_PKEY_CTX_set_group_name(ctx, keys[k].group) <= 0)
+                || EVP_PKEY_keygen(ctx, &pkey) <= 0
+                || (mem = BIO_new(BIO_s_mem())) == NULL
+                || !PEM_write_bio_PrivateKey(mem, pkey, NULL, NULL, 0,
+                                             NULL, NULL)
+                || (pemlen = BIO_get_mem_data(mem, &pem)) <= 0) {
+            BIO_printf(bio_err, "Failed to create a PKCS#8 %s key\n",
+                       keys[k].name);
+            ERR_print_errors(bio_err);
+            goto next;
+        }
+
+        BIO_printf(bio_err, "Doing %s PKCS#8 decodes for %ds: ",
+                   keys[k].name, tm);
+        (void)BIO_flush(bio_err);
+        run = 1;
+        alarm(tm);
+        Time_F(START);
+        for (count = 0; run; count++) {
+            in = BIO_new_mem_buf(pem, (int)pemlen);
+            key = PEM_read_bio_PrivateKey_ex(in, NULL, NULL, NULL,
+                                             app_get0_libctx(),
+                                             app_get0_propq());
+            BIO_free(in);
+            if (key == NULL) {
+                BIO_printf(bio_err, "Failure in the decode\n");
+                ERR_print_errors(bio_err);
+                break;
+            }
+            EVP_PKEY_free(key);
+        }
+        d = Time_F(STOP);
+        BIO_printf(bio_err, "%ld %s PKCS#8 decodes in %.2fs\n",
+                   count, keys[k].name, d);
+        if (count > 0)
+            printf("%s PKCS#8 decode: %.1f us\n", keys[k].name,
+                   d * 1e6 / count);
+ next:
+        BIO_free(mem);
+        EVP_PKEY_free(pkey);
+        EVP_PKEY_CTX_free(ctx);
+    }
+}
+
 static int run_benchmark(int async_jobs,
                          int (*loop_function) (void *), loopargs_t * loopargs)
 {
@@ -1341,7 +1639,8 @@ int speed_main(int argc, char **argv)
     EVP_MAC *mac = NULL;
     double d = 0.0;
     OPTION_CHOICE o;
-    int async_init = 0, multiblock = 0, pr_header = 0;
+    int async_init = 0, multiblock = 0, pr_header = 0, decode = 0;
+    int errs = 0;
     uint8_t doit[ALGOR_NUM] = { 0 };
     int ret = 1, misalign = 0, lengths_single = 0, aead = 0;
     long count = 0;
@@ -1358,7 +1657,7 @@ int speed_main(int argc, char **argv)
     openssl_speed_sec_t seconds = { SECONDS, RSA_SECONDS, DSA_SECONDS,
                                     ECDSA_SECONDS, ECDH_SECONDS,
                                     EdDSA_SECONDS, SM2_SECONDS,
-                                    FFDH_SECONDS };
+                                    FFDH_SECONDS, KDF_SECONDS };
 
     static const unsigned char key32[32] = {
         0x12, 0x34, 0x56, 0x78, 0x9a, 0xbc, 0xde, 0xf0,
@@ -1403,6 +1702,18 @@ int speed_main(int argc, char **argv)
     uint8_t ffdh_doit[FFDH_NUM] = { 0 };
 
 #endif /* OPENSSL_NO_DH */
+#ifndef OPENSSL_NO_ARGON2
+    /* The second recommended option of RFC 9106 section 4 */
+    static const struct {
+        const char *name;
+        uint32_t iter, memcost, lanes;
+    } argon2_params[ARGON2_NUM] = {
+        {OSSL_KDF_NAME_ARGON2D, 3, 64 * 1024, 4},
+        {OSSL_KDF_NAME_ARGON2I, 3, 64 * 1024, 4},
+        {OSSL_KDF_NAME_ARGON2ID, 3, 64 * 1024, 4}
+    };
+    uint8_t argon2_doit[ARGON2_NUM] = { 0 };
+#endif /* OPENSSL_NO_ARGON2 */
     static const unsigned int dsa_bits[DSA_NUM] = { 512, 1024, 2048 };
     uint8_t dsa_doit[DSA_NUM] = { 0 };
     /*
@@ -1591,7 +1902,8 @@ int speed_main(int argc, char **argv)
         case OPT_SECONDS:
             seconds.sym = seconds.rsa = seconds.dsa = seconds.ecdsa
                         = seconds.ecdh = seconds.eddsa
-                        = seconds.sm2 = seconds.ffdh = atoi(opt_arg());
+                        = seconds.sm2 = seconds.ffdh = seconds.kdf
+                        = atoi(opt_arg());
             break;
         case OPT_BYTES:
             lengths_single = atoi(opt_arg());
@@ -1601,6 +1913,12 @@ int speed_main(int argc, char **argv)
         case OPT_AEAD:
             aead = 1;
             break;
+        case OPT_DECODE:
+            decode = 1;
+            break;
+        case OPT_ERRORS:
+            errs = 1;
+            break;
         }
     }
 
@@ -1651,6 +1969,18 @@ int speed_main(int argc, char **argv)
                 continue;
             }
         }
+#endif
+#ifndef OPENSSL_NO_ARGON2
+        if (strncmp(algo, "argon2", 6) == 0) {
+            if (algo[6] == '\0') {
+                memset(argon2_doit, 1, sizeof(argon2_doit));
+                continue;
+            }
+            if (opt_found(algo, argon2_choices, &i)) {
+                argon2_doit[i] = 2;
+                continue;
+            }
+        }
 #endif
         if (strncmp(algo, "dsa", 3) == 0) {
             if (algo[3] == '\0') {
@@ -1725,12 +2055,13 @@ int speed_main(int argc, char **argv)
         }
     }
     if (multiblock) {
-        if (evp_cipher == NULL) {
+        if (evp_cipher == NULL && evp_md_name == NULL) {
             BIO_printf(bio_err, "-mb can be used only with a multi-block"
-                                " capable cipher\n");
+                                " capable cipher or a digest\n");
             goto end;
-        } else if (!(EVP_CIPHER_get_flags(evp_cipher) &
-                     EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK)) {
+        } else if (evp_cipher != NULL
+                   && !(EVP_CIPHER_get_flags(evp_cipher) &
+                        EVP_CIPH_FLAG_TLS1_1_MULTIBLOCK)) {
             BIO_printf(bio_err, "%s is not a multi-block capable\n",
                        EVP_CIPHER_get0_name(evp_cipher));
             goto end;
@@ -1792,7 +2123,8 @@ int speed_main(int argc, char **argv)
     e = setup_engine(engine_id, 0);
 
     /* No parameters; turn on everything. */
-    if (argc == 0 && !doit[D_EVP] && !doit[D_HMAC] && !doit[D_EVP_CMAC]) {
+    if (argc == 0 && !doit[D_EVP] && !doit[D_HMAC] && !doit[D_EVP_CMAC]
+            && !decode && !errs) {
         memset(doit, 1, sizeof(doit));
         doit[D_EVP] = doit[D_EVP_CMAC] = 0;
         ERR_set_mark();
@@ -1822,6 +2154,9 @@ int speed_main(int argc, char **argv)
         memset(rsa_doit, 1, sizeof(rsa_doit));
 #ifndef OPENSSL_NO_DH
         memset(ffdh_doit, 1, sizeof(ffdh_doit));
+#endif
+#ifndef OPENSSL_NO_ARGON2
+        memset(argon2_doit, 1, sizeof(argon2_doit));
 #endif
         memset(dsa_doit, 1, sizeof(dsa_doit));
         memset(ecdsa_doit, 1, sizeof(ecdsa_doit));
@@ -1844,6 +2179,13 @@ int speed_main(int argc, char **argv)
     signal(SIGALRM, alarmed);
 #endif
 
+    if (async_jobs > 0 && !mr)
+        async_switch_speed(loopargs[0].wait_ctx, seconds.sym);
+    if (decode && !mr)
+        pkcs8_decode_speed(seconds.sym);
+    if (errs && !mr)
+        errors_speed(seconds.sym);
+
     if (doit[D_MD2]) {
         for (testnum = 0; testnum < size_num; testnum++) {
             print_message(names[D_MD2], c[D_MD2][testnum], lengths[testnum],
@@ -2244,13 +2586,17 @@ int speed_main(int argc, char **argv)
                 print_result(D_EVP, testnum, count, d);
             }
         } else if (evp_md_name != NULL) {
+            int (*loopfunc) (void *) = EVP_Digest_md_loop;
+
+            if (multiblock)
+                loopfunc = EVP_Digest_many_loop;
             names[D_EVP] = evp_md_name;
 
             for (testnum = 0; testnum < size_num; testnum++) {
                 print_message(names[D_EVP], c[D_EVP][testnum], lengths[testnum],
                               seconds.sym);
                 Time_F(START);
-                count = run_benchmark(async_jobs, EVP_Digest_md_loop, loopargs);
+                count = run_benchmark(async_jobs, loopfunc, loopargs);
                 d = Time_F(STOP);
                 print_result(D_EVP, testnum, count, d);
                 if (count < 0)
@@ -3087,6 +3433,70 @@ int speed_main(int argc, char **argv)
         }
     }
 #endif  /* OPENSSL_NO_DH */
+
+#ifndef OPENSSL_NO_ARGON2
+    for (testnum = 0; testnum < ARGON2_NUM; testnum++) {
+        int argon2_checks = 1;
+
+        if (!argon2_doit[testnum])
+            continue;
+
+        for (i = 0; i < loopargs_len; i++) {
+            EVP_KDF *kdf;
+            OSSL_PARAM params[6], *p = params;
+            uint32_t iter = argon2_params[testnum].iter;
+            uint32_t memcost = argon2_params[testnum].memcost;
+            uint32_t lanes = argon2_params[testnum].lanes;
+
+            kdf = EVP_KDF_fetch(app_get0_libctx(), argon2_params[testnum].name,
+                                app_get0_propq());
+            if (kdf == NULL) {
+                argon2_checks = 0;
+                break;
+            }
+            loopargs[i].argon2_ctx[testnum] = EVP_KDF_CTX_new(kdf);
+            EVP_KDF_free(kdf);
+            *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_PASSWORD,
+                                                     (void *)key32, 16);
+            *p++ = OSSL_PARAM_construct_octet_string(OSSL_KDF_PARAM_SALT,
+                                                     (void *)(key32 + 16), 16);
+            *p++ = OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ITER, &iter);
+            *p++ = OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ARGON2_MEMCOST,
+                                               &memcost);
+            *p++ = OSSL_PARAM_construct_uint32(OSSL_KDF_PARAM_ARGON2_LANES,
+                                               &lanes);
+            *p = OSSL_PARAM_construct_end();
+            if (loopargs[i].argon2_ctx[testnum] == NULL
+                    || !EVP_KDF_CTX_set_params(loopargs[i].argon2_ctx[testnum],
+                                               params)) {
+                BIO_printf(bio_err, "Argon2 context setup failure.\n");
+                ERR_print_errors(bio_err);
+                op_count = 1;
+                argon2_checks = 0;
+                break;
+            }
+        }
+        if (argon2_checks != 0) {
+            kdf_print_message(argon2_choices[testnum].name,
+                              argon2_c[testnum][0],
+                              argon2_params[testnum].memcost, seconds.kdf);
+            Time_F(START);
+            count =
+                run_benchmark(async_jobs, Argon2_derive_loop, loopargs);
+            d = Time_F(STOP);
+            BIO_printf(bio_err,
+                       mr ? "+R13:%ld:%s:%.2f\n" :
+                       "%ld %s derivations in %.2fs\n", count,
+                       argon2_choices[testnum].name, d);
+            argon2_results[testnum][0] = (double)count / d;
+            op_count = count;
+        }
+        if (op_count <= 1) {
+            /* if longer than 10s, don't do any more */
+            stop_it(argon2_doit, testnum);
+        }
+    }
+#endif  /* OPENSSL_NO_ARGON2 */
 #ifndef NO_FORK
  show_res:
 #endif
@@ -3258,6 +3668,25 @@ int speed_main(int argc, char **argv)
                    1.0 / ffdh_results[k][0], ffdh_results[k][0]);
     }
 #endif /* OPENSSL_NO_DH */
+#ifndef OPENSSL_NO_ARGON2
+    testnum = 1;
+    for (k = 0; k < ARGON2_NUM; k++) {
+        if (!argon2_doit[k])
+            continue;
+        if (testnum && !mr) {
+            printf("%23sop     op/s\n", " ");
+            testnum = 0;
+        }
+        if (mr)
+            printf("+F9:%u:%s:%f:%f\n",
+                   k, argon2_choices[k].name,
+                   argon2_results[k][0], 1.0 / argon2_results[k][0]);
+        else
+            printf("%8s %5u KiB %8.4fs %8.1f\n",
+                   argon2_choices[k].name, argon2_params[k].memcost,
+                   1.0 / argon2_results[k][0], argon2_results[k][0]);
+    }
+#endif /* OPENSSL_NO_ARGON2 */
 
     ret = 0;
 
@@ -3278,6 +3707,10 @@ int speed_main(int argc, char **argv)
         OPENSSL_free(loopargs[i].secret_ff_b);
         for (k = 0; k < FFDH_NUM; k++)
             EVP_PKEY_CTX_free(loopargs[i].ffdh_ctx[k]);
+#endif
+#ifndef OPENSSL_NO_ARGON2
+        for (k = 0; k < ARGON2_NUM; k++)
+            EVP_KDF_CTX_free(loopargs[i].argon2_ctx[k]);
 #endif
         for (k = 0; k < DSA_NUM; k++) {
             EVP_PKEY_CTX_free(loopargs[i].dsa_sign_ctx[k]);
@@ -3353,6 +3786,19 @@ static void pkey_print_message(const char *str, const char *str2, long num,
     alarm(tm);
 }
 
+#ifndef OPENSSL_NO_ARGON2
+static void kdf_print_message(const char *str, long num, unsigned int kib,
+                              int tm)
+{
+    BIO_printf(bio_err,
+               mr ? "+DTK:%s:%u:%d\n"
+               : "Doing %s with %u KiB for %ds: ", str, kib, tm);
+    (void)BIO_flush(bio_err);
+    run = 1;
+    alarm(tm);
+}
+#endif
+
 static void print_result(int alg, int run_no, int count, double time_used)
 {
     if (count == -1) {
@@ -3546,6 +3992,18 @@ static int do_multi(int multi, int size_num)
                 d = atof(sstrsep(&p, sep));
                 ffdh_results[k][0] += d;
 # endif /* OPENSSL_NO_DH */
+# ifndef OPENSSL_NO_ARGON2
+            } else if (strncmp(buf, "+F9:", 4) == 0) {
+                int k;
+                double d;
+
+                p = buf + 4;
+                k = atoi(sstrsep(&p, sep));
+                sstrsep(&p, sep);
+
+                d = atof(sstrsep(&p, sep));
+                argon2_results[k][0] += d;
+# endif /* OPENSSL_NO_ARGON2 */
             } else if (strncmp(buf, "+H:", 3) == 0) {
                 ;
             } else {
@@ -0,0 +1,475 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# VAES XTS for AVX-512 capable processors.
+#
+# aesni_xts_[en|de]crypt in aesni-x86_64.pl process six blocks per
+# iteration in 128-bit registers and encrypt one data unit per call.
+# This module encrypts a run of data units, e.g. disk sectors, whose
+# tweaks are consecutive 128-bit little-endian numbers, as IEEE Std
+# 1619 has it for sector numbers. The initial tweaks are computed for
+# four data units at a time, one per lane of a %zmm register, with a
+# single pass of the second key. Within a data unit sixteen blocks are
+# processed per iteration in four %zmm registers, each lane carrying
+# its own tweak, and all four tweak registers are advanced by alpha^16
+# with a byte shift and one carry-less multiplication. Data units must
+# be a multiple of 16 bytes long, ciphertext stealing is left to
+# aesni_xts_[en|de]crypt.
+#
+#		aesni_xts	this module
+# Ice Lake	0.36		0.13		cycles per byte, 4KB, AES-128
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+# VAES and VPCLMULQDQ on %zmm registers
+$vaes = 0;
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$vaes = ($1>=2.30);
+}
+
+if (!$vaes && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
+	    `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)/) {
+	$vaes = ($1>=2.14);
+}
+
+if (!$vaes && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$vaes = ($2>=7.0);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+if ($vaes) {{{
+
+my ($inp,$out,$ulen,$units,$key1,$key2)=("%rdi","%rsi","%rdx","%rcx","%r8","%r9");
+my $ivp="%r10";			# 7th argument
+my $len="%r10";			# bytes left in the data unit
+my $lanes="%r11";		# initial tweaks left in $TW
+my $seventh_arg = $win64 ? 56 : 8;
+
+my @S=map("%zmm$_",(0..3));	# AES state
+my @W=map("%zmm$_",(4..7));	# tweaks, four consecutive ones per register
+my ($ivs,$TW,$poly,$T1,$T2,$inc4,$ones)=map("%zmm$_",(8..14));
+my @rk=map("%zmm$_",(16..29));	# round keys 0..13
+my ($rklast,$rk2)=("%zmm30","%zmm31");
+
+# Run @S[0..$n-1] through the rounds of the first key, the key schedule
+# is a decryption one for "de".
+sub aes_rounds {
+my ($n,$dir,$label,$xmm)=@_;
+my @s=@S[0..$n-1];
+my @k=(@rk,$rklast);
+my $code="";
+
+    if ($xmm) {
+	s/zmm/xmm/ foreach (@s,@k);
+    }
+    for (my $i=0; $i<$n; $i++) {
+	$code.="	vpxorq		$k[0],$s[$i],$s[$i]\n";
+    }
+    for (my $r=1; $r<14; $r++) {
+	$code.="	cmpl		\$11,240($key1)\n"	if ($r==10);
+	$code.="	jb		.Lxts_last$label\n"	if ($r==10);
+	$code.="	je		.Lxts_last$label\n"	if ($r==12);
+	for (my $i=0; $i<$n; $i++) {
+	    $code.="	vaes${dir}c		$k[$r],$s[$i],$s[$i]\n";
+	}
+    }
+    $code.=".Lxts_last$label:\n";
+    for (my $i=0; $i<$n; $i++) {
+	$code.="	vaes${dir}clast	$k[14],$s[$i],$s[$i]\n";
+    }
+    $code;
+}
+
+# Multiply each lane of $w by alpha^$k, $k being a multiple of 8.
+sub mul_alpha_bytes {
+my ($w,$k)=@_;
+my $b=$k/8;
+<<___;
+	vpsrldq		\$`16-$b`,$w,$T1
+	vpslldq		\$$b,$w,$w
+	vpclmulqdq	\$0x00,$poly,$T1,$T1
+	vpxorq		$T1,$w,$w
+___
+}
+
+# Multiply each lane of $src by alpha^$k, 0 < $k < 56, into $dst.
+sub mul_alpha_bits {
+my ($dst,$src,$k)=@_;
+<<___;
+	vpsrlq		\$`64-$k`,$src,$T1
+	vpsllq		\$$k,$src,$dst
+	vpslldq		\$8,$T1,$T2		# low half carries into high one
+	vpsrldq		\$8,$T1,$T1		# high half carries into low one
+	vpclmulqdq	\$0x00,$poly,$T1,$T1
+	vpternlogq	\$0x96,$T2,$T1,$dst
+___
+}
+
+# Add $inc to each lane of $ivs, as 128-bit little-endian numbers.
+sub add128 {
+my $inc=shift;
+<<___;
+	vpaddq		$inc,$ivs,$ivs
+	vpcmpuq		\$1,$inc,$ivs,%k1	# carry out of low halves
+	kshiftlw	\$1,%k1,%k1
+	vpsubq		$ones,$ivs,$ivs\{%k1\}
+___
+}
+
+$code=<<___;
+.text
+___
+
+for my $dir ("en","de") {
+my $label = "_${dir}c";
+
+$code.=<<___;
+.globl	ossl_aes_xts_${dir}crypt_avx512
+.type	ossl_aes_xts_${dir}crypt_avx512,\@function,6
+.align	32
+ossl_aes_xts_${dir}crypt_avx512:
+.cfi_startproc
+	endbranch
+	lea		(%rsp),%rax
+.cfi_def_cfa_register	%rax
+	test		$units,$units
+	jz		.Lxts${label}_abort
+	mov		$seventh_arg(%rax),$ivp		# 7th argument
+___
+$code.=<<___ if ($win64);
+	lea		-0xa8(%rsp),%rsp
+	movaps		%xmm6,-0xa8(%rax)
+	movaps		%xmm7,-0x98(%rax)
+	movaps		%xmm8,-0x88(%rax)
+	movaps		%xmm9,-0x78(%rax)
+	movaps		%xmm10,-0x68(%rax)
+	movaps		%xmm11,-0x58(%rax)
+	movaps		%xmm12,-0x48(%rax)
+	movaps		%xmm13,-0x38(%rax)
+	movaps		%xmm14,-0x28(%rax)
+	movaps		%xmm15,-0x18(%rax)
+.Lxts${label}_body:
+___
+$code.=<<___;
+	vpternlogq	\$0xff,$ones,$ones,$ones
+	vbroadcasti32x4	.Lxts_poly(%rip),$poly
+	vbroadcasti32x4	.Lxts_inc4(%rip),$inc4
+	vmovdqu64	.Lxts_add(%rip),$T1
+	vbroadcasti32x4	($ivp),$ivs
+___
+$code.=add128($T1);			# lanes are iv+0..3
+$code.=<<___;
+
+	mov		240($key1),%r11d		# rounds-1, aesni_set_*_key
+	shl		\$4,%r11
+	vbroadcasti32x4	16($key1,%r11),$rklast
+___
+for (my $r=0; $r<14; $r++) {
+	$code.="	vbroadcasti32x4	".(16*$r)."($key1),@rk[$r]\n";
+}
+$code.=<<___;
+	xor		$lanes,$lanes
+	jmp		.Lxts${label}_unit
+
+.align	32
+.Lxts${label}_unit:
+	test		$lanes,$lanes
+	jnz		.Lxts${label}_tweak
+
+	# Encrypt the next four initial tweaks with the second key
+	mov		240($key2),%r10d
+	shl		\$4,%r10
+	vbroadcasti32x4	($key2),$rk2
+	vpxorq		$rk2,$ivs,$TW
+	mov		\$16,%r11d
+.Lxts${label}_key2:
+	vbroadcasti32x4	($key2,%r11),$rk2
+	vaesenc		$rk2,$TW,$TW
+	add		\$16,%r11
+	cmp		%r10,%r11
+	jbe		.Lxts${label}_key2
+	vbroadcasti32x4	16($key2,%r10),$rk2
+	vaesenclast	$rk2,$TW,$TW
+___
+$code.=add128($inc4);
+$code.=<<___;
+	mov		\$4,$lanes
+
+.Lxts${label}_tweak:
+	# Tweaks 0..3 of the data unit in @W[0], lane i being multiplied
+	# by alpha^i, and tweaks 4..15 in @W[1..3]
+	vshufi64x2	\$0,$TW,$TW,@W[1]
+	vmovdqu64	.Lxts_shl(%rip),$T2
+	vpsrlvq		.Lxts_shr(%rip),@W[1],$T1
+	vpsllvq		$T2,@W[1],@W[0]
+	vpslldq		\$8,$T1,$T2
+	vpsrldq		\$8,$T1,$T1
+	vpclmulqdq	\$0x00,$poly,$T1,$T1
+	vpternlogq	\$0x96,$T2,$T1,@W[0]
+___
+$code.=mul_alpha_bits(@W[1],@W[0],4);
+$code.=mul_alpha_bits(@W[2],@W[1],4);
+$code.=mul_alpha_bits(@W[3],@W[2],4);
+$code.=<<___;
+
+	mov		$ulen,$len
+	sub		\$256,$len
+	jb		.Lxts${label}_tail
+
+.align	32
+.Lxts${label}_loop16:
+	vpxorq		0x00($inp),@W[0],@S[0]
+	vpxorq		0x40($inp),@W[1],@S[1]
+	vpxorq		0x80($inp),@W[2],@S[2]
+	vpxorq		0xc0($inp),@W[3],@S[3]
+	lea		0x100($inp),$inp
+___
+$code.=aes_rounds(4,$dir,"${label}16");
+$code.=<<___;
+	vpxorq		@W[0],@S[0],@S[0]
+	vpxorq		@W[1],@S[1],@S[1]
+	vpxorq		@W[2],@S[2],@S[2]
+	vpxorq		@W[3],@S[3],@S[3]
+	vmovdqu64	@S[0],0x00($out)
+	vmovdqu64	@S[1],0x40($out)
+	vmovdqu64	@S[2],0x80($out)
+	vmovdqu64	@S[3],0xc0($out)
+	lea		0x100($out),$out
+___
+for (my $i=0; $i<4; $i++) {
+	$code.=mul_alpha_bytes(@W[$i],16);
+}
+$code.=<<___;
+	sub		\$256,$len
+	jae		.Lxts${label}_loop16
+
+.Lxts${label}_tail:
+	add		\$256,$len
+	jz		.Lxts${label}_next
+	sub		\$64,$len
+	jb		.Lxts${label}_tail1
+
+.Lxts${label}_loop4:
+	vpxorq		($inp),@W[0],@S[0]
+	lea		0x40($inp),$inp
+___
+$code.=aes_rounds(1,$dir,"${label}4");
+$code.=<<___;
+	vpxorq		@W[0],@S[0],@S[0]
+	vmovdqu64	@S[0],($out)
+	lea		0x40($out),$out
+___
+$code.=mul_alpha_bits(@W[0],@W[0],4);
+$code.=<<___;
+	sub		\$64,$len
+	jae		.Lxts${label}_loop4
+
+.Lxts${label}_tail1:
+	add		\$64,$len
+	jz		.Lxts${label}_next
+
+.Lxts${label}_loop1:
+	vpxorq		($inp),%xmm4,%xmm0
+	lea		0x10($inp),$inp
+___
+$code.=aes_rounds(1,$dir,"${label}1",1);
+$code.=<<___;
+	vpxorq		%xmm4,%xmm0,%xmm0
+	vmovdqu		%xmm0,($out)
+	lea		0x10($out),$out
+	valignq		\$2,@W[0],@W[0],@W[0]	# next tweak to lane 0
+	sub		\$16,$len
+	jnz		.Lxts${label}_loop1
+
+.Lxts${label}_next:
+	valignq		\$2,$TW,$TW,$TW		# next initial tweak to lane 0
+	dec		$lanes
+	dec		$units
+	jnz		.Lxts${label}_unit
+
+	vzeroupper
+___
+$code.=<<___ if ($win64);
+	movaps	-0xa8(%rax),%xmm6
+	movaps	-0x98(%rax),%xmm7
+	movaps	-0x88(%rax),%xmm8
+	movaps	-0x78(%rax),%xmm9
+	movaps	-0x68(%rax),%xmm10
+	movaps	-0x58(%rax),%xmm11
+	movaps	-0x48(%rax),%xmm12
+	movaps	-0x38(%rax),%xmm13
+	movaps	-0x28(%rax),%xmm14
+	movaps	-0x18(%rax),%xmm15
+	lea	(%rax),%rsp			# restore %rsp
+___
+$code.=<<___;
+.Lxts${label}_abort:
+	ret
+.cfi_endproc
+.size	ossl_aes_xts_${dir}crypt_avx512,.-ossl_aes_xts_${dir}crypt_avx512
+___
+}
+
+$code.=<<___;
+.align	64
+.Lxts_add:
+	.quad	0,0, 1,0, 2,0, 3,0
+.Lxts_shl:
+	.quad	0,0, 1,1, 2,2, 3,3
+.Lxts_shr:
+	.quad	64,64, 63,63, 62,62, 61,61
+.Lxts_inc4:
+	.quad	4,0
+.Lxts_poly:
+	.quad	0x87,0
+.align	64
+___
+
+if ($win64) {
+$rec="%rcx";
+$frame="%rdx";
+$context="%r8";
+$disp="%r9";
+
+$code.=<<___;
+.extern	__imp_RtlVirtualUnwind
+.type	xts_avx512_se_handler,\@abi-omnipotent
+.align	16
+xts_avx512_se_handler:
+	push	%rsi
+	push	%rdi
+	push	%rbx
+	push	%rbp
+	push	%r12
+	push	%r13
+	push	%r14
+	push	%r15
+	pushfq
+	sub	\$64,%rsp
+
+	mov	120($context),%rax	# pull context->Rax
+	mov	248($context),%rbx	# pull context->Rip
+
+	mov	8($disp),%rsi		# disp->ImageBase
+	mov	56($disp),%r11		# disp->HandlerData
+
+	mov	0(%r11),%r10d		# HandlerData[0]
+	lea	(%rsi,%r10),%r10	# prologue label
+	cmp	%r10,%rbx		# context->Rip<prologue label
+	jb	.Lcommon_seh_tail
+
+	mov	4(%r11),%r10d		# HandlerData[1]
+	lea	(%rsi,%r10),%r10	# epilogue label
+	cmp	%r10,%rbx		# context->Rip>=epilogue label
+	jae	.Lcommon_seh_tail
+
+	lea	-0xa8(%rax),%rsi	# %xmm save area
+	lea	512($context),%rdi	# & context.Xmm6
+	mov	\$20,%ecx		# 10*sizeof(%xmm0)/sizeof(%rax)
+	.long	0xa548f3fc		# cld; rep movsq
+
+.Lcommon_seh_tail:
+	mov	8(%rax),%rdi
+	mov	16(%rax),%rsi
+	mov	%rax,152($context)	# restore context->Rsp
+	mov	%rsi,168($context)	# restore context->Rsi
+	mov	%rdi,176($context)	# restore context->Rdi
+
+	mov	40($disp),%rdi		# disp->ContextRecord
+	mov	$context,%rsi		# context
+	mov	\$154,%ecx		# sizeof(CONTEXT)
+	.long	0xa548f3fc		# cld; rep movsq
+
+	mov	$disp,%rsi
+	xor	%rcx,%rcx		# arg1, UNW_FLAG_NHANDLER
+	mov	8(%rsi),%rdx		# arg2, disp->ImageBase
+	mov	0(%rsi),%r8		# arg3, disp->ControlPc
+	mov	16(%rsi),%r9		# arg4, disp->FunctionEntry
+	mov	40(%rsi),%r10		# disp->ContextRecord
+	lea	56(%rsi),%r11		# &disp->HandlerData
+	lea	24(%rsi),%r12		# &disp->EstablisherFrame
+	mov	%r10,32(%rsp)		# arg5
+	mov	%r11,40(%rsp)		# arg6
+	mov	%r12,48(%rsp)		# arg7
+	mov	%rcx,56(%rsp)		# arg8, (NULL)
+	call	*__imp_RtlVirtualUnwind(%rip)
+
+	mov	\$1,%eax		# ExceptionContinueSearch
+	add	\$64,%rsp
+	popfq
+	pop	%r15
+	pop	%r14
+	pop	%r13
+	pop	%r12
+	pop	%rbp
+	pop	%rbx
+	pop	%rdi
+	pop	%rsi
+	ret
+.size	xts_avx512_se_handler,.-xts_avx512_se_handler
+
+.section	.pdata
+.align	4
+	.rva	.LSEH_begin_ossl_aes_xts_encrypt_avx512
+	.rva	.LSEH_end_ossl_aes_xts_encrypt_avx512
+	.rva	.LSEH_xts_enc_avx512_info
+
+	.rva	.LSEH_begin_ossl_aes_xts_decrypt_avx512
+	.rva	.LSEH_end_ossl_aes_xts_decrypt_avx512
+	.rva	.LSEH_xts_dec_avx512_info
+.section	.xdata
+.align	8
+.LSEH_xts_enc_avx512_info:
+	.byte	9,0,0,0
+	.rva	xts_avx512_se_handler
+	.rva	.Lxts_enc_body,.Lxts_enc_abort
+.LSEH_xts_dec_avx512_info:
+	.byte	9,0,0,0
+	.rva	xts_avx512_se_handler
+	.rva	.Lxts_dec_body,.Lxts_dec_abort
+___
+}
+}}} else {{{
+$code=<<___;	# assembler is too old
+.text
+
+.globl	ossl_aes_xts_encrypt_avx512
+.globl	ossl_aes_xts_decrypt_avx512
+.type	ossl_aes_xts_encrypt_avx512,\@abi-omnipotent
+.type	ossl_aes_xts_decrypt_avx512,\@abi-omnipotent
+ossl_aes_xts_encrypt_avx512:
+ossl_aes_xts_decrypt_avx512:
+.cfi_startproc
+	.byte	0x0f,0x0b	# ud2
+	ret
+.cfi_endproc
+.size	ossl_aes_xts_encrypt_avx512,.-ossl_aes_xts_encrypt_avx512
+___
+}}}
+
+$code =~ s/\`([^\`]*)\`/eval($1)/gem;
+
+print $code;
+
+close STDOUT or die "error closing STDOUT: $!";
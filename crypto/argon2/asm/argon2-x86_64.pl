@@ -0,0 +1,491 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+# Argon2 block compression for x86_64.
+#
+# The compression function G of RFC 9106 applies the BLAKE2b based
+# permutation P (with the BlaMka multiplications) to the eight rows and
+# then to the eight columns of the 1KB block R = prev ^ ref.  Every row
+# or column is a 4x4 matrix of 64-bit words, and two of them are done at
+# once in eight ymm registers: rows side by side, columns split over the
+# two 128-bit halves.  The diagonal steps rotate the rows of the matrices
+# with vpermq, or for the columns with dword blends and in-lane shuffles.
+# The block is kept on the stack between the row and the column pass.
+#
+# void argon2_fill_block_avx2(const BLOCK *prev, const BLOCK *ref,
+#                             BLOCK *next, int with_xor);
+# void argon2_fill_block_avx512vl(...);
+#
+# next = G(prev, ref), or next ^= G(prev, ref) if with_xor is non-zero.
+# next may be the same block as ref.  The AVX512VL flavour only differs
+# in rotating with vprorq and merging the outputs with vpternlogq.
+#
+# unsigned int argon2_x86_64_caps(void) tells which of them can be used
+# on this processor, see ARGON2_X86_64_* in kdfs/argon2.c.
+#
+# Performance in cycles per 1KB block of Argon2id with 1MB of memory on a
+# 2.1GHz Skylake server, C code compiled with gcc 12 -O2 for comparison.
+# With 64MB the reference blocks come from DRAM and it takes about 1120
+# cycles with either flavour.
+#
+#		G
+# C		2300
+# AVX2		710
+# AVX512VL	700
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+$avx=0;
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$avx = ($1>=2.19) + ($1>=2.22) + ($1>=2.25);
+}
+
+if (!$avx && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
+	   `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)(?:\.([0-9]+))?/) {
+	$avx = ($1>=2.09) + ($1>=2.10) + ($1>=2.12);
+	$avx += 1 if ($1==2.11 && $2>=8);
+}
+
+if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
+	   `ml64 2>&1` =~ /Version ([0-9]+)\./) {
+	$avx = ($1>=10) + ($1>=11);
+}
+
+if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$avx = ($2>=3.0) + ($2>3.0) + ($2>=3.9);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+my ($prev,$ref,$next,$xor) = ("%rdi","%rsi","%rdx","%ecx");
+my ($off,$cnt) = ("%rax","%r10d");
+my @x = map("%ymm$_",(0..7));
+my ($t0,$t1,$r24,$r16) = map("%ymm$_",(8..11));
+
+# Save and restore of the non-volatile xmm6-15 on Win64, both functions
+# use the same frame layout relative to %r9.
+sub win64_prologue {
+	return "" if (!$win64);
+	return <<___;
+	lea	-0xa8(%rsp),%rsp
+	movaps	%xmm6,-0xa8(%r9)
+	movaps	%xmm7,-0x98(%r9)
+	movaps	%xmm8,-0x88(%r9)
+	movaps	%xmm9,-0x78(%r9)
+	movaps	%xmm10,-0x68(%r9)
+	movaps	%xmm11,-0x58(%r9)
+	movaps	%xmm12,-0x48(%r9)
+	movaps	%xmm13,-0x38(%r9)
+	movaps	%xmm14,-0x28(%r9)
+	movaps	%xmm15,-0x18(%r9)
+___
+}
+
+sub win64_epilogue {
+	return "" if (!$win64);
+	return <<___;
+	movaps	-0xa8(%r9),%xmm6
+	movaps	-0x98(%r9),%xmm7
+	movaps	-0x88(%r9),%xmm8
+	movaps	-0x78(%r9),%xmm9
+	movaps	-0x68(%r9),%xmm10
+	movaps	-0x58(%r9),%xmm11
+	movaps	-0x48(%r9),%xmm12
+	movaps	-0x38(%r9),%xmm13
+	movaps	-0x28(%r9),%xmm14
+	movaps	-0x18(%r9),%xmm15
+___
+}
+
+$code.=<<___;
+.text
+
+.extern	OPENSSL_ia32cap_P
+
+.globl	argon2_x86_64_caps
+.type	argon2_x86_64_caps,\@abi-omnipotent
+.align	32
+argon2_x86_64_caps:
+.cfi_startproc
+	mov	OPENSSL_ia32cap_P+4(%rip),%r10
+	xor	%eax,%eax
+___
+$code.=<<___	if ($avx>1);
+	bt	\$37,%r10			# AVX2
+	jnc	.Lcaps_done
+	or	\$1,%eax
+___
+$code.=<<___	if ($avx>2);
+	test	%r10,%r10			# AVX512VL
+	jns	.Lcaps_done
+	or	\$2,%eax
+___
+$code.=<<___;
+.Lcaps_done:
+	ret
+.cfi_endproc
+.size	argon2_x86_64_caps,.-argon2_x86_64_caps
+___
+
+# Half a round of P on the two 4x4 matrices @$q = ([a,b,c,d],[a,b,c,d]),
+# the G function on every column of both, instruction by instruction.
+sub half_round {
+my ($vl,$q) = @_;
+my @t = ($t0,$t1);
+my $code = "";
+
+	# a += b + 2 * lo(a) * lo(b), the BlaMka addition
+	my $blamka = sub {
+	    my ($ia,$ib) = @_;
+
+	    for (my $i = 0; $i < 2; $i++) {
+		$code.="	vpmuludq	$q->[$i][$ib],$q->[$i][$ia],$t[$i]\n";
+	    }
+	    for (my $i = 0; $i < 2; $i++) {
+		$code.="	vpaddq		$t[$i],$t[$i],$t[$i]\n";
+	    }
+	    for (my $i = 0; $i < 2; $i++) {
+		$code.="	vpaddq		$q->[$i][$ib],$q->[$i][$ia],$q->[$i][$ia]\n";
+	    }
+	    for (my $i = 0; $i < 2; $i++) {
+		$code.="	vpaddq		$t[$i],$q->[$i][$ia],$q->[$i][$ia]\n";
+	    }
+	};
+	# x = (x ^ y) >>> n
+	my $xorrot = sub {
+	    my ($ix,$iy,$n) = @_;
+
+	    for (my $i = 0; $i < 2; $i++) {
+		$code.="	vpxor		$q->[$i][$iy],$q->[$i][$ix],$q->[$i][$ix]\n";
+	    }
+	    for (my $i = 0; $i < 2; $i++) {
+		my $r = $q->[$i][$ix];
+
+		if ($vl) {
+		    $code.="	vprorq		\$$n,$r,$r\n";
+		} elsif ($n == 32) {
+		    $code.="	vpshufd		\$0xb1,$r,$r\n";
+		} elsif ($n == 24 || $n == 16) {
+		    $code.="	vpshufb		".($n == 24 ? $r24 : $r16).",$r,$r\n";
+		} else {
+		    $code.=<<___;
+	vpsrlq		\$63,$r,$t[$i]
+	vpaddq		$r,$r,$r
+	vpxor		$t[$i],$r,$r
+___
+		}
+	    }
+	};
+
+	&$blamka(0,1); &$xorrot(3,0,32);
+	&$blamka(2,3); &$xorrot(1,2,24);
+	&$blamka(0,1); &$xorrot(3,0,16);
+	&$blamka(2,3); &$xorrot(1,2,63);
+
+	return $code;
+}
+
+# Moves the 128-bit halves (x0,x1 | y0,y1) and (x2,x3 | y2,y3) of $a and
+# $b to (x1,x2 | y1,y2) and (x3,x0 | y3,y0), or back with $undo.
+sub column_diag {
+my ($a,$b,$undo) = @_;
+my ($i0,$i1) = $undo ? (0xcc,0x33) : (0x33,0xcc);
+
+	return <<___;
+	vpblendd	\$$i0,$b,$a,$t0
+	vpblendd	\$$i1,$b,$a,$t1
+	vpshufd		\$0x4e,$t0,$a
+	vpshufd		\$0x4e,$t1,$b
+___
+}
+
+sub fill_block {
+my ($name,$vl) = @_;
+my $mova = $vl ? "vmovdqa64" : "vmovdqa";
+my $movu = $vl ? "vmovdqu64" : "vmovdqu";
+my $code = "";
+
+	$code.=<<___;
+.globl	$name
+.type	$name,\@function,4
+.align	32
+$name:
+.cfi_startproc
+	mov	%rsp,%r9			# frame register
+.cfi_def_cfa_register	%r9
+___
+	$code.=win64_prologue();
+	$code.=<<___;
+	sub	\$1024,%rsp			# the block between the passes
+	and	\$-32,%rsp
+.L${name}_body:
+___
+	$code.=<<___ if (!$vl);
+	vbroadcasti128	.Lrot24(%rip),$r24
+	vbroadcasti128	.Lrot16(%rip),$r16
+___
+
+	# Rows: two per iteration, R = prev ^ ref is formed on the way in
+	$code.=<<___;
+	xor		$off,$off
+	mov		\$4,$cnt
+.Lrows_$name:
+___
+	for (my $i = 0; $i < 8; $i++) {
+	    $code.=<<___;
+	$movu		`32*$i`($prev,$off),$x[$i]
+	vpxor		`32*$i`($ref,$off),$x[$i],$x[$i]
+___
+	}
+	my @q = ([ @x[0..3] ], [ @x[4..7] ]);
+	$code.=half_round($vl,\@q);
+	for (my $i = 0; $i < 2; $i++) {
+	    $code.=<<___;
+	vpermq		\$0x39,$q[$i][1],$q[$i][1]
+	vpermq		\$0x4e,$q[$i][2],$q[$i][2]
+	vpermq		\$0x93,$q[$i][3],$q[$i][3]
+___
+	}
+	$code.=half_round($vl,\@q);
+	for (my $i = 0; $i < 2; $i++) {
+	    $code.=<<___;
+	vpermq		\$0x93,$q[$i][1],$q[$i][1]
+	vpermq		\$0x4e,$q[$i][2],$q[$i][2]
+	vpermq		\$0x39,$q[$i][3],$q[$i][3]
+___
+	}
+	for (my $i = 0; $i < 8; $i++) {
+	    $code.="	$mova		$x[$i],`32*$i`(%rsp,$off)\n";
+	}
+	$code.=<<___;
+	add		\$256,$off
+	dec		$cnt
+	jnz		.Lrows_$name
+
+	xor		$off,$off
+	mov		\$4,$cnt
+.Lcolumns_$name:
+___
+
+	# Columns: two per iteration, the words of each are two 128-bit
+	# halves, 128 bytes apart
+	for (my $i = 0; $i < 8; $i++) {
+	    $code.="	$mova		`128*$i`(%rsp,$off),$x[$i]\n";
+	}
+	@q = ([ @x[0,2,4,6] ], [ @x[1,3,5,7] ]);
+	$code.=half_round($vl,\@q);
+	$code.=column_diag($x[2],$x[3],0);
+	$code.=column_diag($x[6],$x[7],1);
+	$code.=half_round($vl,[ [ @x[0,2,5,6] ], [ @x[1,3,4,7] ] ]);
+	$code.=column_diag($x[2],$x[3],1);
+	$code.=column_diag($x[6],$x[7],0);
+
+	# next = P(R) ^ R (^ next)
+	for (my $i = 0; $i < 8; $i++) {
+	    if ($vl) {
+		$code.=<<___;
+	$movu		`128*$i`($prev,$off),$t0
+	vpternlogq	\$0x96,`128*$i`($ref,$off),$t0,$x[$i]
+___
+	    } else {
+		$code.=<<___;
+	vpxor		`128*$i`($prev,$off),$x[$i],$x[$i]
+	vpxor		`128*$i`($ref,$off),$x[$i],$x[$i]
+___
+	    }
+	}
+	$code.=<<___;
+	test		$xor,$xor
+	jz		.Lstore_$name
+___
+	for (my $i = 0; $i < 8; $i++) {
+	    $code.="	vpxor		`128*$i`($next,$off),$x[$i],$x[$i]\n";
+	}
+	$code.=".Lstore_$name:\n";
+	for (my $i = 0; $i < 8; $i++) {
+	    $code.="	$movu		$x[$i],`128*$i`($next,$off)\n";
+	}
+	$code.=<<___;
+	add		\$32,$off
+	dec		$cnt
+	jnz		.Lcolumns_$name
+
+	vzeroall
+___
+	$code.=win64_epilogue();
+	$code.=<<___;
+	lea	(%r9),%rsp
+.cfi_def_cfa_register	%rsp
+.L${name}_epilogue:
+	ret
+.cfi_endproc
+.size	$name,.-$name
+___
+	return $code;
+}
+
+my @funcs;
+
+if ($avx>1) {
+$code.=fill_block("argon2_fill_block_avx2",0);
+push @funcs, "argon2_fill_block_avx2";
+}
+if ($avx>2) {
+$code.=fill_block("argon2_fill_block_avx512vl",1);
+push @funcs, "argon2_fill_block_avx512vl";
+}
+foreach my $name ("argon2_fill_block_avx2","argon2_fill_block_avx512vl") {
+next if (grep { $_ eq $name } @funcs);
+$code.=<<___;
+.globl	$name
+.type	$name,\@abi-omnipotent
+$name:
+.cfi_startproc
+	.byte	0x0f,0x0b	# ud2
+	ret
+.cfi_endproc
+.size	$name,.-$name
+___
+}
+
+$code.=<<___;
+.align	64
+.Lrot24:
+	.byte	3,4,5,6,7,0,1,2,11,12,13,14,15,8,9,10
+.Lrot16:
+	.byte	2,3,4,5,6,7,0,1,10,11,12,13,14,15,8,9
+___
+
+# EXCEPTION_DISPOSITION handler (EXCEPTION_RECORD *rec,ULONG64 frame,
+#		CONTEXT *context,DISPATCHER_CONTEXT *disp)
+if ($win64) {
+$rec="%rcx";
+$frame="%rdx";
+$context="%r8";
+$disp="%r9";
+
+$code.=<<___;
+.extern	__imp_RtlVirtualUnwind
+.type	simd_handler,\@abi-omnipotent
+.align	16
+simd_handler:
+	push	%rsi
+	push	%rdi
+	push	%rbx
+	push	%rbp
+	push	%r12
+	push	%r13
+	push	%r14
+	push	%r15
+	pushfq
+	sub	\$64,%rsp
+
+	mov	120($context),%rax	# pull context->Rax
+	mov	248($context),%rbx	# pull context->Rip
+
+	mov	8($disp),%rsi		# disp->ImageBase
+	mov	56($disp),%r11		# disp->HandlerData
+
+	mov	0(%r11),%r10d		# HandlerData[0]
+	lea	(%rsi,%r10),%r10	# prologue label
+	cmp	%r10,%rbx		# context->Rip<prologue label
+	jb	.Lcommon_seh_tail
+
+	mov	192($context),%rax	# pull context->R9
+
+	mov	4(%r11),%r10d		# HandlerData[1]
+	lea	(%rsi,%r10),%r10	# epilogue label
+	cmp	%r10,%rbx		# context->Rip>=epilogue label
+	jae	.Lcommon_seh_tail
+
+	lea	-0xa8(%rax),%rsi
+	lea	512($context),%rdi	# &context.Xmm6
+	mov	\$20,%ecx
+	.long	0xa548f3fc		# cld; rep movsq
+
+.Lcommon_seh_tail:
+	mov	8(%rax),%rdi
+	mov	16(%rax),%rsi
+	mov	%rax,152($context)	# restore context->Rsp
+	mov	%rsi,168($context)	# restore context->Rsi
+	mov	%rdi,176($context)	# restore context->Rdi
+
+	mov	40($disp),%rdi		# disp->ContextRecord
+	mov	$context,%rsi		# context
+	mov	\$154,%ecx		# sizeof(CONTEXT)
+	.long	0xa548f3fc		# cld; rep movsq
+
+	mov	$disp,%rsi
+	xor	%rcx,%rcx		# arg1, UNW_FLAG_NHANDLER
+	mov	8(%rsi),%rdx		# arg2, disp->ImageBase
+	mov	0(%rsi),%r8		# arg3, disp->ControlPc
+	mov	16(%rsi),%r9		# arg4, disp->FunctionEntry
+	mov	40(%rsi),%r10		# disp->ContextRecord
+	lea	56(%rsi),%r11		# &disp->HandlerData
+	lea	24(%rsi),%r12		# &disp->EstablisherFrame
+	mov	%r10,32(%rsp)		# arg5
+	mov	%r11,40(%rsp)		# arg6
+	mov	%r12,48(%rsp)		# arg7
+	mov	%rcx,56(%rsp)		# arg8, (NULL)
+	call	*__imp_RtlVirtualUnwind(%rip)
+
+	mov	\$1,%eax		# ExceptionContinueSearch
+	add	\$64,%rsp
+	popfq
+	pop	%r15
+	pop	%r14
+	pop	%r13
+	pop	%r12
+	pop	%rbp
+	pop	%rbx
+	pop	%rdi
+	pop	%rsi
+	ret
+.size	simd_handler,.-simd_handler
+
+.section	.pdata
+.align	4
+___
+foreach my $f (@funcs) {
+$code.=<<___;
+	.rva	.LSEH_begin_$f
+	.rva	.LSEH_end_$f
+	.rva	.LSEH_info_$f
+___
+}
+$code.=<<___;
+
+.section	.xdata
+.align	8
+___
+foreach my $f (@funcs) {
+$code.=<<___;
+.LSEH_info_$f:
+	.byte	9,0,0,0
+	.rva	simd_handler
+	.rva	.L${f}_body,.L${f}_epilogue	# HandlerData[]
+___
+}
+}
+
+$code =~ s/\`([^\`]*)\`/eval $1/gem;
+print $code;
+close STDOUT or die "error closing STDOUT: $!";
@@ -14,6 +14,11 @@
 
 # include <stddef.h>
 # include <unistd.h>
+# include <sys/mman.h>
+
+# if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#  define MAP_ANONYMOUS MAP_ANON
+# endif
 
 #define STACKSIZE       32768
 
@@ -32,15 +37,68 @@ void async_local_cleanup(void)
 {
 }
 
+#ifdef MAP_ANONYMOUS
+static size_t page_size(void)
+{
+    long ps = sysconf(_SC_PAGESIZE);
+
+    return ps > 0 ? (size_t)ps : 4096;
+}
+#endif
+
+/*
+ * Fibre stacks are mapped with an inaccessible guard page below them where
+ * possible, so that an overflow faults instead of silently corrupting
+ * whatever happens to be allocated next to the stack.
+ */
+static void *stack_alloc(size_t *size)
+{
+#ifdef MAP_ANONYMOUS
+    size_t ps = page_size();
+    unsigned char *p;
+
+    /* Leave room for the rounding and the guard page */
+    if (*size > (size_t)-1 - 2 * ps)
+        return NULL;
+    *size = (*size + ps - 1) & ~(ps - 1);
+    p = mmap(NULL, *size + ps, PROT_READ | PROT_WRITE,
+             MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED)
+        return NULL;
+    if (mprotect(p, ps, PROT_NONE) != 0) {
+        munmap(p, *size + ps);
+        return NULL;
+    }
+    return p + ps;
+#else
+    return OPENSSL_malloc(*size);
+#endif
+}
+
+static void stack_free(void *stack, size_t size)
+{
+#ifdef MAP_ANONYMOUS
+    size_t ps = page_size();
+
+    munmap((unsigned char *)stack - ps, size + ps);
+#else
+    OPENSSL_free(stack);
+#endif
+}
+
 int async_fibre_makecontext(async_fibre *fibre)
 {
+    size_t size = async_get_stack_size();
+
+    if (size == 0)
+        size = STACKSIZE;
 #ifndef USE_SWAPCONTEXT
     fibre->env_init = 0;
 #endif
     if (getcontext(&fibre->fibre) == 0) {
-        fibre->fibre.uc_stack.ss_sp = OPENSSL_malloc(STACKSIZE);
+        fibre->fibre.uc_stack.ss_sp = stack_alloc(&size);
         if (fibre->fibre.uc_stack.ss_sp != NULL) {
-            fibre->fibre.uc_stack.ss_size = STACKSIZE;
+            fibre->fibre.uc_stack.ss_size = size;
             fibre->fibre.uc_link = NULL;
             makecontext(&fibre->fibre, async_start_func, 0);
             return 1;
@@ -53,7 +111,8 @@ int async_fibre_makecontext(async_fibre *fibre)
 
 void async_fibre_free(async_fibre *fibre)
 {
-    OPENSSL_free(fibre->fibre.uc_stack.ss_sp);
+    if (fibre->fibre.uc_stack.ss_sp != NULL)
+        stack_free(fibre->fibre.uc_stack.ss_sp, fibre->fibre.uc_stack.ss_size);
     fibre->fibre.uc_stack.ss_sp = NULL;
 }
 
@@ -29,11 +29,13 @@ typedef struct async_fibre_st {
 
 # if defined(_WIN32_WINNT) && _WIN32_WINNT >= 0x600
 #   define async_fibre_makecontext(c) \
-        ((c)->fibre = CreateFiberEx(0, 0, FIBER_FLAG_FLOAT_SWITCH, \
+        ((c)->fibre = CreateFiberEx(0, async_get_stack_size(), \
+                                    FIBER_FLAG_FLOAT_SWITCH, \
                                     async_start_func_win, 0))
 # else
 #   define async_fibre_makecontext(c) \
-        ((c)->fibre = CreateFiber(0, async_start_func_win, 0))
+        ((c)->fibre = CreateFiber(async_get_stack_size(), \
+                                  async_start_func_win, 0))
 # endif
 
 # define async_fibre_free(f)             (DeleteFiber((f)->fibre))
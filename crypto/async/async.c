@@ -30,6 +30,21 @@
 static CRYPTO_THREAD_LOCAL ctxkey;
 static CRYPTO_THREAD_LOCAL poolkey;
 
+/*
+ * Stack size for newly created fibres, 0 means the platform default.  Jobs
+ * may be created on any thread while it is changed, so it is only accessed
+ * under |stack_size_lock|.
+ */
+static size_t stack_size = 0;
+static CRYPTO_RWLOCK *stack_size_lock = NULL;
+
+/*
+ * Smaller stacks are not enough for the library's own code to run in a job,
+ * and larger ones would overflow when rounded up to whole pages.
+ */
+#define ASYNC_STACK_SIZE_MIN    16384
+#define ASYNC_STACK_SIZE_MAX    ((size_t)-1 / 2)
+
 static void async_delete_thread_state(void *arg);
 
 static async_ctx *async_ctx_new(void)
@@ -95,7 +110,7 @@ static ASYNC_JOB *async_job_new(void)
 static void async_job_free(ASYNC_JOB *job)
 {
     if (job != NULL) {
-        OPENSSL_free(job->funcargs);
+        OPENSSL_free(job->argbuf);
         async_fibre_free(&job->fibrectx);
         OPENSSL_free(job);
     }
@@ -138,7 +153,7 @@ static void async_release_job(ASYNC_JOB *job) {
     async_pool *pool;
 
     pool = (async_pool *)CRYPTO_THREAD_get_local(&poolkey);
-    OPENSSL_free(job->funcargs);
+    /* The argument buffer stays with the job for reuse */
     job->funcargs = NULL;
     sk_ASYNC_JOB_push(pool->jobs, job);
 }
@@ -246,13 +261,19 @@ int ASYNC_start_job(ASYNC_JOB **job, ASYNC_WAIT_CTX *wctx, int *ret,
             return ASYNC_NO_JOBS;
 
         if (args != NULL) {
-            ctx->currjob->funcargs = OPENSSL_malloc(size);
-            if (ctx->currjob->funcargs == NULL) {
-                ERR_raise(ERR_LIB_ASYNC, ERR_R_MALLOC_FAILURE);
-                async_release_job(ctx->currjob);
-                ctx->currjob = NULL;
-                return ASYNC_ERR;
+            if (size > ctx->currjob->argbuf_size) {
+                OPENSSL_free(ctx->currjob->argbuf);
+                ctx->currjob->argbuf_size = 0;
+                ctx->currjob->argbuf = OPENSSL_malloc(size);
+                if (ctx->currjob->argbuf == NULL) {
+                    ERR_raise(ERR_LIB_ASYNC, ERR_R_MALLOC_FAILURE);
+                    async_release_job(ctx->currjob);
+                    ctx->currjob = NULL;
+                    return ASYNC_ERR;
+                }
+                ctx->currjob->argbuf_size = size;
             }
+            ctx->currjob->funcargs = ctx->currjob->argbuf;
             memcpy(ctx->currjob->funcargs, args, size);
         } else {
             ctx->currjob->funcargs = NULL;
@@ -332,6 +353,12 @@ int async_init(void)
         return 0;
     }
 
+    if ((stack_size_lock = CRYPTO_THREAD_lock_new()) == NULL) {
+        CRYPTO_THREAD_cleanup_local(&ctxkey);
+        CRYPTO_THREAD_cleanup_local(&poolkey);
+        return 0;
+    }
+
     return 1;
 }
 
@@ -339,6 +366,9 @@ void async_deinit(void)
 {
     CRYPTO_THREAD_cleanup_local(&ctxkey);
     CRYPTO_THREAD_cleanup_local(&poolkey);
+    CRYPTO_THREAD_lock_free(stack_size_lock);
+    stack_size_lock = NULL;
+    stack_size = 0;
 }
 
 int ASYNC_init_thread(size_t max_size, size_t init_size)
@@ -424,6 +454,33 @@ void ASYNC_cleanup_thread(void)
     async_delete_thread_state(NULL);
 }
 
+int ASYNC_set_stack_size(size_t size)
+{
+    if (size != 0
+        && (size < ASYNC_STACK_SIZE_MIN || size > ASYNC_STACK_SIZE_MAX)) {
+        ERR_raise(ERR_LIB_ASYNC, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+
+    if (!OPENSSL_init_crypto(OPENSSL_INIT_ASYNC, NULL)
+        || !CRYPTO_THREAD_write_lock(stack_size_lock))
+        return 0;
+    stack_size = size;
+    CRYPTO_THREAD_unlock(stack_size_lock);
+    return 1;
+}
+
+size_t async_get_stack_size(void)
+{
+    size_t size;
+
+    if (!CRYPTO_THREAD_read_lock(stack_size_lock))
+        return 0;
+    size = stack_size;
+    CRYPTO_THREAD_unlock(stack_size_lock);
+    return size;
+}
+
 ASYNC_JOB *ASYNC_get_current_job(void)
 {
     async_ctx *ctx;
@@ -40,6 +40,8 @@ struct async_job_st {
     async_fibre fibrectx;
     int (*func) (void *);
     void *funcargs;
+    void *argbuf;
+    size_t argbuf_size;
     int ret;
     int status;
     ASYNC_WAIT_CTX *waitctx;
@@ -63,6 +65,8 @@ struct async_wait_ctx_st {
     ASYNC_callback_fn callback;
     void *callback_arg;
     int status;
+    ASYNC_QUEUE *queue;
+    void *queue_item;
 };
 
 DEFINE_STACK_OF(ASYNC_JOB)
@@ -76,6 +80,7 @@ struct async_pool_st {
 void async_local_cleanup(void);
 void async_start_func(void);
 async_ctx *async_get_ctx(void);
+size_t async_get_stack_size(void);
 
 void async_wait_ctx_reset_counts(ASYNC_WAIT_CTX *ctx);
 
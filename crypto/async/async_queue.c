@@ -0,0 +1,261 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/* This must be the first #include file */
+#include "async_local.h"
+
+#include <string.h>
+#include <openssl/err.h>
+#include "e_os.h"
+
+#if defined(ASYNC_POSIX)
+# include <errno.h>
+# include <fcntl.h>
+# include <unistd.h>
+# if defined(__linux__)
+#  include <sys/eventfd.h>
+#  define ASYNC_QUEUE_EVENTFD
+# endif
+#endif
+
+#define ASYNC_QUEUE_MIN_SIZE    16
+
+/*
+ * A completion queue is a ring of opaque items guarded by a lock, plus one
+ * OS level wait object that is signalled while the ring is not empty. Items
+ * are pushed from engine completion callbacks, possibly on other threads,
+ * and drained by the thread running the event loop.
+ */
+struct async_queue_st {
+    CRYPTO_RWLOCK *lock;
+    void **items;
+    size_t head;
+    size_t count;
+    size_t size;
+#if defined(ASYNC_WIN)
+    HANDLE event;
+#elif defined(ASYNC_POSIX)
+    int readfd;
+    int writefd;
+#endif
+};
+
+#if defined(ASYNC_POSIX) && !defined(ASYNC_QUEUE_EVENTFD)
+static int set_nonblock(int fd)
+{
+    int flags = fcntl(fd, F_GETFL);
+
+    return flags != -1 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+#endif
+
+static int queue_init_signal(ASYNC_QUEUE *q)
+{
+#if defined(ASYNC_WIN)
+    q->event = CreateEvent(NULL, TRUE, FALSE, NULL);
+    if (q->event == NULL) {
+        ERR_raise_data(ERR_LIB_SYS, get_last_sys_error(),
+                       "calling CreateEvent()");
+        return 0;
+    }
+#elif defined(ASYNC_QUEUE_EVENTFD)
+    q->readfd = q->writefd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (q->readfd == -1) {
+        ERR_raise_data(ERR_LIB_SYS, get_last_sys_error(),
+                       "calling eventfd()");
+        return 0;
+    }
+#elif defined(ASYNC_POSIX)
+    int fds[2];
+
+    q->readfd = q->writefd = -1;
+    if (pipe(fds) != 0) {
+        ERR_raise_data(ERR_LIB_SYS, get_last_sys_error(), "calling pipe()");
+        return 0;
+    }
+    q->readfd = fds[0];
+    q->writefd = fds[1];
+    if (!set_nonblock(q->readfd) || !set_nonblock(q->writefd)) {
+        ERR_raise_data(ERR_LIB_SYS, get_last_sys_error(), "calling fcntl()");
+        return 0;
+    }
+#endif
+    return 1;
+}
+
+static void queue_free_signal(ASYNC_QUEUE *q)
+{
+#if defined(ASYNC_WIN)
+    if (q->event != NULL)
+        CloseHandle(q->event);
+#elif defined(ASYNC_POSIX)
+    if (q->readfd != -1)
+        close(q->readfd);
+    if (q->writefd != -1 && q->writefd != q->readfd)
+        close(q->writefd);
+#endif
+}
+
+/* Called with the lock held when the ring goes from empty to non-empty */
+static void queue_signal(ASYNC_QUEUE *q)
+{
+#if defined(ASYNC_WIN)
+    SetEvent(q->event);
+#elif defined(ASYNC_QUEUE_EVENTFD)
+    uint64_t one = 1;
+
+    while (write(q->writefd, &one, sizeof(one)) == -1 && errno == EINTR)
+        continue;
+#elif defined(ASYNC_POSIX)
+    char c = 0;
+
+    while (write(q->writefd, &c, 1) == -1 && errno == EINTR)
+        continue;
+#endif
+}
+
+/* Called with the lock held when the ring becomes empty */
+static void queue_clear(ASYNC_QUEUE *q)
+{
+#if defined(ASYNC_WIN)
+    ResetEvent(q->event);
+#elif defined(ASYNC_QUEUE_EVENTFD)
+    uint64_t val;
+
+    while (read(q->readfd, &val, sizeof(val)) == -1 && errno == EINTR)
+        continue;
+#elif defined(ASYNC_POSIX)
+    char buf[16];
+    ssize_t n;
+
+    do {
+        n = read(q->readfd, buf, sizeof(buf));
+    } while (n > 0 || (n == -1 && errno == EINTR));
+#endif
+}
+
+ASYNC_QUEUE *ASYNC_QUEUE_new(void)
+{
+    ASYNC_QUEUE *q = OPENSSL_zalloc(sizeof(*q));
+
+    if (q == NULL) {
+        ERR_raise(ERR_LIB_ASYNC, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+#if defined(ASYNC_POSIX)
+    q->readfd = q->writefd = -1;
+#endif
+    q->lock = CRYPTO_THREAD_lock_new();
+    if (q->lock == NULL) {
+        ERR_raise(ERR_LIB_ASYNC, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    if (!queue_init_signal(q))
+        goto err;
+    return q;
+ err:
+    ASYNC_QUEUE_free(q);
+    return NULL;
+}
+
+void ASYNC_QUEUE_free(ASYNC_QUEUE *q)
+{
+    if (q == NULL)
+        return;
+
+    queue_free_signal(q);
+    CRYPTO_THREAD_lock_free(q->lock);
+    OPENSSL_free(q->items);
+    OPENSSL_free(q);
+}
+
+int ASYNC_QUEUE_get_fd(ASYNC_QUEUE *q, OSSL_ASYNC_FD *fd)
+{
+    if (q == NULL || fd == NULL) {
+        ERR_raise(ERR_LIB_ASYNC, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+#if defined(ASYNC_WIN)
+    *fd = q->event;
+    return 1;
+#elif defined(ASYNC_POSIX)
+    *fd = q->readfd;
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int ASYNC_QUEUE_push(ASYNC_QUEUE *q, void *item)
+{
+    int ret = 0;
+
+    if (q == NULL) {
+        ERR_raise(ERR_LIB_ASYNC, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+    if (!CRYPTO_THREAD_write_lock(q->lock))
+        return 0;
+
+    if (q->count == q->size) {
+        size_t newsize = q->size == 0 ? ASYNC_QUEUE_MIN_SIZE : q->size * 2;
+        void **newitems = OPENSSL_malloc(newsize * sizeof(*newitems));
+        size_t first;
+
+        if (newitems == NULL) {
+            ERR_raise(ERR_LIB_ASYNC, ERR_R_MALLOC_FAILURE);
+            goto end;
+        }
+        /* Unwrap the ring into the start of the new array */
+        first = q->size - q->head;
+        if (first > q->count)
+            first = q->count;
+        if (q->count > 0) {
+            memcpy(newitems, q->items + q->head, first * sizeof(*newitems));
+            memcpy(newitems + first, q->items,
+                   (q->count - first) * sizeof(*newitems));
+        }
+        OPENSSL_free(q->items);
+        q->items = newitems;
+        q->head = 0;
+        q->size = newsize;
+    }
+
+    q->items[(q->head + q->count) % q->size] = item;
+    if (q->count++ == 0)
+        queue_signal(q);
+    ret = 1;
+ end:
+    CRYPTO_THREAD_unlock(q->lock);
+    return ret;
+}
+
+size_t ASYNC_QUEUE_drain(ASYNC_QUEUE *q, void **items, size_t max_items)
+{
+    size_t n, i;
+
+    if (q == NULL || items == NULL) {
+        ERR_raise(ERR_LIB_ASYNC, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+    if (!CRYPTO_THREAD_write_lock(q->lock))
+        return 0;
+
+    n = q->count < max_items ? q->count : max_items;
+    for (i = 0; i < n; i++) {
+        items[i] = q->items[q->head];
+        q->head = (q->head + 1) % q->size;
+    }
+    q->count -= n;
+    if (n > 0 && q->count == 0)
+        queue_clear(q);
+
+    CRYPTO_THREAD_unlock(q->lock);
+    return n;
+}
@@ -206,6 +206,31 @@ int ASYNC_WAIT_CTX_get_callback(ASYNC_WAIT_CTX *ctx,
       return 1;
 }
 
+static int async_wait_ctx_queue_cb(void *arg)
+{
+    ASYNC_WAIT_CTX *ctx = arg;
+
+    return ASYNC_QUEUE_push(ctx->queue, ctx->queue_item);
+}
+
+int ASYNC_WAIT_CTX_set_queue(ASYNC_WAIT_CTX *ctx, ASYNC_QUEUE *queue,
+                             void *item)
+{
+    if (ctx == NULL)
+        return 0;
+
+    ctx->queue = queue;
+    ctx->queue_item = item;
+    if (queue != NULL) {
+        ctx->callback = async_wait_ctx_queue_cb;
+        ctx->callback_arg = ctx;
+    } else if (ctx->callback == async_wait_ctx_queue_cb) {
+        ctx->callback = NULL;
+        ctx->callback_arg = NULL;
+    }
+    return 1;
+}
+
 int ASYNC_WAIT_CTX_set_status(ASYNC_WAIT_CTX *ctx, int status)
 {
       ctx->status = status;
@@ -397,6 +397,72 @@ int BIO_write_ex(BIO *b, const void *data, size_t dlen, size_t *written)
         || (b != NULL && dlen == 0); /* order is important for *written */
 }
 
+/* Common argument checks of BIO_sendmmsg() and BIO_recvmmsg() */
+static int bio_mmsg_check(BIO *b, int write, BIO_MSG *msg, size_t stride,
+                          uint64_t flags, size_t *msgs_processed)
+{
+    if (msgs_processed != NULL)
+        *msgs_processed = 0;
+    if (b == NULL || msg == NULL || msgs_processed == NULL) {
+        ERR_raise(ERR_LIB_BIO, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+    if (b->method == NULL
+        || (write ? b->method->bsendmmsg : b->method->brecvmmsg) == NULL) {
+        ERR_raise(ERR_LIB_BIO, BIO_R_UNSUPPORTED_METHOD);
+        return 0;
+    }
+    if (stride < sizeof(BIO_MSG) || flags != 0) {
+        ERR_raise(ERR_LIB_BIO, BIO_R_INVALID_ARGUMENT);
+        return 0;
+    }
+    if (!b->init) {
+        ERR_raise(ERR_LIB_BIO, BIO_R_UNINITIALIZED);
+        return 0;
+    }
+    return 1;
+}
+
+static uint64_t bio_mmsg_bytes(BIO_MSG *msg, size_t stride, size_t num_msg)
+{
+    uint64_t total = 0;
+    size_t i;
+
+    for (i = 0; i < num_msg; i++)
+        total += BIO_MSG_N(msg, stride, i).data_len;
+    return total;
+}
+
+int BIO_sendmmsg(BIO *b, BIO_MSG *msg, size_t stride, size_t num_msg,
+                 uint64_t flags, size_t *msgs_processed)
+{
+    if (!bio_mmsg_check(b, 1, msg, stride, flags, msgs_processed))
+        return 0;
+    if (num_msg == 0)
+        return 1;
+
+    if (b->method->bsendmmsg(b, msg, stride, num_msg, flags,
+                             msgs_processed) <= 0)
+        return 0;
+    b->num_write += bio_mmsg_bytes(msg, stride, *msgs_processed);
+    return 1;
+}
+
+int BIO_recvmmsg(BIO *b, BIO_MSG *msg, size_t stride, size_t num_msg,
+                 uint64_t flags, size_t *msgs_processed)
+{
+    if (!bio_mmsg_check(b, 0, msg, stride, flags, msgs_processed))
+        return 0;
+    if (num_msg == 0)
+        return 1;
+
+    if (b->method->brecvmmsg(b, msg, stride, num_msg, flags,
+                             msgs_processed) <= 0)
+        return 0;
+    b->num_read += bio_mmsg_bytes(msg, stride, *msgs_processed);
+    return 1;
+}
+
 int BIO_puts(BIO *b, const char *buf)
 {
     int ret;
@@ -10,6 +10,10 @@
 #include "e_os.h"
 #include "internal/sockets.h"
 
+/* Access the n-th element of a BIO_MSG array with the given stride */
+#define BIO_MSG_N(array, stride, n) \
+    (*(BIO_MSG *)((char *)(array) + (n) * (stride)))
+
 /* BEGIN BIO_ADDRINFO/BIO_ADDR stuff. */
 
 #ifndef OPENSSL_NO_SOCK
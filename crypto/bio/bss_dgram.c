@@ -7,12 +7,31 @@
  * https://www.openssl.org/source/license.html
  */
 
+#ifndef _GNU_SOURCE
+# define _GNU_SOURCE             /* for sendmmsg() and recvmmsg() */
+#endif
+
 #include <stdio.h>
 #include <errno.h>
 
 #include "bio_local.h"
 #ifndef OPENSSL_NO_DGRAM
 
+/*
+ * sendmmsg() and recvmmsg() let us move a whole batch of datagrams with one
+ * system call.  Elsewhere, BIO_sendmmsg() and BIO_recvmmsg() fall back to
+ * one sendto() or recvfrom() per datagram.
+ */
+# if defined(OPENSSL_SYS_LINUX) && defined(__GLIBC__) \
+    && defined(__GLIBC_PREREQ)
+#  if __GLIBC_PREREQ(2, 14)
+#   define M_METHOD_MMSG
+#  endif
+# endif
+
+/* Upper limit of datagrams handled per BIO_sendmmsg() or BIO_recvmmsg() */
+# define BIO_MAX_MSGS_PER_CALL   64
+
 # ifndef OPENSSL_NO_SCTP
 #  include <netinet/sctp.h>
 #  include <fcntl.h>
@@ -40,6 +59,12 @@
 
 static int dgram_write(BIO *h, const char *buf, int num);
 static int dgram_read(BIO *h, char *buf, int size);
+static int dgram_sendmmsg(BIO *b, BIO_MSG *msg, size_t stride,
+                          size_t num_msg, uint64_t flags,
+                          size_t *msgs_processed);
+static int dgram_recvmmsg(BIO *b, BIO_MSG *msg, size_t stride,
+                          size_t num_msg, uint64_t flags,
+                          size_t *msgs_processed);
 static int dgram_puts(BIO *h, const char *str);
 static long dgram_ctrl(BIO *h, int cmd, long arg1, void *arg2);
 static int dgram_new(BIO *h);
@@ -78,6 +103,8 @@ static const BIO_METHOD methods_dgramp = {
     dgram_new,
     dgram_free,
     NULL,                       /* dgram_callback_ctrl */
+    dgram_sendmmsg,
+    dgram_recvmmsg,
 };
 
 # ifndef OPENSSL_NO_SCTP
@@ -105,6 +132,7 @@ typedef struct bio_dgram_data_st {
     struct timeval next_timeout;
     struct timeval socket_timeout;
     unsigned int peekmode;
+    unsigned int no_mmsg;       /* recvmmsg() failed with ENOSYS */
 } bio_dgram_data;
 
 # ifndef OPENSSL_NO_SCTP
@@ -351,6 +379,234 @@ static int dgram_write(BIO *b, const char *in, int inl)
     return ret;
 }
 
+/*
+ * The destination of a datagram is its own peer address if there is one,
+ * otherwise the BIO's peer, unless the socket is connected.
+ */
+static const BIO_ADDR *dgram_msg_peer(bio_dgram_data *data, const BIO_MSG *m)
+{
+    if (m->peer != NULL)
+        return m->peer;
+    return data->connected ? NULL : &data->peer;
+}
+
+static int dgram_sendmmsg(BIO *b, BIO_MSG *msg, size_t stride,
+                          size_t num_msg, uint64_t flags,
+                          size_t *msgs_processed)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+    const BIO_ADDR *peer;
+    size_t i;
+    int ret;
+# ifdef M_METHOD_MMSG
+    struct mmsghdr mh[BIO_MAX_MSGS_PER_CALL];
+    struct iovec iov[BIO_MAX_MSGS_PER_CALL];
+# endif
+
+    if (num_msg > BIO_MAX_MSGS_PER_CALL)
+        num_msg = BIO_MAX_MSGS_PER_CALL;
+
+# ifdef M_METHOD_MMSG
+    memset(mh, 0, sizeof(mh[0]) * num_msg);
+    for (i = 0; i < num_msg; i++) {
+        BIO_MSG *m = &BIO_MSG_N(msg, stride, i);
+
+        iov[i].iov_base = m->data;
+        iov[i].iov_len = m->data_len;
+        mh[i].msg_hdr.msg_iov = &iov[i];
+        mh[i].msg_hdr.msg_iovlen = 1;
+        if ((peer = dgram_msg_peer(data, m)) != NULL) {
+            mh[i].msg_hdr.msg_name = (void *)BIO_ADDR_sockaddr(peer);
+            mh[i].msg_hdr.msg_namelen = BIO_ADDR_sockaddr_size(peer);
+        }
+    }
+
+    clear_socket_error();
+    ret = sendmmsg(b->num, mh, (unsigned int)num_msg, 0);
+    BIO_clear_retry_flags(b);
+    if (ret <= 0) {
+        if (BIO_dgram_should_retry(ret)) {
+            BIO_set_retry_write(b);
+            data->_errno = get_last_socket_error();
+        }
+        return 0;
+    }
+    *msgs_processed = (size_t)ret;
+    return 1;
+# else
+    BIO_clear_retry_flags(b);
+    for (i = 0; i < num_msg; i++) {
+        BIO_MSG *m = &BIO_MSG_N(msg, stride, i);
+
+        if (m->data_len > INT_MAX)
+            break;
+        clear_socket_error();
+        if ((peer = dgram_msg_peer(data, m)) == NULL)
+            ret = writesocket(b->num, m->data, (int)m->data_len);
+        else
+            ret = sendto(b->num, m->data, (int)m->data_len, 0,
+                         BIO_ADDR_sockaddr(peer),
+                         BIO_ADDR_sockaddr_size(peer));
+        if (ret < 0) {
+            /* Report the datagrams sent so far, the error comes next call */
+            if (i > 0)
+                break;
+            if (BIO_dgram_should_retry(ret)) {
+                BIO_set_retry_write(b);
+                data->_errno = get_last_socket_error();
+            }
+            return 0;
+        }
+    }
+    *msgs_processed = i;
+    return i > 0;
+# endif
+}
+
+/*
+ * Receives up to |num_msg| datagrams with one recvfrom() each, for systems
+ * without recvmmsg() and for kernels that turn out not to implement it.
+ */
+static int dgram_recvfrom_msgs(BIO *b, BIO_MSG *msg, size_t stride,
+                               size_t num_msg, int sflags,
+                               size_t *msgs_processed)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+    size_t i;
+    int ret;
+
+# if defined(OPENSSL_SYS_LINUX) && defined(MSG_TRUNC)
+    /* Have recvfrom() return the real length of a truncated datagram */
+    sflags |= MSG_TRUNC;
+# endif
+# ifndef MSG_DONTWAIT
+    /* We can't read past the first datagram without the risk of blocking */
+    num_msg = 1;
+# endif
+
+    dgram_adjust_rcv_timeout(b);
+    BIO_clear_retry_flags(b);
+    for (i = 0; i < num_msg; i++) {
+        BIO_MSG *m = &BIO_MSG_N(msg, stride, i);
+        BIO_ADDR peer;
+        socklen_t len = sizeof(peer);
+
+        if (m->data_len > INT_MAX)
+            break;
+        clear_socket_error();
+        memset(&peer, 0, sizeof(peer));
+        ret = recvfrom(b->num, m->data, (int)m->data_len, sflags,
+                       BIO_ADDR_sockaddr_noconst(&peer), &len);
+        m->flags = 0;
+# ifdef OPENSSL_SYS_WINDOWS
+        /* Winsock fills the buffer but reports a truncated datagram as error */
+        if (ret < 0 && get_last_socket_error() == WSAEMSGSIZE) {
+            ret = (int)m->data_len;
+            m->flags = BIO_MSG_TRUNCATED;
+        }
+# endif
+        if (ret < 0) {
+            /* Report the datagrams received so far, if any */
+            if (i == 0 && BIO_dgram_should_retry(ret)) {
+                BIO_set_retry_read(b);
+                data->_errno = get_last_socket_error();
+            }
+            break;
+        }
+        if ((size_t)ret > m->data_len)
+            m->flags = BIO_MSG_TRUNCATED;
+        else
+            m->data_len = (size_t)ret;
+        if (m->peer != NULL)
+            *m->peer = peer;
+# ifdef MSG_DONTWAIT
+        /* Only wait for the first datagram, then take what is queued */
+        sflags |= MSG_DONTWAIT;
+# endif
+    }
+    dgram_reset_rcv_timeout(b);
+    *msgs_processed = i;
+    return i > 0;
+}
+
+static int dgram_recvmmsg(BIO *b, BIO_MSG *msg, size_t stride,
+                          size_t num_msg, uint64_t flags,
+                          size_t *msgs_processed)
+{
+    bio_dgram_data *data = (bio_dgram_data *)b->ptr;
+    int sflags = 0;
+# ifdef M_METHOD_MMSG
+    struct mmsghdr mh[BIO_MAX_MSGS_PER_CALL];
+    struct iovec iov[BIO_MAX_MSGS_PER_CALL];
+    size_t i;
+    int ret;
+# endif
+
+    if (num_msg > BIO_MAX_MSGS_PER_CALL)
+        num_msg = BIO_MAX_MSGS_PER_CALL;
+    /* Peeking at several datagrams makes no sense */
+    if (data->peekmode) {
+        sflags = MSG_PEEK;
+        num_msg = 1;
+    }
+
+# ifdef M_METHOD_MMSG
+    if (data->no_mmsg)
+        return dgram_recvfrom_msgs(b, msg, stride, num_msg, sflags,
+                                   msgs_processed);
+
+    memset(mh, 0, sizeof(mh[0]) * num_msg);
+    for (i = 0; i < num_msg; i++) {
+        BIO_MSG *m = &BIO_MSG_N(msg, stride, i);
+
+        iov[i].iov_base = m->data;
+        iov[i].iov_len = m->data_len;
+        mh[i].msg_hdr.msg_iov = &iov[i];
+        mh[i].msg_hdr.msg_iovlen = 1;
+        if (m->peer != NULL) {
+            BIO_ADDR_clear(m->peer);
+            mh[i].msg_hdr.msg_name = BIO_ADDR_sockaddr_noconst(m->peer);
+            mh[i].msg_hdr.msg_namelen = sizeof(*m->peer);
+        }
+    }
+
+    clear_socket_error();
+    dgram_adjust_rcv_timeout(b);
+    /* Only wait for the first datagram, then take what is queued */
+    ret = recvmmsg(b->num, mh, (unsigned int)num_msg,
+                   sflags | MSG_WAITFORONE, NULL);
+    BIO_clear_retry_flags(b);
+    if (ret < 0 && get_last_socket_error() == ENOSYS) {
+        /* The kernel doesn't have it, so don't try again on this BIO */
+        dgram_reset_rcv_timeout(b);
+        data->no_mmsg = 1;
+        return dgram_recvfrom_msgs(b, msg, stride, num_msg, sflags,
+                                   msgs_processed);
+    }
+    if (ret <= 0) {
+        if (BIO_dgram_should_retry(ret)) {
+            BIO_set_retry_read(b);
+            data->_errno = get_last_socket_error();
+        }
+        dgram_reset_rcv_timeout(b);
+        return 0;
+    }
+    for (i = 0; i < (size_t)ret; i++) {
+        BIO_MSG *m = &BIO_MSG_N(msg, stride, i);
+
+        m->data_len = mh[i].msg_len;
+        m->flags = (mh[i].msg_hdr.msg_flags & MSG_TRUNC) != 0
+                   ? BIO_MSG_TRUNCATED : 0;
+    }
+    dgram_reset_rcv_timeout(b);
+    *msgs_processed = (size_t)ret;
+    return 1;
+# else
+    return dgram_recvfrom_msgs(b, msg, stride, num_msg, sflags,
+                               msgs_processed);
+# endif
+}
+
 static long dgram_get_mtu_overhead(bio_dgram_data *data)
 {
     long ret;
@@ -578,6 +834,9 @@ static long dgram_ctrl(BIO *b, int cmd, long num, void *ptr)
     case BIO_CTRL_DGRAM_SET_PEER:
         BIO_ADDR_make(&data->peer, BIO_ADDR_sockaddr((BIO_ADDR *)ptr));
         break;
+    case BIO_CTRL_DGRAM_GET_CONNECTED:
+        ret = data->connected != 0;
+        break;
     case BIO_CTRL_DGRAM_SET_NEXT_TIMEOUT:
         memcpy(&(data->next_timeout), ptr, sizeof(struct timeval));
         break;
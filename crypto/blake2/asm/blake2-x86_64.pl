@@ -0,0 +1,889 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+# BLAKE2b and BLAKE2s compression functions for x86_64.
+#
+# blake2b_compress_avx2 and blake2s_compress_sse41 hash a single stream.
+# The 4x4 matrix of state words is kept one row per register, ymm for
+# BLAKE2b and xmm for BLAKE2s, so that the four column (and, after
+# rotating rows 1-3, the four diagonal) G functions run side by side.
+# With AVX512VL the rotations are single vprorq/vprord instructions,
+# otherwise they are byte shuffles or shift pairs.
+#
+# blake2b_compress_x4 and blake2s_compress_x8 hash the leaves of BLAKE2bp
+# and BLAKE2sp: four BLAKE2b or eight BLAKE2s states at once, word i of
+# every state in register i, so every G is plain lane-wise arithmetic.
+# Those need AVX512VL for the 32 registers and the rotations.
+#
+# The single stream functions take the BLAKE2B_CTX/BLAKE2S_CTX from
+# providers/implementations/include/prov/blake2.h and compress |len|
+# bytes the same way as the C code: a multiple of the block size, or a
+# single final block of |len| (possibly zero) bytes padded with zeros.
+#
+# void blake2b_compress_avx2(BLAKE2B_CTX *S, const void *in, size_t len);
+# void blake2s_compress_sse41(BLAKE2S_CTX *S, const void *in, size_t len);
+#
+# The multi-lane ones take the chaining values transposed, H[i][j] being
+# word i of leaf j, the block counter shared by all the leaves, and |num|
+# 512-byte runs of data each holding one block for every leaf in turn.
+# The final blocks of the leaves are left to the single stream code.
+#
+# void blake2b_compress_x4(uint64_t H[8][4], uint64_t t[2],
+#                          const void *in, size_t num);
+# void blake2s_compress_x8(uint32_t H[8][8], uint32_t t[2],
+#                          const void *in, size_t num);
+#
+# unsigned int blake2_x86_64_caps(void) tells which of them can be used
+# on this processor, see BLAKE2_X86_64_* in prov/blake2.h.
+#
+# Performance in cycles per byte out of 64KB buffer on a 2.1GHz Skylake
+# server, C code compiled with gcc 12 -O2 for comparison. BLAKE2bp and
+# BLAKE2sp leaves fall back to the single-stream code without AVX512VL.
+#
+#		BLAKE2b		BLAKE2s		BLAKE2bp	BLAKE2sp
+# C		3.9		5.9		4.3		5.7
+# AVX2/SSE4.1	2.5		4.3		2.9		4.8
+# AVX512VL	2.6		3.3		0.82		0.96
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+$avx=0;
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$avx = ($1>=2.19) + ($1>=2.22) + ($1>=2.25);
+}
+
+if (!$avx && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
+	   `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)(?:\.([0-9]+))?/) {
+	$avx = ($1>=2.09) + ($1>=2.10) + ($1>=2.12);
+	$avx += 1 if ($1==2.11 && $2>=8);
+}
+
+if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
+	   `ml64 2>&1` =~ /Version ([0-9]+)\./) {
+	$avx = ($1>=10) + ($1>=11);
+}
+
+if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$avx = ($2>=3.0) + ($2>3.0) + ($2>=3.9);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+my @sigma = (
+	[  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 ],
+	[ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 ],
+	[ 11,  8, 12,  0,  5,  2, 15, 13, 10, 14,  3,  6,  7,  1,  9,  4 ],
+	[  7,  9,  3,  1, 13, 12, 11, 14,  2,  6,  5, 10,  4,  0, 15,  8 ],
+	[  9,  0,  5,  7,  2,  4, 10, 15, 14,  1, 11, 12,  6,  8,  3, 13 ],
+	[  2, 12,  6, 10,  0, 11,  8,  3,  4, 13,  7,  5, 15, 14,  1,  9 ],
+	[ 12,  5,  1, 15, 14, 13,  4, 10,  0,  7,  6,  3,  9,  2,  8, 11 ],
+	[ 13, 11,  7, 14, 12,  1,  3,  9,  5,  0, 15,  4,  8,  6,  2, 10 ],
+	[  6, 15, 14,  9, 11,  3,  0,  8, 12,  2, 13,  7,  1,  4, 10,  5 ],
+	[ 10,  2,  8,  4,  7,  6,  1,  5, 15, 11,  9, 14,  3, 12, 13,  0 ],
+	[  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 ],
+	[ 14, 10,  4,  8,  9, 15, 13,  6,  1, 12,  0,  2, 11,  7,  5,  3 ] );
+
+my ($ctx,$inp,$len,$num) = ("%rdi","%rsi","%rdx","%rcx");
+
+# Save and restore of the non-volatile xmm6-15 on Win64, all functions
+# but blake2_x86_64_caps use the same frame layout relative to %r9.
+sub win64_prologue {
+	return "" if (!$win64);
+	return <<___;
+	lea	-0xa8(%rsp),%rsp
+	movaps	%xmm6,-0xa8(%r9)
+	movaps	%xmm7,-0x98(%r9)
+	movaps	%xmm8,-0x88(%r9)
+	movaps	%xmm9,-0x78(%r9)
+	movaps	%xmm10,-0x68(%r9)
+	movaps	%xmm11,-0x58(%r9)
+	movaps	%xmm12,-0x48(%r9)
+	movaps	%xmm13,-0x38(%r9)
+	movaps	%xmm14,-0x28(%r9)
+	movaps	%xmm15,-0x18(%r9)
+___
+}
+
+sub win64_epilogue {
+	return "" if (!$win64);
+	return <<___;
+	movaps	-0xa8(%r9),%xmm6
+	movaps	-0x98(%r9),%xmm7
+	movaps	-0x88(%r9),%xmm8
+	movaps	-0x78(%r9),%xmm9
+	movaps	-0x68(%r9),%xmm10
+	movaps	-0x58(%r9),%xmm11
+	movaps	-0x48(%r9),%xmm12
+	movaps	-0x38(%r9),%xmm13
+	movaps	-0x28(%r9),%xmm14
+	movaps	-0x18(%r9),%xmm15
+___
+}
+
+$code.=<<___;
+.text
+
+.extern	OPENSSL_ia32cap_P
+
+.globl	blake2_x86_64_caps
+.type	blake2_x86_64_caps,\@abi-omnipotent
+.align	32
+blake2_x86_64_caps:
+.cfi_startproc
+	mov	OPENSSL_ia32cap_P+4(%rip),%r10
+	xor	%eax,%eax
+	bt	\$19,%r10			# SSE4.1
+	jnc	.Lcaps_done
+	or	\$1,%eax
+___
+$code.=<<___	if ($avx>1);
+	bt	\$37,%r10			# AVX2
+	jnc	.Lcaps_done
+	or	\$2,%eax
+___
+$code.=<<___	if ($avx>2);
+	test	%r10,%r10			# AVX512VL
+	jns	.Lcaps_done
+	or	\$4,%eax
+___
+$code.=<<___;
+.Lcaps_done:
+	ret
+.cfi_endproc
+.size	blake2_x86_64_caps,.-blake2_x86_64_caps
+___
+
+######################################################################
+# Single stream, one row of the state matrix per register.
+#
+# Emits one round; $w is "q" or "d", @rot are the G rotation amounts,
+# $vl selects vprorq/vprord over shuffles and shifts and $vex selects
+# three operand AVX encoding over SSE.
+sub row_round {
+my ($r,$w,$vex,$vl,$rows,$msg,$tmp,$masks,$rot) = @_;
+my ($a,$b,$c,$d) = @$rows;
+my @m = @$msg;
+my @s = @{$sigma[$r]};
+my $code = "";
+
+	# Gather the message words of the round, m[0..1] for the column
+	# step and m[2..3] for the diagonal one.
+	for (my $k = 0; $k < 4; $k++) {
+	    my @idx = map($s[8*int($k/2) + ($k%2) + 2*$_], (0..3));
+	    my $x = $m[$k];
+	    if ($w eq "q") {
+		my $t = $tmp->[$k%2];
+		(my $xx = $x) =~ s/%ymm/%xmm/;
+		(my $tx = $t) =~ s/%ymm/%xmm/;
+		$code.=<<___;
+	vmovq		`8*$idx[0]`($inp),$xx
+	vpinsrq		\$1,`8*$idx[1]`($inp),$xx,$xx
+	vmovq		`8*$idx[2]`($inp),$tx
+	vpinsrq		\$1,`8*$idx[3]`($inp),$tx,$tx
+	vinserti128	\$1,$tx,$x,$x
+___
+	    } elsif ($vex) {
+		$code.="	vmovd		`4*$idx[0]`($inp),$x\n";
+		for (my $i = 1; $i < 4; $i++) {
+		    $code.="	vpinsrd		\$$i,`4*$idx[$i]`($inp),$x,$x\n";
+		}
+	    } else {
+		$code.="	movd		`4*$idx[0]`($inp),$x\n";
+		for (my $i = 1; $i < 4; $i++) {
+		    $code.="	pinsrd		\$$i,`4*$idx[$i]`($inp),$x\n";
+		}
+	    }
+	}
+
+	my $add = sub {
+	    my ($src,$dst) = @_;
+	    return $vex ? "	vpadd$w		$src,$dst,$dst\n"
+			: "	padd$w		$src,$dst\n";
+	};
+	my $xor = sub {
+	    my ($src,$dst) = @_;
+	    return $vex ? "	vpxor		$src,$dst,$dst\n"
+			: "	pxor		$src,$dst\n";
+	};
+	my $ror = sub {
+	    my ($n,$x) = @_;
+	    my $bits = $w eq "q" ? 64 : 32;
+	    my $t = $tmp->[0];
+
+	    return "	vpror$w		\$$n,$x,$x\n"	if ($vl);
+	    return "	vpshufd		\$0xb1,$x,$x\n"	if ($n == 32);
+	    if (defined($masks->{$n})) {
+		return $vex ? "	vpshufb		$masks->{$n},$x,$x\n"
+			    : "	pshufb		$masks->{$n},$x\n";
+	    }
+	    if ($n == 63) {
+		return <<___;
+	vpaddq		$x,$x,$t
+	vpsrlq		\$63,$x,$x
+	vpor		$t,$x,$x
+___
+	    }
+	    return <<___;
+	movdqa		$x,$t
+	psrld		\$$n,$x
+	pslld		\$`$bits-$n`,$t
+	por		$t,$x
+___
+	};
+	my $perm = sub {
+	    my ($imm,$x) = @_;
+	    return $w eq "q" ? "	vpermq		\$$imm,$x,$x\n"
+			     : $vex ? "	vpshufd		\$$imm,$x,$x\n"
+				    : "	pshufd		\$$imm,$x,$x\n";
+	};
+
+	for (my $step = 0; $step < 2; $step++) {
+	    my ($mx,$my) = @m[2*$step,2*$step+1];
+
+	    $code.=&$add($mx,$a).&$add($b,$a).&$xor($a,$d).&$ror($rot->[0],$d);
+	    $code.=&$add($d,$c).&$xor($c,$b).&$ror($rot->[1],$b);
+	    $code.=&$add($my,$a).&$add($b,$a).&$xor($a,$d).&$ror($rot->[2],$d);
+	    $code.=&$add($d,$c).&$xor($c,$b).&$ror($rot->[3],$b);
+	    if ($step == 0) {		# diagonalize
+		$code.=&$perm("0x39",$b).&$perm("0x4e",$c).&$perm("0x93",$d);
+	    } else {			# and back
+		$code.=&$perm("0x93",$b).&$perm("0x4e",$c).&$perm("0x39",$d);
+	    }
+	}
+
+	return $code;
+}
+
+{
+my @rows = map("%ymm$_",(0..3));
+my @msg = map("%ymm$_",(4..7));
+my @tmp = ("%ymm8","%ymm9");
+my %masks = (24 => "%ymm10", 16 => "%ymm11");
+my ($h0,$h1,$iv0,$iv1) = map("%ymm$_",(12..15));
+my ($t0,$t1,$inc) = ("%r10","%r11","%r8");
+
+# Emits the whole block loop of blake2b_compress_avx2
+sub blake2b_loop {
+my ($vl,$label) = @_;
+my $code = "";
+
+	$code.=<<___;
+.align	32
+$label:
+	add		$inc,$t0
+	adc		\$0,$t1
+	vmovdqa		$h0,$rows[0]
+	vmovdqa		$h1,$rows[1]
+	vmovdqa		$iv0,$rows[2]
+	vmovq		$t0,%xmm8
+	vpinsrq		\$1,$t1,%xmm8,%xmm8
+	vpxor		%ymm8,$iv1,$rows[3]
+___
+	for (my $r = 0; $r < 12; $r++) {
+	    $code.=row_round($r,"q",1,$vl,\@rows,\@msg,\@tmp,\%masks,
+			     [32,24,16,63]);
+	}
+	$code.=<<___;
+	vpxor		$rows[2],$rows[0],$rows[0]
+	vpxor		$rows[3],$rows[1],$rows[1]
+	vpxor		$rows[0],$h0,$h0
+	vpxor		$rows[1],$h1,$h1
+	add		$inc,$inp
+	sub		$inc,$len
+	jnz		$label
+___
+	return $code;
+}
+
+if ($avx>1) {
+$code.=<<___;
+.globl	blake2b_compress_avx2
+.type	blake2b_compress_avx2,\@function,3
+.align	32
+blake2b_compress_avx2:
+.cfi_startproc
+	mov	%rsp,%r9			# frame register
+.cfi_def_cfa_register	%r9
+___
+$code.=win64_prologue();
+$code.=<<___;
+.Lb2b_body:
+	vmovdqu		0($ctx),$h0
+	vmovdqu		32($ctx),$h1
+	mov		64($ctx),$t0
+	mov		72($ctx),$t1
+	vmovdqa		.Lblake2b_iv(%rip),$iv0
+	vmovdqu		80($ctx),%xmm8		# f[0..1]
+	vpxor		%xmm9,%xmm9,%xmm9
+	vinserti128	\$1,%xmm8,%ymm9,%ymm8
+	vpxor		.Lblake2b_iv+32(%rip),%ymm8,$iv1
+
+	mov		\$128,$inc		# bytes per block, fewer for
+	cmp		$inc,$len		# the final one
+	cmovb		$len,$inc
+___
+$code.=<<___	if ($avx>2);
+	mov		OPENSSL_ia32cap_P+4(%rip),%rax
+	test		%rax,%rax		# AVX512VL
+	js		.Lb2b_vl
+___
+$code.=<<___;
+	vmovdqa		.Lrot24q(%rip),$masks{24}
+	vmovdqa		.Lrot16q(%rip),$masks{16}
+___
+$code.=blake2b_loop(0,".Loop_b2b_avx2");
+$code.=<<___	if ($avx>2);
+	jmp		.Lb2b_done
+___
+$code.=blake2b_loop(1,".Lb2b_vl") if ($avx>2);
+$code.=<<___;
+.Lb2b_done:
+	vmovdqu		$h0,0($ctx)
+	vmovdqu		$h1,32($ctx)
+	mov		$t0,64($ctx)
+	mov		$t1,72($ctx)
+	vzeroall
+___
+$code.=win64_epilogue();
+$code.=<<___;
+	lea	(%r9),%rsp
+.cfi_def_cfa_register	%rsp
+.Lb2b_epilogue:
+	ret
+.cfi_endproc
+.size	blake2b_compress_avx2,.-blake2b_compress_avx2
+___
+} else {
+$code.=<<___;
+.globl	blake2b_compress_avx2
+.type	blake2b_compress_avx2,\@abi-omnipotent
+blake2b_compress_avx2:
+.cfi_startproc
+	.byte	0x0f,0x0b	# ud2
+	ret
+.cfi_endproc
+.size	blake2b_compress_avx2,.-blake2b_compress_avx2
+___
+}
+}
+
+{
+my ($t,$inc) = ("%r10","%r8");
+
+# Emits the whole block loop of blake2s_compress_sse41
+sub blake2s_loop {
+my ($vex,$label) = @_;
+my @rows = map("%xmm$_",(0..3));
+my @msg = map("%xmm$_",(4..7));
+my @tmp = ("%xmm8","%xmm9");
+my %masks = (16 => "%xmm10", 8 => "%xmm11");
+my ($h0,$h1,$iv0,$iv1) = map("%xmm$_",(12..15));
+my $code = "";
+
+	$code.=<<___;
+.align	32
+$label:
+	add		$inc,$t
+___
+	if ($vex) {
+	    $code.=<<___;
+	vmovq		$t,%xmm8
+	vmovdqa		$h0,$rows[0]
+	vmovdqa		$h1,$rows[1]
+	vmovdqa		$iv0,$rows[2]
+	vpxor		%xmm8,$iv1,$rows[3]
+___
+	} else {
+	    $code.=<<___;
+	movq		$t,%xmm8
+	movdqa		$h0,$rows[0]
+	movdqa		$h1,$rows[1]
+	movdqa		$iv0,$rows[2]
+	movdqa		$iv1,$rows[3]
+	pxor		%xmm8,$rows[3]
+___
+	}
+	for (my $r = 0; $r < 10; $r++) {
+	    $code.=row_round($r,"d",$vex,$vex,\@rows,\@msg,\@tmp,\%masks,
+			     [16,12,8,7]);
+	}
+	if ($vex) {
+	    $code.=<<___;
+	vpxor		$rows[2],$rows[0],$rows[0]
+	vpxor		$rows[3],$rows[1],$rows[1]
+	vpxor		$rows[0],$h0,$h0
+	vpxor		$rows[1],$h1,$h1
+___
+	} else {
+	    $code.=<<___;
+	pxor		$rows[2],$rows[0]
+	pxor		$rows[3],$rows[1]
+	pxor		$rows[0],$h0
+	pxor		$rows[1],$h1
+___
+	}
+	$code.=<<___;
+	add		$inc,$inp
+	sub		$inc,$len
+	jnz		$label
+___
+	return $code;
+}
+
+$code.=<<___;
+.globl	blake2s_compress_sse41
+.type	blake2s_compress_sse41,\@function,3
+.align	32
+blake2s_compress_sse41:
+.cfi_startproc
+	mov	%rsp,%r9			# frame register
+.cfi_def_cfa_register	%r9
+___
+$code.=win64_prologue();
+$code.=<<___;
+.Lb2s_body:
+	movdqu		0($ctx),%xmm12		# h[0..3]
+	movdqu		16($ctx),%xmm13		# h[4..7]
+	mov		32($ctx),$t		# t[0..1] as one counter
+	movdqa		.Lblake2s_iv(%rip),%xmm14
+	movq		40($ctx),%xmm8		# f[0..1]
+	pslldq		\$8,%xmm8
+	movdqa		.Lblake2s_iv+16(%rip),%xmm15
+	pxor		%xmm8,%xmm15
+
+	mov		\$64,$inc		# bytes per block, fewer for
+	cmp		$inc,$len		# the final one
+	cmovb		$len,$inc
+___
+$code.=<<___	if ($avx>2);
+	mov		OPENSSL_ia32cap_P+4(%rip),%rax
+	test		%rax,%rax		# AVX512VL
+	js		.Lb2s_vl
+___
+$code.=<<___;
+	movdqa		.Lrot16d(%rip),%xmm10
+	movdqa		.Lrot8d(%rip),%xmm11
+___
+$code.=blake2s_loop(0,".Loop_b2s_sse41");
+$code.=<<___	if ($avx>2);
+	jmp		.Lb2s_done
+___
+$code.=blake2s_loop(1,".Lb2s_vl") if ($avx>2);
+$code.=<<___;
+.Lb2s_done:
+	movdqu		%xmm12,0($ctx)
+	movdqu		%xmm13,16($ctx)
+	mov		$t,32($ctx)
+	pxor		%xmm0,%xmm0		# wipe the state copies
+	pxor		%xmm1,%xmm1
+	pxor		%xmm2,%xmm2
+	pxor		%xmm3,%xmm3
+	pxor		%xmm12,%xmm12
+	pxor		%xmm13,%xmm13
+___
+$code.=win64_epilogue();
+$code.=<<___;
+	lea	(%r9),%rsp
+.cfi_def_cfa_register	%rsp
+.Lb2s_epilogue:
+	ret
+.cfi_endproc
+.size	blake2s_compress_sse41,.-blake2s_compress_sse41
+___
+}
+
+######################################################################
+# Multiple leaves, word i of every leaf in register i.
+#
+# The state v[0..15] lives in ymm16-31 and the message words m[0..15]
+# of the current block of every leaf in ymm0-15, so the rounds need no
+# temporaries at all.
+{
+my @v = map("%ymm$_",(16..31));
+my @m = map("%ymm$_",(0..15));
+
+# Emits one round of G functions, interleaving the four independent ones
+# of each half round instruction by instruction.
+sub lane_round {
+my ($r,$w,$rot) = @_;
+my @s = @{$sigma[$r]};
+my $code = "";
+
+	for (my $half = 0; $half < 2; $half++) {
+	    my @g;
+
+	    for (my $i = 0; $i < 4; $i++) {
+		my @abcd = $half == 0
+			   ? ($i, 4+$i, 8+$i, 12+$i)
+			   : ($i, 4+($i+1)%4, 8+($i+2)%4, 12+($i+3)%4);
+		my $gi = 4*$half + $i;
+
+		push @g, [ @v[@abcd], $m[$s[2*$gi]], $m[$s[2*$gi+1]] ];
+	    }
+	    for (my $step = 0; $step < 2; $step++) {
+		my @ops = (
+		    sub { my ($a,$b,$c,$d,$x,$y) = @_;
+			  "	vpadd$w		".($step ? $y : $x).",$a,$a\n" },
+		    sub { my ($a,$b,$c,$d) = @_; "	vpadd$w		$b,$a,$a\n" },
+		    sub { my ($a,$b,$c,$d) = @_; "	vpxor$w		$a,$d,$d\n" },
+		    sub { my ($a,$b,$c,$d) = @_;
+			  "	vpror$w		\$$rot->[2*$step],$d,$d\n" },
+		    sub { my ($a,$b,$c,$d) = @_; "	vpadd$w		$d,$c,$c\n" },
+		    sub { my ($a,$b,$c,$d) = @_; "	vpxor$w		$c,$b,$b\n" },
+		    sub { my ($a,$b,$c,$d) = @_;
+			  "	vpror$w		\$$rot->[2*$step+1],$b,$b\n" } );
+
+		foreach my $op (@ops) {
+		    foreach my $g (@g) {
+			$code.=&$op(@$g);
+		    }
+		}
+	    }
+	}
+
+	return $code;
+}
+
+# Transposes the message words of four BLAKE2b blocks 128 bytes apart
+sub transpose_x4 {
+my $code = "";
+
+	for (my $k = 0; $k < 4; $k++) {
+	    for (my $j = 0; $j < 4; $j++) {
+		$code.="	vmovdqu64	".(128*$j+32*$k)."($len),$v[$j]\n";
+	    }
+	    $code.=<<___;
+	vpunpcklqdq	$v[1],$v[0],$v[4]
+	vpunpckhqdq	$v[1],$v[0],$v[5]
+	vpunpcklqdq	$v[3],$v[2],$v[6]
+	vpunpckhqdq	$v[3],$v[2],$v[7]
+	vshufi64x2	\$0,$v[6],$v[4],$m[4*$k]
+	vshufi64x2	\$0,$v[7],$v[5],$m[4*$k+1]
+	vshufi64x2	\$3,$v[6],$v[4],$m[4*$k+2]
+	vshufi64x2	\$3,$v[7],$v[5],$m[4*$k+3]
+___
+	}
+	return $code;
+}
+
+# Transposes the message words of eight BLAKE2s blocks 64 bytes apart
+sub transpose_x8 {
+my $code = "";
+
+	for (my $k = 0; $k < 2; $k++) {
+	    for (my $j = 0; $j < 8; $j++) {
+		$code.="	vmovdqu32	".(64*$j+32*$k)."($len),$v[$j]\n";
+	    }
+	    for (my $j = 0; $j < 8; $j += 2) {
+		$code.=<<___;
+	vpunpckldq	$v[$j+1],$v[$j],$v[8+$j]
+	vpunpckhdq	$v[$j+1],$v[$j],$v[9+$j]
+___
+	    }
+	    for (my $j = 0; $j < 8; $j += 4) {
+		$code.=<<___;
+	vpunpcklqdq	$v[10+$j],$v[8+$j],$v[$j]
+	vpunpckhqdq	$v[10+$j],$v[8+$j],$v[1+$j]
+	vpunpcklqdq	$v[11+$j],$v[9+$j],$v[2+$j]
+	vpunpckhqdq	$v[11+$j],$v[9+$j],$v[3+$j]
+___
+	    }
+	    for (my $j = 0; $j < 4; $j++) {
+		$code.=<<___;
+	vshufi32x4	\$0,$v[4+$j],$v[$j],$m[8*$k+$j]
+	vshufi32x4	\$3,$v[4+$j],$v[$j],$m[8*$k+4+$j]
+___
+	    }
+	}
+	return $code;
+}
+
+# Emits blake2b_compress_x4 or blake2s_compress_x8
+sub lanes_function {
+my ($name,$w,$lanes,$rounds,$bsz,$rot) = @_;
+my ($t0,$t1) = ("%r10","%r11");
+my $iv = $w eq "q" ? ".Lblake2b_iv" : ".Lblake2s_iv";
+my $sz = $w eq "q" ? 8 : 4;
+my $mov = $w eq "q" ? "vmovdqu64" : "vmovdqu32";
+my $code = "";
+
+	$code.=<<___;
+.globl	$name
+.type	$name,\@function,4
+.align	32
+$name:
+.cfi_startproc
+	mov	%rsp,%r9			# frame register
+.cfi_def_cfa_register	%r9
+___
+	$code.=win64_prologue();
+	$code.=<<___;
+.L${name}_body:
+___
+	if ($w eq "q") {
+	    $code.=<<___;
+	mov		0($inp),$t0
+	mov		8($inp),$t1
+___
+	} else {
+	    $code.=<<___;
+	mov		0($inp),$t0		# t[0..1] as one counter
+___
+	}
+	$code.=<<___;
+	jmp		.Loop_$name
+
+.align	32
+.Loop_$name:
+___
+	$code.=$w eq "q" ? transpose_x4() : transpose_x8();
+	if ($w eq "q") {
+	    $code.=<<___;
+	add		\$$bsz,$t0
+	adc		\$0,$t1
+	mov		$iv+32(%rip),%rax
+	xor		$t0,%rax
+	vpbroadcastq	%rax,$v[12]
+	mov		$iv+40(%rip),%rax
+	xor		$t1,%rax
+	vpbroadcastq	%rax,$v[13]
+___
+	} else {
+	    $code.=<<___;
+	add		\$$bsz,$t0
+	mov		$t0,$t1
+	shr		\$32,$t1
+	mov		$iv+16(%rip),%eax
+	xor		%r10d,%eax
+	vpbroadcastd	%eax,$v[12]
+	mov		$iv+20(%rip),%eax
+	xor		%r11d,%eax
+	vpbroadcastd	%eax,$v[13]
+___
+	}
+	for (my $i = 0; $i < 8; $i++) {
+	    $code.="	$mov	".(32*$i)."($ctx),$v[$i]\n";
+	}
+	foreach my $i (8..11,14,15) {
+	    $code.="	vpbroadcast$w	$iv+".($sz*($i-8))."(%rip),$v[$i]\n";
+	}
+	for (my $r = 0; $r < $rounds; $r++) {
+	    $code.=lane_round($r,$w,$rot);
+	}
+	for (my $i = 0; $i < 8; $i++) {
+	    $code.=<<___;
+	vpternlog$w	\$0x96,`32*$i`($ctx),$v[$i+8],$v[$i]
+	$mov	$v[$i],`32*$i`($ctx)
+___
+	}
+	$code.=<<___;
+	lea		512($len),$len
+	dec		$num
+	jnz		.Loop_$name
+
+___
+	if ($w eq "q") {
+	    $code.=<<___;
+	mov		$t0,0($inp)
+	mov		$t1,8($inp)
+___
+	} else {
+	    $code.=<<___;
+	mov		$t0,0($inp)
+___
+	}
+	$code.="	vzeroall\n";
+	$code.=win64_epilogue();
+	$code.=<<___;
+	lea	(%r9),%rsp
+.cfi_def_cfa_register	%rsp
+.L${name}_epilogue:
+	ret
+.cfi_endproc
+.size	$name,.-$name
+___
+	return $code;
+}
+
+if ($avx>2) {
+$code.=lanes_function("blake2b_compress_x4","q",4,12,128,[32,24,16,63]);
+$code.=lanes_function("blake2s_compress_x8","d",8,10,64,[16,12,8,7]);
+} else {
+foreach my $name ("blake2b_compress_x4","blake2s_compress_x8") {
+$code.=<<___;
+.globl	$name
+.type	$name,\@abi-omnipotent
+$name:
+.cfi_startproc
+	.byte	0x0f,0x0b	# ud2
+	ret
+.cfi_endproc
+.size	$name,.-$name
+___
+}
+}
+}
+
+$code.=<<___;
+.align	64
+.Lblake2b_iv:
+	.quad	0x6a09e667f3bcc908,0xbb67ae8584caa73b
+	.quad	0x3c6ef372fe94f82b,0xa54ff53a5f1d36f1
+	.quad	0x510e527fade682d1,0x9b05688c2b3e6c1f
+	.quad	0x1f83d9abfb41bd6b,0x5be0cd19137e2179
+.Lblake2s_iv:
+	.long	0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a
+	.long	0x510e527f,0x9b05688c,0x1f83d9ab,0x5be0cd19
+.Lrot24q:
+	.byte	3,4,5,6,7,0,1,2,11,12,13,14,15,8,9,10
+	.byte	3,4,5,6,7,0,1,2,11,12,13,14,15,8,9,10
+.Lrot16q:
+	.byte	2,3,4,5,6,7,0,1,10,11,12,13,14,15,8,9
+	.byte	2,3,4,5,6,7,0,1,10,11,12,13,14,15,8,9
+.Lrot16d:
+	.byte	2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13
+.Lrot8d:
+	.byte	1,2,3,0,5,6,7,4,9,10,11,8,13,14,15,12
+___
+
+# EXCEPTION_DISPOSITION handler (EXCEPTION_RECORD *rec,ULONG64 frame,
+#		CONTEXT *context,DISPATCHER_CONTEXT *disp)
+if ($win64) {
+$rec="%rcx";
+$frame="%rdx";
+$context="%r8";
+$disp="%r9";
+
+$code.=<<___;
+.extern	__imp_RtlVirtualUnwind
+.type	simd_handler,\@abi-omnipotent
+.align	16
+simd_handler:
+	push	%rsi
+	push	%rdi
+	push	%rbx
+	push	%rbp
+	push	%r12
+	push	%r13
+	push	%r14
+	push	%r15
+	pushfq
+	sub	\$64,%rsp
+
+	mov	120($context),%rax	# pull context->Rax
+	mov	248($context),%rbx	# pull context->Rip
+
+	mov	8($disp),%rsi		# disp->ImageBase
+	mov	56($disp),%r11		# disp->HandlerData
+
+	mov	0(%r11),%r10d		# HandlerData[0]
+	lea	(%rsi,%r10),%r10	# prologue label
+	cmp	%r10,%rbx		# context->Rip<prologue label
+	jb	.Lcommon_seh_tail
+
+	mov	192($context),%rax	# pull context->R9
+
+	mov	4(%r11),%r10d		# HandlerData[1]
+	lea	(%rsi,%r10),%r10	# epilogue label
+	cmp	%r10,%rbx		# context->Rip>=epilogue label
+	jae	.Lcommon_seh_tail
+
+	lea	-0xa8(%rax),%rsi
+	lea	512($context),%rdi	# &context.Xmm6
+	mov	\$20,%ecx
+	.long	0xa548f3fc		# cld; rep movsq
+
+.Lcommon_seh_tail:
+	mov	8(%rax),%rdi
+	mov	16(%rax),%rsi
+	mov	%rax,152($context)	# restore context->Rsp
+	mov	%rsi,168($context)	# restore context->Rsi
+	mov	%rdi,176($context)	# restore context->Rdi
+
+	mov	40($disp),%rdi		# disp->ContextRecord
+	mov	$context,%rsi		# context
+	mov	\$154,%ecx		# sizeof(CONTEXT)
+	.long	0xa548f3fc		# cld; rep movsq
+
+	mov	$disp,%rsi
+	xor	%rcx,%rcx		# arg1, UNW_FLAG_NHANDLER
+	mov	8(%rsi),%rdx		# arg2, disp->ImageBase
+	mov	0(%rsi),%r8		# arg3, disp->ControlPc
+	mov	16(%rsi),%r9		# arg4, disp->FunctionEntry
+	mov	40(%rsi),%r10		# disp->ContextRecord
+	lea	56(%rsi),%r11		# &disp->HandlerData
+	lea	24(%rsi),%r12		# &disp->EstablisherFrame
+	mov	%r10,32(%rsp)		# arg5
+	mov	%r11,40(%rsp)		# arg6
+	mov	%r12,48(%rsp)		# arg7
+	mov	%rcx,56(%rsp)		# arg8, (NULL)
+	call	*__imp_RtlVirtualUnwind(%rip)
+
+	mov	\$1,%eax		# ExceptionContinueSearch
+	add	\$64,%rsp
+	popfq
+	pop	%r15
+	pop	%r14
+	pop	%r13
+	pop	%r12
+	pop	%rbp
+	pop	%rbx
+	pop	%rdi
+	pop	%rsi
+	ret
+.size	simd_handler,.-simd_handler
+
+.section	.pdata
+.align	4
+___
+my @seh = (["blake2s_compress_sse41",".Lb2s_body",".Lb2s_epilogue"]);
+push @seh, ["blake2b_compress_avx2",".Lb2b_body",".Lb2b_epilogue"]
+							if ($avx>1);
+push @seh, (["blake2b_compress_x4",".Lblake2b_compress_x4_body",
+				  ".Lblake2b_compress_x4_epilogue"],
+	    ["blake2s_compress_x8",".Lblake2s_compress_x8_body",
+				  ".Lblake2s_compress_x8_epilogue"])
+							if ($avx>2);
+foreach my $f (@seh) {
+$code.=<<___;
+	.rva	.LSEH_begin_$f->[0]
+	.rva	.LSEH_end_$f->[0]
+	.rva	.LSEH_info_$f->[0]
+___
+}
+$code.=<<___;
+
+.section	.xdata
+.align	8
+___
+foreach my $f (@seh) {
+$code.=<<___;
+.LSEH_info_$f->[0]:
+	.byte	9,0,0,0
+	.rva	simd_handler
+	.rva	$f->[1],$f->[2]		# HandlerData[]
+___
+}
+}
+
+$code =~ s/\`([^\`]*)\`/eval $1/gem;
+print $code;
+close STDOUT or die "error closing STDOUT: $!";
@@ -0,0 +1,506 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+# BLAKE3 compression of eight chunks or parent nodes at once for x86_64.
+#
+# The eight inputs are hashed side by side, word i of every state in
+# register i, so that every G function is plain lane-wise arithmetic.
+# The AVX512VL flavour keeps the state in ymm16-31 and the transposed
+# message words in ymm0-15, and rotates with vprord.  The AVX2 one has
+# only sixteen registers for the state, so it keeps the message words on
+# the stack, rotates by 16 and 8 with byte shuffles and by 12 and 7 with
+# shift pairs, for which one state register is briefly spilled.
+#
+# void blake3_hash_x8_avx2(uint32_t H[8][8], uint32_t ctr[2][8],
+#                          const uint8_t *const in[8], size_t blocks,
+#                          unsigned int flags);
+# void blake3_hash_x8_avx512vl(...);
+#
+# H[i][j] is word i of the chaining value of lane j, the key on input and
+# the output CV on return.  ctr[0][j] and ctr[1][j] are the low and high
+# halves of the counter of lane j.  Every lane hashes |blocks| (> 0) whole
+# blocks at in[j].  The low byte of |flags| is used for all the blocks,
+# bits 8-15 are added for the first block and bits 16-23 for the last.
+#
+# unsigned int blake3_x86_64_caps(void) tells which of them can be used
+# on this processor, see BLAKE3_X86_64_* in prov/blake3.h.
+#
+# Performance in cycles per byte out of 64KB buffer on a 2.1GHz Skylake
+# server, C code compiled with gcc 12 -O2 for comparison.
+#
+#		BLAKE3
+# C		4.3
+# AVX2		0.97
+# AVX512VL	0.75
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+$avx=0;
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$avx = ($1>=2.19) + ($1>=2.22) + ($1>=2.25);
+}
+
+if (!$avx && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
+	   `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)(?:\.([0-9]+))?/) {
+	$avx = ($1>=2.09) + ($1>=2.10) + ($1>=2.12);
+	$avx += 1 if ($1==2.11 && $2>=8);
+}
+
+if (!$avx && $win64 && ($flavour =~ /masm/ || $ENV{ASM} =~ /ml64/) &&
+	   `ml64 2>&1` =~ /Version ([0-9]+)\./) {
+	$avx = ($1>=10) + ($1>=11);
+}
+
+if (!$avx && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$avx = ($2>=3.0) + ($2>3.0) + ($2>=3.9);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+# The message schedule, every round permutes the words of the previous one
+my @schedule = ([ 0..15 ]);
+my @perm = (2, 6, 3, 10, 7, 0, 4, 13, 1, 11, 12, 5, 9, 14, 15, 8);
+for (my $r = 1; $r < 7; $r++) {
+	push @schedule, [ map { $schedule[$r-1][$_] } @perm ];
+}
+
+my ($H,$ctr,$inp,$blocks,$flags) = ("%rdi","%rsi","%rdx","%rcx","%r8");
+my ($off,$fl) = ("%r10","%r11d");
+
+# Save and restore of the non-volatile xmm6-15 on Win64, both functions
+# use the same frame layout relative to %r9.
+sub win64_prologue {
+	return "" if (!$win64);
+	return <<___;
+	lea	-0xa8(%rsp),%rsp
+	movaps	%xmm6,-0xa8(%r9)
+	movaps	%xmm7,-0x98(%r9)
+	movaps	%xmm8,-0x88(%r9)
+	movaps	%xmm9,-0x78(%r9)
+	movaps	%xmm10,-0x68(%r9)
+	movaps	%xmm11,-0x58(%r9)
+	movaps	%xmm12,-0x48(%r9)
+	movaps	%xmm13,-0x38(%r9)
+	movaps	%xmm14,-0x28(%r9)
+	movaps	%xmm15,-0x18(%r9)
+___
+}
+
+sub win64_epilogue {
+	return "" if (!$win64);
+	return <<___;
+	movaps	-0xa8(%r9),%xmm6
+	movaps	-0x98(%r9),%xmm7
+	movaps	-0x88(%r9),%xmm8
+	movaps	-0x78(%r9),%xmm9
+	movaps	-0x68(%r9),%xmm10
+	movaps	-0x58(%r9),%xmm11
+	movaps	-0x48(%r9),%xmm12
+	movaps	-0x38(%r9),%xmm13
+	movaps	-0x28(%r9),%xmm14
+	movaps	-0x18(%r9),%xmm15
+___
+}
+
+$code.=<<___;
+.text
+
+.extern	OPENSSL_ia32cap_P
+
+.globl	blake3_x86_64_caps
+.type	blake3_x86_64_caps,\@abi-omnipotent
+.align	32
+blake3_x86_64_caps:
+.cfi_startproc
+	mov	OPENSSL_ia32cap_P+4(%rip),%r10
+	xor	%eax,%eax
+___
+$code.=<<___	if ($avx>1);
+	bt	\$37,%r10			# AVX2
+	jnc	.Lcaps_done
+	or	\$1,%eax
+___
+$code.=<<___	if ($avx>2);
+	test	%r10,%r10			# AVX512VL
+	jns	.Lcaps_done
+	or	\$2,%eax
+___
+$code.=<<___;
+.Lcaps_done:
+	ret
+.cfi_endproc
+.size	blake3_x86_64_caps,.-blake3_x86_64_caps
+___
+
+# Emits one round of G functions, interleaving the four independent ones
+# of each half round instruction by instruction.  @$v is the state and
+# @$m the message words, registers or stack slots.
+sub lane_round {
+my ($r,$vl,$v,$m) = @_;
+my @s = @{$schedule[$r]};
+my $spill = "16*32(%rsp)";
+my $code = "";
+
+	for (my $half = 0; $half < 2; $half++) {
+	    my @g;
+
+	    for (my $i = 0; $i < 4; $i++) {
+		my @abcd = $half == 0
+			   ? ($i, 4+$i, 8+$i, 12+$i)
+			   : ($i, 4+($i+1)%4, 8+($i+2)%4, 12+($i+3)%4);
+		my $gi = 4*$half + $i;
+
+		push @g, [ @$v[@abcd], $m->[$s[2*$gi]], $m->[$s[2*$gi+1]] ];
+	    }
+	    for (my $step = 0; $step < 2; $step++) {
+		my ($rd,$rb) = $step ? (8,7) : (16,12);
+		my @ops = (
+		    sub { my ($a,$b,$c,$d,$x,$y) = @_;
+			  "	vpaddd		".($step ? $y : $x).",$a,$a\n" },
+		    sub { my ($a,$b,$c,$d) = @_; "	vpaddd		$b,$a,$a\n" },
+		    sub { my ($a,$b,$c,$d) = @_; "	vpxor".($vl?"d":"")."		$a,$d,$d\n" },
+		    sub { my ($a,$b,$c,$d) = @_;
+			  $vl ? "	vprord		\$$rd,$d,$d\n"
+			      : "	vpshufb		.Lrot$rd(%rip),$d,$d\n" },
+		    sub { my ($a,$b,$c,$d) = @_; "	vpaddd		$d,$c,$c\n" },
+		    sub { my ($a,$b,$c,$d) = @_; "	vpxor".($vl?"d":"")."		$c,$b,$b\n" } );
+
+		foreach my $op (@ops) {
+		    foreach my $g (@g) {
+			$code.=&$op(@$g);
+		    }
+		}
+		if ($vl) {
+		    foreach my $g (@g) {
+			$code.="	vprord		\$$rb,$g->[1],$g->[1]\n";
+		    }
+		} else {
+		    # None of the b words is the spilled one, $v->[8]
+		    my $t = $v->[8];
+
+		    $code.="	vmovdqa		$t,$spill\n";
+		    foreach my $g (@g) {
+			my $b = $g->[1];
+
+			$code.=<<___;
+	vpsrld		\$$rb,$b,$t
+	vpslld		\$`32-$rb`,$b,$b
+	vpor		$t,$b,$b
+___
+		    }
+		    $code.="	vmovdqa		$spill,$t\n";
+		}
+	    }
+	}
+
+	return $code;
+}
+
+# Transposes the current block of the eight inputs into @$m, with @$t
+# (sixteen registers) as temporaries.  Stack slots in @$m are written to
+# from the temporaries.
+sub transpose_x8 {
+my ($vl,$t,$m) = @_;
+my $mov = $vl ? "vmovdqu32" : "vmovdqu";
+my $code = "";
+
+	for (my $k = 0; $k < 2; $k++) {
+	    for (my $j = 0; $j < 8; $j++) {
+		$code.=<<___;
+	mov		`8*$j`($inp),%rax
+	$mov	`32*$k`(%rax,$off),$t->[$j]
+___
+	    }
+	    for (my $j = 0; $j < 8; $j += 2) {
+		$code.=<<___;
+	vpunpckldq	$t->[$j+1],$t->[$j],$t->[8+$j]
+	vpunpckhdq	$t->[$j+1],$t->[$j],$t->[9+$j]
+___
+	    }
+	    for (my $j = 0; $j < 8; $j += 4) {
+		$code.=<<___;
+	vpunpcklqdq	$t->[10+$j],$t->[8+$j],$t->[$j]
+	vpunpckhqdq	$t->[10+$j],$t->[8+$j],$t->[1+$j]
+	vpunpcklqdq	$t->[11+$j],$t->[9+$j],$t->[2+$j]
+	vpunpckhqdq	$t->[11+$j],$t->[9+$j],$t->[3+$j]
+___
+	    }
+	    for (my $j = 0; $j < 4; $j++) {
+		if ($vl) {
+		    $code.=<<___;
+	vshufi32x4	\$0,$t->[4+$j],$t->[$j],$m->[8*$k+$j]
+	vshufi32x4	\$3,$t->[4+$j],$t->[$j],$m->[8*$k+4+$j]
+___
+		} else {
+		    $code.=<<___;
+	vperm2i128	\$0x20,$t->[4+$j],$t->[$j],$t->[8+$j]
+	vperm2i128	\$0x31,$t->[4+$j],$t->[$j],$t->[12+$j]
+	vmovdqa		$t->[8+$j],$m->[8*$k+$j]
+	vmovdqa		$t->[12+$j],$m->[8*$k+4+$j]
+___
+		}
+	    }
+	}
+	return $code;
+}
+
+sub hash_x8 {
+my ($name,$vl) = @_;
+my @v = map("%ymm$_", $vl ? (16..31) : (0..15));
+my @m = $vl ? map("%ymm$_",(0..15)) : map(32*$_."(%rsp)",(0..15));
+my @t = $vl ? @v : map("%ymm$_",(0..15));
+my $mov = $vl ? "vmovdqu32" : "vmovdqu";
+my $x = $vl ? "d" : "";
+my $code = "";
+
+	$code.=<<___;
+.globl	$name
+.type	$name,\@function,5
+.align	32
+$name:
+.cfi_startproc
+	mov	%rsp,%r9			# frame register
+.cfi_def_cfa_register	%r9
+___
+	$code.=win64_prologue();
+	$code.=<<___ if (!$vl);
+	sub	\$17*32,%rsp			# message words and a spill slot
+	and	\$-32,%rsp
+___
+	$code.=<<___;
+.L${name}_body:
+	xor		$off,$off
+	movzb		%r8b,$fl		# flags of every block
+
+.Loop_$name:
+___
+	$code.=transpose_x8($vl,\@t,\@m);
+	$code.=<<___;
+	mov		$fl,%eax
+	test		$off,$off
+	jnz		.L${name}_not_first
+	mov		%r8d,%eax
+	and		\$0xffff,%eax
+	shr		\$8,%eax
+	or		$fl,%eax
+.L${name}_not_first:
+	cmp		\$1,$blocks
+	jne		.L${name}_not_last
+	mov		%r8d,$fl
+	shr		\$16,$fl
+	or		$fl,%eax
+	movzb		%r8b,$fl
+.L${name}_not_last:
+	vpbroadcastd	%eax,$v[15]
+___
+	for (my $i = 0; $i < 8; $i++) {
+	    $code.="	$mov	".(32*$i)."($H),$v[$i]\n";
+	}
+	for (my $i = 0; $i < 4; $i++) {
+	    $code.="	vpbroadcastd	.Lblake3_iv+".(4*$i)."(%rip),$v[8+$i]\n";
+	}
+	$code.=<<___;
+	$mov	0($ctr),$v[12]
+	$mov	32($ctr),$v[13]
+	vpbroadcastd	.Lblock_len(%rip),$v[14]
+___
+	for (my $r = 0; $r < 7; $r++) {
+	    $code.=lane_round($r,$vl,\@v,\@m);
+	}
+	for (my $i = 0; $i < 8; $i++) {
+	    $code.=<<___;
+	vpxor$x		$v[$i+8],$v[$i],$v[$i]
+	$mov	$v[$i],`32*$i`($H)
+___
+	}
+	$code.=<<___;
+	lea		64($off),$off
+	dec		$blocks
+	jnz		.Loop_$name
+
+	vzeroall
+___
+	$code.=win64_epilogue();
+	$code.=<<___;
+	lea	(%r9),%rsp
+.cfi_def_cfa_register	%rsp
+.L${name}_epilogue:
+	ret
+.cfi_endproc
+.size	$name,.-$name
+___
+	return $code;
+}
+
+my @funcs;
+
+if ($avx>1) {
+$code.=hash_x8("blake3_hash_x8_avx2",0);
+push @funcs, "blake3_hash_x8_avx2";
+}
+if ($avx>2) {
+$code.=hash_x8("blake3_hash_x8_avx512vl",1);
+push @funcs, "blake3_hash_x8_avx512vl";
+}
+foreach my $name ("blake3_hash_x8_avx2","blake3_hash_x8_avx512vl") {
+next if (grep { $_ eq $name } @funcs);
+$code.=<<___;
+.globl	$name
+.type	$name,\@abi-omnipotent
+$name:
+.cfi_startproc
+	.byte	0x0f,0x0b	# ud2
+	ret
+.cfi_endproc
+.size	$name,.-$name
+___
+}
+
+$code.=<<___;
+.align	64
+.Lblake3_iv:
+	.long	0x6a09e667,0xbb67ae85,0x3c6ef372,0xa54ff53a
+.Lblock_len:
+	.long	64
+.align	32
+.Lrot16:
+	.byte	2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13
+	.byte	2,3,0,1,6,7,4,5,10,11,8,9,14,15,12,13
+.Lrot8:
+	.byte	1,2,3,0,5,6,7,4,9,10,11,8,13,14,15,12
+	.byte	1,2,3,0,5,6,7,4,9,10,11,8,13,14,15,12
+___
+
+# EXCEPTION_DISPOSITION handler (EXCEPTION_RECORD *rec,ULONG64 frame,
+#		CONTEXT *context,DISPATCHER_CONTEXT *disp)
+if ($win64) {
+$rec="%rcx";
+$frame="%rdx";
+$context="%r8";
+$disp="%r9";
+
+$code.=<<___;
+.extern	__imp_RtlVirtualUnwind
+.type	simd_handler,\@abi-omnipotent
+.align	16
+simd_handler:
+	push	%rsi
+	push	%rdi
+	push	%rbx
+	push	%rbp
+	push	%r12
+	push	%r13
+	push	%r14
+	push	%r15
+	pushfq
+	sub	\$64,%rsp
+
+	mov	120($context),%rax	# pull context->Rax
+	mov	248($context),%rbx	# pull context->Rip
+
+	mov	8($disp),%rsi		# disp->ImageBase
+	mov	56($disp),%r11		# disp->HandlerData
+
+	mov	0(%r11),%r10d		# HandlerData[0]
+	lea	(%rsi,%r10),%r10	# prologue label
+	cmp	%r10,%rbx		# context->Rip<prologue label
+	jb	.Lcommon_seh_tail
+
+	mov	192($context),%rax	# pull context->R9
+
+	mov	4(%r11),%r10d		# HandlerData[1]
+	lea	(%rsi,%r10),%r10	# epilogue label
+	cmp	%r10,%rbx		# context->Rip>=epilogue label
+	jae	.Lcommon_seh_tail
+
+	lea	-0xa8(%rax),%rsi
+	lea	512($context),%rdi	# &context.Xmm6
+	mov	\$20,%ecx
+	.long	0xa548f3fc		# cld; rep movsq
+
+.Lcommon_seh_tail:
+	mov	8(%rax),%rdi
+	mov	16(%rax),%rsi
+	mov	%rax,152($context)	# restore context->Rsp
+	mov	%rsi,168($context)	# restore context->Rsi
+	mov	%rdi,176($context)	# restore context->Rdi
+
+	mov	40($disp),%rdi		# disp->ContextRecord
+	mov	$context,%rsi		# context
+	mov	\$154,%ecx		# sizeof(CONTEXT)
+	.long	0xa548f3fc		# cld; rep movsq
+
+	mov	$disp,%rsi
+	xor	%rcx,%rcx		# arg1, UNW_FLAG_NHANDLER
+	mov	8(%rsi),%rdx		# arg2, disp->ImageBase
+	mov	0(%rsi),%r8		# arg3, disp->ControlPc
+	mov	16(%rsi),%r9		# arg4, disp->FunctionEntry
+	mov	40(%rsi),%r10		# disp->ContextRecord
+	lea	56(%rsi),%r11		# &disp->HandlerData
+	lea	24(%rsi),%r12		# &disp->EstablisherFrame
+	mov	%r10,32(%rsp)		# arg5
+	mov	%r11,40(%rsp)		# arg6
+	mov	%r12,48(%rsp)		# arg7
+	mov	%rcx,56(%rsp)		# arg8, (NULL)
+	call	*__imp_RtlVirtualUnwind(%rip)
+
+	mov	\$1,%eax		# ExceptionContinueSearch
+	add	\$64,%rsp
+	popfq
+	pop	%r15
+	pop	%r14
+	pop	%r13
+	pop	%r12
+	pop	%rbp
+	pop	%rbx
+	pop	%rdi
+	pop	%rsi
+	ret
+.size	simd_handler,.-simd_handler
+
+.section	.pdata
+.align	4
+___
+foreach my $f (@funcs) {
+$code.=<<___;
+	.rva	.LSEH_begin_$f
+	.rva	.LSEH_end_$f
+	.rva	.LSEH_info_$f
+___
+}
+$code.=<<___;
+
+.section	.xdata
+.align	8
+___
+foreach my $f (@funcs) {
+$code.=<<___;
+.LSEH_info_$f:
+	.byte	9,0,0,0
+	.rva	simd_handler
+	.rva	.L${f}_body,.L${f}_epilogue	# HandlerData[]
+___
+}
+}
+
+$code =~ s/\`([^\`]*)\`/eval $1/gem;
+print $code;
+close STDOUT or die "error closing STDOUT: $!";
@@ -1824,6 +1824,7 @@ my ($xb0,$xb1,$xb2,$xb3, $xd0,$xd1,$xd2,$xd3,
     $xa0,$xa1,$xa2,$xa3, $xt0,$xt1,$xt2,$xt3)=map("%ymm$_",(0..15));
 my @xx=($xa0,$xa1,$xa2,$xa3, $xb0,$xb1,$xb2,$xb3,
 	"%nox","%nox","%nox","%nox", $xd0,$xd1,$xd2,$xd3);
+my ($xc0,$xc1,$xc2,$xc3);
 
 sub AVX2_lane_ROUND {
 my ($a0,$b0,$c0,$d0)=@_;
@@ -1939,6 +1940,114 @@ my @x=map("\"$_\"",@xx);
 	);
 }
 
+sub AVX2_8x_feed_forward {
+# Add the input block to the state after the last round and turn the
+# lanes into consecutive 64-byte blocks, see ChaCha20_8x for the stack
+# layout.  Register names are permuted on the way, $xa0-$xd3 end up
+# holding the key stream in output order.
+$code.=<<___;
+
+	lea		0x200(%rsp),%rax	# size optimization
+	vpaddd		0x80-0x100(%rcx),$xa0,$xa0	# accumulate key
+	vpaddd		0xa0-0x100(%rcx),$xa1,$xa1
+	vpaddd		0xc0-0x100(%rcx),$xa2,$xa2
+	vpaddd		0xe0-0x100(%rcx),$xa3,$xa3
+
+	vpunpckldq	$xa1,$xa0,$xt2		# "de-interlace" data
+	vpunpckldq	$xa3,$xa2,$xt3
+	vpunpckhdq	$xa1,$xa0,$xa0
+	vpunpckhdq	$xa3,$xa2,$xa2
+	vpunpcklqdq	$xt3,$xt2,$xa1		# "a0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "a1"
+	vpunpcklqdq	$xa2,$xa0,$xa3		# "a2"
+	vpunpckhqdq	$xa2,$xa0,$xa0		# "a3"
+___
+	($xa0,$xa1,$xa2,$xa3,$xt2)=($xa1,$xt2,$xa3,$xa0,$xa2);
+$code.=<<___;
+	vpaddd		0x100-0x100(%rcx),$xb0,$xb0
+	vpaddd		0x120-0x100(%rcx),$xb1,$xb1
+	vpaddd		0x140-0x100(%rcx),$xb2,$xb2
+	vpaddd		0x160-0x100(%rcx),$xb3,$xb3
+
+	vpunpckldq	$xb1,$xb0,$xt2
+	vpunpckldq	$xb3,$xb2,$xt3
+	vpunpckhdq	$xb1,$xb0,$xb0
+	vpunpckhdq	$xb3,$xb2,$xb2
+	vpunpcklqdq	$xt3,$xt2,$xb1		# "b0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "b1"
+	vpunpcklqdq	$xb2,$xb0,$xb3		# "b2"
+	vpunpckhqdq	$xb2,$xb0,$xb0		# "b3"
+___
+	($xb0,$xb1,$xb2,$xb3,$xt2)=($xb1,$xt2,$xb3,$xb0,$xb2);
+$code.=<<___;
+	vperm2i128	\$0x20,$xb0,$xa0,$xt3	# "de-interlace" further
+	vperm2i128	\$0x31,$xb0,$xa0,$xb0
+	vperm2i128	\$0x20,$xb1,$xa1,$xa0
+	vperm2i128	\$0x31,$xb1,$xa1,$xb1
+	vperm2i128	\$0x20,$xb2,$xa2,$xa1
+	vperm2i128	\$0x31,$xb2,$xa2,$xb2
+	vperm2i128	\$0x20,$xb3,$xa3,$xa2
+	vperm2i128	\$0x31,$xb3,$xa3,$xb3
+___
+	($xa0,$xa1,$xa2,$xa3,$xt3)=($xt3,$xa0,$xa1,$xa2,$xa3);
+	($xc0,$xc1,$xc2,$xc3)=($xt0,$xt1,$xa0,$xa1);
+$code.=<<___;
+	vmovdqa		$xa0,0x00(%rsp)		# offload $xaN
+	vmovdqa		$xa1,0x20(%rsp)
+	vmovdqa		0x40(%rsp),$xc2		# $xa0
+	vmovdqa		0x60(%rsp),$xc3		# $xa1
+
+	vpaddd		0x180-0x200(%rax),$xc0,$xc0
+	vpaddd		0x1a0-0x200(%rax),$xc1,$xc1
+	vpaddd		0x1c0-0x200(%rax),$xc2,$xc2
+	vpaddd		0x1e0-0x200(%rax),$xc3,$xc3
+
+	vpunpckldq	$xc1,$xc0,$xt2
+	vpunpckldq	$xc3,$xc2,$xt3
+	vpunpckhdq	$xc1,$xc0,$xc0
+	vpunpckhdq	$xc3,$xc2,$xc2
+	vpunpcklqdq	$xt3,$xt2,$xc1		# "c0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "c1"
+	vpunpcklqdq	$xc2,$xc0,$xc3		# "c2"
+	vpunpckhqdq	$xc2,$xc0,$xc0		# "c3"
+___
+	($xc0,$xc1,$xc2,$xc3,$xt2)=($xc1,$xt2,$xc3,$xc0,$xc2);
+$code.=<<___;
+	vpaddd		0x200-0x200(%rax),$xd0,$xd0
+	vpaddd		0x220-0x200(%rax),$xd1,$xd1
+	vpaddd		0x240-0x200(%rax),$xd2,$xd2
+	vpaddd		0x260-0x200(%rax),$xd3,$xd3
+
+	vpunpckldq	$xd1,$xd0,$xt2
+	vpunpckldq	$xd3,$xd2,$xt3
+	vpunpckhdq	$xd1,$xd0,$xd0
+	vpunpckhdq	$xd3,$xd2,$xd2
+	vpunpcklqdq	$xt3,$xt2,$xd1		# "d0"
+	vpunpckhqdq	$xt3,$xt2,$xt2		# "d1"
+	vpunpcklqdq	$xd2,$xd0,$xd3		# "d2"
+	vpunpckhqdq	$xd2,$xd0,$xd0		# "d3"
+___
+	($xd0,$xd1,$xd2,$xd3,$xt2)=($xd1,$xt2,$xd3,$xd0,$xd2);
+$code.=<<___;
+	vperm2i128	\$0x20,$xd0,$xc0,$xt3	# "de-interlace" further
+	vperm2i128	\$0x31,$xd0,$xc0,$xd0
+	vperm2i128	\$0x20,$xd1,$xc1,$xc0
+	vperm2i128	\$0x31,$xd1,$xc1,$xd1
+	vperm2i128	\$0x20,$xd2,$xc2,$xc1
+	vperm2i128	\$0x31,$xd2,$xc2,$xd2
+	vperm2i128	\$0x20,$xd3,$xc3,$xc2
+	vperm2i128	\$0x31,$xd3,$xc3,$xd3
+___
+	($xc0,$xc1,$xc2,$xc3,$xt3)=($xt3,$xc0,$xc1,$xc2,$xc3);
+	($xb0,$xb1,$xb2,$xb3,$xc0,$xc1,$xc2,$xc3)=
+	($xc0,$xc1,$xc2,$xc3,$xb0,$xb1,$xb2,$xb3);
+	($xa0,$xa1)=($xt2,$xt3);
+$code.=<<___;
+	vmovdqa		0x00(%rsp),$xa0		# $xaN was offloaded, remember?
+	vmovdqa		0x20(%rsp),$xa1
+___
+}
+
 my $xframe = $win64 ? 0xa8 : 8;
 
 $code.=<<___;
@@ -2060,105 +2169,9 @@ ___
 $code.=<<___;
 	dec		%eax
 	jnz		.Loop8x
-
-	lea		0x200(%rsp),%rax	# size optimization
-	vpaddd		0x80-0x100(%rcx),$xa0,$xa0	# accumulate key
-	vpaddd		0xa0-0x100(%rcx),$xa1,$xa1
-	vpaddd		0xc0-0x100(%rcx),$xa2,$xa2
-	vpaddd		0xe0-0x100(%rcx),$xa3,$xa3
-
-	vpunpckldq	$xa1,$xa0,$xt2		# "de-interlace" data
-	vpunpckldq	$xa3,$xa2,$xt3
-	vpunpckhdq	$xa1,$xa0,$xa0
-	vpunpckhdq	$xa3,$xa2,$xa2
-	vpunpcklqdq	$xt3,$xt2,$xa1		# "a0"
-	vpunpckhqdq	$xt3,$xt2,$xt2		# "a1"
-	vpunpcklqdq	$xa2,$xa0,$xa3		# "a2"
-	vpunpckhqdq	$xa2,$xa0,$xa0		# "a3"
-___
-	($xa0,$xa1,$xa2,$xa3,$xt2)=($xa1,$xt2,$xa3,$xa0,$xa2);
-$code.=<<___;
-	vpaddd		0x100-0x100(%rcx),$xb0,$xb0
-	vpaddd		0x120-0x100(%rcx),$xb1,$xb1
-	vpaddd		0x140-0x100(%rcx),$xb2,$xb2
-	vpaddd		0x160-0x100(%rcx),$xb3,$xb3
-
-	vpunpckldq	$xb1,$xb0,$xt2
-	vpunpckldq	$xb3,$xb2,$xt3
-	vpunpckhdq	$xb1,$xb0,$xb0
-	vpunpckhdq	$xb3,$xb2,$xb2
-	vpunpcklqdq	$xt3,$xt2,$xb1		# "b0"
-	vpunpckhqdq	$xt3,$xt2,$xt2		# "b1"
-	vpunpcklqdq	$xb2,$xb0,$xb3		# "b2"
-	vpunpckhqdq	$xb2,$xb0,$xb0		# "b3"
-___
-	($xb0,$xb1,$xb2,$xb3,$xt2)=($xb1,$xt2,$xb3,$xb0,$xb2);
-$code.=<<___;
-	vperm2i128	\$0x20,$xb0,$xa0,$xt3	# "de-interlace" further
-	vperm2i128	\$0x31,$xb0,$xa0,$xb0
-	vperm2i128	\$0x20,$xb1,$xa1,$xa0
-	vperm2i128	\$0x31,$xb1,$xa1,$xb1
-	vperm2i128	\$0x20,$xb2,$xa2,$xa1
-	vperm2i128	\$0x31,$xb2,$xa2,$xb2
-	vperm2i128	\$0x20,$xb3,$xa3,$xa2
-	vperm2i128	\$0x31,$xb3,$xa3,$xb3
-___
-	($xa0,$xa1,$xa2,$xa3,$xt3)=($xt3,$xa0,$xa1,$xa2,$xa3);
-	my ($xc0,$xc1,$xc2,$xc3)=($xt0,$xt1,$xa0,$xa1);
-$code.=<<___;
-	vmovdqa		$xa0,0x00(%rsp)		# offload $xaN
-	vmovdqa		$xa1,0x20(%rsp)
-	vmovdqa		0x40(%rsp),$xc2		# $xa0
-	vmovdqa		0x60(%rsp),$xc3		# $xa1
-
-	vpaddd		0x180-0x200(%rax),$xc0,$xc0
-	vpaddd		0x1a0-0x200(%rax),$xc1,$xc1
-	vpaddd		0x1c0-0x200(%rax),$xc2,$xc2
-	vpaddd		0x1e0-0x200(%rax),$xc3,$xc3
-
-	vpunpckldq	$xc1,$xc0,$xt2
-	vpunpckldq	$xc3,$xc2,$xt3
-	vpunpckhdq	$xc1,$xc0,$xc0
-	vpunpckhdq	$xc3,$xc2,$xc2
-	vpunpcklqdq	$xt3,$xt2,$xc1		# "c0"
-	vpunpckhqdq	$xt3,$xt2,$xt2		# "c1"
-	vpunpcklqdq	$xc2,$xc0,$xc3		# "c2"
-	vpunpckhqdq	$xc2,$xc0,$xc0		# "c3"
 ___
-	($xc0,$xc1,$xc2,$xc3,$xt2)=($xc1,$xt2,$xc3,$xc0,$xc2);
+	&AVX2_8x_feed_forward();
 $code.=<<___;
-	vpaddd		0x200-0x200(%rax),$xd0,$xd0
-	vpaddd		0x220-0x200(%rax),$xd1,$xd1
-	vpaddd		0x240-0x200(%rax),$xd2,$xd2
-	vpaddd		0x260-0x200(%rax),$xd3,$xd3
-
-	vpunpckldq	$xd1,$xd0,$xt2
-	vpunpckldq	$xd3,$xd2,$xt3
-	vpunpckhdq	$xd1,$xd0,$xd0
-	vpunpckhdq	$xd3,$xd2,$xd2
-	vpunpcklqdq	$xt3,$xt2,$xd1		# "d0"
-	vpunpckhqdq	$xt3,$xt2,$xt2		# "d1"
-	vpunpcklqdq	$xd2,$xd0,$xd3		# "d2"
-	vpunpckhqdq	$xd2,$xd0,$xd0		# "d3"
-___
-	($xd0,$xd1,$xd2,$xd3,$xt2)=($xd1,$xt2,$xd3,$xd0,$xd2);
-$code.=<<___;
-	vperm2i128	\$0x20,$xd0,$xc0,$xt3	# "de-interlace" further
-	vperm2i128	\$0x31,$xd0,$xc0,$xd0
-	vperm2i128	\$0x20,$xd1,$xc1,$xc0
-	vperm2i128	\$0x31,$xd1,$xc1,$xd1
-	vperm2i128	\$0x20,$xd2,$xc2,$xc1
-	vperm2i128	\$0x31,$xd2,$xc2,$xd2
-	vperm2i128	\$0x20,$xd3,$xc3,$xc2
-	vperm2i128	\$0x31,$xd3,$xc3,$xd3
-___
-	($xc0,$xc1,$xc2,$xc3,$xt3)=($xt3,$xc0,$xc1,$xc2,$xc3);
-	($xb0,$xb1,$xb2,$xb3,$xc0,$xc1,$xc2,$xc3)=
-	($xc0,$xc1,$xc2,$xc3,$xb0,$xb1,$xb2,$xb3);
-	($xa0,$xa1)=($xt2,$xt3);
-$code.=<<___;
-	vmovdqa		0x00(%rsp),$xa0		# $xaN was offloaded, remember?
-	vmovdqa		0x20(%rsp),$xa1
 
 	cmp		\$64*8,$len
 	jb		.Ltail8x
@@ -2460,6 +2473,161 @@ $code.=<<___;
 .cfi_endproc
 .size	ChaCha20_8x,.-ChaCha20_8x
 ___
+
+########################################################################
+# ChaCha20_8xlanes computes a single key stream block for each of eight
+# independent lanes, each with its own key, counter and nonce.  It's
+# meant for callers that interleave many short messages, such as the
+# batched ChaCha20-Poly1305 in the default provider.
+#
+# void ChaCha20_8xlanes(unsigned char out[8][64],
+#                       unsigned int state[12][8]);
+#
+# |state| holds words 4-15 of the initial state smashed by lanes, word
+# 4+i of lane j is state[i][j].  The eight blocks are written to |out|
+# in lane order.  Lanes are permuted with .Lincy on the way in, so that
+# "de-interlacing" puts them back in order.  Without AVX2 support in
+# the assembler this is an empty stub, and so is poly1305_blocks_8xlanes,
+# which callers check for.
+
+($xb0,$xb1,$xb2,$xb3, $xd0,$xd1,$xd2,$xd3,
+ $xa0,$xa1,$xa2,$xa3, $xt0,$xt1,$xt2,$xt3)=map("%ymm$_",(0..15));
+
+$code.=<<___;
+.globl	ChaCha20_8xlanes
+.type	ChaCha20_8xlanes,\@function,2
+.align	32
+ChaCha20_8xlanes:
+.cfi_startproc
+	mov		%rsp,%r9		# frame register
+.cfi_def_cfa_register	%r9
+	sub		\$0x280+$xframe,%rsp
+	and		\$-32,%rsp
+___
+$code.=<<___	if ($win64);
+	movaps		%xmm6,-0xa8(%r9)
+	movaps		%xmm7,-0x98(%r9)
+	movaps		%xmm8,-0x88(%r9)
+	movaps		%xmm9,-0x78(%r9)
+	movaps		%xmm10,-0x68(%r9)
+	movaps		%xmm11,-0x58(%r9)
+	movaps		%xmm12,-0x48(%r9)
+	movaps		%xmm13,-0x38(%r9)
+	movaps		%xmm14,-0x28(%r9)
+	movaps		%xmm15,-0x18(%r9)
+.L8xlanes_body:
+___
+$code.=<<___;
+	vzeroupper
+
+	vmovdqa		.Lincy(%rip),$xt3	# lane permutation
+	vbroadcasti128	.Lsigma(%rip),$xa3	# key[0]
+	lea		0x100(%rsp),%rcx	# size optimization
+	lea		0x200(%rsp),%rax	# size optimization
+	lea		.Lrot16(%rip),%r10
+	lea		.Lrot24(%rip),%r11
+
+	vpshufd		\$0x00,$xa3,$xa0	# smash sigma by lanes...
+	vpshufd		\$0x55,$xa3,$xa1
+	vmovdqa		$xa0,0x80-0x100(%rcx)	# ... and offload
+	vpshufd		\$0xaa,$xa3,$xa2
+	vmovdqa		$xa1,0xa0-0x100(%rcx)
+	vpshufd		\$0xff,$xa3,$xa3
+	vmovdqa		$xa2,0xc0-0x100(%rcx)
+	vmovdqa		$xa3,0xe0-0x100(%rcx)
+
+	vpermd		0x00(%rsi),$xt3,$xb0	# per-lane key...
+	vpermd		0x20(%rsi),$xt3,$xb1
+	vmovdqa		$xb0,0x100-0x100(%rcx)	# ... and offload
+	vpermd		0x40(%rsi),$xt3,$xb2
+	vmovdqa		$xb1,0x120-0x100(%rcx)
+	vpermd		0x60(%rsi),$xt3,$xb3
+	vmovdqa		$xb2,0x140-0x100(%rcx)
+	vmovdqa		$xb3,0x160-0x100(%rcx)
+
+	vpermd		0x100(%rsi),$xt3,$xd0	# per-lane counter and nonce
+	vpermd		0x120(%rsi),$xt3,$xd1
+	vmovdqa		$xd0,0x200-0x200(%rax)
+	vpermd		0x140(%rsi),$xt3,$xd2
+	vmovdqa		$xd1,0x220-0x200(%rax)
+	vpermd		0x160(%rsi),$xt3,$xd3
+	vmovdqa		$xd2,0x240-0x200(%rax)
+	vmovdqa		$xd3,0x260-0x200(%rax)
+
+	vpermd		0x80(%rsi),$xt3,$xt0	# "xc0"
+	vpermd		0xa0(%rsi),$xt3,$xt1	# "xc1"
+	vpermd		0xc0(%rsi),$xt3,$xt2	# "xc2"
+	vpermd		0xe0(%rsi),$xt3,$xt3	# "xc3"
+	vmovdqa		$xt0,0x180-0x200(%rax)
+	vmovdqa		$xt1,0x1a0-0x200(%rax)
+	vmovdqa		$xt2,0x1c0-0x200(%rax)
+	vmovdqa		$xt3,0x1e0-0x200(%rax)
+
+	vmovdqa		$xt2,0x40(%rsp)		# SIMD equivalent of "@x[10]"
+	vmovdqa		$xt3,0x60(%rsp)		# SIMD equivalent of "@x[11]"
+	vbroadcasti128	(%r10),$xt3
+	mov		\$10,%eax
+	jmp		.Loop8xlanes
+
+.align	32
+.Loop8xlanes:
+___
+	foreach (&AVX2_lane_ROUND(0, 4, 8,12)) { eval; }
+	foreach (&AVX2_lane_ROUND(0, 5,10,15)) { eval; }
+$code.=<<___;
+	dec		%eax
+	jnz		.Loop8xlanes
+___
+	&AVX2_8x_feed_forward();
+$code.=<<___;
+
+	vmovdqu		$xa0,0x00(%rdi)
+	vmovdqu		$xb0,0x20(%rdi)
+	vmovdqu		$xc0,0x40(%rdi)
+	vmovdqu		$xd0,0x60(%rdi)
+	vmovdqu		$xa1,0x80(%rdi)
+	vmovdqu		$xb1,0xa0(%rdi)
+	vmovdqu		$xc1,0xc0(%rdi)
+	vmovdqu		$xd1,0xe0(%rdi)
+	vmovdqu		$xa2,0x100(%rdi)
+	vmovdqu		$xb2,0x120(%rdi)
+	vmovdqu		$xc2,0x140(%rdi)
+	vmovdqu		$xd2,0x160(%rdi)
+	vmovdqu		$xa3,0x180(%rdi)
+	vmovdqu		$xb3,0x1a0(%rdi)
+	vmovdqu		$xc3,0x1c0(%rdi)
+	vmovdqu		$xd3,0x1e0(%rdi)
+
+	vzeroall
+___
+$code.=<<___	if ($win64);
+	movaps		-0xa8(%r9),%xmm6
+	movaps		-0x98(%r9),%xmm7
+	movaps		-0x88(%r9),%xmm8
+	movaps		-0x78(%r9),%xmm9
+	movaps		-0x68(%r9),%xmm10
+	movaps		-0x58(%r9),%xmm11
+	movaps		-0x48(%r9),%xmm12
+	movaps		-0x38(%r9),%xmm13
+	movaps		-0x28(%r9),%xmm14
+	movaps		-0x18(%r9),%xmm15
+___
+$code.=<<___;
+	lea		(%r9),%rsp
+.cfi_def_cfa_register	%rsp
+.L8xlanes_epilogue:
+	ret
+.cfi_endproc
+.size	ChaCha20_8xlanes,.-ChaCha20_8xlanes
+___
+} else {
+$code.=<<___;
+.globl	ChaCha20_8xlanes
+.type	ChaCha20_8xlanes,\@abi-omnipotent
+ChaCha20_8xlanes:
+	ret
+.size	ChaCha20_8xlanes,.-ChaCha20_8xlanes
+___
 }
 
 ########################################################################
@@ -3944,6 +4112,10 @@ $code.=<<___ if ($avx>1);
 	.rva	.LSEH_begin_ChaCha20_8x
 	.rva	.LSEH_end_ChaCha20_8x
 	.rva	.LSEH_info_ChaCha20_8x
+
+	.rva	.LSEH_begin_ChaCha20_8xlanes
+	.rva	.LSEH_end_ChaCha20_8xlanes
+	.rva	.LSEH_info_ChaCha20_8xlanes
 ___
 $code.=<<___ if ($avx>2);
 	.rva	.LSEH_begin_ChaCha20_avx512
@@ -4000,6 +4172,12 @@ $code.=<<___ if ($avx>1);
 	.rva	simd_handler
 	.rva	.L8x_body,.L8x_epilogue			# HandlerData[]
 	.long	0xa0,0
+
+.LSEH_info_ChaCha20_8xlanes:
+	.byte	9,0,0,0
+	.rva	simd_handler
+	.rva	.L8xlanes_body,.L8xlanes_epilogue	# HandlerData[]
+	.long	0xa0,0
 ___
 $code.=<<___ if ($avx>2);
 .LSEH_info_ChaCha20_avx512:
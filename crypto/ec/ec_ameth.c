@@ -612,6 +612,25 @@ int ec_pkey_export_to(const EVP_PKEY *from, void *to_keydata,
     return rv;
 }
 
+/*
+ * Only EC keys (not SM2 keys, which share this method) that use the built-in
+ * implementation are duplicated directly, as anything else would change how
+ * the provider operations behave.
+ */
+static void *ec_pkey_dup_to(const EVP_PKEY *from, OSSL_LIB_CTX *libctx)
+{
+    const EC_KEY *eckey = from->pkey.ec;
+
+    if (from->type != EVP_PKEY_EC
+        || eckey->engine != NULL
+        || eckey->meth != EC_KEY_OpenSSL()
+        || eckey->group == NULL
+        || ossl_lib_ctx_get_concrete(eckey->libctx)
+           != ossl_lib_ctx_get_concrete(libctx))
+        return NULL;
+    return ossl_ec_key_dup(eckey, OSSL_KEYMGMT_SELECT_ALL);
+}
+
 static int ec_pkey_import_from(const OSSL_PARAM params[], void *vpctx)
 {
     EVP_PKEY_CTX *pctx = vpctx;
@@ -702,7 +721,8 @@ const EVP_PKEY_ASN1_METHOD ossl_eckey_asn1_meth = {
     ec_pkey_export_to,
     ec_pkey_import_from,
     ec_pkey_copy,
-    eckey_priv_decode_ex
+    eckey_priv_decode_ex,
+    ec_pkey_dup_to
 };
 
 #if !defined(OPENSSL_NO_SM2)
@@ -15,9 +15,12 @@
 #include <openssl/decoder.h>
 #include <openssl/safestack.h>
 #include <openssl/trace.h>
+#include <openssl/lhash.h>
 #include "crypto/evp.h"
 #include "crypto/decoder.h"
+#include "crypto/lhash.h"
 #include "encoder_local.h"
+#include "internal/cryptlib.h"
 #include "e_os.h"                /* strcasecmp on Windows */
 
 int OSSL_DECODER_CTX_set_passphrase(OSSL_DECODER_CTX *ctx,
@@ -458,6 +461,366 @@ int ossl_decoder_ctx_setup_for_pkey(OSSL_DECODER_CTX *ctx,
     return ok;
 }
 
+/*
+ * Decoder chain cache
+ * -------------------
+ *
+ * Building the decoder chain for OSSL_DECODER_CTX_new_for_pkey() means
+ * walking all keymgmts and all decoders of all active providers, which is
+ * far more expensive than the actual decoding of a typical key.  Since the
+ * result depends only on the parameters below and on the set of active
+ * providers, the first chain built for a given set of parameters is kept
+ * as a template in the library context, and later requests get a copy of
+ * it with fresh decoder contexts.  The cache is flushed whenever a provider
+ * is activated or deactivated and whenever the default properties change.
+ *
+ * The key type may come from untrusted input (such as an unknown algorithm
+ * OID in a certificate), so chains without any key manager are never cached
+ * and the cache is emptied once it holds DECODER_CACHE_MAX_ENTRIES chains.
+ */
+#define DECODER_CACHE_MAX_ENTRIES   64
+
+typedef struct {
+    char *input_type;
+    char *input_structure;
+    char *keytype;
+    int selection;
+    char *propquery;
+    OSSL_DECODER_CTX *template;
+} DECODER_CACHE_ENTRY;
+
+DEFINE_LHASH_OF(DECODER_CACHE_ENTRY);
+
+typedef struct {
+    CRYPTO_RWLOCK *lock;
+    LHASH_OF(DECODER_CACHE_ENTRY) *hashtable;
+    /* Bumped on each flush, so that stale chains are never added */
+    unsigned int generation;
+} DECODER_CACHE;
+
+static unsigned long decoder_cache_entry_hash(const DECODER_CACHE_ENTRY *e)
+{
+    unsigned long hash = 17;
+
+    hash = (hash * 23)
+           + (e->propquery == NULL ? 0 : OPENSSL_LH_strhash(e->propquery));
+    hash = (hash * 23)
+           + (e->input_structure == NULL
+              ? 0 : ossl_lh_strcasehash(e->input_structure));
+    hash = (hash * 23)
+           + (e->input_type == NULL ? 0 : ossl_lh_strcasehash(e->input_type));
+    hash = (hash * 23)
+           + (e->keytype == NULL ? 0 : ossl_lh_strcasehash(e->keytype));
+    hash ^= e->selection;
+
+    return hash;
+}
+
+static int nullstrcmp(const char *a, const char *b, int casecmp)
+{
+    if (a == NULL || b == NULL)
+        return a == b ? 0 : (a == NULL ? 1 : -1);
+    return casecmp ? strcasecmp(a, b) : strcmp(a, b);
+}
+
+static int decoder_cache_entry_cmp(const DECODER_CACHE_ENTRY *a,
+                                   const DECODER_CACHE_ENTRY *b)
+{
+    int cmp;
+
+    if (a->selection != b->selection)
+        return (a->selection < b->selection) ? -1 : 1;
+
+    cmp = nullstrcmp(a->keytype, b->keytype, 1);
+    if (cmp != 0)
+        return cmp;
+
+    cmp = nullstrcmp(a->input_type, b->input_type, 1);
+    if (cmp != 0)
+        return cmp;
+
+    cmp = nullstrcmp(a->input_structure, b->input_structure, 1);
+    if (cmp != 0)
+        return cmp;
+
+    return nullstrcmp(a->propquery, b->propquery, 0);
+}
+
+static void decoder_cache_entry_free(DECODER_CACHE_ENTRY *entry)
+{
+    if (entry == NULL)
+        return;
+    OPENSSL_free(entry->input_type);
+    OPENSSL_free(entry->input_structure);
+    OPENSSL_free(entry->keytype);
+    OPENSSL_free(entry->propquery);
+    OSSL_DECODER_CTX_free(entry->template);
+    OPENSSL_free(entry);
+}
+
+static void *decoder_cache_new(OSSL_LIB_CTX *ctx)
+{
+    DECODER_CACHE *cache = OPENSSL_zalloc(sizeof(*cache));
+
+    if (cache == NULL)
+        return NULL;
+
+    cache->lock = CRYPTO_THREAD_lock_new();
+    if (cache->lock == NULL) {
+        OPENSSL_free(cache);
+        return NULL;
+    }
+    cache->hashtable = lh_DECODER_CACHE_ENTRY_new(decoder_cache_entry_hash,
+                                                  decoder_cache_entry_cmp);
+    if (cache->hashtable == NULL) {
+        CRYPTO_THREAD_lock_free(cache->lock);
+        OPENSSL_free(cache);
+        return NULL;
+    }
+
+    return cache;
+}
+
+static void decoder_cache_free(void *vcache)
+{
+    DECODER_CACHE *cache = (DECODER_CACHE *)vcache;
+
+    lh_DECODER_CACHE_ENTRY_doall(cache->hashtable, decoder_cache_entry_free);
+    lh_DECODER_CACHE_ENTRY_free(cache->hashtable);
+    CRYPTO_THREAD_lock_free(cache->lock);
+    OPENSSL_free(cache);
+}
+
+static const OSSL_LIB_CTX_METHOD decoder_cache_method = {
+    /*
+     * The cache holds references to decoders and keymgmts, so it must be
+     * cleaned up before the provider store
+     */
+    OSSL_LIB_CTX_METHOD_PRIORITY_2,
+    decoder_cache_new,
+    decoder_cache_free,
+};
+
+static DECODER_CACHE *get_decoder_cache(OSSL_LIB_CTX *libctx)
+{
+    return ossl_lib_ctx_get_data(libctx, OSSL_LIB_CTX_DECODER_CACHE_INDEX,
+                                 &decoder_cache_method);
+}
+
+/* Remove all entries, the caller must hold the write lock */
+static void decoder_cache_clear(DECODER_CACHE *cache)
+{
+    lh_DECODER_CACHE_ENTRY_doall(cache->hashtable, decoder_cache_entry_free);
+    lh_DECODER_CACHE_ENTRY_flush(cache->hashtable);
+}
+
+int ossl_decoder_cache_flush(OSSL_LIB_CTX *libctx)
+{
+    DECODER_CACHE *cache = get_decoder_cache(libctx);
+
+    if (cache == NULL)
+        return 0;
+
+    if (!CRYPTO_THREAD_write_lock(cache->lock))
+        return 0;
+
+    decoder_cache_clear(cache);
+    cache->generation++;
+
+    CRYPTO_THREAD_unlock(cache->lock);
+    return 1;
+}
+
+static OSSL_DECODER_INSTANCE *
+decoder_instance_dup(const OSSL_DECODER_INSTANCE *src)
+{
+    OSSL_DECODER_INSTANCE *dest;
+    const OSSL_PROVIDER *prov;
+    void *provctx;
+
+    if ((dest = OPENSSL_zalloc(sizeof(*dest))) == NULL) {
+        ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+
+    *dest = *src;
+    dest->decoderctx = NULL;
+    if (!OSSL_DECODER_up_ref(dest->decoder)) {
+        ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_INTERNAL_ERROR);
+        OPENSSL_free(dest);
+        return NULL;
+    }
+    prov = OSSL_DECODER_get0_provider(dest->decoder);
+    provctx = OSSL_PROVIDER_get0_provider_ctx(prov);
+    if ((dest->decoderctx = dest->decoder->newctx(provctx)) == NULL) {
+        ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_INTERNAL_ERROR);
+        ossl_decoder_instance_free(dest);
+        return NULL;
+    }
+
+    return dest;
+}
+
+/*
+ * Copy the decoder chain and construction data of |src| into a new decoder
+ * context that places its result in |pkey|.  The input type and structure
+ * of the new context are set to the caller's strings, just like when the
+ * chain is built from scratch.
+ */
+static OSSL_DECODER_CTX *
+decoder_ctx_for_pkey_dup(OSSL_DECODER_CTX *src, EVP_PKEY **pkey,
+                         const char *input_type, const char *input_structure)
+{
+    OSSL_DECODER_CTX *dest;
+    struct decoder_pkey_data_st *process_data_src;
+    struct decoder_pkey_data_st *process_data_dest = NULL;
+    int i, end;
+
+    if ((dest = OSSL_DECODER_CTX_new()) == NULL) {
+        ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+
+    if (!OSSL_DECODER_CTX_set_input_type(dest, input_type)
+        || !OSSL_DECODER_CTX_set_input_structure(dest, input_structure)
+        || !OSSL_DECODER_CTX_set_selection(dest, src->selection))
+        goto err;
+
+    if (src->decoder_insts != NULL) {
+        end = sk_OSSL_DECODER_INSTANCE_num(src->decoder_insts);
+        dest->decoder_insts = sk_OSSL_DECODER_INSTANCE_new_reserve(NULL, end);
+        if (dest->decoder_insts == NULL) {
+            ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_MALLOC_FAILURE);
+            goto err;
+        }
+        for (i = 0; i < end; i++) {
+            OSSL_DECODER_INSTANCE *di =
+                decoder_instance_dup(sk_OSSL_DECODER_INSTANCE_value(src->decoder_insts,
+                                                                    i));
+
+            if (di == NULL)
+                goto err;
+            /* Cannot fail, the space was reserved above */
+            (void)sk_OSSL_DECODER_INSTANCE_push(dest->decoder_insts, di);
+        }
+    }
+
+    process_data_src = src->construct_data;
+    if (process_data_src != NULL) {
+        process_data_dest = OPENSSL_zalloc(sizeof(*process_data_dest));
+        if (process_data_dest == NULL) {
+            ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_MALLOC_FAILURE);
+            goto err;
+        }
+        if (process_data_src->propq != NULL) {
+            process_data_dest->propq = OPENSSL_strdup(process_data_src->propq);
+            if (process_data_dest->propq == NULL) {
+                ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_MALLOC_FAILURE);
+                goto err;
+            }
+        }
+
+        end = sk_EVP_KEYMGMT_num(process_data_src->keymgmts);
+        process_data_dest->keymgmts = sk_EVP_KEYMGMT_new_reserve(NULL, end);
+        if (process_data_dest->keymgmts == NULL) {
+            ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_MALLOC_FAILURE);
+            goto err;
+        }
+        for (i = 0; i < end; i++) {
+            EVP_KEYMGMT *keymgmt =
+                sk_EVP_KEYMGMT_value(process_data_src->keymgmts, i);
+
+            if (!EVP_KEYMGMT_up_ref(keymgmt)) {
+                ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_INTERNAL_ERROR);
+                goto err;
+            }
+            /* Cannot fail, the space was reserved above */
+            (void)sk_EVP_KEYMGMT_push(process_data_dest->keymgmts, keymgmt);
+        }
+
+        process_data_dest->object = (void **)pkey;
+        process_data_dest->libctx = process_data_src->libctx;
+        process_data_dest->selection = process_data_src->selection;
+        if (!OSSL_DECODER_CTX_set_construct(dest, decoder_construct_pkey)
+            || !OSSL_DECODER_CTX_set_construct_data(dest, process_data_dest)
+            || !OSSL_DECODER_CTX_set_cleanup(dest,
+                                             decoder_clean_pkey_construct_arg))
+            goto err;
+        process_data_dest = NULL; /* Avoid it being freed */
+    }
+
+    return dest;
+ err:
+    decoder_clean_pkey_construct_arg(process_data_dest);
+    OSSL_DECODER_CTX_free(dest);
+    return NULL;
+}
+
+/*
+ * Store a template of |ctx| in |cache|, unless another thread got there
+ * first or the cache was flushed since |generation| was read, in which case
+ * |ctx| may have been built from a stale set of providers.  Failures are not
+ * fatal, the caller still has a working |ctx|.
+ */
+static void decoder_cache_add(DECODER_CACHE *cache, unsigned int generation,
+                              OSSL_DECODER_CTX *ctx,
+                              const DECODER_CACHE_ENTRY *key)
+{
+    struct decoder_pkey_data_st *data = ctx->construct_data;
+    DECODER_CACHE_ENTRY *newentry;
+    int i, end;
+
+    /* Nothing could be decoded with this chain, so don't keep it around */
+    if (OSSL_DECODER_CTX_get_num_decoders(ctx) == 0 || data == NULL)
+        return;
+    /* Neither keep chains for key types that no provider knows about */
+    if (key->keytype != NULL) {
+        end = sk_EVP_KEYMGMT_num(data->keymgmts);
+        for (i = 0; i < end; i++)
+            if (EVP_KEYMGMT_is_a(sk_EVP_KEYMGMT_value(data->keymgmts, i),
+                                 key->keytype))
+                break;
+        if (i >= end)
+            return;
+    }
+
+    if ((newentry = OPENSSL_zalloc(sizeof(*newentry))) == NULL)
+        return;
+    newentry->selection = key->selection;
+    if ((key->input_type != NULL
+         && (newentry->input_type = OPENSSL_strdup(key->input_type)) == NULL)
+        || (key->input_structure != NULL
+            && (newentry->input_structure =
+                OPENSSL_strdup(key->input_structure)) == NULL)
+        || (key->keytype != NULL
+            && (newentry->keytype = OPENSSL_strdup(key->keytype)) == NULL)
+        || (key->propquery != NULL
+            && (newentry->propquery = OPENSSL_strdup(key->propquery)) == NULL)
+        || (newentry->template =
+            decoder_ctx_for_pkey_dup(ctx, NULL, newentry->input_type,
+                                     newentry->input_structure)) == NULL) {
+        decoder_cache_entry_free(newentry);
+        return;
+    }
+
+    if (!CRYPTO_THREAD_write_lock(cache->lock)) {
+        decoder_cache_entry_free(newentry);
+        return;
+    }
+    if (cache->generation == generation
+        && lh_DECODER_CACHE_ENTRY_retrieve(cache->hashtable, newentry) == NULL) {
+        if (lh_DECODER_CACHE_ENTRY_num_items(cache->hashtable)
+            >= DECODER_CACHE_MAX_ENTRIES)
+            decoder_cache_clear(cache);
+        (void)lh_DECODER_CACHE_ENTRY_insert(cache->hashtable, newentry);
+        if (lh_DECODER_CACHE_ENTRY_error(cache->hashtable))
+            decoder_cache_entry_free(newentry);
+    } else {
+        decoder_cache_entry_free(newentry);
+    }
+    CRYPTO_THREAD_unlock(cache->lock);
+}
+
 OSSL_DECODER_CTX *
 OSSL_DECODER_CTX_new_for_pkey(EVP_PKEY **pkey,
                               const char *input_type,
@@ -466,6 +829,41 @@ OSSL_DECODER_CTX_new_for_pkey(EVP_PKEY **pkey,
                               OSSL_LIB_CTX *libctx, const char *propquery)
 {
     OSSL_DECODER_CTX *ctx = NULL;
+    DECODER_CACHE *cache = get_decoder_cache(libctx);
+    DECODER_CACHE_ENTRY cacheent, *res = NULL;
+    unsigned int generation = 0;
+
+    if (cache != NULL) {
+        /* The key only borrows the caller's strings */
+        cacheent.input_type = (char *)input_type;
+        cacheent.input_structure = (char *)input_structure;
+        cacheent.keytype = (char *)keytype;
+        cacheent.selection = selection;
+        cacheent.propquery = (char *)propquery;
+        cacheent.template = NULL;
+
+        if (!CRYPTO_THREAD_read_lock(cache->lock)) {
+            ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_INTERNAL_ERROR);
+            return NULL;
+        }
+        generation = cache->generation;
+        res = lh_DECODER_CACHE_ENTRY_retrieve(cache->hashtable, &cacheent);
+        if (res != NULL)
+            ctx = decoder_ctx_for_pkey_dup(res->template, pkey,
+                                           input_type, input_structure);
+        CRYPTO_THREAD_unlock(cache->lock);
+
+        if (res != NULL) {
+            OSSL_TRACE_BEGIN(DECODER) {
+                BIO_printf(trc_out,
+                           "(ctx %p) Got %d decoders from the cache\n",
+                           (void *)ctx,
+                           ctx == NULL
+                           ? 0 : OSSL_DECODER_CTX_get_num_decoders(ctx));
+            } OSSL_TRACE_END(DECODER);
+            return ctx;
+        }
+    }
 
     if ((ctx = OSSL_DECODER_CTX_new()) == NULL) {
         ERR_raise(ERR_LIB_OSSL_DECODER, ERR_R_MALLOC_FAILURE);
@@ -490,6 +888,8 @@ OSSL_DECODER_CTX_new_for_pkey(EVP_PKEY **pkey,
             BIO_printf(trc_out, "(ctx %p) Got %d decoders\n",
                        (void *)ctx, OSSL_DECODER_CTX_get_num_decoders(ctx));
         } OSSL_TRACE_END(DECODER);
+        if (cache != NULL)
+            decoder_cache_add(cache, generation, ctx, &cacheent);
         return ctx;
     }
 
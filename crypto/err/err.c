@@ -639,6 +639,7 @@ DEFINE_RUN_ONCE_STATIC(err_do_init)
 ERR_STATE *ossl_err_get_state_int(void)
 {
     ERR_STATE *state;
+    ERR_STATE_EXT *ext;
     int saveerrno = get_last_sys_error();
 
     if (!OPENSSL_init_crypto(OPENSSL_INIT_BASE_ONLY, NULL))
@@ -655,10 +656,11 @@ ERR_STATE *ossl_err_get_state_int(void)
         if (!CRYPTO_THREAD_set_local(&err_thread_local, (ERR_STATE*)-1))
             return NULL;
 
-        if ((state = OPENSSL_zalloc(sizeof(*state))) == NULL) {
+        if ((ext = OPENSSL_zalloc(sizeof(*ext))) == NULL) {
             CRYPTO_THREAD_set_local(&err_thread_local, NULL);
             return NULL;
         }
+        state = &ext->st;
 
         if (!ossl_init_thread_start(NULL, NULL, err_delete_thread_state)
                 || !CRYPTO_THREAD_set_local(&err_thread_local, state)) {
@@ -749,6 +751,11 @@ static int err_set_error_data_int(char *data, size_t size, int flags,
     es = ossl_err_get_state_int();
     if (es == NULL)
         return 0;
+    if (err_state_ext(es)->suppress > 0) {
+        if (deallocate && (flags & ERR_TXT_MALLOCED) != 0)
+            OPENSSL_free(data);
+        return 1;
+    }
 
     err_clear_data(es, es->top, deallocate);
     err_set_data(es, es->top, data, size, flags);
@@ -792,7 +799,7 @@ void ERR_add_error_vdata(int num, va_list args)
 
     /* Get the current error data; if an allocated string get it. */
     es = ossl_err_get_state_int();
-    if (es == NULL)
+    if (es == NULL || err_state_ext(es)->suppress > 0)
         return;
     i = es->top;
 
@@ -897,6 +904,44 @@ int ERR_clear_last_mark(void)
     return 1;
 }
 
+/*
+ * Stop recording errors on this thread until the matching
+ * ossl_err_unsuppress() call.  This is meant for probing code that would
+ * otherwise set a mark, try something that is expected to fail, and pop
+ * everything back off again: nothing is allocated, copied or formatted for
+ * errors raised in between.  Errors that were already on the queue are left
+ * alone.  Calls nest.
+ *
+ * Marks are not affected: ERR_set_mark() while suppressed marks the last
+ * error recorded before, or fails if there is none, and ERR_pop_to_mark()
+ * and ERR_peek_*() only ever see errors recorded outside suppression.  An
+ * error raised while suppressed is therefore lost even to a caller further
+ * out that set a mark to look at it, so only code whose errors never escape
+ * may use this.
+ */
+int ossl_err_suppress(void)
+{
+    ERR_STATE *es;
+
+    es = ossl_err_get_state_int();
+    if (es == NULL)
+        return 0;
+
+    err_state_ext(es)->suppress++;
+    return 1;
+}
+
+void ossl_err_unsuppress(void)
+{
+    ERR_STATE *es;
+
+    es = ossl_err_get_state_int();
+    if (es == NULL || err_state_ext(es)->suppress == 0)
+        return;
+
+    err_state_ext(es)->suppress--;
+}
+
 void err_clear_last_constant_time(int clear)
 {
     ERR_STATE *es;
@@ -18,7 +18,7 @@ void ERR_new(void)
     ERR_STATE *es;
 
     es = ossl_err_get_state_int();
-    if (es == NULL)
+    if (es == NULL || err_state_ext(es)->suppress > 0)
         return;
 
     /* Allocate a slot */
@@ -31,7 +31,7 @@ void ERR_set_debug(const char *file, int line, const char *func)
     ERR_STATE *es;
 
     es = ossl_err_get_state_int();
-    if (es == NULL)
+    if (es == NULL || err_state_ext(es)->suppress > 0)
         return;
 
     err_set_debug(es, es->top, file, line, func);
@@ -53,65 +53,51 @@ void ERR_vset_error(int lib, int reason, const char *fmt, va_list args)
     size_t buf_size = 0;
     unsigned long flags = 0;
     size_t i;
+    char tmp[ERR_MAX_DATA_SIZE];
+    int printed_len = 0;
 
     es = ossl_err_get_state_int();
-    if (es == NULL)
+    if (es == NULL || err_state_ext(es)->suppress > 0)
         return;
-    i = es->top;
 
+    /*
+     * Format into a local buffer first, so that nothing BIO_vsnprintf() may
+     * end up calling can tamper with the error slot while we work.
+     */
     if (fmt != NULL) {
-        int printed_len = 0;
-        char *rbuf = NULL;
+        printed_len = BIO_vsnprintf(tmp, sizeof(tmp), fmt, args);
+        if (printed_len < 0)
+            printed_len = 0;
+        tmp[printed_len] = '\0';
+    }
 
+    i = es->top;
+    if (fmt != NULL) {
         buf = es->err_data[i];
         buf_size = es->err_data_size[i];
 
         /*
-         * To protect the string we just grabbed from tampering by other
-         * functions we may call, or to protect them from freeing a pointer
-         * that may no longer be valid at that point, we clear away the
-         * data pointer and the flags.  We will set them again at the end
-         * of this function.
-         */
-        es->err_data[i] = NULL;
-        es->err_data_flags[i] = 0;
-
-        /*
-         * Try to maximize the space available.  If that fails, we use what
-         * we have.
-         */
-        if (buf_size < ERR_MAX_DATA_SIZE
-            && (rbuf = OPENSSL_realloc(buf, ERR_MAX_DATA_SIZE)) != NULL) {
-            buf = rbuf;
-            buf_size = ERR_MAX_DATA_SIZE;
-        }
-
-        if (buf != NULL) {
-            printed_len = BIO_vsnprintf(buf, buf_size, fmt, args);
-        }
-        if (printed_len < 0)
-            printed_len = 0;
-        if (buf != NULL)
-            buf[printed_len] = '\0';
-
-        /*
-         * Try to reduce the size, but only if we maximized above.  If that
-         * fails, we keep what we have.
-         * (According to documentation, realloc leaves the old buffer untouched
-         * if it fails)
+         * Reuse the slot's data buffer when it is allocated and large
+         * enough, which is the common case for a thread that keeps raising
+         * errors.  Otherwise replace it with one that just fits.
          */
-        if ((rbuf = OPENSSL_realloc(buf, printed_len + 1)) != NULL) {
-            buf = rbuf;
+        if ((es->err_data_flags[i] & ERR_TXT_MALLOCED) == 0
+            || buf_size < (size_t)printed_len + 1) {
+            buf = OPENSSL_malloc(printed_len + 1);
             buf_size = printed_len + 1;
-            buf[printed_len] = '\0';
+        } else {
+            es->err_data[i] = NULL;
+            es->err_data_flags[i] = 0;
         }
 
-        if (buf != NULL)
+        if (buf != NULL) {
+            memcpy(buf, tmp, printed_len + 1);
             flags = ERR_TXT_MALLOCED | ERR_TXT_STRING;
+        }
     }
 
-    err_clear_data(es, es->top, 0);
-    err_set_error(es, es->top, lib, reason);
-    if (fmt != NULL)
-        err_set_data(es, es->top, buf, buf_size, flags);
+    err_clear_data(es, i, 0);
+    err_set_error(es, i, lib, reason);
+    if (buf != NULL)
+        err_set_data(es, i, buf, buf_size, flags);
 }
@@ -7,9 +7,27 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <string.h>
 #include <openssl/err.h>
 #include <openssl/e_os2.h>
 
+/*
+ * The per-thread state.  It starts with the ERR_STATE that applications can
+ * still see through ERR_get_state(), whose layout can't change, and goes on
+ * with what only this module knows about.
+ */
+typedef struct err_state_ext_st {
+    ERR_STATE st;
+    size_t err_file_size[ERR_NUM_ERRORS];
+    size_t err_func_size[ERR_NUM_ERRORS];
+    int suppress;
+} ERR_STATE_EXT;
+
+static ossl_inline ERR_STATE_EXT *err_state_ext(ERR_STATE *es)
+{
+    return (ERR_STATE_EXT *)es;
+}
+
 static ossl_inline void err_get_slot(ERR_STATE *es)
 {
     es->top = (es->top + 1) % ERR_NUM_ERRORS;
@@ -45,25 +63,46 @@ static ossl_inline void err_set_error(ERR_STATE *es, size_t i,
         : ERR_PACK(lib, 0, reason);
 }
 
+/*
+ * Copy |src| into the slot string |*dst|, reusing its buffer when it is
+ * large enough.  An empty string is kept as an empty buffer rather than
+ * freed, so a thread that keeps raising errors stops allocating once its
+ * slots have grown to fit.
+ */
+static ossl_inline void err_set_debug_str(char **dst, size_t *dstsz,
+                                          const char *src)
+{
+    size_t len;
+
+    if (src == NULL || src[0] == '\0') {
+        if (*dst != NULL)
+            (*dst)[0] = '\0';
+        return;
+    }
+    len = strlen(src) + 1;
+    if (len > *dstsz) {
+        OPENSSL_free(*dst);
+        *dstsz = 0;
+        if ((*dst = OPENSSL_malloc(len)) == NULL)
+            return;
+        *dstsz = len;
+    }
+    memcpy(*dst, src, len);
+}
+
 static ossl_inline void err_set_debug(ERR_STATE *es, size_t i,
                                       const char *file, int line,
                                       const char *fn)
 {
     /*
-     * We dup the file and fn strings because they may be provider owned. If the
-     * provider gets unloaded, they may not be valid anymore.
+     * We copy the file and fn strings because they may be provider owned. If
+     * the provider gets unloaded, they may not be valid anymore.
      */
-    OPENSSL_free(es->err_file[i]);
-    if (file == NULL || file[0] == '\0')
-        es->err_file[i] = NULL;
-    else
-        es->err_file[i] = OPENSSL_strdup(file);
+    err_set_debug_str(&es->err_file[i], &err_state_ext(es)->err_file_size[i],
+                      file);
     es->err_line[i] = line;
-    OPENSSL_free(es->err_func[i]);
-    if (fn == NULL || fn[0] == '\0')
-        es->err_func[i] = NULL;
-    else
-        es->err_func[i] = OPENSSL_strdup(fn);
+    err_set_debug_str(&es->err_func[i], &err_state_ext(es)->err_func_size[i],
+                      fn);
 }
 
 static ossl_inline void err_set_data(ERR_STATE *es, size_t i,
@@ -83,10 +122,19 @@ static ossl_inline void err_clear(ERR_STATE *es, size_t i, int deall)
     es->err_flags[i] = 0;
     es->err_buffer[i] = 0;
     es->err_line[i] = -1;
-    OPENSSL_free(es->err_file[i]);
-    es->err_file[i] = NULL;
-    OPENSSL_free(es->err_func[i]);
-    es->err_func[i] = NULL;
+    if (deall) {
+        OPENSSL_free(es->err_file[i]);
+        es->err_file[i] = NULL;
+        err_state_ext(es)->err_file_size[i] = 0;
+        OPENSSL_free(es->err_func[i]);
+        es->err_func[i] = NULL;
+        err_state_ext(es)->err_func_size[i] = 0;
+    } else {
+        if (es->err_file[i] != NULL)
+            es->err_file[i][0] = '\0';
+        if (es->err_func[i] != NULL)
+            es->err_func[i][0] = '\0';
+    }
 }
 
 ERR_STATE *ossl_err_get_state_int(void);
@@ -648,6 +648,42 @@ int EVP_Q_digest(OSSL_LIB_CTX *libctx, const char *name, const char *propq,
     return ret;
 }
 
+int EVP_Digest_many(const unsigned char *const data[], const size_t count[],
+                    size_t num, unsigned char *md, size_t mdsize,
+                    const EVP_MD *type)
+{
+    EVP_MD_CTX *ctx;
+    int mdlen = EVP_MD_get_size(type);
+    size_t i;
+    int ret = 1;
+
+    if (mdlen <= 0) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_NO_DIGEST_SET);
+        return 0;
+    }
+    if (mdsize / mdlen < num) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_BUFFER_TOO_SMALL);
+        return 0;
+    }
+    if (num == 0)
+        return 1;
+
+    if (type->digest_many != NULL)
+        return type->digest_many(ossl_provider_ctx(type->prov), num, data,
+                                 count, md, mdsize);
+
+    ctx = EVP_MD_CTX_new();
+    if (ctx == NULL)
+        return 0;
+    EVP_MD_CTX_set_flags(ctx, EVP_MD_CTX_FLAG_ONESHOT);
+    for (i = 0; ret && i < num; i++)
+        ret = EVP_DigestInit_ex(ctx, type, NULL)
+              && EVP_DigestUpdate(ctx, data[i], count[i])
+              && EVP_DigestFinal_ex(ctx, md + i * mdlen, NULL);
+    EVP_MD_CTX_free(ctx);
+    return ret;
+}
+
 int EVP_MD_get_params(const EVP_MD *digest, OSSL_PARAM params[])
 {
     if (digest != NULL && digest->get_params != NULL)
@@ -999,6 +1035,11 @@ static void *evp_md_from_algorithm(int name_id,
                 md->gettable_ctx_params =
                     OSSL_FUNC_digest_gettable_ctx_params(fns);
             break;
+        case OSSL_FUNC_DIGEST_DIGEST_MANY:
+            if (md->digest_many == NULL)
+                md->digest_many = OSSL_FUNC_digest_digest_many(fns);
+            /* Stand alone too, like OSSL_FUNC_DIGEST_DIGEST */
+            break;
         }
     }
     if ((fncnt != 0 && fncnt != 5)
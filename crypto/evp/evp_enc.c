@@ -1116,8 +1116,23 @@ int EVP_CIPHER_CTX_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr)
         params[0] = OSSL_PARAM_construct_uint(OSSL_CIPHER_PARAM_SPEED, &i);
         break;
     case EVP_CTRL_AEAD_GET_TAG:
-        set_params = 0; /* Fall thru */
+        if (arg < 0)
+            return 0;
+        if (ctx->cipher->get_aead_tag != NULL) {
+            ret = ctx->cipher->get_aead_tag(ctx->algctx, ptr, sz);
+            goto end;
+        }
+        set_params = 0;
+        params[0] = OSSL_PARAM_construct_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG,
+                                                      ptr, sz);
+        break;
     case EVP_CTRL_AEAD_SET_TAG:
+        if (arg < 0)
+            return 0;
+        if (ctx->cipher->set_aead_tag != NULL) {
+            ret = ctx->cipher->set_aead_tag(ctx->algctx, ptr, sz);
+            goto end;
+        }
         params[0] = OSSL_PARAM_construct_octet_string(OSSL_CIPHER_PARAM_AEAD_TAG,
                                                       ptr, sz);
         break;
@@ -1237,6 +1252,289 @@ legacy:
     return ret;
 }
 
+int EVP_CIPHER_CTX_aead_init(EVP_CIPHER_CTX *ctx,
+                             const unsigned char *iv, size_t ivlen,
+                             const unsigned char *aad, size_t aadlen)
+{
+    size_t soutl;
+    int outl;
+
+    if (ctx == NULL || ctx->cipher == NULL) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_NO_CIPHER_SET);
+        return 0;
+    }
+    if ((EVP_CIPHER_get_flags(ctx->cipher) & EVP_CIPH_FLAG_AEAD_CIPHER) == 0) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_UNSUPPORTED_CIPHER);
+        return 0;
+    }
+    if (iv == NULL || ivlen > INT_MAX || aadlen > INT_MAX) {
+        ERR_raise(ERR_LIB_EVP, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+
+    if (ctx->cipher->prov == NULL)
+        goto legacy;
+
+    /*
+     * The key and direction stay as they are, so the provider init only has
+     * to take the new IV, and the AAD goes straight to the update function.
+     * The init functions check the IV against the current IV length, so that
+     * has to be changed first.
+     */
+    if ((int)ivlen != EVP_CIPHER_CTX_get_iv_length(ctx)) {
+        OSSL_PARAM params[2] = { OSSL_PARAM_END, OSSL_PARAM_END };
+
+        params[0] = OSSL_PARAM_construct_size_t(OSSL_CIPHER_PARAM_AEAD_IVLEN,
+                                                &ivlen);
+        if (EVP_CIPHER_CTX_set_params(ctx, params) <= 0)
+            goto err;
+    }
+    if (ctx->encrypt) {
+        if (ctx->cipher->einit == NULL
+            || !ctx->cipher->einit(ctx->algctx, NULL, 0, iv, ivlen, NULL))
+            goto err;
+    } else {
+        if (ctx->cipher->dinit == NULL
+            || !ctx->cipher->dinit(ctx->algctx, NULL, 0, iv, ivlen, NULL))
+            goto err;
+    }
+    if (aad != NULL
+        && (ctx->cipher->cupdate == NULL
+            || !ctx->cipher->cupdate(ctx->algctx, NULL, &soutl, aadlen,
+                                     aad, aadlen)))
+        goto err;
+    return 1;
+
+    /* Code below to be removed when legacy support is dropped. */
+ legacy:
+    if ((int)ivlen != EVP_CIPHER_CTX_get_iv_length(ctx)
+        && EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN, (int)ivlen,
+                               NULL) <= 0)
+        return 0;
+    if (!EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, -1))
+        return 0;
+    return aad == NULL
+           || EVP_CipherUpdate(ctx, NULL, &outl, aad, (int)aadlen);
+
+ err:
+    ERR_raise(ERR_LIB_EVP, EVP_R_INITIALIZATION_ERROR);
+    return 0;
+}
+
+int EVP_CIPHER_CTX_get_aead_tag(EVP_CIPHER_CTX *ctx,
+                                unsigned char *tag, size_t taglen)
+{
+    if (ctx == NULL || ctx->cipher == NULL) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_NO_CIPHER_SET);
+        return 0;
+    }
+    if (ctx->cipher->get_aead_tag != NULL)
+        return ctx->cipher->get_aead_tag(ctx->algctx, tag, taglen);
+    if (taglen > INT_MAX) {
+        ERR_raise(ERR_LIB_EVP, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+    return EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, (int)taglen,
+                               tag) > 0;
+}
+
+int EVP_CIPHER_CTX_set_aead_tag(EVP_CIPHER_CTX *ctx,
+                                const unsigned char *tag, size_t taglen)
+{
+    if (ctx == NULL || ctx->cipher == NULL) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_NO_CIPHER_SET);
+        return 0;
+    }
+    if (ctx->cipher->set_aead_tag != NULL)
+        return ctx->cipher->set_aead_tag(ctx->algctx, tag, taglen);
+    if (taglen > INT_MAX) {
+        ERR_raise(ERR_LIB_EVP, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+    return EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_TAG, (int)taglen,
+                               (void *)tag) > 0;
+}
+
+static int aead_oneshot_check(EVP_CIPHER_CTX *ctx, int enc, size_t inl,
+                              const void *tag, size_t taglen)
+{
+    if (ctx == NULL || ctx->cipher == NULL) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_NO_CIPHER_SET);
+        return 0;
+    }
+    if (ctx->encrypt != enc) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_INVALID_OPERATION);
+        return 0;
+    }
+    if (tag == NULL) {
+        ERR_raise(ERR_LIB_EVP, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+    if (inl > INT_MAX || taglen > INT_MAX) {
+        ERR_raise(ERR_LIB_EVP, ERR_R_PASSED_INVALID_ARGUMENT);
+        return 0;
+    }
+    return 1;
+}
+
+int EVP_CIPHER_CTX_aead_seal(EVP_CIPHER_CTX *ctx,
+                             const unsigned char *iv, size_t ivlen,
+                             const unsigned char *aad, size_t aadlen,
+                             const unsigned char *in, size_t inl,
+                             unsigned char *out,
+                             unsigned char *tag, size_t taglen)
+{
+    int outl, tmpl;
+
+    if (!aead_oneshot_check(ctx, 1, inl, tag, taglen))
+        return 0;
+
+    if (ctx->cipher->aead_seal != NULL)
+        return ctx->cipher->aead_seal(ctx->algctx, iv, ivlen, aad, aadlen,
+                                      in, inl, out, tag, taglen);
+
+    return EVP_CIPHER_CTX_aead_init(ctx, iv, ivlen, aad, aadlen)
+           && EVP_EncryptUpdate(ctx, out, &outl, in, (int)inl)
+           && EVP_EncryptFinal_ex(ctx, out + outl, &tmpl)
+           && EVP_CIPHER_CTX_get_aead_tag(ctx, tag, taglen);
+}
+
+int EVP_CIPHER_CTX_aead_open(EVP_CIPHER_CTX *ctx,
+                             const unsigned char *iv, size_t ivlen,
+                             const unsigned char *aad, size_t aadlen,
+                             const unsigned char *in, size_t inl,
+                             unsigned char *out,
+                             const unsigned char *tag, size_t taglen)
+{
+    int outl, tmpl;
+
+    if (!aead_oneshot_check(ctx, 0, inl, tag, taglen))
+        return 0;
+
+    if (ctx->cipher->aead_open != NULL)
+        return ctx->cipher->aead_open(ctx->algctx, iv, ivlen, aad, aadlen,
+                                      in, inl, out, tag, taglen);
+
+    /* Some ciphers need the tag before any ciphertext, so set it first */
+    if (!EVP_CIPHER_CTX_aead_init(ctx, iv, ivlen, aad, aadlen)
+        || !EVP_CIPHER_CTX_set_aead_tag(ctx, tag, taglen))
+        return 0;
+    if (!EVP_DecryptUpdate(ctx, out, &outl, in, (int)inl)
+        || !EVP_DecryptFinal_ex(ctx, out + outl, &tmpl)) {
+        /* Don't leave unauthenticated plaintext behind */
+        OPENSSL_cleanse(out, inl);
+        return 0;
+    }
+    return 1;
+}
+
+int EVP_CIPHER_CTX_aead_seal_many(EVP_CIPHER_CTX *ctx, size_t num,
+                                  const unsigned char *const iv[],
+                                  size_t ivlen,
+                                  const unsigned char *const aad[],
+                                  const size_t aadlen[],
+                                  const unsigned char *const in[],
+                                  const size_t inl[],
+                                  unsigned char *const out[],
+                                  unsigned char *const tag[], size_t taglen)
+{
+    size_t i;
+
+    if (!aead_oneshot_check(ctx, 1, 0, tag, taglen))
+        return 0;
+
+    if (ctx->cipher->aead_seal_many != NULL)
+        return ctx->cipher->aead_seal_many(ctx->algctx, num, iv, ivlen,
+                                           aad, aadlen, in, inl, out,
+                                           tag, taglen);
+
+    for (i = 0; i < num; i++)
+        if (!EVP_CIPHER_CTX_aead_seal(ctx, iv[i], ivlen,
+                                      aad != NULL ? aad[i] : NULL,
+                                      aad != NULL ? aadlen[i] : 0,
+                                      in[i], inl[i], out[i], tag[i], taglen))
+            return 0;
+    return 1;
+}
+
+int EVP_CIPHER_CTX_aead_open_many(EVP_CIPHER_CTX *ctx, size_t num,
+                                  const unsigned char *const iv[],
+                                  size_t ivlen,
+                                  const unsigned char *const aad[],
+                                  const size_t aadlen[],
+                                  const unsigned char *const in[],
+                                  const size_t inl[],
+                                  unsigned char *const out[],
+                                  const unsigned char *const tag[],
+                                  size_t taglen, int ok[])
+{
+    size_t i;
+    int r, ret = 1;
+
+    if (!aead_oneshot_check(ctx, 0, 0, tag, taglen))
+        return 0;
+
+    if (ctx->cipher->aead_open_many != NULL)
+        return ctx->cipher->aead_open_many(ctx->algctx, num, iv, ivlen,
+                                           aad, aadlen, in, inl, out,
+                                           tag, taglen, ok);
+
+    /* A packet that doesn't authenticate doesn't stop the others */
+    for (i = 0; i < num; i++) {
+        r = EVP_CIPHER_CTX_aead_open(ctx, iv[i], ivlen,
+                                     aad != NULL ? aad[i] : NULL,
+                                     aad != NULL ? aadlen[i] : 0,
+                                     in[i], inl[i], out[i], tag[i], taglen);
+        if (ok != NULL)
+            ok[i] = r;
+        ret &= r;
+    }
+    return ret;
+}
+
+int EVP_CIPHER_CTX_cipher_data_units(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                                     const unsigned char *in, size_t inl,
+                                     size_t unit_len, uint64_t first_unit)
+{
+    unsigned char iv[16];
+    uint64_t unit, hi = 0;
+    size_t i;
+    int outl;
+
+    if (ctx == NULL || ctx->cipher == NULL) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_NO_CIPHER_SET);
+        return 0;
+    }
+    if (EVP_CIPHER_CTX_get_mode(ctx) != EVP_CIPH_XTS_MODE
+        || EVP_CIPHER_CTX_get_iv_length(ctx) != (int)sizeof(iv)) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_UNSUPPORTED_CIPHER);
+        return 0;
+    }
+    if (unit_len == 0 || unit_len > INT_MAX || inl % unit_len != 0) {
+        ERR_raise(ERR_LIB_EVP, EVP_R_INVALID_LENGTH);
+        return 0;
+    }
+
+    if (ctx->cipher->cipher_data_units != NULL)
+        return ctx->cipher->cipher_data_units(ctx->algctx, out, in, inl,
+                                              unit_len, first_unit);
+
+    /* The tweak is the data unit number, a 128-bit little-endian integer */
+    for (unit = first_unit; inl > 0;
+         inl -= unit_len, in += unit_len, out += unit_len) {
+        for (i = 0; i < 8; i++) {
+            iv[i] = (unsigned char)(unit >> (8 * i));
+            iv[i + 8] = (unsigned char)(hi >> (8 * i));
+        }
+        if (!EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, -1)
+            || !EVP_CipherUpdate(ctx, out, &outl, in, (int)unit_len))
+            return 0;
+        if (++unit == 0)
+            hi++;
+    }
+    return 1;
+}
+
 int EVP_CIPHER_get_params(EVP_CIPHER *cipher, OSSL_PARAM params[])
 {
     if (cipher != NULL && cipher->get_params != NULL)
@@ -1566,6 +1864,42 @@ static void *evp_cipher_from_algorithm(const int name_id,
             cipher->settable_ctx_params =
                 OSSL_FUNC_cipher_settable_ctx_params(fns);
             break;
+        case OSSL_FUNC_CIPHER_GET_AEAD_TAG:
+            if (cipher->get_aead_tag != NULL)
+                break;
+            cipher->get_aead_tag = OSSL_FUNC_cipher_get_aead_tag(fns);
+            break;
+        case OSSL_FUNC_CIPHER_SET_AEAD_TAG:
+            if (cipher->set_aead_tag != NULL)
+                break;
+            cipher->set_aead_tag = OSSL_FUNC_cipher_set_aead_tag(fns);
+            break;
+        case OSSL_FUNC_CIPHER_AEAD_SEAL:
+            if (cipher->aead_seal != NULL)
+                break;
+            cipher->aead_seal = OSSL_FUNC_cipher_aead_seal(fns);
+            break;
+        case OSSL_FUNC_CIPHER_AEAD_OPEN:
+            if (cipher->aead_open != NULL)
+                break;
+            cipher->aead_open = OSSL_FUNC_cipher_aead_open(fns);
+            break;
+        case OSSL_FUNC_CIPHER_AEAD_SEAL_MANY:
+            if (cipher->aead_seal_many != NULL)
+                break;
+            cipher->aead_seal_many = OSSL_FUNC_cipher_aead_seal_many(fns);
+            break;
+        case OSSL_FUNC_CIPHER_AEAD_OPEN_MANY:
+            if (cipher->aead_open_many != NULL)
+                break;
+            cipher->aead_open_many = OSSL_FUNC_cipher_aead_open_many(fns);
+            break;
+        case OSSL_FUNC_CIPHER_CIPHER_DATA_UNITS:
+            if (cipher->cipher_data_units != NULL)
+                break;
+            cipher->cipher_data_units =
+                OSSL_FUNC_cipher_cipher_data_units(fns);
+            break;
         }
     }
     if ((fnciphcnt != 0 && fnciphcnt != 3 && fnciphcnt != 4)
@@ -19,6 +19,9 @@
 #include "internal/namemap.h"
 #include "internal/property.h"
 #include "crypto/evp.h"    /* evp_local.h needs it */
+#ifndef FIPS_MODULE
+# include "crypto/decoder.h" /* ossl_decoder_cache_flush */
+#endif
 #include "evp_local.h"
 
 #define NAME_SEPARATOR ':'
@@ -451,6 +454,11 @@ static int evp_set_parsed_default_properties(OSSL_LIB_CTX *libctx,
 #endif
         ossl_property_free(*plp);
         *plp = def_prop;
+#ifndef FIPS_MODULE
+        /* Cached decoder chains were built with the old defaults */
+        if (!ossl_decoder_cache_flush(libctx))
+            return 0;
+#endif
         if (store != NULL)
             return ossl_method_store_flush_cache(store, 0);
     }
@@ -88,6 +88,7 @@ struct evp_rand_ctx_st {
     EVP_RAND_CTX *parent;       /* Parent EVP_RAND or NULL if none */
     CRYPTO_REF_COUNT refcnt;    /* Context reference count */
     CRYPTO_RWLOCK *refcnt_lock;
+    size_t max_request;         /* Cached maximum request size, 0 if unknown */
 } /* EVP_RAND_CTX */ ;
 
 struct evp_keymgmt_st {
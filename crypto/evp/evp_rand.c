@@ -415,6 +415,7 @@ int EVP_RAND_CTX_get_params(EVP_RAND_CTX *ctx, OSSL_PARAM params[])
 static int evp_rand_set_ctx_params_locked(EVP_RAND_CTX *ctx,
                                           const OSSL_PARAM params[])
 {
+    ctx->max_request = 0;
     if (ctx->meth->set_ctx_params != NULL)
         return ctx->meth->set_ctx_params(ctx->algctx, params);
     return 1;
@@ -502,6 +503,7 @@ static int evp_rand_instantiate_locked
     (EVP_RAND_CTX *ctx, unsigned int strength, int prediction_resistance,
      const unsigned char *pstr, size_t pstr_len, const OSSL_PARAM params[])
 {
+    ctx->max_request = 0;
     return ctx->meth->instantiate(ctx->algctx, strength, prediction_resistance,
                                   pstr, pstr_len, params);
 }
@@ -523,6 +525,7 @@ int EVP_RAND_instantiate(EVP_RAND_CTX *ctx, unsigned int strength,
 
 static int evp_rand_uninstantiate_locked(EVP_RAND_CTX *ctx)
 {
+    ctx->max_request = 0;
     return ctx->meth->uninstantiate(ctx->algctx);
 }
 
@@ -543,15 +546,22 @@ static int evp_rand_generate_locked(EVP_RAND_CTX *ctx, unsigned char *out,
                                     const unsigned char *addin,
                                     size_t addin_len)
 {
-    size_t chunk, max_request = 0;
+    size_t chunk, max_request = ctx->max_request;
     OSSL_PARAM params[2] = { OSSL_PARAM_END, OSSL_PARAM_END };
 
-    params[0] = OSSL_PARAM_construct_size_t(OSSL_RAND_PARAM_MAX_REQUEST,
-                                            &max_request);
-    if (!evp_rand_get_ctx_params_locked(ctx, params)
-            || max_request == 0) {
-        ERR_raise(ERR_LIB_EVP, EVP_R_UNABLE_TO_GET_MAXIMUM_REQUEST_SIZE);
-        return 0;
+    /*
+     * The maximum request size is fixed once the RAND is instantiated, so
+     * it is only queried the first time around rather than on every call.
+     */
+    if (max_request == 0) {
+        params[0] = OSSL_PARAM_construct_size_t(OSSL_RAND_PARAM_MAX_REQUEST,
+                                                &max_request);
+        if (!evp_rand_get_ctx_params_locked(ctx, params)
+                || max_request == 0) {
+            ERR_raise(ERR_LIB_EVP, EVP_R_UNABLE_TO_GET_MAXIMUM_REQUEST_SIZE);
+            return 0;
+        }
+        ctx->max_request = max_request;
     }
     for (; outlen > 0; outlen -= chunk, out += chunk) {
         chunk = outlen > max_request ? max_request : outlen;
@@ -239,10 +239,18 @@ OP_CACHE_ELEM *evp_keymgmt_util_find_operation_cache(EVP_PKEY *pk,
     /*
      * A comparison and sk_P_CACHE_ELEM_find() are avoided to not cause
      * problems when we've only a read lock.
+     *
+     * Like for the "origin" check in evp_keymgmt_util_export_to_provider(),
+     * a keymgmt from the same provider with the same name ID matches too.
+     * A fetch cache flush creates new EVP_KEYMGMT objects, which would
+     * otherwise miss, redo the export and grow the cache.  This way there
+     * is at most one element per provider, so the search stays short.
      */
     for (i = 0; i < end; i++) {
         p = sk_OP_CACHE_ELEM_value(pk->operation_cache, i);
-        if (keymgmt == p->keymgmt)
+        if (keymgmt == p->keymgmt
+            || (keymgmt->name_id == p->keymgmt->name_id
+                && keymgmt->prov == p->keymgmt->prov))
             return p;
     }
     return NULL;
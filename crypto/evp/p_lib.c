@@ -42,6 +42,7 @@
 #include "crypto/dsa.h"
 #include "crypto/ec.h"
 #include "crypto/ecx.h"
+#include "crypto/err.h"
 #include "crypto/rsa.h"
 #ifndef FIPS_MODULE
 # include "crypto/asn1.h"
@@ -1275,9 +1276,9 @@ static int legacy_asn1_ctrl_to_param(EVP_PKEY *pkey, int op,
                 OSSL_NAMEMAP *namemap;
                 int nid = NID_undef;
 
-                (void)ERR_set_mark();
+                (void)ossl_err_suppress();
                 md = EVP_MD_fetch(libctx, mdname, NULL);
-                (void)ERR_pop_to_mark();
+                ossl_err_unsuppress();
                 namemap = ossl_namemap_stored(libctx);
 
                 /*
@@ -1353,10 +1354,10 @@ int EVP_PKEY_digestsign_supports_digest(EVP_PKEY *pkey, OSSL_LIB_CTX *libctx,
     if ((ctx = EVP_MD_CTX_new()) == NULL)
         return -1;
 
-    ERR_set_mark();
+    (void)ossl_err_suppress();
     rv = EVP_DigestSignInit_ex(ctx, NULL, name, libctx,
                                propq, pkey, NULL);
-    ERR_pop_to_mark();
+    ossl_err_unsuppress();
 
     EVP_MD_CTX_free(ctx);
     return rv;
@@ -1584,7 +1585,7 @@ static void find_ameth(const char *name, void *data)
      * The error messages from pkey_set_type() are uninteresting here,
      * and misleading.
      */
-    ERR_set_mark();
+    (void)ossl_err_suppress();
 
     if (pkey_set_type(NULL, NULL, EVP_PKEY_NONE, name, strlen(name),
                       NULL)) {
@@ -1594,7 +1595,7 @@ static void find_ameth(const char *name, void *data)
             str[1] = name;
     }
 
-    ERR_pop_to_mark();
+    ossl_err_unsuppress();
 }
 #endif
 
@@ -1883,14 +1884,32 @@ void *evp_pkey_export_to_provider(EVP_PKEY *pk, OSSL_LIB_CTX *libctx,
         if (!EVP_KEYMGMT_is_a(tmp_keymgmt, OBJ_nid2sn(pk->type)))
             goto end;
 
-        if ((keydata = evp_keymgmt_newdata(tmp_keymgmt)) == NULL)
-            goto end;
+        /*
+         * The built-in default provider works on the very same key
+         * structures as the legacy code, so if the legacy method allows,
+         * we simply give it a duplicate of the legacy key instead of
+         * serializing the key to an OSSL_PARAM array and back.  It has to
+         * be a copy rather than a reference: the legacy key may be changed
+         * through its own API, even while provider operations are using
+         * the exported key on other threads.
+         */
+        if (pk->ameth->dup_to != NULL
+            && ossl_provider_is_builtin_default(tmp_keymgmt->prov)) {
+            OSSL_LIB_CTX *provlibctx = ossl_provider_libctx(tmp_keymgmt->prov);
 
-        if (!pk->ameth->export_to(pk, keydata, tmp_keymgmt->import,
-                                  libctx, propquery)) {
-            evp_keymgmt_freedata(tmp_keymgmt, keydata);
-            keydata = NULL;
-            goto end;
+            keydata = pk->ameth->dup_to(pk, provlibctx);
+        }
+
+        if (keydata == NULL) {
+            if ((keydata = evp_keymgmt_newdata(tmp_keymgmt)) == NULL)
+                goto end;
+
+            if (!pk->ameth->export_to(pk, keydata, tmp_keymgmt->import,
+                                      libctx, propquery)) {
+                evp_keymgmt_freedata(tmp_keymgmt, keydata);
+                keydata = NULL;
+                goto end;
+            }
         }
 
         /*
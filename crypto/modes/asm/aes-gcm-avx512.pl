@@ -0,0 +1,796 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+#
+# VAES+VPCLMULQDQ CTR+GHASH for AVX-512 capable processors.
+#
+# aesni-gcm-x86_64.pl processes six 16-byte blocks per iteration in
+# 128-bit registers. Ice Lake and later can execute AES rounds and
+# carry-less multiplications on full 512-bit registers, i.e. on four
+# blocks per instruction, at the same issue rate as on 128-bit ones.
+# This module takes advantage of that. The bulk loop encrypts sixteen
+# counter blocks in four %zmm registers and hashes the 256 bytes of
+# ciphertext with sixteen precomputed powers of H, H^16 .. H^1, so that
+# a single reduction is performed per iteration. Shorter input is
+# processed 64 bytes at a time with H^4 .. H^1, anything shorter than
+# 64 bytes is left to the caller. The loop is not explicitly stitched,
+# but encryption of the next chunk does not depend on hashing of the
+# previous one, which lets out-of-order execution overlap the two.
+#
+# The powers of H are kept in bit-reflected and "twisted" form, as
+# computed by gcm_init_clmul, see ghash-x86_64.pl, and are produced by
+# ossl_gcm_init_avx512. The table goes up to H^32 for the benefit of
+# ossl_gcm_ghash_avx512, which hashes whole short messages, e.g. AAD,
+# ciphertext and the length block, with a single reduction. It is
+# paired with ossl_aes_ctr32_encrypt_avx512, plain counter mode.
+#
+#		aesni_gcm	this module
+# Ice Lake	0.49		0.25		cycles per byte, 8KB, AES-128
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+# VAES and VPCLMULQDQ on %zmm registers
+$vaes = 0;
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$vaes = ($1>=2.30);
+}
+
+if (!$vaes && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
+	    `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)/) {
+	$vaes = ($1>=2.14);
+}
+
+if (!$vaes && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$vaes = ($2>=7.0);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+if ($vaes) {{{
+
+($inp,$out,$len,$key,$ivp,$Xip)=("%rdi","%rsi","%rdx","%rcx","%r8","%r9");
+my $Htbl="%r10";		# 7th argument
+my $ret="%r11";
+my $seventh_arg = $win64 ? 56 : 8;
+
+my @S=map("%zmm$_",(0..3));	# AES state, GHASH accumulators afterwards
+my @D=map("%zmm$_",(4..7));	# byte-swapped ciphertext
+my @H=map("%zmm$_",(8..11));	# H^16..H^13, H^12..H^9, H^8..H^5, H^4..H^1
+my ($ctr,$T,$bswap,$Xi)=map("%zmm$_",(12..15));
+my @rk=map("%zmm$_",(16..29));	# round keys 0..13
+my ($inc4,$rklast)=("%zmm30","%zmm31");
+
+my ($LO,$HI,$MID,$T1)=@S;
+
+# Encrypt $n counter blocks of four, i.e. @S[0..$n-1], advancing $ctr.
+sub aes_ctr {
+my ($n,$label)=@_;
+my $code="";
+
+    for (my $i=0; $i<$n; $i++) {
+	$code.=<<___;
+	vpshufb		$bswap,$ctr,@S[$i]
+	vpaddd		$inc4,$ctr,$ctr
+___
+    }
+    for (my $i=0; $i<$n; $i++) {
+	$code.="	vpxorq		@rk[0],@S[$i],@S[$i]\n";
+    }
+    for (my $r=1; $r<14; $r++) {
+	$code.="	cmpl		\$11,240($key)\n"	if ($r==10);
+	$code.="	jb		.Laes_last$label$n\n" if ($r==10);
+	$code.="	je		.Laes_last$label$n\n" if ($r==12);
+	for (my $i=0; $i<$n; $i++) {
+	    $code.="	vaesenc		@rk[$r],@S[$i],@S[$i]\n";
+	}
+    }
+    $code.=".Laes_last$label$n:\n";
+    for (my $i=0; $i<$n; $i++) {
+	$code.="	vaesenclast	$rklast,@S[$i],@S[$i]\n";
+    }
+    $code;
+}
+
+# Multiply @D[0..$n-1] by @H[4-$n..3], fold the results of all lanes
+# together, reduce, and leave the result in $Xi. $Xi is added to the
+# first block on input, which is the lowest lane of @D[0].
+sub ghash {
+my $n=shift;
+my @h=@H[4-$n..3];
+my $code=<<___;
+	vpxorq		$Xi,@D[0],@D[0]
+	vpclmulqdq	\$0x00,@h[0],@D[0],$LO
+	vpclmulqdq	\$0x11,@h[0],@D[0],$HI
+	vpclmulqdq	\$0x01,@h[0],@D[0],$MID
+	vpclmulqdq	\$0x10,@h[0],@D[0],$T1
+	vpxorq		$T1,$MID,$MID
+___
+    for (my $i=1; $i<$n; $i++) {
+	$code.=<<___;
+	vpclmulqdq	\$0x00,@h[$i],@D[$i],$T1
+	vpclmulqdq	\$0x11,@h[$i],@D[$i],$T
+	vpxorq		$T1,$LO,$LO
+	vpxorq		$T,$HI,$HI
+	vpclmulqdq	\$0x01,@h[$i],@D[$i],$T1
+	vpclmulqdq	\$0x10,@h[$i],@D[$i],$T
+	vpternlogq	\$0x96,$T1,$T,$MID
+___
+    }
+    my ($lo,$hi,$t1)=map("%xmm$_",(0..1,3));
+    my ($ylo,$yhi,$yt1)=map("%ymm$_",(0..1,3));
+    my $xi="%xmm15";
+    $code.=<<___;
+	vpslldq		\$8,$MID,$T1
+	vpsrldq		\$8,$MID,$MID
+	vpxorq		$T1,$LO,$LO
+	vpxorq		$MID,$HI,$HI
+
+	vextracti64x4	\$1,$LO,$yt1		# fold lanes
+	vpxor		$yt1,$ylo,$ylo
+	vextracti64x4	\$1,$HI,$yt1
+	vpxor		$yt1,$yhi,$yhi
+	vextracti128	\$1,$ylo,$t1
+	vpxor		$t1,$lo,$lo
+	vextracti128	\$1,$yhi,$t1
+	vpxor		$t1,$hi,$hi
+
+	vpalignr	\$8,$lo,$lo,$t1		# 1st phase
+	vpclmulqdq	\$0x10,.Lpoly(%rip),$lo,$lo
+	vpxor		$t1,$lo,$lo
+
+	vpalignr	\$8,$lo,$lo,$t1		# 2nd phase
+	vpclmulqdq	\$0x10,.Lpoly(%rip),$lo,$lo
+	vpxor		$hi,$t1,$t1
+	vpxor		$t1,$lo,$xi		# upper lanes of $Xi are zero
+___
+    $code;
+}
+
+$code=<<___;
+.text
+
+.globl	ossl_vaes_vpclmulqdq_capable
+.type	ossl_vaes_vpclmulqdq_capable,\@abi-omnipotent
+.align	32
+ossl_vaes_vpclmulqdq_capable:
+.cfi_startproc
+	mov	OPENSSL_ia32cap_P+8(%rip),%rcx
+	# AVX512F, AVX512BW, AVX512VL, VAES and VPCLMULQDQ
+	mov	\$`1<<16|1<<30|1<<31|1<<41|1<<42`,%rdx
+	xor	%eax,%eax
+	and	%rdx,%rcx
+	cmp	%rdx,%rcx
+	sete	%al
+	ret
+.cfi_endproc
+.size	ossl_vaes_vpclmulqdq_capable,.-ossl_vaes_vpclmulqdq_capable
+___
+
+{
+my ($Htable,$Hp)=("%rdi","%rsi");
+my ($Hkey,$X,$T1,$T2,$T3,$Z)=map("%xmm$_",(0..5));
+
+$code.=<<___;
+.globl	ossl_gcm_init_avx512
+.type	ossl_gcm_init_avx512,\@function,2
+.align	32
+ossl_gcm_init_avx512:
+.cfi_startproc
+	vmovdqu		($Hp),$Hkey
+	vpshufd		\$0b01001110,$Hkey,$Hkey	# dword swap
+
+	# <<1 twist
+	vpshufd		\$0b11111111,$Hkey,$T2	# broadcast uppermost dword
+	vpsrlq		\$63,$Hkey,$T1
+	vpsllq		\$1,$Hkey,$Hkey
+	vpxor		$T3,$T3,$T3		#
+	vpcmpgtd	$T2,$T3,$T3		# broadcast carry bit
+	vpslldq		\$8,$T1,$T1
+	vpor		$T1,$Hkey,$Hkey		# H<<=1
+
+	# magic reduction
+	vpand		.L0x1c2_polynomial(%rip),$T3,$T3
+	vpxor		$T3,$Hkey,$Hkey		# if(carry) H^=0x1c2_polynomial
+
+	vmovdqu		$Hkey,0x1f0($Htable)	# H^1 goes last
+	vmovdqa		$Hkey,$X
+	lea		0x1e0($Htable),$Htable
+	mov		\$31,%eax
+	jmp		.Linit_loop
+
+.align	16
+.Linit_loop:
+	vpclmulqdq	\$0x00,$Hkey,$X,$T1
+	vpclmulqdq	\$0x11,$Hkey,$X,$Z
+	vpclmulqdq	\$0x01,$Hkey,$X,$T2
+	vpclmulqdq	\$0x10,$Hkey,$X,$T3
+	vpxor		$T3,$T2,$T2
+	vpslldq		\$8,$T2,$T3
+	vpsrldq		\$8,$T2,$T2
+	vpxor		$T3,$T1,$X
+	vpxor		$T2,$Z,$Z
+
+	vpalignr	\$8,$X,$X,$T2		# 1st phase
+	vpclmulqdq	\$0x10,.Lpoly(%rip),$X,$X
+	vpxor		$T2,$X,$X
+
+	vpalignr	\$8,$X,$X,$T2		# 2nd phase
+	vpclmulqdq	\$0x10,.Lpoly(%rip),$X,$X
+	vpxor		$Z,$T2,$T2
+	vpxor		$T2,$X,$X
+
+	vmovdqu		$X,($Htable)
+	lea		-0x10($Htable),$Htable
+	dec		%eax
+	jnz		.Linit_loop
+
+	vzeroupper
+	ret
+.cfi_endproc
+.size	ossl_gcm_init_avx512,.-ossl_gcm_init_avx512
+___
+}
+
+{
+my ($Xip,$Htbl,$inp,$len)=("%rdi","%rsi","%rdx","%rcx");
+my ($D,$Hk,$T1,$T2,$bswap)=map("%zmm$_",(16..20));
+my ($LO,$HI,$MID,$T)=map("%zmm$_",(0..3));
+my ($lo,$hi,$t)=map("%xmm$_",(0..1,3));
+my ($ylo,$yhi,$yt)=map("%ymm$_",(0..1,3));
+my $Xi="%zmm5";
+my $xi="%xmm5";
+
+# ossl_gcm_ghash_avx512 hashes $len bytes with up to 32 blocks per
+# reduction. The first chunk takes the remainder, so that whole short
+# messages, e.g. AAD, ciphertext and the length block, are usually
+# reduced once. Each chunk of k blocks is multiplied by H^k .. H^1,
+# four blocks at a time, with blocks past the end masked off.
+
+$code.=<<___;
+.globl	ossl_gcm_ghash_avx512
+.type	ossl_gcm_ghash_avx512,\@function,4
+.align	32
+ossl_gcm_ghash_avx512:
+.cfi_startproc
+	endbranch
+	shr		\$4,$len
+	jz		.Lghash_abort
+
+	vbroadcasti32x4	.Lbswap_mask(%rip),$bswap
+	vmovdqu		($Xip),$xi
+	vpshufb		.Lbswap_mask(%rip),$xi,$xi
+	mov		$len,%r11			# blocks left
+	lea		-1($len),%rax
+	and		\$31,%eax
+	inc		%eax				# first chunk, 1..32 blocks
+
+.Lghash_chunk:
+	mov		\$64,%ecx
+	sub		%eax,%ecx
+	sub		%eax,%ecx
+	mov		\$-1,%r8
+	shrq		%cl,%r8				# 2*k quadwords
+	kmovq		%r8,%k1
+	mov		\$32,%ecx
+	sub		%eax,%ecx
+	shl		\$4,%rcx
+	lea		($Htbl,%rcx),%r9		# H^k
+	shl		\$4,%rax
+	lea		($inp,%rax),%r8			# next chunk
+	shr		\$4,%rax
+	lea		3(%rax),%r10d
+	shr		\$2,%r10d			# groups of four blocks
+	vpxorq		$LO,$LO,$LO
+	vpxorq		$HI,$HI,$HI
+	vpxorq		$MID,$MID,$MID
+
+.Lghash_group:
+	vmovdqu64	($inp),${D}{%k1}{z}
+	vmovdqu64	(%r9),${Hk}{%k1}{z}
+	kshiftrq	\$8,%k1,%k1
+	lea		0x40($inp),$inp
+	lea		0x40(%r9),%r9
+	vpshufb		$bswap,$D,$D
+	vpxorq		$Xi,$D,$D
+	vpxor		$xi,$xi,$xi			# added to the first block only
+	vpclmulqdq	\$0x00,$Hk,$D,$T1
+	vpclmulqdq	\$0x11,$Hk,$D,$T2
+	vpxorq		$T1,$LO,$LO
+	vpxorq		$T2,$HI,$HI
+	vpclmulqdq	\$0x01,$Hk,$D,$T1
+	vpclmulqdq	\$0x10,$Hk,$D,$T2
+	vpternlogq	\$0x96,$T1,$T2,$MID
+	dec		%r10d
+	jnz		.Lghash_group
+
+	mov		%r8,$inp
+	vpslldq		\$8,$MID,$T
+	vpsrldq		\$8,$MID,$MID
+	vpxorq		$T,$LO,$LO
+	vpxorq		$MID,$HI,$HI
+
+	vextracti64x4	\$1,$LO,$yt			# fold lanes
+	vpxor		$yt,$ylo,$ylo
+	vextracti64x4	\$1,$HI,$yt
+	vpxor		$yt,$yhi,$yhi
+	vextracti128	\$1,$ylo,$t
+	vpxor		$t,$lo,$lo
+	vextracti128	\$1,$yhi,$t
+	vpxor		$t,$hi,$hi
+
+	vpalignr	\$8,$lo,$lo,$t			# 1st phase
+	vpclmulqdq	\$0x10,.Lpoly(%rip),$lo,$lo
+	vpxor		$t,$lo,$lo
+
+	vpalignr	\$8,$lo,$lo,$t			# 2nd phase
+	vpclmulqdq	\$0x10,.Lpoly(%rip),$lo,$lo
+	vpxor		$hi,$t,$t
+	vpxor		$t,$lo,$xi
+
+	sub		%rax,%r11
+	mov		\$32,%eax
+	jnz		.Lghash_chunk
+
+	vpshufb		.Lbswap_mask(%rip),$xi,$xi
+	vmovdqu		$xi,($Xip)
+	vzeroupper
+.Lghash_abort:
+	ret
+.cfi_endproc
+.size	ossl_gcm_ghash_avx512,.-ossl_gcm_ghash_avx512
+___
+}
+
+for my $dir ("en","de") {
+my $enc = $dir eq "en";
+my $label = "_${dir}c";
+
+$code.=<<___;
+.globl	ossl_aes_gcm_${dir}crypt_avx512
+.type	ossl_aes_gcm_${dir}crypt_avx512,\@function,6
+.align	32
+ossl_aes_gcm_${dir}crypt_avx512:
+.cfi_startproc
+	endbranch
+	lea		(%rsp),%rax
+.cfi_def_cfa_register	%rax
+	xor		$ret,$ret
+	and		\$-64,$len
+	jz		.Lgcm${label}_abort
+	mov		$seventh_arg(%rax),$Htbl	# 7th argument
+___
+$code.=<<___ if ($win64);
+	lea		-0xa8(%rsp),%rsp
+	movaps		%xmm6,-0xa8(%rax)
+	movaps		%xmm7,-0x98(%rax)
+	movaps		%xmm8,-0x88(%rax)
+	movaps		%xmm9,-0x78(%rax)
+	movaps		%xmm10,-0x68(%rax)
+	movaps		%xmm11,-0x58(%rax)
+	movaps		%xmm12,-0x48(%rax)
+	movaps		%xmm13,-0x38(%rax)
+	movaps		%xmm14,-0x28(%rax)
+	movaps		%xmm15,-0x18(%rax)
+.Lgcm${label}_body:
+___
+$code.=<<___;
+	mov		$len,$ret			# return value
+
+	vbroadcasti32x4	.Lbswap_mask(%rip),$bswap
+	vbroadcasti32x4	.Linc4(%rip),$inc4
+	vbroadcasti32x4	($ivp),$ctr
+	vpshufb		$bswap,$ctr,$ctr
+	vpaddd		.Lctr_add(%rip),$ctr,$ctr	# lanes are counter+0..3
+	vmovdqu		($Xip),%xmm15
+	vpshufb		%xmm14,%xmm15,%xmm15
+
+	vmovdqu64	0x00($Htbl),@H[0]
+	vmovdqu64	0x40($Htbl),@H[1]
+	vmovdqu64	0x80($Htbl),@H[2]
+	vmovdqu64	0xc0($Htbl),@H[3]
+
+	mov		240($key),%r10d
+	shl		\$4,%r10
+	vbroadcasti32x4	16($key,%r10),$rklast
+___
+for (my $r=0; $r<14; $r++) {
+	$code.="	vbroadcasti32x4	".(16*$r)."($key),@rk[$r]\n";
+}
+$code.=<<___;
+
+	mov		$len,%r10
+	shr		\$6,%r10			# 64-byte chunks
+	mov		12($ivp),%eax
+	bswap		%eax
+	lea		(%rax,%r10,4),%eax		# advance counter
+	bswap		%eax
+	mov		%eax,12($ivp)
+
+	sub		\$256,$len
+	jb		.Lgcm${label}_tail
+	jmp		.Lgcm${label}_loop
+
+.align	32
+.Lgcm${label}_loop:
+___
+if ($enc) {
+	$code.=aes_ctr(4,$label);
+	$code.=<<___;
+	vpxorq		0x00($inp),@S[0],@S[0]
+	vpxorq		0x40($inp),@S[1],@S[1]
+	vpxorq		0x80($inp),@S[2],@S[2]
+	vpxorq		0xc0($inp),@S[3],@S[3]
+	lea		0x100($inp),$inp
+	vmovdqu64	@S[0],0x00($out)
+	vmovdqu64	@S[1],0x40($out)
+	vmovdqu64	@S[2],0x80($out)
+	vmovdqu64	@S[3],0xc0($out)
+	lea		0x100($out),$out
+	vpshufb		$bswap,@S[0],@D[0]
+	vpshufb		$bswap,@S[1],@D[1]
+	vpshufb		$bswap,@S[2],@D[2]
+	vpshufb		$bswap,@S[3],@D[3]
+___
+	$code.=ghash(4);
+} else {
+	$code.=<<___;
+	vmovdqu64	0x00($inp),@D[0]
+	vmovdqu64	0x40($inp),@D[1]
+	vmovdqu64	0x80($inp),@D[2]
+	vmovdqu64	0xc0($inp),@D[3]
+	vpshufb		$bswap,@D[0],@D[0]
+	vpshufb		$bswap,@D[1],@D[1]
+	vpshufb		$bswap,@D[2],@D[2]
+	vpshufb		$bswap,@D[3],@D[3]
+___
+	$code.=ghash(4);
+	$code.=aes_ctr(4,$label);
+	$code.=<<___;
+	vpxorq		0x00($inp),@S[0],@S[0]
+	vpxorq		0x40($inp),@S[1],@S[1]
+	vpxorq		0x80($inp),@S[2],@S[2]
+	vpxorq		0xc0($inp),@S[3],@S[3]
+	lea		0x100($inp),$inp
+	vmovdqu64	@S[0],0x00($out)
+	vmovdqu64	@S[1],0x40($out)
+	vmovdqu64	@S[2],0x80($out)
+	vmovdqu64	@S[3],0xc0($out)
+	lea		0x100($out),$out
+___
+}
+$code.=<<___;
+	sub		\$256,$len
+	jae		.Lgcm${label}_loop
+
+.Lgcm${label}_tail:
+	add		\$256,$len
+	jz		.Lgcm${label}_done
+
+.Lgcm${label}_loop64:
+___
+if ($enc) {
+	$code.=aes_ctr(1,$label);
+	$code.=<<___;
+	vpxorq		($inp),@S[0],@S[0]
+	lea		0x40($inp),$inp
+	vmovdqu64	@S[0],($out)
+	lea		0x40($out),$out
+	vpshufb		$bswap,@S[0],@D[0]
+___
+	$code.=ghash(1);
+} else {
+	$code.=<<___;
+	vmovdqu64	($inp),@D[0]
+	vpshufb		$bswap,@D[0],@D[0]
+___
+	$code.=ghash(1);
+	$code.=aes_ctr(1,$label);
+	$code.=<<___;
+	vpxorq		($inp),@S[0],@S[0]
+	lea		0x40($inp),$inp
+	vmovdqu64	@S[0],($out)
+	lea		0x40($out),$out
+___
+}
+$code.=<<___;
+	sub		\$64,$len
+	jnz		.Lgcm${label}_loop64
+
+.Lgcm${label}_done:
+	vpshufb		%xmm14,%xmm15,%xmm15
+	vmovdqu		%xmm15,($Xip)			# output Xi
+
+	vzeroupper
+___
+$code.=<<___ if ($win64);
+	movaps	-0xa8(%rax),%xmm6
+	movaps	-0x98(%rax),%xmm7
+	movaps	-0x88(%rax),%xmm8
+	movaps	-0x78(%rax),%xmm9
+	movaps	-0x68(%rax),%xmm10
+	movaps	-0x58(%rax),%xmm11
+	movaps	-0x48(%rax),%xmm12
+	movaps	-0x38(%rax),%xmm13
+	movaps	-0x28(%rax),%xmm14
+	movaps	-0x18(%rax),%xmm15
+	lea	(%rax),%rsp			# restore %rsp
+___
+$code.=<<___;
+.Lgcm${label}_abort:
+	mov		$ret,%rax			# return value
+	ret
+.cfi_endproc
+.size	ossl_aes_gcm_${dir}crypt_avx512,.-ossl_aes_gcm_${dir}crypt_avx512
+___
+}
+
+{
+my ($inp,$out,$blocks,$key,$ivp)=("%rdi","%rsi","%rdx","%rcx","%r8");
+
+# Plain counter mode with the ctr128_f interface, for whatever the GCM
+# functions above don't cover: short messages and tails. The counter and
+# byte swap mask are moved to registers that are volatile on Win64.
+($ctr,$bswap)=("%zmm4","%zmm5");
+
+$code.=<<___;
+.globl	ossl_aes_ctr32_encrypt_avx512
+.type	ossl_aes_ctr32_encrypt_avx512,\@function,5
+.align	32
+ossl_aes_ctr32_encrypt_avx512:
+.cfi_startproc
+	endbranch
+	test		$blocks,$blocks
+	jz		.Lctr32_abort
+
+	vbroadcasti32x4	.Lbswap_mask(%rip),$bswap
+	vbroadcasti32x4	.Linc4(%rip),$inc4
+	vbroadcasti32x4	($ivp),$ctr
+	vpshufb		$bswap,$ctr,$ctr
+	vpaddd		.Lctr_add(%rip),$ctr,$ctr	# lanes are counter+0..3
+
+	mov		240($key),%eax
+	shl		\$4,%rax
+	vbroadcasti32x4	16($key,%rax),$rklast
+___
+for (my $r=0; $r<14; $r++) {
+	$code.="	vbroadcasti32x4	".(16*$r)."($key),@rk[$r]\n";
+}
+$code.=<<___;
+
+	sub		\$16,$blocks
+	jb		.Lctr32_tail
+
+.align	32
+.Lctr32_loop16:
+___
+$code.=aes_ctr(4,"_ctr32");
+$code.=<<___;
+	vpxorq		0x00($inp),@S[0],@S[0]
+	vpxorq		0x40($inp),@S[1],@S[1]
+	vpxorq		0x80($inp),@S[2],@S[2]
+	vpxorq		0xc0($inp),@S[3],@S[3]
+	lea		0x100($inp),$inp
+	vmovdqu64	@S[0],0x00($out)
+	vmovdqu64	@S[1],0x40($out)
+	vmovdqu64	@S[2],0x80($out)
+	vmovdqu64	@S[3],0xc0($out)
+	lea		0x100($out),$out
+	sub		\$16,$blocks
+	jae		.Lctr32_loop16
+
+.Lctr32_tail:
+	add		\$16,$blocks
+	jz		.Lctr32_done
+
+.Lctr32_loop4:
+___
+$code.=aes_ctr(1,"_ctr32");
+$code.=<<___;
+	cmp		\$4,$blocks
+	jb		.Lctr32_last
+	vpxorq		($inp),@S[0],@S[0]
+	lea		0x40($inp),$inp
+	vmovdqu64	@S[0],($out)
+	lea		0x40($out),$out
+	sub		\$4,$blocks
+	jnz		.Lctr32_loop4
+	jmp		.Lctr32_done
+
+.Lctr32_last:
+	lea		($blocks,$blocks),%ecx
+	mov		\$1,%eax
+	shll		%cl,%eax
+	dec		%eax				# 2*blocks quadwords
+	kmovd		%eax,%k1
+	vmovdqu64	($inp),@S[1]\{%k1\}\{z\}
+	vpxorq		@S[1],@S[0],@S[0]
+	vmovdqu64	@S[0],($out)\{%k1\}
+
+.Lctr32_done:
+	vzeroupper
+.Lctr32_abort:
+	ret
+.cfi_endproc
+.size	ossl_aes_ctr32_encrypt_avx512,.-ossl_aes_ctr32_encrypt_avx512
+___
+}
+
+$code.=<<___;
+.align	64
+.Lctr_add:
+	.long	0,0,0,0, 1,0,0,0, 2,0,0,0, 3,0,0,0
+.Linc4:
+	.long	4,0,0,0
+.Lbswap_mask:
+	.byte	15,14,13,12,11,10,9,8,7,6,5,4,3,2,1,0
+.Lpoly:
+	.byte	0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0xc2
+.L0x1c2_polynomial:
+	.byte	1,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0xc2
+.align	64
+___
+
+if ($win64) {
+$rec="%rcx";
+$frame="%rdx";
+$context="%r8";
+$disp="%r9";
+
+$code.=<<___;
+.extern	__imp_RtlVirtualUnwind
+.type	gcm_avx512_se_handler,\@abi-omnipotent
+.align	16
+gcm_avx512_se_handler:
+	push	%rsi
+	push	%rdi
+	push	%rbx
+	push	%rbp
+	push	%r12
+	push	%r13
+	push	%r14
+	push	%r15
+	pushfq
+	sub	\$64,%rsp
+
+	mov	120($context),%rax	# pull context->Rax
+	mov	248($context),%rbx	# pull context->Rip
+
+	mov	8($disp),%rsi		# disp->ImageBase
+	mov	56($disp),%r11		# disp->HandlerData
+
+	mov	0(%r11),%r10d		# HandlerData[0]
+	lea	(%rsi,%r10),%r10	# prologue label
+	cmp	%r10,%rbx		# context->Rip<prologue label
+	jb	.Lcommon_seh_tail
+
+	mov	4(%r11),%r10d		# HandlerData[1]
+	lea	(%rsi,%r10),%r10	# epilogue label
+	cmp	%r10,%rbx		# context->Rip>=epilogue label
+	jae	.Lcommon_seh_tail
+
+	lea	-0xa8(%rax),%rsi	# %xmm save area
+	lea	512($context),%rdi	# & context.Xmm6
+	mov	\$20,%ecx		# 10*sizeof(%xmm0)/sizeof(%rax)
+	.long	0xa548f3fc		# cld; rep movsq
+
+.Lcommon_seh_tail:
+	mov	8(%rax),%rdi
+	mov	16(%rax),%rsi
+	mov	%rax,152($context)	# restore context->Rsp
+	mov	%rsi,168($context)	# restore context->Rsi
+	mov	%rdi,176($context)	# restore context->Rdi
+
+	mov	40($disp),%rdi		# disp->ContextRecord
+	mov	$context,%rsi		# context
+	mov	\$154,%ecx		# sizeof(CONTEXT)
+	.long	0xa548f3fc		# cld; rep movsq
+
+	mov	$disp,%rsi
+	xor	%rcx,%rcx		# arg1, UNW_FLAG_NHANDLER
+	mov	8(%rsi),%rdx		# arg2, disp->ImageBase
+	mov	0(%rsi),%r8		# arg3, disp->ControlPc
+	mov	16(%rsi),%r9		# arg4, disp->FunctionEntry
+	mov	40(%rsi),%r10		# disp->ContextRecord
+	lea	56(%rsi),%r11		# &disp->HandlerData
+	lea	24(%rsi),%r12		# &disp->EstablisherFrame
+	mov	%r10,32(%rsp)		# arg5
+	mov	%r11,40(%rsp)		# arg6
+	mov	%r12,48(%rsp)		# arg7
+	mov	%rcx,56(%rsp)		# arg8, (NULL)
+	call	*__imp_RtlVirtualUnwind(%rip)
+
+	mov	\$1,%eax		# ExceptionContinueSearch
+	add	\$64,%rsp
+	popfq
+	pop	%r15
+	pop	%r14
+	pop	%r13
+	pop	%r12
+	pop	%rbp
+	pop	%rbx
+	pop	%rdi
+	pop	%rsi
+	ret
+.size	gcm_avx512_se_handler,.-gcm_avx512_se_handler
+
+.section	.pdata
+.align	4
+	.rva	.LSEH_begin_ossl_aes_gcm_encrypt_avx512
+	.rva	.LSEH_end_ossl_aes_gcm_encrypt_avx512
+	.rva	.LSEH_gcm_enc_avx512_info
+
+	.rva	.LSEH_begin_ossl_aes_gcm_decrypt_avx512
+	.rva	.LSEH_end_ossl_aes_gcm_decrypt_avx512
+	.rva	.LSEH_gcm_dec_avx512_info
+.section	.xdata
+.align	8
+.LSEH_gcm_enc_avx512_info:
+	.byte	9,0,0,0
+	.rva	gcm_avx512_se_handler
+	.rva	.Lgcm_enc_body,.Lgcm_enc_abort
+.LSEH_gcm_dec_avx512_info:
+	.byte	9,0,0,0
+	.rva	gcm_avx512_se_handler
+	.rva	.Lgcm_dec_body,.Lgcm_dec_abort
+___
+}
+}}} else {{{
+$code=<<___;	# assembler is too old
+.text
+
+.globl	ossl_vaes_vpclmulqdq_capable
+.type	ossl_vaes_vpclmulqdq_capable,\@abi-omnipotent
+ossl_vaes_vpclmulqdq_capable:
+.cfi_startproc
+	xor	%eax,%eax
+	ret
+.cfi_endproc
+.size	ossl_vaes_vpclmulqdq_capable,.-ossl_vaes_vpclmulqdq_capable
+
+.globl	ossl_gcm_init_avx512
+.globl	ossl_gcm_ghash_avx512
+.globl	ossl_aes_gcm_encrypt_avx512
+.globl	ossl_aes_gcm_decrypt_avx512
+.globl	ossl_aes_ctr32_encrypt_avx512
+.type	ossl_gcm_init_avx512,\@abi-omnipotent
+.type	ossl_gcm_ghash_avx512,\@abi-omnipotent
+.type	ossl_aes_gcm_encrypt_avx512,\@abi-omnipotent
+.type	ossl_aes_gcm_decrypt_avx512,\@abi-omnipotent
+.type	ossl_aes_ctr32_encrypt_avx512,\@abi-omnipotent
+ossl_gcm_init_avx512:
+ossl_gcm_ghash_avx512:
+ossl_aes_gcm_encrypt_avx512:
+ossl_aes_gcm_decrypt_avx512:
+ossl_aes_ctr32_encrypt_avx512:
+.cfi_startproc
+	.byte	0x0f,0x0b	# ud2
+	ret
+.cfi_endproc
+.size	ossl_gcm_init_avx512,.-ossl_gcm_init_avx512
+___
+}}}
+
+$code =~ s/\`([^\`]*)\`/eval($1)/gem;
+
+print $code;
+
+close STDOUT or die "error closing STDOUT: $!";
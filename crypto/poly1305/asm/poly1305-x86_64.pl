@@ -3924,6 +3924,247 @@ xor128_decrypt_n_pad:
 ___
 }
 
+{	# Poly1305 of eight independent messages, for batched chacha20-poly1305
+	#
+	# int poly1305_blocks_8xlanes(uint64_t h[5][8], uint64_t r[9][8],
+	#                             const unsigned char *inp, size_t blocks,
+	#                             const uint64_t start[8]);
+	#
+	# Lane j hashes the j-th 16-byte block of each of |blocks| 128-byte
+	# rows at |inp| into the accumulator h[0..4][j], base 2^26, with its
+	# own key r[0..8][j], which is r0, r1, 5*r1, r2, 5*r2, r3, 5*r3, r4
+	# and 5*r4 base 2^26.  Rows before start[j] have to be zero and are
+	# hashed without padbit, so they don't change the result.  This lets
+	# messages of different length share the rows by ending in the last
+	# one.  The accumulator is left partially reduced.  The lanes are
+	# processed four at a time, with the inner loop of the AVX2 code
+	# path above except that every lane multiplies by its own key
+	# instead of by r^4.  The return value is 1, or 0 if the code was
+	# built without AVX2 support and nothing was done.
+my ($h,$r,$inp,$len,$start)=("%rdi","%rsi","%rdx","%rcx","%r8");
+my ($H0,$H1,$H2,$H3,$H4, $D0,$D1,$D2,$D3,$D4, $T0,$T1, $MASK,$J,$START,$ONE)=
+    map("%ymm$_",(0..15));
+
+if ($avx>1) {
+$code.=<<___;
+.globl	poly1305_blocks_8xlanes
+.type	poly1305_blocks_8xlanes,\@function,5
+.align	32
+poly1305_blocks_8xlanes:
+.cfi_startproc
+___
+$code.=<<___	if ($win64);
+	lea		-0xf8(%rsp),%r11
+	sub		\$0xf8,%rsp
+	vmovdqa		%xmm6,0x50(%r11)
+	vmovdqa		%xmm7,0x60(%r11)
+	vmovdqa		%xmm8,0x70(%r11)
+	vmovdqa		%xmm9,0x80(%r11)
+	vmovdqa		%xmm10,0x90(%r11)
+	vmovdqa		%xmm11,0xa0(%r11)
+	vmovdqa		%xmm12,0xb0(%r11)
+	vmovdqa		%xmm13,0xc0(%r11)
+	vmovdqa		%xmm14,0xd0(%r11)
+	vmovdqa		%xmm15,0xe0(%r11)
+.Ldo_8xlanes_body:
+___
+$code.=<<___;
+	test		$len,$len
+	jz		.Ldone_8xlanes
+
+	vmovdqa		.Lmask26(%rip),$MASK
+	vpcmpeqq	$ONE,$ONE,$ONE
+	vpsrlq		\$63,$ONE,$ONE
+	mov		\$2,%r10d		# two groups of four lanes
+
+.Louter_8xlanes:
+	vmovdqu		0x00($h),$H0
+	vmovdqu		0x40($h),$H1
+	vmovdqu		0x80($h),$H2
+	vmovdqu		0xc0($h),$H3
+	vmovdqu		0x100($h),$H4
+	vmovdqu		($start),$START
+	vpxor		$J,$J,$J		# row number
+	mov		$inp,%r9
+	mov		$len,%rax
+	jmp		.Loop_8xlanes
+
+.align	32
+.Loop_8xlanes:
+	################################################################
+	# load input, one block of each lane
+	vmovdqu		16*0(%r9),%x#$D0
+	vmovdqu		16*1(%r9),%x#$D1
+	vinserti128	\$1,16*2(%r9),$D0,$D0
+	vinserti128	\$1,16*3(%r9),$D1,$D1
+	lea		16*8(%r9),%r9
+
+	vpcmpgtq	$J,$START,$T0		# lanes that haven't started
+	vpaddq		$ONE,$J,$J
+	vpsrldq		\$6,$D0,$D2		# splat input
+	vpsrldq		\$6,$D1,$D3
+	vpunpckhqdq	$D1,$D0,$D4		# 4
+	vpunpcklqdq	$D3,$D2,$D2		# 2:3
+	vpunpcklqdq	$D1,$D0,$D0		# 0:1
+	vpandn		.L129(%rip),$T0,$T0	# padbit of the others
+
+	vpsrlq		\$30,$D2,$D3
+	vpsrlq		\$4,$D2,$D2
+	vpsrlq		\$26,$D0,$D1
+	vpsrlq		\$40,$D4,$D4		# 4
+	vpand		$MASK,$D2,$D2		# 2
+	vpand		$MASK,$D0,$D0		# 0
+	vpand		$MASK,$D1,$D1		# 1
+	vpand		$MASK,$D3,$D3		# 3
+	vpor		$T0,$D4,$D4
+
+	vpaddq		$D0,$H0,$H0		# accumulate input
+	vpaddq		$D1,$H1,$H1
+	vpaddq		$D2,$H2,$H2
+	vpaddq		$D3,$H3,$H3
+	vpaddq		$D4,$H4,$H4
+
+	# d0 = h0*r0 + h1*5*r4 + h2*5*r3 + h3*5*r2 + h4*5*r1
+	# d1 = h0*r1 + h1*r0   + h2*5*r4 + h3*5*r3 + h4*5*r2
+	# d2 = h0*r2 + h1*r1   + h2*r0   + h3*5*r4 + h4*5*r3
+	# d3 = h0*r3 + h1*r2   + h2*r1   + h3*r0   + h4*5*r4
+	# d4 = h0*r4 + h1*r3   + h2*r2   + h3*r1   + h4*r0
+
+	vpmuludq	0x000($r),$H0,$D0	# h0*r0
+	vpmuludq	0x040($r),$H0,$D1	# h0*r1
+	vpmuludq	0x0c0($r),$H0,$D2	# h0*r2
+	vpmuludq	0x140($r),$H0,$D3	# h0*r3
+	vpmuludq	0x1c0($r),$H0,$D4	# h0*r4
+
+	vpmuludq	0x200($r),$H1,$T0	# h1*s4
+	vpmuludq	0x000($r),$H1,$T1	# h1*r0
+	vpaddq		$T0,$D0,$D0
+	vpaddq		$T1,$D1,$D1
+	vpmuludq	0x040($r),$H1,$T0	# h1*r1
+	vpmuludq	0x0c0($r),$H1,$T1	# h1*r2
+	vpaddq		$T0,$D2,$D2
+	vpaddq		$T1,$D3,$D3
+	vpmuludq	0x140($r),$H1,$T0	# h1*r3
+	vpmuludq	0x180($r),$H2,$T1	# h2*s3
+	vpaddq		$T0,$D4,$D4
+	vpaddq		$T1,$D0,$D0
+
+	vpmuludq	0x200($r),$H2,$T0	# h2*s4
+	vpmuludq	0x000($r),$H2,$T1	# h2*r0
+	vpaddq		$T0,$D1,$D1
+	vpaddq		$T1,$D2,$D2
+	vpmuludq	0x040($r),$H2,$T0	# h2*r1
+	vpmuludq	0x0c0($r),$H2,$T1	# h2*r2
+	vpaddq		$T0,$D3,$D3
+	vpaddq		$T1,$D4,$D4
+
+	vpmuludq	0x100($r),$H3,$T0	# h3*s2
+	vpmuludq	0x180($r),$H3,$T1	# h3*s3
+	vpaddq		$T0,$D0,$D0
+	vpaddq		$T1,$D1,$D1
+	vpmuludq	0x200($r),$H3,$T0	# h3*s4
+	vpmuludq	0x000($r),$H3,$T1	# h3*r0
+	vpaddq		$T0,$D2,$D2
+	vpaddq		$T1,$D3,$D3
+	vpmuludq	0x040($r),$H3,$T0	# h3*r1
+	vpmuludq	0x080($r),$H4,$T1	# h4*s1
+	vpaddq		$T0,$D4,$D4
+	vpaddq		$T1,$D0,$D0
+
+	vpmuludq	0x100($r),$H4,$T0	# h4*s2
+	vpmuludq	0x180($r),$H4,$T1	# h4*s3
+	vpaddq		$T0,$D1,$D1
+	vpaddq		$T1,$D2,$D2
+	vpmuludq	0x200($r),$H4,$T0	# h4*s4
+	vpmuludq	0x000($r),$H4,$T1	# h4*r0
+	vpaddq		$T0,$D3,$D3
+	vpaddq		$T1,$D4,$D4
+
+	################################################################
+	# lazy reduction
+
+	vpsrlq		\$26,$D3,$T0
+	vpand		$MASK,$D3,$H3
+	vpaddq		$T0,$D4,$D4		# d3 -> d4
+
+	vpsrlq		\$26,$D0,$T1
+	vpand		$MASK,$D0,$H0
+	vpaddq		$T1,$D1,$D1		# d0 -> d1
+
+	vpsrlq		\$26,$D4,$T0
+	vpand		$MASK,$D4,$H4
+
+	vpsrlq		\$26,$D1,$T1
+	vpand		$MASK,$D1,$H1
+	vpaddq		$T1,$D2,$D2		# d1 -> d2
+
+	vpaddq		$T0,$H0,$H0
+	vpsllq		\$2,$T0,$T0
+	vpaddq		$T0,$H0,$H0		# d4 -> h0
+
+	vpsrlq		\$26,$D2,$T1
+	vpand		$MASK,$D2,$H2
+	vpaddq		$T1,$H3,$H3		# d2 -> h3
+
+	vpsrlq		\$26,$H0,$T0
+	vpand		$MASK,$H0,$H0
+	vpaddq		$T0,$H1,$H1		# h0 -> h1
+
+	vpsrlq		\$26,$H3,$T1
+	vpand		$MASK,$H3,$H3
+	vpaddq		$T1,$H4,$H4		# h3 -> h4
+
+	dec		%rax
+	jnz		.Loop_8xlanes
+
+	vmovdqu		$H0,0x00($h)
+	vmovdqu		$H1,0x40($h)
+	vmovdqu		$H2,0x80($h)
+	vmovdqu		$H3,0xc0($h)
+	vmovdqu		$H4,0x100($h)
+
+	lea		0x20($h),$h		# next four lanes
+	lea		0x20($r),$r
+	lea		0x20($start),$start
+	lea		16*4($inp),$inp
+	dec		%r10d
+	jnz		.Louter_8xlanes
+
+.Ldone_8xlanes:
+	mov		\$1,%eax
+___
+$code.=<<___	if ($win64);
+	vmovdqa		0x50(%r11),%xmm6
+	vmovdqa		0x60(%r11),%xmm7
+	vmovdqa		0x70(%r11),%xmm8
+	vmovdqa		0x80(%r11),%xmm9
+	vmovdqa		0x90(%r11),%xmm10
+	vmovdqa		0xa0(%r11),%xmm11
+	vmovdqa		0xb0(%r11),%xmm12
+	vmovdqa		0xc0(%r11),%xmm13
+	vmovdqa		0xd0(%r11),%xmm14
+	vmovdqa		0xe0(%r11),%xmm15
+	lea		0xf8(%r11),%rsp
+.Ldo_8xlanes_epilogue:
+___
+$code.=<<___;
+	vzeroupper
+	ret
+.cfi_endproc
+.size	poly1305_blocks_8xlanes,.-poly1305_blocks_8xlanes
+___
+} else {
+$code.=<<___;
+.globl	poly1305_blocks_8xlanes
+.type	poly1305_blocks_8xlanes,\@abi-omnipotent
+poly1305_blocks_8xlanes:
+	xor	%eax,%eax
+	ret
+.size	poly1305_blocks_8xlanes,.-poly1305_blocks_8xlanes
+___
+}
+}
+
 # EXCEPTION_DISPOSITION handler (EXCEPTION_RECORD *rec,ULONG64 frame,
 #		CONTEXT *context,DISPATCHER_CONTEXT *disp)
 if ($win64) {
@@ -4108,6 +4349,11 @@ $code.=<<___ if ($avx>1);
 	.rva	.LSEH_end_poly1305_blocks_avx2
 	.rva	.LSEH_info_poly1305_blocks_avx2_3
 ___
+$code.=<<___ if ($avx>1);
+	.rva	.LSEH_begin_poly1305_blocks_8xlanes
+	.rva	.LSEH_end_poly1305_blocks_8xlanes
+	.rva	.LSEH_info_poly1305_blocks_8xlanes
+___
 $code.=<<___ if ($avx>2);
 	.rva	.LSEH_begin_poly1305_blocks_avx512
 	.rva	.LSEH_end_poly1305_blocks_avx512
@@ -4168,6 +4414,12 @@ $code.=<<___ if ($avx>1);
 	.rva	avx_handler
 	.rva	.Ldo_avx2_body,.Ldo_avx2_epilogue		# HandlerData[]
 ___
+$code.=<<___ if ($avx>1);
+.LSEH_info_poly1305_blocks_8xlanes:
+	.byte	9,0,0,0
+	.rva	avx_handler
+	.rva	.Ldo_8xlanes_body,.Ldo_8xlanes_epilogue		# HandlerData[]
+___
 $code.=<<___ if ($avx>2);
 .LSEH_info_poly1305_blocks_avx512:
 	.byte	9,0,0,0
@@ -17,6 +17,9 @@
 #include "crypto/cryptlib.h"
 #include "crypto/evp.h" /* evp_method_store_flush */
 #include "crypto/rand.h"
+#ifndef FIPS_MODULE
+# include "crypto/decoder.h" /* ossl_decoder_cache_flush */
+#endif
 #include "internal/nelem.h"
 #include "internal/thread_once.h"
 #include "internal/provider.h"
@@ -1039,8 +1042,13 @@ static int provider_flush_store_cache(const OSSL_PROVIDER *prov)
     freeing = store->freeing;
     CRYPTO_THREAD_unlock(store->lock);
 
-    if (!freeing)
+    if (!freeing) {
+#ifndef FIPS_MODULE
+        if (!ossl_decoder_cache_flush(prov->libctx))
+            return 0;
+#endif
         return evp_method_store_flush(prov->libctx);
+    }
     return 1;
 }
 
@@ -1482,6 +1490,15 @@ int ossl_provider_is_child(const OSSL_PROVIDER *prov)
     return prov->ischild;
 }
 
+/*
+ * The built-in default provider is part of libcrypto itself, so its key
+ * objects are the same structures as the legacy keys.
+ */
+int ossl_provider_is_builtin_default(const OSSL_PROVIDER *prov)
+{
+    return prov != NULL && prov->init_function == ossl_default_provider_init;
+}
+
 int ossl_provider_set_child(OSSL_PROVIDER *prov, const OSSL_CORE_HANDLE *handle)
 {
     prov->handle = handle;
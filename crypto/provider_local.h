@@ -24,6 +24,7 @@ typedef struct {
 } OSSL_PROVIDER_INFO;
 
 extern const OSSL_PROVIDER_INFO ossl_predefined_providers[];
+OSSL_provider_init_fn ossl_default_provider_init;
 
 void ossl_provider_info_clear(OSSL_PROVIDER_INFO *info);
 int ossl_provider_info_add_to_store(OSSL_LIB_CTX *libctx,
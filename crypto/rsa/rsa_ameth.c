@@ -869,6 +869,25 @@ static int rsa_pss_pkey_export_to(const EVP_PKEY *from, void *to_keydata,
                              importer, libctx, propq);
 }
 
+/*
+ * Only plain RSA keys that use the built-in implementation are duplicated
+ * directly, as anything else would change how the provider operations
+ * behave.
+ */
+static void *rsa_pkey_dup_to(const EVP_PKEY *from, OSSL_LIB_CTX *libctx)
+{
+    const RSA *rsa = from->pkey.rsa;
+
+    if (RSA_test_flags(rsa, RSA_FLAG_TYPE_MASK) != RSA_FLAG_TYPE_RSA
+        || rsa->engine != NULL
+        || rsa->meth != RSA_PKCS1_OpenSSL()
+        || RSA_get0_n(rsa) == NULL || RSA_get0_e(rsa) == NULL
+        || ossl_lib_ctx_get_concrete(ossl_rsa_get0_libctx((RSA *)rsa))
+           != ossl_lib_ctx_get_concrete(libctx))
+        return NULL;
+    return ossl_rsa_dup(rsa, OSSL_KEYMGMT_SELECT_ALL);
+}
+
 static int rsa_pkey_import_from(const OSSL_PARAM params[], void *vpctx)
 {
     return rsa_int_import_from(params, vpctx, RSA_FLAG_TYPE_RSA);
@@ -937,7 +956,9 @@ const EVP_PKEY_ASN1_METHOD ossl_rsa_asn1_meths[2] = {
      rsa_pkey_dirty_cnt,
      rsa_pkey_export_to,
      rsa_pkey_import_from,
-     rsa_pkey_copy
+     rsa_pkey_copy,
+     0,
+     rsa_pkey_dup_to
     },
 
     {
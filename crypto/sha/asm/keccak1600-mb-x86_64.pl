@@ -0,0 +1,357 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+# Multi-lane Keccak-f[1600] for AVX-512F.
+#
+# Eight independent states are permuted at once, state word i of lane j
+# living in qword j of register i. That takes 25 of the 32 zmm registers,
+# leaving enough for the column parities and Chi temporaries, so nothing
+# is spilled and every step of a round is a handful of vpternlogq and
+# vprolq per register. Rho and Pi are done in one pass along the single
+# 24 element cycle of Pi.
+#
+# The state layout in memory is uint64_t A[25][8], which is what
+# crypto/sha/sha3.c absorbs into and squeezes from.
+#
+# void KeccakF1600_x8(uint64_t A[25][8]);
+# int keccak1600_x8_eligible(void);
+
+# $output is the last argument if it looks like a file (it has an extension)
+# $flavour is the first argument if it doesn't look like a file
+$output = $#ARGV >= 0 && $ARGV[$#ARGV] =~ m|\.\w+$| ? pop : undef;
+$flavour = $#ARGV >= 0 && $ARGV[0] !~ m|\.| ? shift : undef;
+
+$win64=0; $win64=1 if ($flavour =~ /[nm]asm|mingw64/ || $output =~ /\.asm$/);
+$avx512=0;
+
+$0 =~ m/(.*[\/\\])[^\/\\]+$/; $dir=$1;
+( $xlate="${dir}x86_64-xlate.pl" and -f $xlate ) or
+( $xlate="${dir}../../perlasm/x86_64-xlate.pl" and -f $xlate) or
+die "can't locate x86_64-xlate.pl";
+
+if (`$ENV{CC} -Wa,-v -c -o /dev/null -x assembler /dev/null 2>&1`
+		=~ /GNU assembler version ([2-9]\.[0-9]+)/) {
+	$avx512 = ($1>=2.25);
+}
+
+if (!$avx512 && $win64 && ($flavour =~ /nasm/ || $ENV{ASM} =~ /nasm/) &&
+	   `nasm -v 2>&1` =~ /NASM version ([2-9]\.[0-9]+)(?:\.([0-9]+))?/) {
+	$avx512 = ($1==2.11 && $2>=8) + ($1>=2.12);
+}
+
+if (!$avx512 && `$ENV{CC} -v 2>&1` =~ /((?:clang|LLVM) version|.*based on LLVM) ([0-9]+\.[0-9]+)/) {
+	$avx512 = ($2>=3.9);
+}
+
+open OUT,"| \"$^X\" \"$xlate\" $flavour \"$output\""
+    or die "can't call $xlate: $!";
+*STDOUT=*OUT;
+
+if ($avx512) {
+my @A = map("%zmm$_",(0..24));		# A[x + 5*y]
+my @C = map("%zmm$_",(25..29));		# column parities
+my ($T0,$T1) = ("%zmm30","%zmm31");
+
+# Rho rotation amounts, indexed by x + 5*y
+my @rho = ( 0,  1, 62, 28, 27,
+	   36, 44,  6, 55, 20,
+	    3, 10, 43, 25, 39,
+	   41, 45, 15, 21,  8,
+	   18,  2, 61, 56, 14 );
+
+# Pi moves word (x,y) to (y,2x+3y), which is a single cycle through all
+# words but the first. Walk it backwards so that every vprolq lands in a
+# register whose old value has already been used.
+my @cycle = (1);
+while (1) {
+	my $i = $cycle[-1];
+	my ($x,$y) = ($i % 5, int($i / 5));
+	my $j = $y + 5 * ((2*$x + 3*$y) % 5);
+	last if ($j == 1);
+	push @cycle, $j;
+}
+die "unexpected Pi cycle" if (scalar(@cycle) != 24);
+
+$code.=<<___;
+.text
+
+.extern	OPENSSL_ia32cap_P
+.globl	keccak1600_x8_eligible
+.type	keccak1600_x8_eligible,\@abi-omnipotent
+.align	32
+keccak1600_x8_eligible:
+.cfi_startproc
+	mov	OPENSSL_ia32cap_P+8(%rip),%ecx
+	xor	%eax,%eax
+	and	\$`1<<16`,%ecx			# avx512f
+	cmovnz	%ecx,%eax
+	ret
+.cfi_endproc
+.size	keccak1600_x8_eligible,.-keccak1600_x8_eligible
+
+.globl	KeccakF1600_x8
+.type	KeccakF1600_x8,\@function,1
+.align	32
+KeccakF1600_x8:
+.cfi_startproc
+	mov	%rsp,%r9			# frame register
+.cfi_def_cfa_register	%r9
+___
+$code.=<<___	if ($win64);
+	lea	-0xa8(%rsp),%rsp
+	movaps	%xmm6,-0xa8(%r9)
+	movaps	%xmm7,-0x98(%r9)
+	movaps	%xmm8,-0x88(%r9)
+	movaps	%xmm9,-0x78(%r9)
+	movaps	%xmm10,-0x68(%r9)
+	movaps	%xmm11,-0x58(%r9)
+	movaps	%xmm12,-0x48(%r9)
+	movaps	%xmm13,-0x38(%r9)
+	movaps	%xmm14,-0x28(%r9)
+	movaps	%xmm15,-0x18(%r9)
+___
+$code.=<<___;
+.Lx8_body:
+___
+for (my $i = 0; $i < 25; $i++) {
+	$code.="	vmovdqu64	".(64*$i)."(%rdi),$A[$i]\n";
+}
+$code.=<<___;
+	lea	iotas(%rip),%r10
+	mov	\$24,%eax
+	jmp	.Loop_x8
+
+.align	32
+.Loop_x8:
+	######################################### Theta
+___
+for (my $x = 0; $x < 5; $x++) {
+	$code.=<<___;
+	vmovdqa64	$A[$x],$C[$x]
+	vpternlogq	\$0x96,$A[$x+10],$A[$x+5],$C[$x]
+	vpternlogq	\$0x96,$A[$x+20],$A[$x+15],$C[$x]
+___
+}
+for (my $x = 0; $x < 5; $x++) {
+	my ($cl,$cr) = ($C[($x+4)%5],$C[($x+1)%5]);
+
+	$code.="	vprolq		\$1,$cr,$T0\n";
+	for (my $y = 0; $y < 25; $y += 5) {
+		$code.="	vpternlogq	\$0x96,$T0,$cl,$A[$x+$y]\n";
+	}
+}
+$code.=<<___;
+
+	######################################### Rho and Pi
+	vprolq		\$$rho[$cycle[23]],$A[$cycle[23]],$T0
+___
+for (my $k = 22; $k >= 0; $k--) {
+	my ($from,$to) = ($cycle[$k],$cycle[$k+1]);
+
+	$code.="	vprolq		\$$rho[$from],$A[$from],$A[$to]\n";
+}
+$code.=<<___;
+	vmovdqa64	$T0,$A[$cycle[0]]
+
+	######################################### Chi
+___
+for (my $y = 0; $y < 25; $y += 5) {
+	my @B = @A[$y..$y+4];
+
+	$code.=<<___;
+	vmovdqa64	$B[0],$T0
+	vmovdqa64	$B[1],$T1
+	vpternlogq	\$0xD2,$B[2],$B[1],$B[0]
+	vpternlogq	\$0xD2,$B[3],$B[2],$B[1]
+	vpternlogq	\$0xD2,$B[4],$B[3],$B[2]
+	vpternlogq	\$0xD2,$T0,$B[4],$B[3]
+	vpternlogq	\$0xD2,$T1,$T0,$B[4]
+___
+}
+$code.=<<___;
+
+	######################################### Iota
+	vpbroadcastq	(%r10),$T0
+	lea		8(%r10),%r10
+	vpxorq		$T0,$A[0],$A[0]
+
+	dec	%eax
+	jnz	.Loop_x8
+
+___
+for (my $i = 0; $i < 25; $i++) {
+	$code.="	vmovdqu64	$A[$i],".(64*$i)."(%rdi)\n";
+}
+$code.=<<___;
+	vzeroupper
+___
+$code.=<<___	if ($win64);
+	movaps	-0xa8(%r9),%xmm6
+	movaps	-0x98(%r9),%xmm7
+	movaps	-0x88(%r9),%xmm8
+	movaps	-0x78(%r9),%xmm9
+	movaps	-0x68(%r9),%xmm10
+	movaps	-0x58(%r9),%xmm11
+	movaps	-0x48(%r9),%xmm12
+	movaps	-0x38(%r9),%xmm13
+	movaps	-0x28(%r9),%xmm14
+	movaps	-0x18(%r9),%xmm15
+___
+$code.=<<___;
+	lea	(%r9),%rsp
+.cfi_def_cfa_register	%rsp
+.Lx8_epilogue:
+	ret
+.cfi_endproc
+.size	KeccakF1600_x8,.-KeccakF1600_x8
+
+.align	64
+iotas:
+	.quad	0x0000000000000001, 0x0000000000008082
+	.quad	0x800000000000808a, 0x8000000080008000
+	.quad	0x000000000000808b, 0x0000000080000001
+	.quad	0x8000000080008081, 0x8000000000008009
+	.quad	0x000000000000008a, 0x0000000000000088
+	.quad	0x0000000080008009, 0x000000008000000a
+	.quad	0x000000008000808b, 0x800000000000008b
+	.quad	0x8000000000008089, 0x8000000000008003
+	.quad	0x8000000000008002, 0x8000000000000080
+	.quad	0x000000000000800a, 0x800000008000000a
+	.quad	0x8000000080008081, 0x8000000000008080
+	.quad	0x0000000080000001, 0x8000000080008008
+.asciz	"Keccak-1600 x8 for AVX-512F"
+___
+
+# EXCEPTION_DISPOSITION handler (EXCEPTION_RECORD *rec,ULONG64 frame,
+#		CONTEXT *context,DISPATCHER_CONTEXT *disp)
+if ($win64) {
+$rec="%rcx";
+$frame="%rdx";
+$context="%r8";
+$disp="%r9";
+
+$code.=<<___;
+.extern	__imp_RtlVirtualUnwind
+.type	simd_handler,\@abi-omnipotent
+.align	16
+simd_handler:
+	push	%rsi
+	push	%rdi
+	push	%rbx
+	push	%rbp
+	push	%r12
+	push	%r13
+	push	%r14
+	push	%r15
+	pushfq
+	sub	\$64,%rsp
+
+	mov	120($context),%rax	# pull context->Rax
+	mov	248($context),%rbx	# pull context->Rip
+
+	mov	8($disp),%rsi		# disp->ImageBase
+	mov	56($disp),%r11		# disp->HandlerData
+
+	mov	0(%r11),%r10d		# HandlerData[0]
+	lea	(%rsi,%r10),%r10	# prologue label
+	cmp	%r10,%rbx		# context->Rip<prologue label
+	jb	.Lcommon_seh_tail
+
+	mov	192($context),%rax	# pull context->R9
+
+	mov	4(%r11),%r10d		# HandlerData[1]
+	lea	(%rsi,%r10),%r10	# epilogue label
+	cmp	%r10,%rbx		# context->Rip>=epilogue label
+	jae	.Lcommon_seh_tail
+
+	lea	-0xa8(%rax),%rsi
+	lea	512($context),%rdi	# &context.Xmm6
+	mov	\$20,%ecx
+	.long	0xa548f3fc		# cld; rep movsq
+
+.Lcommon_seh_tail:
+	mov	8(%rax),%rdi
+	mov	16(%rax),%rsi
+	mov	%rax,152($context)	# restore context->Rsp
+	mov	%rsi,168($context)	# restore context->Rsi
+	mov	%rdi,176($context)	# restore context->Rdi
+
+	mov	40($disp),%rdi		# disp->ContextRecord
+	mov	$context,%rsi		# context
+	mov	\$154,%ecx		# sizeof(CONTEXT)
+	.long	0xa548f3fc		# cld; rep movsq
+
+	mov	$disp,%rsi
+	xor	%rcx,%rcx		# arg1, UNW_FLAG_NHANDLER
+	mov	8(%rsi),%rdx		# arg2, disp->ImageBase
+	mov	0(%rsi),%r8		# arg3, disp->ControlPc
+	mov	16(%rsi),%r9		# arg4, disp->FunctionEntry
+	mov	40(%rsi),%r10		# disp->ContextRecord
+	lea	56(%rsi),%r11		# &disp->HandlerData
+	lea	24(%rsi),%r12		# &disp->EstablisherFrame
+	mov	%r10,32(%rsp)		# arg5
+	mov	%r11,40(%rsp)		# arg6
+	mov	%r12,48(%rsp)		# arg7
+	mov	%rcx,56(%rsp)		# arg8, (NULL)
+	call	*__imp_RtlVirtualUnwind(%rip)
+
+	mov	\$1,%eax		# ExceptionContinueSearch
+	add	\$64,%rsp
+	popfq
+	pop	%r15
+	pop	%r14
+	pop	%r13
+	pop	%r12
+	pop	%rbp
+	pop	%rbx
+	pop	%rdi
+	pop	%rsi
+	ret
+.size	simd_handler,.-simd_handler
+
+.section	.pdata
+.align	4
+	.rva	.LSEH_begin_KeccakF1600_x8
+	.rva	.LSEH_end_KeccakF1600_x8
+	.rva	.LSEH_info_KeccakF1600_x8
+
+.section	.xdata
+.align	8
+.LSEH_info_KeccakF1600_x8:
+	.byte	9,0,0,0
+	.rva	simd_handler
+	.rva	.Lx8_body,.Lx8_epilogue		# HandlerData[]
+___
+}
+} else {
+$code.=<<___;
+.text
+
+.globl	keccak1600_x8_eligible
+.type	keccak1600_x8_eligible,\@abi-omnipotent
+keccak1600_x8_eligible:
+.cfi_startproc
+	xor	%eax,%eax
+	ret
+.cfi_endproc
+.size	keccak1600_x8_eligible,.-keccak1600_x8_eligible
+
+.globl	KeccakF1600_x8
+.type	KeccakF1600_x8,\@abi-omnipotent
+KeccakF1600_x8:
+.cfi_startproc
+	.byte	0x0f,0x0b	# ud2
+	ret
+.cfi_endproc
+.size	KeccakF1600_x8,.-KeccakF1600_x8
+___
+}
+
+$code =~ s/\`([^\`]*)\`/eval $1/gem;
+print $code;
+close STDOUT or die "error closing STDOUT: $!";
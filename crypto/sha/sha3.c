@@ -8,10 +8,24 @@
  */
 
 #include <string.h>
+#include <openssl/crypto.h>
 #include "internal/sha3.h"
 
 void SHA3_squeeze(uint64_t A[5][5], unsigned char *out, size_t len, size_t r);
 
+/*
+ * keccak1600-mb-x86_64.pl permutes eight independent states at once with
+ * AVX-512F, which ossl_sha3_many() uses to hash eight messages in parallel.
+ */
+#if defined(KECCAK1600_ASM) \
+    && (defined(__x86_64) || defined(_M_AMD64) || defined(_M_X64))
+# define KECCAK1600_MULTI_LANE
+# define KECCAK1600_LANES 8
+
+void KeccakF1600_x8(uint64_t A[25][KECCAK1600_LANES]);
+int keccak1600_x8_eligible(void);
+#endif
+
 void ossl_sha3_reset(KECCAK1600_CTX *ctx)
 {
     memset(ctx->A, 0, sizeof(ctx->A));
@@ -107,3 +121,158 @@ int ossl_sha3_final(unsigned char *md, KECCAK1600_CTX *ctx)
 
     return 1;
 }
+
+#ifdef KECCAK1600_MULTI_LANE
+
+/*
+ * A permutation of eight lanes costs about as much as a single one, so the
+ * lanes are only given up once the messages run out and no more than this
+ * many are still busy.  The rest of their messages is then hashed with the
+ * single state code.
+ */
+# define KECCAK1600_HANDOFF 1
+
+typedef struct {
+    const unsigned char *ptr;   /* may be NULL for an empty message */
+    size_t len;                 /* bytes left to absorb at |ptr| */
+    size_t msg;                 /* index of the message in the lane */
+    int active;                 /* a message is being hashed in the lane */
+    int last;                   /* the padded final block was absorbed */
+} KECCAK1600_LANE;
+
+static void keccak1600_lane_absorb(uint64_t A[25][KECCAK1600_LANES], size_t j,
+                                   KECCAK1600_LANE *lane, size_t bsz,
+                                   unsigned char pad)
+{
+    unsigned char buf[KECCAK1600_WIDTH / 8];
+    const unsigned char *p = lane->ptr;
+    uint64_t w;
+    size_t i;
+
+    if (lane->len < bsz) {
+        memset(buf, 0, bsz);
+        if (lane->len > 0)
+            memcpy(buf, lane->ptr, lane->len);
+        buf[lane->len] = pad;
+        buf[bsz - 1] |= 0x80;
+        p = buf;
+        lane->last = 1;
+    } else {
+        lane->ptr += bsz;
+        lane->len -= bsz;
+    }
+    /* Only built for x86_64, so the words can be loaded as they are */
+    for (i = 0; i < bsz / 8; i++) {
+        memcpy(&w, p + 8 * i, sizeof(w));
+        A[i][j] ^= w;
+    }
+}
+
+/* Finishes the message in lane |j| with the single state code */
+static void keccak1600_lane_handoff(uint64_t A[25][KECCAK1600_LANES], size_t j,
+                                    const KECCAK1600_LANE *lane,
+                                    KECCAK1600_CTX *ctx, unsigned char *md)
+{
+    uint64_t *A_flat = (uint64_t *)ctx->A;
+    size_t i;
+
+    for (i = 0; i < 25; i++)
+        A_flat[i] = A[i][j];
+    ctx->bufsz = 0;
+    ossl_sha3_update(ctx, lane->ptr, lane->len);
+    ossl_sha3_final(md, ctx);
+}
+
+/*
+ * Every lane absorbs one block per permutation.  When a lane absorbs the
+ * final block of its message the digest is squeezed out and the lane starts
+ * on the next message, so messages of different lengths keep all the lanes
+ * busy until there are no more left to start.
+ */
+static void sha3_many_x8(KECCAK1600_CTX *ctx, size_t num,
+                         const unsigned char *const in[], const size_t inl[],
+                         unsigned char *out)
+{
+    uint64_t A[25][KECCAK1600_LANES];
+    uint64_t lane_A[5][5];
+    KECCAK1600_LANE lanes[KECCAK1600_LANES];
+    size_t bsz = ctx->block_size, mdlen = ctx->md_size;
+    size_t next = 0, busy, i, j;
+
+    memset(lanes, 0, sizeof(lanes));
+    for (;;) {
+        busy = 0;
+        for (j = 0; j < KECCAK1600_LANES; j++) {
+            if (!lanes[j].active && next < num) {
+                for (i = 0; i < 25; i++)
+                    A[i][j] = 0;
+                lanes[j].ptr = in[next];
+                lanes[j].len = inl[next];
+                lanes[j].msg = next++;
+                lanes[j].active = 1;
+                lanes[j].last = 0;
+            }
+            if (lanes[j].active)
+                busy++;
+        }
+        if (busy == 0)
+            break;
+        if (busy <= KECCAK1600_HANDOFF && next == num) {
+            for (j = 0; j < KECCAK1600_LANES; j++)
+                if (lanes[j].active)
+                    keccak1600_lane_handoff(A, j, &lanes[j], ctx,
+                                            out + lanes[j].msg * mdlen);
+            break;
+        }
+
+        for (j = 0; j < KECCAK1600_LANES; j++)
+            if (lanes[j].active)
+                keccak1600_lane_absorb(A, j, &lanes[j], bsz, ctx->pad);
+        KeccakF1600_x8(A);
+
+        for (j = 0; j < KECCAK1600_LANES; j++) {
+            if (!lanes[j].active || !lanes[j].last)
+                continue;
+            for (i = 0; i < 25; i++)
+                ((uint64_t *)lane_A)[i] = A[i][j];
+            SHA3_squeeze(lane_A, out + lanes[j].msg * mdlen, mdlen, bsz);
+            lanes[j].active = 0;
+        }
+    }
+    OPENSSL_cleanse(A, sizeof(A));
+    OPENSSL_cleanse(lane_A, sizeof(lane_A));
+}
+#endif
+
+/*
+ * Hashes |num| independent messages with the Keccak parameters |pad| and
+ * |bitlen|, writing |mdlen| bytes of output for each to |out|.
+ */
+int ossl_sha3_many(size_t num, const unsigned char *const in[],
+                   const size_t inl[], unsigned char *out,
+                   unsigned char pad, size_t bitlen, size_t mdlen)
+{
+    KECCAK1600_CTX ctx;
+    size_t i;
+
+    if (!ossl_sha3_init(&ctx, pad, bitlen))
+        return 0;
+    ctx.md_size = mdlen;
+
+#ifdef KECCAK1600_MULTI_LANE
+    if (num > KECCAK1600_HANDOFF && mdlen <= ctx.block_size
+        && keccak1600_x8_eligible()) {
+        sha3_many_x8(&ctx, num, in, inl, out);
+        OPENSSL_cleanse(&ctx, sizeof(ctx));
+        return 1;
+    }
+#endif
+    for (i = 0; i < num; i++) {
+        ossl_sha3_reset(&ctx);
+        if (!ossl_sha3_update(&ctx, in[i], inl[i])
+            || !ossl_sha3_final(out + i * mdlen, &ctx))
+            return 0;
+    }
+    OPENSSL_cleanse(&ctx, sizeof(ctx));
+    return 1;
+}
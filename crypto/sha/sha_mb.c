@@ -0,0 +1,502 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * SHA low level APIs are deprecated for public use, but still ok for
+ * internal use.
+ */
+#include "internal/deprecated.h"
+
+#include <limits.h>
+#include <string.h>
+#include <openssl/crypto.h>
+#include <openssl/sha.h>
+#include "internal/cryptlib.h"
+#include "crypto/sha.h"
+
+/*
+ * Hashing of many independent messages at once.  On x86_64 the multi-buffer
+ * kernels in sha1-mb-x86_64.pl and sha256-mb-x86_64.pl hash up to eight
+ * messages in parallel, one per SIMD lane (or interleaved pairs with the
+ * SHA extensions).  Elsewhere the messages are simply hashed one by one.
+ */
+#if defined(SHA256_ASM) \
+    && (defined(__x86_64) || defined(_M_AMD64) || defined(_M_X64))
+# define SHA_MULTI_BLOCK
+#endif
+
+#ifdef SHA_MULTI_BLOCK
+
+# define SHA_MB_LANES   8
+# define SHA_MB_CBLOCK  64
+
+/*
+ * Lane |j| of word |i| of the chaining value is h[i][j].  SHA-1 only uses
+ * the first five words.
+ */
+typedef struct {
+    unsigned int h[8][SHA_MB_LANES];
+} SHA_MB_STATE;
+
+typedef struct {
+    const unsigned char *ptr;
+    int blocks;
+} HASH_DESC;
+
+void sha1_multi_block(SHA_MB_STATE *ctx, const HASH_DESC *inp, int num);
+void sha256_multi_block(SHA_MB_STATE *ctx, const HASH_DESC *inp, int num);
+
+typedef void sha_mb_fn(SHA_MB_STATE *ctx, const HASH_DESC *inp, int num);
+
+typedef struct {
+    const unsigned char *ptr;   /* NULL when the lane is idle */
+    size_t blocks;              /* blocks left to hash at |ptr| */
+    size_t msg;                 /* index of the message in the lane */
+    int in_pad;                 /* |ptr| points into |pad| */
+    int pad_blocks;
+    unsigned char pad[2 * SHA_MB_CBLOCK];
+} SHA_MB_LANE;
+
+/* The kernels need SSSE3 for the byte swap */
+static ossl_inline int sha_mb_capable(void)
+{
+    return (OPENSSL_ia32cap_P[1] & (1 << 9)) != 0;
+}
+
+static void sha_mb_lane_start(SHA_MB_LANE *lane, SHA_MB_STATE *st, size_t j,
+                              const unsigned int *iv, size_t words,
+                              size_t msg, const unsigned char *in, size_t inl)
+{
+    size_t rem = inl % SHA_MB_CBLOCK;
+    unsigned char *p;
+    uint64_t bits = (uint64_t)inl << 3;
+    size_t i;
+
+    for (i = 0; i < words; i++)
+        st->h[i][j] = iv[i];
+
+    /* The final one or two blocks hold the tail, 0x80 and the bit length */
+    memset(lane->pad, 0, sizeof(lane->pad));
+    if (rem > 0)
+        memcpy(lane->pad, in + inl - rem, rem);
+    lane->pad[rem] = 0x80;
+    lane->pad_blocks = rem + 9 > SHA_MB_CBLOCK ? 2 : 1;
+    p = lane->pad + lane->pad_blocks * SHA_MB_CBLOCK;
+    for (i = 0; i < 8; i++, bits >>= 8)
+        *--p = (unsigned char)bits;
+
+    lane->msg = msg;
+    lane->blocks = inl / SHA_MB_CBLOCK;
+    lane->ptr = in;
+    lane->in_pad = 0;
+    if (lane->blocks == 0) {
+        lane->ptr = lane->pad;
+        lane->blocks = lane->pad_blocks;
+        lane->in_pad = 1;
+    }
+}
+
+/* Writes the first |mdlen| bytes of the hash in lane |j| to |md| */
+static void sha_mb_store(const SHA_MB_STATE *st, size_t j, unsigned char *md,
+                         size_t mdlen)
+{
+    size_t i;
+
+    for (i = 0; i < mdlen / 4; i++) {
+        unsigned int w = st->h[i][j];
+
+        md[4 * i] = (unsigned char)(w >> 24);
+        md[4 * i + 1] = (unsigned char)(w >> 16);
+        md[4 * i + 2] = (unsigned char)(w >> 8);
+        md[4 * i + 3] = (unsigned char)w;
+    }
+}
+
+static void sha_mb_lane_finish(SHA_MB_LANE *lane, const SHA_MB_STATE *st,
+                               size_t j, unsigned char *md, size_t mdlen)
+{
+    sha_mb_store(st, j, md, mdlen);
+    lane->ptr = NULL;
+}
+
+/* Moves lane |from| to the idle lane |to| */
+static void sha_mb_lane_move(SHA_MB_LANE *lanes, SHA_MB_STATE *st,
+                             size_t words, size_t to, size_t from)
+{
+    size_t i;
+
+    for (i = 0; i < words; i++)
+        st->h[i][to] = st->h[i][from];
+    lanes[to] = lanes[from];
+    if (lanes[to].in_pad)
+        lanes[to].ptr = lanes[to].pad + (lanes[from].ptr - lanes[from].pad);
+    lanes[from].ptr = NULL;
+}
+
+/*
+ * Every call to the kernel advances all busy lanes by the smallest number of
+ * blocks any of them has left, so at least one lane runs dry each time.  A
+ * lane that finishes its message is refilled with the next one, which keeps
+ * the lanes busy even when the message lengths differ a lot.  The kernels
+ * stop at the first group of lanes with nothing to do, so once the messages
+ * run out the busy lanes are moved down to the lowest ones.
+ */
+static void sha_mb_many(sha_mb_fn *kernel, const unsigned int *iv,
+                        size_t words, size_t mdlen, size_t num,
+                        const unsigned char *const in[], const size_t inl[],
+                        unsigned char *out)
+{
+    SHA_MB_STATE st;
+    SHA_MB_LANE lanes[SHA_MB_LANES];
+    HASH_DESC desc[SHA_MB_LANES];
+    size_t next = 0, busy, step, j;
+
+    /*
+     * The kernels load and store the whole state, including the lanes and
+     * words (SHA-1 only has five) that aren't in use.
+     */
+    memset(&st, 0, sizeof(st));
+    memset(lanes, 0, sizeof(lanes));
+    for (;;) {
+        busy = 0;
+        step = (size_t)INT_MAX;
+        for (j = 0; j < SHA_MB_LANES; j++) {
+            if (lanes[j].ptr == NULL && next < num) {
+                sha_mb_lane_start(&lanes[j], &st, j, iv, words, next,
+                                  in[next], inl[next]);
+                next++;
+            }
+            if (lanes[j].ptr == NULL)
+                continue;
+            if (busy != j)
+                sha_mb_lane_move(lanes, &st, words, busy, j);
+            if (lanes[busy].blocks < step)
+                step = lanes[busy].blocks;
+            busy++;
+        }
+        if (busy == 0)
+            break;
+
+        for (j = 0; j < SHA_MB_LANES; j++) {
+            desc[j].ptr = lanes[j].ptr;
+            desc[j].blocks = j < busy ? (int)step : 0;
+        }
+        kernel(&st, desc, busy > 4 ? 2 : 1);
+
+        for (j = 0; j < SHA_MB_LANES; j++) {
+            SHA_MB_LANE *lane = &lanes[j];
+
+            if (lane->ptr == NULL)
+                continue;
+            lane->ptr += step * SHA_MB_CBLOCK;
+            lane->blocks -= step;
+            if (lane->blocks > 0)
+                continue;
+            if (!lane->in_pad) {
+                lane->ptr = lane->pad;
+                lane->blocks = lane->pad_blocks;
+                lane->in_pad = 1;
+            } else {
+                sha_mb_lane_finish(lane, &st, j, out + lane->msg * mdlen,
+                                   mdlen);
+            }
+        }
+    }
+    OPENSSL_cleanse(&st, sizeof(st));
+    OPENSSL_cleanse(lanes, sizeof(lanes));
+}
+
+# ifndef FIPS_MODULE
+/* Starts lanes 0 to |num| - 1 from the chaining value |h| */
+static void sha_mb_load(SHA_MB_STATE *st, const unsigned int *h, size_t words,
+                        size_t num)
+{
+    size_t i, j;
+
+    for (i = 0; i < words; i++)
+        for (j = 0; j < num; j++)
+            st->h[i][j] = h[i];
+}
+
+/* Puts the 0x80 byte and the bit count |bits| after |len| bytes of |blk| */
+static size_t sha_mb_pad(unsigned char *blk, size_t len, uint64_t bits)
+{
+    size_t n = len + 9 > SHA_MB_CBLOCK ? 2 : 1;
+    unsigned char *p = blk + n * SHA_MB_CBLOCK;
+
+    memset(blk + len, 0, n * SHA_MB_CBLOCK - len);
+    blk[len] = 0x80;
+    for (; bits != 0; bits >>= 8)
+        *--p = (unsigned char)bits;
+    return n;
+}
+
+/*
+ * Hashes the single padded block of each of the first |num| lanes of |blk|
+ * from the chaining value |h|, and overwrites the message at the start of
+ * the block with the hash.
+ */
+static void sha_mb_hmac_block(sha_mb_fn *kernel, SHA_MB_STATE *st,
+                              const HASH_DESC *desc,
+                              unsigned char blk[][2 * SHA_MB_CBLOCK],
+                              const unsigned int *h, size_t words,
+                              size_t mdlen, size_t num)
+{
+    size_t j;
+
+    sha_mb_load(st, h, words, num);
+    kernel(st, desc, num > 4 ? 2 : 1);
+    for (j = 0; j < num; j++)
+        sha_mb_store(st, j, blk[j], mdlen);
+}
+
+/*
+ * PBKDF2 with HMAC: the output blocks |first| to |first| + |num| - 1, where
+ * |num| is at most SHA_MB_LANES, are derived side by side, one in each lane.
+ * Every iteration after the first is an inner and an outer hash of a single
+ * block, so the lanes stay in step all the way through.
+ */
+static void sha_mb_pbkdf2(sha_mb_fn *kernel, const unsigned int *iv,
+                          size_t words, size_t mdlen,
+                          const unsigned char *pass, size_t passlen,
+                          const unsigned char *salt, size_t saltlen,
+                          uint64_t iter, uint32_t first, size_t num,
+                          unsigned char *out)
+{
+    SHA_MB_STATE st;
+    HASH_DESC desc[SHA_MB_LANES];
+    unsigned int pad[2][8];
+    unsigned char key[SHA_MB_CBLOCK];
+    unsigned char blk[SHA_MB_LANES][2 * SHA_MB_CBLOCK];
+    size_t i, j, k, n, rem;
+    uint32_t ctr;
+    uint64_t it;
+
+    /* The unused lanes and words are read by the kernels too */
+    memset(&st, 0, sizeof(st));
+
+    /* The inner and outer chaining values after the padded key */
+    memset(key, 0, sizeof(key));
+    if (passlen > SHA_MB_CBLOCK)
+        sha_mb_many(kernel, iv, words, mdlen, 1, &pass, &passlen, key);
+    else if (passlen > 0)
+        memcpy(key, pass, passlen);
+    for (k = 0; k < SHA_MB_CBLOCK; k++) {
+        blk[0][k] = key[k] ^ 0x36;
+        blk[1][k] = key[k] ^ 0x5c;
+    }
+    for (j = 0; j < SHA_MB_LANES; j++) {
+        desc[j].ptr = blk[j];
+        desc[j].blocks = j < 2 ? 1 : 0;
+    }
+    sha_mb_load(&st, iv, words, 2);
+    kernel(&st, desc, 1);
+    for (i = 0; i < words; i++) {
+        pad[0][i] = st.h[i][0];
+        pad[1][i] = st.h[i][1];
+    }
+
+    /*
+     * U_1 = HMAC(P, S || INT(first + j)).  The whole blocks of the salt are
+     * the same for every lane, only the block(s) with the counter differ.
+     */
+    sha_mb_load(&st, pad[0], words, num);
+    if (saltlen >= SHA_MB_CBLOCK) {
+        for (j = 0; j < SHA_MB_LANES; j++) {
+            desc[j].ptr = salt;
+            desc[j].blocks = j < num ? (int)(saltlen / SHA_MB_CBLOCK) : 0;
+        }
+        kernel(&st, desc, num > 4 ? 2 : 1);
+    }
+    rem = saltlen % SHA_MB_CBLOCK;
+    for (j = 0, n = 1; j < num; j++) {
+        ctr = first + (uint32_t)j;
+        if (rem > 0)
+            memcpy(blk[j], salt + saltlen - rem, rem);
+        blk[j][rem] = (unsigned char)(ctr >> 24);
+        blk[j][rem + 1] = (unsigned char)(ctr >> 16);
+        blk[j][rem + 2] = (unsigned char)(ctr >> 8);
+        blk[j][rem + 3] = (unsigned char)ctr;
+        n = sha_mb_pad(blk[j], rem + 4,
+                       ((uint64_t)SHA_MB_CBLOCK + saltlen + 4) << 3);
+    }
+    for (j = 0; j < SHA_MB_LANES; j++) {
+        desc[j].ptr = blk[j];
+        desc[j].blocks = j < num ? (int)n : 0;
+    }
+    kernel(&st, desc, num > 4 ? 2 : 1);
+
+    /* From here on every message is one hash long and fits in a block */
+    for (j = 0; j < SHA_MB_LANES; j++) {
+        if (j < num) {
+            sha_mb_store(&st, j, blk[j], mdlen);
+            sha_mb_pad(blk[j], mdlen, ((uint64_t)SHA_MB_CBLOCK + mdlen) << 3);
+        }
+        desc[j].blocks = j < num ? 1 : 0;
+    }
+    sha_mb_hmac_block(kernel, &st, desc, blk, pad[1], words, mdlen, num);
+    for (j = 0; j < num; j++)
+        memcpy(out + j * mdlen, blk[j], mdlen);
+
+    for (it = 1; it < iter; it++) {
+        sha_mb_hmac_block(kernel, &st, desc, blk, pad[0], words, mdlen, num);
+        sha_mb_hmac_block(kernel, &st, desc, blk, pad[1], words, mdlen, num);
+        for (j = 0; j < num; j++)
+            for (k = 0; k < mdlen; k++)
+                out[j * mdlen + k] ^= blk[j][k];
+    }
+
+    OPENSSL_cleanse(&st, sizeof(st));
+    OPENSSL_cleanse(pad, sizeof(pad));
+    OPENSSL_cleanse(key, sizeof(key));
+    OPENSSL_cleanse(blk, sizeof(blk));
+}
+# endif /* FIPS_MODULE */
+#endif
+
+int ossl_sha1_many(size_t num, const unsigned char *const in[],
+                   const size_t inl[], unsigned char *out)
+{
+    SHA_CTX c;
+    size_t i;
+
+#ifdef SHA_MULTI_BLOCK
+    if (num > 1 && sha_mb_capable()) {
+        unsigned int iv[5];
+
+        SHA1_Init(&c);
+        iv[0] = c.h0;
+        iv[1] = c.h1;
+        iv[2] = c.h2;
+        iv[3] = c.h3;
+        iv[4] = c.h4;
+        sha_mb_many(sha1_multi_block, iv, 5, SHA_DIGEST_LENGTH, num, in, inl,
+                    out);
+        return 1;
+    }
+#endif
+    for (i = 0; i < num; i++)
+        if (!SHA1_Init(&c)
+            || !SHA1_Update(&c, in[i], inl[i])
+            || !SHA1_Final(out + i * SHA_DIGEST_LENGTH, &c))
+            return 0;
+    OPENSSL_cleanse(&c, sizeof(c));
+    return 1;
+}
+
+static int sha256_many(int (*init)(SHA256_CTX *), size_t mdlen, size_t num,
+                       const unsigned char *const in[], const size_t inl[],
+                       unsigned char *out)
+{
+    SHA256_CTX c;
+    size_t i;
+
+#ifdef SHA_MULTI_BLOCK
+    if (num > 1 && sha_mb_capable()) {
+        init(&c);
+        sha_mb_many(sha256_multi_block, c.h, 8, mdlen, num, in, inl, out);
+        return 1;
+    }
+#endif
+    for (i = 0; i < num; i++)
+        if (!init(&c)
+            || !SHA256_Update(&c, in[i], inl[i])
+            || !SHA256_Final(out + i * mdlen, &c))
+            return 0;
+    OPENSSL_cleanse(&c, sizeof(c));
+    return 1;
+}
+
+int ossl_sha224_many(size_t num, const unsigned char *const in[],
+                     const size_t inl[], unsigned char *out)
+{
+    return sha256_many(SHA224_Init, SHA224_DIGEST_LENGTH, num, in, inl, out);
+}
+
+int ossl_sha256_many(size_t num, const unsigned char *const in[],
+                     const size_t inl[], unsigned char *out)
+{
+    return sha256_many(SHA256_Init, SHA256_DIGEST_LENGTH, num, in, inl, out);
+}
+
+#ifndef FIPS_MODULE
+/*
+ * The multi-lane PBKDF2 isn't part of the FIPS module.
+ *
+ * PBKDF2 with HMAC-SHA1, HMAC-SHA224 or HMAC-SHA256 for the |num| whole
+ * output blocks starting with block number |first| (counting from 1), which
+ * are written one after the other to |out|.  Up to eight blocks are derived
+ * at once by the multi-buffer kernels.  Returns 0 without touching |out| when
+ * those aren't available, the caller then has to do it the slow way.
+ */
+static int sha_pbkdf2_many(int sha1, const unsigned int *iv, size_t mdlen,
+                           const unsigned char *pass, size_t passlen,
+                           const unsigned char *salt, size_t saltlen,
+                           uint64_t iter, uint32_t first, size_t num,
+                           unsigned char *out)
+{
+#ifdef SHA_MULTI_BLOCK
+    size_t n;
+
+    if (!sha_mb_capable())
+        return 0;
+    for (; num > 0; num -= n, first += (uint32_t)n, out += n * mdlen) {
+        n = num < SHA_MB_LANES ? num : SHA_MB_LANES;
+        sha_mb_pbkdf2(sha1 ? sha1_multi_block : sha256_multi_block, iv,
+                      sha1 ? 5 : 8, mdlen, pass, passlen, salt, saltlen,
+                      iter, first, n, out);
+    }
+    return 1;
+#else
+    return 0;
+#endif
+}
+
+int ossl_sha1_pbkdf2_many(const unsigned char *pass, size_t passlen,
+                          const unsigned char *salt, size_t saltlen,
+                          uint64_t iter, uint32_t first, size_t num,
+                          unsigned char *out)
+{
+    SHA_CTX c;
+    unsigned int iv[5];
+
+    SHA1_Init(&c);
+    iv[0] = c.h0;
+    iv[1] = c.h1;
+    iv[2] = c.h2;
+    iv[3] = c.h3;
+    iv[4] = c.h4;
+    return sha_pbkdf2_many(1, iv, SHA_DIGEST_LENGTH, pass, passlen,
+                           salt, saltlen, iter, first, num, out);
+}
+
+int ossl_sha224_pbkdf2_many(const unsigned char *pass, size_t passlen,
+                            const unsigned char *salt, size_t saltlen,
+                            uint64_t iter, uint32_t first, size_t num,
+                            unsigned char *out)
+{
+    SHA256_CTX c;
+
+    SHA224_Init(&c);
+    return sha_pbkdf2_many(0, c.h, SHA224_DIGEST_LENGTH, pass, passlen,
+                           salt, saltlen, iter, first, num, out);
+}
+
+int ossl_sha256_pbkdf2_many(const unsigned char *pass, size_t passlen,
+                            const unsigned char *salt, size_t saltlen,
+                            uint64_t iter, uint32_t first, size_t num,
+                            unsigned char *out)
+{
+    SHA256_CTX c;
+
+    SHA256_Init(&c);
+    return sha_pbkdf2_many(0, c.h, SHA256_DIGEST_LENGTH, pass, passlen,
+                           salt, saltlen, iter, first, num, out);
+}
+#endif /* FIPS_MODULE */
@@ -162,4 +162,16 @@ int openssl_get_fork_id(void)
     return 0;
 # endif
 }
+
+int ossl_crypto_parallel_run(size_t num, size_t threads,
+                             int (*fn)(void *arg, size_t i), void *arg)
+{
+    size_t i;
+    int ret = 1;
+
+    for (i = 0; i < num; i++)
+        if (!fn(arg, i))
+            ret = 0;
+    return ret;
+}
 #endif
@@ -288,4 +288,73 @@ int openssl_get_fork_id(void)
 {
     return getpid();
 }
+
+typedef struct {
+    pthread_mutex_t lock;
+    size_t next;
+    size_t num;
+    int (*fn)(void *arg, size_t i);
+    void *arg;
+    int ret;
+} PARALLEL_RUN;
+
+/* Every thread takes the next index until there are none left */
+static void *parallel_run_worker(void *vrun)
+{
+    PARALLEL_RUN *run = vrun;
+    size_t i;
+
+    for (;;) {
+        pthread_mutex_lock(&run->lock);
+        i = run->next;
+        if (i < run->num)
+            run->next++;
+        pthread_mutex_unlock(&run->lock);
+        if (i >= run->num)
+            break;
+        if (!run->fn(run->arg, i)) {
+            pthread_mutex_lock(&run->lock);
+            run->ret = 0;
+            pthread_mutex_unlock(&run->lock);
+        }
+    }
+    return NULL;
+}
+
+int ossl_crypto_parallel_run(size_t num, size_t threads,
+                             int (*fn)(void *arg, size_t i), void *arg)
+{
+    PARALLEL_RUN run;
+    pthread_t tid[OSSL_CRYPTO_PARALLEL_MAX_THREADS - 1];
+    size_t i, started;
+    int ret = 1;
+
+    if (threads > num)
+        threads = num;
+    if (threads > OSSL_CRYPTO_PARALLEL_MAX_THREADS)
+        threads = OSSL_CRYPTO_PARALLEL_MAX_THREADS;
+    if (threads <= 1 || pthread_mutex_init(&run.lock, NULL) != 0) {
+        for (i = 0; i < num; i++)
+            if (!fn(arg, i))
+                ret = 0;
+        return ret;
+    }
+
+    run.next = 0;
+    run.num = num;
+    run.fn = fn;
+    run.arg = arg;
+    run.ret = 1;
+
+    /* Threads that fail to start just leave more work to the others */
+    for (started = 0; started < threads - 1; started++)
+        if (pthread_create(&tid[started], NULL, parallel_run_worker, &run) != 0)
+            break;
+    parallel_run_worker(&run);
+    for (i = 0; i < started; i++)
+        pthread_join(tid[i], NULL);
+
+    pthread_mutex_destroy(&run.lock);
+    return run.ret;
+}
 #endif
@@ -16,6 +16,7 @@
 #endif
 
 #include <openssl/crypto.h>
+#include "internal/cryptlib.h"
 
 #if defined(OPENSSL_THREADS) && !defined(CRYPTO_TDEBUG) && defined(OPENSSL_SYS_WINDOWS)
 
@@ -227,4 +228,79 @@ int openssl_get_fork_id(void)
 {
     return 0;
 }
+
+typedef struct {
+    CRITICAL_SECTION lock;
+    size_t next;
+    size_t num;
+    int (*fn)(void *arg, size_t i);
+    void *arg;
+    int ret;
+} PARALLEL_RUN;
+
+/* Every thread takes the next index until there are none left */
+static DWORD WINAPI parallel_run_worker(LPVOID vrun)
+{
+    PARALLEL_RUN *run = vrun;
+    size_t i;
+
+    for (;;) {
+        EnterCriticalSection(&run->lock);
+        i = run->next;
+        if (i < run->num)
+            run->next++;
+        LeaveCriticalSection(&run->lock);
+        if (i >= run->num)
+            break;
+        if (!run->fn(run->arg, i)) {
+            EnterCriticalSection(&run->lock);
+            run->ret = 0;
+            LeaveCriticalSection(&run->lock);
+        }
+    }
+    return 0;
+}
+
+int ossl_crypto_parallel_run(size_t num, size_t threads,
+                             int (*fn)(void *arg, size_t i), void *arg)
+{
+    PARALLEL_RUN run;
+    HANDLE tid[OSSL_CRYPTO_PARALLEL_MAX_THREADS - 1];
+    size_t i, started;
+    int ret = 1;
+
+    if (threads > num)
+        threads = num;
+    if (threads > OSSL_CRYPTO_PARALLEL_MAX_THREADS)
+        threads = OSSL_CRYPTO_PARALLEL_MAX_THREADS;
+    if (threads <= 1) {
+        for (i = 0; i < num; i++)
+            if (!fn(arg, i))
+                ret = 0;
+        return ret;
+    }
+
+    InitializeCriticalSection(&run.lock);
+    run.next = 0;
+    run.num = num;
+    run.fn = fn;
+    run.arg = arg;
+    run.ret = 1;
+
+    /* Threads that fail to start just leave more work to the others */
+    for (started = 0; started < threads - 1; started++) {
+        tid[started] = CreateThread(NULL, 0, parallel_run_worker, &run, 0,
+                                    NULL);
+        if (tid[started] == NULL)
+            break;
+    }
+    parallel_run_worker(&run);
+    for (i = 0; i < started; i++) {
+        WaitForSingleObject(tid[i], INFINITE);
+        CloseHandle(tid[i]);
+    }
+
+    DeleteCriticalSection(&run.lock);
+    return run.ret;
+}
 #endif
@@ -14,6 +14,7 @@
 #include <openssl/x509.h>
 #include <openssl/x509v3.h>
 #include <openssl/core_names.h>
+#include "internal/property.h"
 #include "crypto/x509.h"
 
 int X509_issuer_and_serial_cmp(const X509 *a, const X509 *b)
@@ -247,6 +248,29 @@ int ossl_x509_add_certs_new(STACK_OF(X509) **p_sk, STACK_OF(X509) *certs,
     return 1;
 }
 
+/* Ensure canonical encoding is present and up to date */
+static int x509_name_canon_update(const X509_NAME *a)
+{
+    if (a->canon_enc == NULL || a->modified)
+        return i2d_X509_NAME((X509_NAME *)a, NULL) >= 0;
+    return 1;
+}
+
+/*
+ * The SHA1 from ossl_sha1() may only stand in for a fetched one when the
+ * fetch would be made from the default library context without any property
+ * query, neither given by the caller nor configured as a default.
+ */
+static int x509_name_hash_is_default(OSSL_LIB_CTX *libctx, const char *propq)
+{
+    OSSL_PROPERTY_LIST **plp;
+
+    if (propq != NULL || !ossl_lib_ctx_is_default(libctx))
+        return 0;
+    plp = ossl_ctx_global_properties(libctx, 1);
+    return plp != NULL && *plp == NULL;
+}
+
 int X509_NAME_cmp(const X509_NAME *a, const X509_NAME *b)
 {
     int ret;
@@ -256,18 +280,8 @@ int X509_NAME_cmp(const X509_NAME *a, const X509_NAME *b)
     if (a == NULL)
         return -1;
 
-    /* Ensure canonical encoding is present and up to date */
-    if (a->canon_enc == NULL || a->modified) {
-        ret = i2d_X509_NAME((X509_NAME *)a, NULL);
-        if (ret < 0)
-            return -2;
-    }
-
-    if (b->canon_enc == NULL || b->modified) {
-        ret = i2d_X509_NAME((X509_NAME *)b, NULL);
-        if (ret < 0)
-            return -2;
-    }
+    if (!x509_name_canon_update(a) || !x509_name_canon_update(b))
+        return -2;
 
     ret = a->canon_enclen - b->canon_enclen;
     if (ret == 0 && a->canon_enclen == 0)
@@ -282,17 +296,45 @@ int X509_NAME_cmp(const X509_NAME *a, const X509_NAME *b)
     return ret < 0 ? -1 : ret > 0;
 }
 
+/*
+ * Equality test for the hot paths that don't need X509_NAME_cmp() ordering.
+ * Names almost always differ in their precomputed hashes, which saves
+ * comparing the encodings.  Returns 1 if equal, 0 if not or on error.
+ */
+int ossl_x509_name_eq(const X509_NAME *a, const X509_NAME *b)
+{
+    if (a == b)
+        return 1;
+    if (a == NULL || b == NULL
+        || !x509_name_canon_update(a) || !x509_name_canon_update(b))
+        return 0;
+    if (a->canon_enclen != b->canon_enclen || a->canon_hash != b->canon_hash)
+        return 0;
+    return a->canon_enclen == 0
+        || memcmp(a->canon_enc, b->canon_enc, a->canon_enclen) == 0;
+}
+
 unsigned long X509_NAME_hash_ex(const X509_NAME *x, OSSL_LIB_CTX *libctx,
                                 const char *propq, int *ok)
 {
     unsigned long ret = 0;
     unsigned char md[SHA_DIGEST_LENGTH];
-    EVP_MD *sha1 = EVP_MD_fetch(libctx, "SHA1", propq);
+    EVP_MD *sha1;
 
-    /* Make sure X509_NAME structure contains valid cached encoding */
-    i2d_X509_NAME(x, NULL);
     if (ok != NULL)
         *ok = 0;
+    /* Make sure X509_NAME structure contains valid cached encoding */
+    if (!x509_name_canon_update(x))
+        return 0;
+
+    /* Use the precomputed hash when the fetch would find the default SHA1 */
+    if (x509_name_hash_is_default(libctx, propq)) {
+        if (ok != NULL)
+            *ok = 1;
+        return (unsigned long)(x->canon_hash & 0xffffffffL);
+    }
+
+    sha1 = EVP_MD_fetch(libctx, "SHA1", propq);
     if (sha1 != NULL
         && EVP_Digest(x->canon_enc, x->canon_enclen, md, NULL, sha1, NULL)) {
         ret = (((unsigned long)md[0]) | ((unsigned long)md[1] << 8L) |
@@ -365,7 +407,7 @@ X509 *X509_find_by_subject(STACK_OF(X509) *sk, const X509_NAME *name)
 
     for (i = 0; i < sk_X509_num(sk); i++) {
         x509 = sk_X509_value(sk, i);
-        if (X509_NAME_cmp(X509_get_subject_name(x509), name) == 0)
+        if (ossl_x509_name_eq(X509_get_subject_name(x509), name))
             return x509;
     }
     return NULL;
@@ -383,7 +383,7 @@ static STACK_OF(X509) *lookup_certs_sk(X509_STORE_CTX *ctx,
         return NULL;
     for (i = 0; i < sk_X509_num(ctx->other_ctx); i++) {
         x = sk_X509_value(ctx->other_ctx, i);
-        if (X509_NAME_cmp(nm, X509_get_subject_name(x)) == 0) {
+        if (ossl_x509_name_eq(nm, X509_get_subject_name(x))) {
             if (!X509_add_cert(sk, x, X509_ADD_FLAG_UP_REF)) {
                 sk_X509_pop_free(sk, X509_free);
                 ctx->error = X509_V_ERR_OUT_OF_MEM;
@@ -1224,7 +1224,7 @@ static int get_crl_score(X509_STORE_CTX *ctx, X509 **pissuer,
     else if (crl->base_crl_number != NULL)
         return 0;
     /* If issuer name doesn't match certificate need indirect CRL */
-    if (X509_NAME_cmp(X509_get_issuer_name(x), X509_CRL_get_issuer(crl)) != 0) {
+    if (!ossl_x509_name_eq(X509_get_issuer_name(x), X509_CRL_get_issuer(crl))) {
         if ((crl->idp_flags & IDP_INDIRECT) == 0)
             return 0;
     } else {
@@ -14,6 +14,7 @@
 #include <openssl/x509.h>
 #include "crypto/x509.h"
 #include "crypto/asn1.h"
+#include "crypto/sha.h"
 #include "x509_local.h"
 
 /*
@@ -35,9 +36,12 @@ static void x509_name_ex_free(ASN1_VALUE **val, const ASN1_ITEM *it);
 
 static int x509_name_encode(X509_NAME *a);
 static int x509_name_canon(X509_NAME *a);
-static int asn1_string_canon(ASN1_STRING *out, const ASN1_STRING *in);
-static int i2d_name_canon(const STACK_OF(STACK_OF_X509_NAME_ENTRY) * intname,
-                          unsigned char **in);
+static int x509_name_rdn_canon(const STACK_OF(X509_NAME_ENTRY) *entries,
+                               int start, int *end, unsigned char **pp);
+static int x509_name_entry_canon(const X509_NAME_ENTRY *entry,
+                                 unsigned char **pp);
+static int asn1_string_canon(unsigned char *to, const unsigned char *from,
+                             int len);
 
 static int x509_name_ex_print(BIO *out, const ASN1_VALUE **pval,
                               int indent,
@@ -298,83 +302,133 @@ static int x509_name_ex_print(BIO *out, const ASN1_VALUE **pval,
  * comparison of Name structures can be rapidly performed by just using
  * memcmp() of the canonical encoding. By omitting the leading SEQUENCE name
  * constraints of type dirName can also be checked with a simple memcmp().
+ * The encoding is written directly into a single allocation, and the SHA1
+ * digest of it is computed once here for X509_NAME_hash_ex() and for fast
+ * rejection in ossl_x509_name_eq().  Doing it here rather than on first use
+ * keeps names that are shared between threads free of lazy writes.
  * NOTE: For empty X509_NAME (NULL-DN), canon_enclen == 0 && canon_enc == NULL
  */
 
 static int x509_name_canon(X509_NAME *a)
 {
+    unsigned char md[SHA_DIGEST_LENGTH];
     unsigned char *p;
-    STACK_OF(STACK_OF_X509_NAME_ENTRY) *intname;
-    STACK_OF(X509_NAME_ENTRY) *entries = NULL;
-    X509_NAME_ENTRY *entry, *tmpentry = NULL;
-    int i, set = -1, ret = 0, len;
+    int i, j, len, rdnlen, num;
 
     OPENSSL_free(a->canon_enc);
     a->canon_enc = NULL;
+    a->canon_enclen = 0;
+    a->canon_hash = 0;
+
     /* Special case: empty X509_NAME => null encoding */
-    if (sk_X509_NAME_ENTRY_num(a->entries) == 0) {
-        a->canon_enclen = 0;
-        return 1;
-    }
-    intname = sk_STACK_OF_X509_NAME_ENTRY_new_null();
-    if (intname == NULL) {
-        ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
-        goto err;
+    num = sk_X509_NAME_ENTRY_num(a->entries);
+    len = 0;
+    for (i = 0; i < num; i = j) {
+        rdnlen = x509_name_rdn_canon(a->entries, i, &j, NULL);
+        if (rdnlen < 0 || len > INT_MAX - rdnlen)
+            return 0;
+        len += rdnlen;
     }
-    for (i = 0; i < sk_X509_NAME_ENTRY_num(a->entries); i++) {
-        entry = sk_X509_NAME_ENTRY_value(a->entries, i);
-        if (entry->set != set) {
-            entries = sk_X509_NAME_ENTRY_new_null();
-            if (entries == NULL)
-                goto err;
-            if (!sk_STACK_OF_X509_NAME_ENTRY_push(intname, entries)) {
-                sk_X509_NAME_ENTRY_free(entries);
-                ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
-                goto err;
-            }
-            set = entry->set;
-        }
-        tmpentry = X509_NAME_ENTRY_new();
-        if (tmpentry == NULL) {
-            ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
-            goto err;
-        }
-        tmpentry->object = OBJ_dup(entry->object);
-        if (tmpentry->object == NULL) {
-            ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
-            goto err;
-        }
-        if (!asn1_string_canon(tmpentry->value, entry->value))
-            goto err;
-        if (!sk_X509_NAME_ENTRY_push(entries, tmpentry)) {
+
+    if (len > 0) {
+        if ((a->canon_enc = OPENSSL_malloc(len)) == NULL) {
             ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
-            goto err;
+            return 0;
         }
-        tmpentry = NULL;
+        p = a->canon_enc;
+        for (i = 0; i < num; i = j)
+            if (x509_name_rdn_canon(a->entries, i, &j, &p) < 0)
+                goto err;
+        a->canon_enclen = len;
     }
 
-    /* Finally generate encoding */
-    len = i2d_name_canon(intname, NULL);
-    if (len < 0)
+    if (ossl_sha1(a->canon_enc, a->canon_enclen, md) == NULL)
         goto err;
-    a->canon_enclen = len;
+    for (i = sizeof(a->canon_hash) - 1; i >= 0; i--)
+        a->canon_hash = (a->canon_hash << 8) | md[i];
+    return 1;
 
-    p = OPENSSL_malloc(a->canon_enclen);
-    if (p == NULL) {
-        ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
-        goto err;
-    }
+ err:
+    OPENSSL_free(a->canon_enc);
+    a->canon_enc = NULL;
+    a->canon_enclen = 0;
+    return 0;
+}
 
-    a->canon_enc = p;
+typedef struct {
+    unsigned char *data;
+    int length;
+} CANON_ENC;
 
-    i2d_name_canon(intname, &p);
+/* Same ordering as used by ASN1_item_i2d() for DER SET OF */
+static int canon_enc_cmp(const void *a, const void *b)
+{
+    const CANON_ENC *d1 = a, *d2 = b;
+    int cmplen, i;
+
+    cmplen = (d1->length < d2->length) ? d1->length : d2->length;
+    i = memcmp(d1->data, d2->data, cmplen);
+    if (i != 0)
+        return i;
+    return d1->length - d2->length;
+}
 
-    ret = 1;
+/*
+ * Canonically encode the RelativeDistinguishedName starting at index |start|
+ * of |entries| into |*pp| if |pp| is not NULL, and set |*end| to the index
+ * following it.  Returns the encoded length or -1 on error.
+ */
+static int x509_name_rdn_canon(const STACK_OF(X509_NAME_ENTRY) *entries,
+                               int start, int *end, unsigned char **pp)
+{
+    X509_NAME_ENTRY *entry = sk_X509_NAME_ENTRY_value(entries, start);
+    CANON_ENC *enc = NULL;
+    unsigned char *p, *tmp = NULL;
+    int i, n, len = 0, elen, total, ret = -1;
+
+    for (i = start; i < sk_X509_NAME_ENTRY_num(entries)
+             && sk_X509_NAME_ENTRY_value(entries, i)->set == entry->set; i++) {
+        elen = x509_name_entry_canon(sk_X509_NAME_ENTRY_value(entries, i),
+                                     NULL);
+        if (elen < 0 || len > INT_MAX - elen)
+            return -1;
+        len += elen;
+    }
+    *end = i;
+    n = i - start;
+    total = ASN1_object_size(1, len, V_ASN1_SET);
+    if (pp == NULL || total < 0)
+        return total;
+
+    ASN1_put_object(pp, 1, len, V_ASN1_SET, V_ASN1_UNIVERSAL);
+    if (n == 1)
+        return x509_name_entry_canon(entry, pp) < 0 ? -1 : total;
+
+    /* A multi-valued RDN has to be sorted, DER SET OF style */
+    enc = OPENSSL_malloc(n * sizeof(*enc));
+    tmp = OPENSSL_malloc(len);
+    if (enc == NULL || tmp == NULL) {
+        ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
+        goto err;
+    }
+    p = *pp;
+    for (i = 0; i < n; i++) {
+        enc[i].data = *pp;
+        enc[i].length =
+            x509_name_entry_canon(sk_X509_NAME_ENTRY_value(entries, start + i),
+                                  pp);
+        if (enc[i].length < 0)
+            goto err;
+    }
+    qsort(enc, n, sizeof(*enc), canon_enc_cmp);
+    for (i = 0, elen = 0; i < n; elen += enc[i].length, i++)
+        memcpy(tmp + elen, enc[i].data, enc[i].length);
+    memcpy(p, tmp, len);
+    ret = total;
 
  err:
-    X509_NAME_ENTRY_free(tmpentry);
-    sk_STACK_OF_X509_NAME_ENTRY_pop_free(intname,
-                                         local_sk_X509_NAME_ENTRY_pop_free);
+    OPENSSL_free(enc);
+    OPENSSL_free(tmp);
     return ret;
 }
 
@@ -385,33 +439,80 @@ static int x509_name_canon(X509_NAME *a)
         | B_ASN1_PRINTABLESTRING | B_ASN1_T61STRING | B_ASN1_IA5STRING \
         | B_ASN1_VISIBLESTRING)
 
-static int asn1_string_canon(ASN1_STRING *out, const ASN1_STRING *in)
-{
-    unsigned char *to, *from;
-    int len, i;
+/* The canonicalized types with one byte per character */
+#define ASN1_MASK_CANON_1BYTE \
+        (B_ASN1_UTF8STRING | B_ASN1_PRINTABLESTRING | B_ASN1_T61STRING \
+        | B_ASN1_IA5STRING | B_ASN1_VISIBLESTRING)
 
-    /* If type not in bitmask just copy string across */
-    if (!(ASN1_tag2bit(in->type) & ASN1_MASK_CANON)) {
-        if (!ASN1_STRING_copy(out, in))
-            return 0;
-        return 1;
+/*
+ * Encode the canonical form of the AttributeTypeAndValue |entry| into |*pp|
+ * if |pp| is not NULL.  Returns the encoded length or -1 on error.
+ */
+static int x509_name_entry_canon(const X509_NAME_ENTRY *entry,
+                                 unsigned char **pp)
+{
+    const ASN1_STRING *in = entry->value;
+    unsigned char *utf8 = NULL;
+    const unsigned char *from;
+    int i, fromlen, olen, vlen, clen = 0, canon, ret = -1;
+
+    if ((olen = i2d_ASN1_OBJECT(entry->object, NULL)) <= 0)
+        return -1;
+
+    canon = (ASN1_tag2bit(in->type) & ASN1_MASK_CANON) != 0;
+    if (!canon) {
+        /* If type not in bitmask just copy string across */
+        if ((vlen = i2d_ASN1_PRINTABLE(in, NULL)) < 0)
+            return -1;
+    } else {
+        from = in->data;
+        fromlen = in->length;
+        /* ASCII in a one byte per character type is already valid UTF8 */
+        if ((ASN1_tag2bit(in->type) & ASN1_MASK_CANON_1BYTE) != 0) {
+            for (i = 0; i < fromlen && ossl_isascii(from[i]); i++)
+                continue;
+        } else {
+            i = -1;
+        }
+        if (i != fromlen) {
+            if ((fromlen = ASN1_STRING_to_UTF8(&utf8, in)) < 0)
+                return -1;
+            from = utf8;
+        }
+        clen = asn1_string_canon(NULL, from, fromlen);
+        vlen = ASN1_object_size(0, clen, V_ASN1_UTF8STRING);
     }
 
-    out->type = V_ASN1_UTF8STRING;
-    out->length = ASN1_STRING_to_UTF8(&out->data, in);
-    if (out->length == -1)
-        return 0;
-
-    to = out->data;
-    from = to;
+    ret = ASN1_object_size(1, olen + vlen, V_ASN1_SEQUENCE);
+    if (pp != NULL && ret > 0) {
+        ASN1_put_object(pp, 1, olen + vlen, V_ASN1_SEQUENCE, V_ASN1_UNIVERSAL);
+        i2d_ASN1_OBJECT(entry->object, pp);
+        if (canon) {
+            ASN1_put_object(pp, 0, clen, V_ASN1_UTF8STRING, V_ASN1_UNIVERSAL);
+            *pp += asn1_string_canon(*pp, from, fromlen);
+        } else {
+            i2d_ASN1_PRINTABLE(in, pp);
+        }
+    }
+    OPENSSL_free(utf8);
+    return ret;
+}
 
-    len = out->length;
+/*
+ * Convert the UTF8 string |from| of |len| bytes to canonical form, writing
+ * it to |to| if not NULL.  Returns the canonical length, which is never
+ * larger than |len|.
+ */
+static int asn1_string_canon(unsigned char *to, const unsigned char *from,
+                             int len)
+{
+    unsigned char c;
+    int i, outlen = 0;
 
     /*
-     * Convert string in place to canonical form. Ultimately we may need to
-     * handle a wider range of characters but for now ignore anything with
-     * MSB set and rely on the ossl_isspace() to fail on bad characters without
-     * needing isascii or range checks as well.
+     * Ultimately we may need to handle a wider range of characters but for
+     * now ignore anything with MSB set and rely on the ossl_isspace() to
+     * fail on bad characters without needing isascii or range checks as well.
      */
 
     /* Ignore leading spaces */
@@ -420,67 +521,30 @@ static int asn1_string_canon(ASN1_STRING *out, const ASN1_STRING *in)
         len--;
     }
 
-    to = from + len;
-
     /* Ignore trailing spaces */
-    while (len > 0 && ossl_isspace(to[-1])) {
-        to--;
+    while (len > 0 && ossl_isspace(from[len - 1]))
         len--;
-    }
-
-    to = out->data;
 
-    i = 0;
-    while (i < len) {
+    for (i = 0; i < len; i++) {
         /* If not ASCII set just copy across */
-        if (!ossl_isascii(*from)) {
-            *to++ = *from++;
-            i++;
-        }
-        /* Collapse multiple spaces */
-        else if (ossl_isspace(*from)) {
-            /* Copy one space across */
-            *to++ = ' ';
+        if (!ossl_isascii(from[i])) {
+            c = from[i];
+        } else if (ossl_isspace(from[i])) {
             /*
-             * Ignore subsequent spaces. Note: don't need to check len here
-             * because we know the last character is a non-space so we can't
-             * overflow.
+             * Collapse multiple spaces into one. Note: don't need to check
+             * len here because we know the last character is a non-space.
              */
-            do {
-                from++;
+            c = ' ';
+            while (ossl_isspace(from[i + 1]))
                 i++;
-            }
-            while (ossl_isspace(*from));
         } else {
-            *to++ = ossl_tolower(*from);
-            from++;
-            i++;
+            c = ossl_tolower(from[i]);
         }
+        if (to != NULL)
+            to[outlen] = c;
+        outlen++;
     }
-
-    out->length = to - out->data;
-
-    return 1;
-
-}
-
-static int i2d_name_canon(const STACK_OF(STACK_OF_X509_NAME_ENTRY) * _intname,
-                          unsigned char **in)
-{
-    int i, len, ltmp;
-    const ASN1_VALUE *v;
-    STACK_OF(ASN1_VALUE) *intname = (STACK_OF(ASN1_VALUE) *)_intname;
-
-    len = 0;
-    for (i = 0; i < sk_ASN1_VALUE_num(intname); i++) {
-        v = sk_ASN1_VALUE_value(intname, i);
-        ltmp = ASN1_item_ex_i2d(&v, in,
-                                ASN1_ITEM_rptr(X509_NAME_ENTRIES), -1, -1);
-        if (ltmp < 0)
-            return ltmp;
-        len += ltmp;
-    }
-    return len;
+    return outlen;
 }
 
 int X509_NAME_set(X509_NAME **xn, const X509_NAME *name)
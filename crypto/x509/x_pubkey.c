@@ -27,12 +27,16 @@
 #include <openssl/encoder.h>
 #include "internal/provider.h"
 #include "internal/sizes.h"
+#include "internal/tsan_assist.h"
 
 struct X509_pubkey_st {
     X509_ALGOR *algor;
     ASN1_BIT_STRING *public_key;
 
     EVP_PKEY *pkey;
+    /* Set once |pkey| holds the decoded key, or decoding it has failed */
+    volatile int pkey_cached;
+    CRYPTO_RWLOCK *lock;
 
     /* extra data for the callback, used by d2i_PUBKEY_ex */
     OSSL_LIB_CTX *libctx;
@@ -91,6 +95,7 @@ static void x509_pubkey_ex_free(ASN1_VALUE **pval, const ASN1_ITEM *it)
         ASN1_BIT_STRING_free(pubkey->public_key);
         EVP_PKEY_free(pubkey->pkey);
         OPENSSL_free(pubkey->propq);
+        CRYPTO_THREAD_lock_free(pubkey->lock);
         OPENSSL_free(pubkey);
         *pval = NULL;
     }
@@ -103,7 +108,9 @@ static int x509_pubkey_ex_populate(ASN1_VALUE **pval, const ASN1_ITEM *it)
     return (pubkey->algor != NULL
             || (pubkey->algor = X509_ALGOR_new()) != NULL)
         && (pubkey->public_key != NULL
-            || (pubkey->public_key = ASN1_BIT_STRING_new()) != NULL);
+            || (pubkey->public_key = ASN1_BIT_STRING_new()) != NULL)
+        && (pubkey->lock != NULL
+            || (pubkey->lock = CRYPTO_THREAD_lock_new()) != NULL);
 }
 
 
@@ -131,12 +138,8 @@ static int x509_pubkey_ex_d2i_ex(ASN1_VALUE **pval,
                                  char opt, ASN1_TLC *ctx, OSSL_LIB_CTX *libctx,
                                  const char *propq)
 {
-    const unsigned char *in_saved = *in;
-    size_t publen;
     X509_PUBKEY *pubkey;
     int ret;
-    OSSL_DECODER_CTX *dctx = NULL;
-    unsigned char *tmpbuf = NULL;
 
     if (*pval == NULL && !x509_pubkey_ex_new_ex(pval, it, libctx, propq))
         return 0;
@@ -151,87 +154,126 @@ static int x509_pubkey_ex_d2i_ex(ASN1_VALUE **pval,
                                 tag, aclass, opt, ctx)) <= 0)
         return ret;
 
-    publen = *in - in_saved;
-    if (!ossl_assert(publen > 0)) {
-        ERR_raise(ERR_LIB_ASN1, ERR_R_INTERNAL_ERROR);
-        return 0;
-    }
-
+    /*
+     * The key itself is decoded on first use, see x509_pubkey_get0_cached().
+     * Most keys in parsed certificates are never looked at, and running them
+     * through the decoders is by far the most expensive part of the parse.
+     */
     pubkey = (X509_PUBKEY *)*pval;
     EVP_PKEY_free(pubkey->pkey);
     pubkey->pkey = NULL;
+    pubkey->pkey_cached = 0;
+    return 1;
+}
 
-    /*
-     * Opportunistically decode the key but remove any non fatal errors
-     * from the queue. Subsequent explicit attempts to decode/use the key
-     * will return an appropriate error.
-     */
-    ERR_set_mark();
+/*
+ * Decode |pubkey->algor| and |pubkey->public_key| into |pubkey->pkey|.
+ * Returns 1 on success, 0 for a decode failure and -1 for a fatal
+ * error e.g. malloc failure.
+ */
+static int x509_pubkey_decode_pkey(X509_PUBKEY *pubkey)
+{
+    unsigned char *der = NULL;
+    const unsigned char *p;
+    char txtoidname[OSSL_MAX_NAME_SIZE];
+    OSSL_DECODER_CTX *dctx = NULL;
+    long derlen;
+    size_t slen;
+    int ret;
 
     /*
      * Try to decode with legacy method first.  This ensures that engines
      * aren't overriden by providers.
      */
-    if ((ret = x509_pubkey_decode(&pubkey->pkey, pubkey)) == -1) {
-        /* -1 indicates a fatal error, like malloc failure */
-        ERR_clear_last_mark();
+    if ((ret = x509_pubkey_decode(&pubkey->pkey, pubkey)) != 0
+        || pubkey->flag_force_legacy)
+        return ret;
+
+    /*
+     * Try to decode it into an EVP_PKEY with OSSL_DECODER.  The decoders
+     * don't know how to handle anything other than Universal class, which
+     * is what re-encoding through the internal item gives us.
+     */
+    if ((derlen = ASN1_item_i2d((const ASN1_VALUE *)pubkey, &der,
+                                ASN1_ITEM_rptr(X509_PUBKEY_INTERNAL))) <= 0) {
+        ERR_raise(ERR_LIB_ASN1, ERR_R_MALLOC_FAILURE);
+        return -1;
+    }
+    p = der;
+    slen = (size_t)derlen;
+
+    ret = 0;
+    if (OBJ_obj2txt(txtoidname, sizeof(txtoidname),
+                    pubkey->algor->algorithm, 0) <= 0)
         goto end;
+    if ((dctx =
+         OSSL_DECODER_CTX_new_for_pkey(&pubkey->pkey,
+                                       "DER", "SubjectPublicKeyInfo",
+                                       txtoidname, EVP_PKEY_PUBLIC_KEY,
+                                       pubkey->libctx,
+                                       pubkey->propq)) != NULL
+        && OSSL_DECODER_from_data(dctx, &p, &slen)) {
+        /* If we successfully decoded then we *must* consume all the bytes. */
+        if (slen == 0) {
+            ret = 1;
+        } else {
+            EVP_PKEY_free(pubkey->pkey);
+            pubkey->pkey = NULL;
+        }
     }
+ end:
+    OSSL_DECODER_CTX_free(dctx);
+    OPENSSL_free(der);
+    return ret;
+}
 
-    /* Try to decode it into an EVP_PKEY with OSSL_DECODER */
-    if (ret <= 0 && !pubkey->flag_force_legacy) {
-        const unsigned char *p;
-        char txtoidname[OSSL_MAX_NAME_SIZE];
-        size_t slen = publen;
+/*
+ * Returns the decoded key, decoding it first if this hasn't been done yet.
+ * This may be called concurrently on a shared object, so the decode is done
+ * under the write lock, with a lock-free fast path once it is cached.
+ */
+static EVP_PKEY *x509_pubkey_get0_cached(X509_PUBKEY *pubkey)
+{
+    EVP_PKEY *ret;
 
-        /*
-        * The decoders don't know how to handle anything other than Universal
-        * class so we modify the data accordingly.
-        */
-        if (aclass != V_ASN1_UNIVERSAL) {
-            tmpbuf = OPENSSL_memdup(in_saved, publen);
-            if (tmpbuf == NULL) {
-                ERR_raise(ERR_LIB_ASN1, ERR_R_MALLOC_FAILURE);
-                return 0;
-            }
-            in_saved = tmpbuf;
-            *tmpbuf = V_ASN1_CONSTRUCTED | V_ASN1_SEQUENCE;
-        }
-        p = in_saved;
+    if (pubkey->lock == NULL)
+        return pubkey->pkey;
 
-        if (OBJ_obj2txt(txtoidname, sizeof(txtoidname),
-                        pubkey->algor->algorithm, 0) <= 0) {
+#ifdef tsan_ld_acq
+    /* Fast lock-free check, see end of the function for details. */
+    if (tsan_ld_acq((TSAN_QUALIFIER int *)&pubkey->pkey_cached))
+        return pubkey->pkey;
+#endif
+
+    if (!CRYPTO_THREAD_write_lock(pubkey->lock))
+        return NULL;
+    if (!pubkey->pkey_cached) {
+        /*
+         * Decoding is opportunistic, so remove any non fatal errors from the
+         * queue.  The caller reports the key as undecodable.
+         */
+        ERR_set_mark();
+        if (x509_pubkey_decode_pkey(pubkey) == -1) {
+            /* A fatal error is not cached, we may do better next time */
             ERR_clear_last_mark();
-            goto end;
+            CRYPTO_THREAD_unlock(pubkey->lock);
+            return NULL;
         }
-        if ((dctx =
-             OSSL_DECODER_CTX_new_for_pkey(&pubkey->pkey,
-                                           "DER", "SubjectPublicKeyInfo",
-                                           txtoidname, EVP_PKEY_PUBLIC_KEY,
-                                           pubkey->libctx,
-                                           pubkey->propq)) != NULL)
-            /*
-             * As said higher up, we're being opportunistic.  In other words,
-             * we don't care if we fail.
-             */
-            if (OSSL_DECODER_from_data(dctx, &p, &slen)) {
-                if (slen != 0) {
-                    /*
-                     * If we successfully decoded then we *must* consume all the
-                     * bytes.
-                     */
-                    ERR_clear_last_mark();
-                    ERR_raise(ERR_LIB_ASN1, EVP_R_DECODE_ERROR);
-                    goto end;
-                }
-            }
+        ERR_pop_to_mark();
+#ifdef tsan_st_rel
+        tsan_st_rel((TSAN_QUALIFIER int *)&pubkey->pkey_cached, 1);
+        /*
+         * Above store triggers fast lock-free check in the beginning of the
+         * function. But one has to ensure that the structure is "stable",
+         * i.e. all stores are visible on all processors. Hence the release
+         * fence.
+         */
+#else
+        pubkey->pkey_cached = 1;
+#endif
     }
-
-    ERR_pop_to_mark();
-    ret = 1;
- end:
-    OSSL_DECODER_CTX_free(dctx);
-    OPENSSL_free(tmpbuf);
+    ret = pubkey->pkey;
+    CRYPTO_THREAD_unlock(pubkey->lock);
     return ret;
 }
 
@@ -283,6 +325,8 @@ X509_PUBKEY *X509_PUBKEY_new_ex(OSSL_LIB_CTX *libctx, const char *propq)
 X509_PUBKEY *X509_PUBKEY_dup(const X509_PUBKEY *a)
 {
     X509_PUBKEY *pubkey = OPENSSL_zalloc(sizeof(*pubkey));
+    /* Decode first so that both copies share the same key */
+    EVP_PKEY *pkey = x509_pubkey_get0_cached((X509_PUBKEY *)a);
 
     if (pubkey == NULL
             || !x509_pubkey_set0_libctx(pubkey, a->libctx, a->propq)
@@ -290,13 +334,17 @@ X509_PUBKEY *X509_PUBKEY_dup(const X509_PUBKEY *a)
             || (pubkey->public_key = ASN1_BIT_STRING_new()) == NULL
             || !ASN1_BIT_STRING_set(pubkey->public_key,
                                     a->public_key->data, a->public_key->length)
-            || (a->pkey != NULL && !EVP_PKEY_up_ref(a->pkey))) {
+            || (a->lock != NULL
+                && (pubkey->lock = CRYPTO_THREAD_lock_new()) == NULL)
+            || (pkey != NULL && !EVP_PKEY_up_ref(pkey))) {
         x509_pubkey_ex_free((ASN1_VALUE **)&pubkey,
                             ASN1_ITEM_rptr(X509_PUBKEY_INTERNAL));
         ERR_raise(ERR_LIB_X509, ERR_R_MALLOC_FAILURE);
         return NULL;
     }
-    pubkey->pkey = a->pkey;
+    pubkey->pkey = pkey;
+    pubkey->pkey_cached = a->pkey_cached;
+    pubkey->flag_force_legacy = a->flag_force_legacy;
     return pubkey;
 }
 
@@ -367,6 +415,7 @@ int X509_PUBKEY_set(X509_PUBKEY **x, EVP_PKEY *pkey)
         EVP_PKEY_free(pk->pkey);
 
     pk->pkey = pkey;
+    pk->pkey_cached = 1;
     return 1;
 
  error:
@@ -434,18 +483,21 @@ static int x509_pubkey_decode(EVP_PKEY **ppkey, const X509_PUBKEY *key)
 
 EVP_PKEY *X509_PUBKEY_get0(const X509_PUBKEY *key)
 {
+    EVP_PKEY *pkey;
+
     if (key == NULL) {
         ERR_raise(ERR_LIB_X509, ERR_R_PASSED_NULL_PARAMETER);
         return NULL;
     }
 
-    if (key->pkey == NULL) {
-        /* We failed to decode the key when we loaded it, or it was never set */
+    /* The cast is fine, the key is only decoded once and then cached */
+    if ((pkey = x509_pubkey_get0_cached((X509_PUBKEY *)key)) == NULL) {
+        /* We failed to decode the key, or it was never set */
         ERR_raise(ERR_LIB_EVP, EVP_R_DECODE_ERROR);
         return NULL;
     }
 
-    return key->pkey;
+    return pkey;
 }
 
 EVP_PKEY *X509_PUBKEY_get(const X509_PUBKEY *key)
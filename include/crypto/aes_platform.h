@@ -227,6 +227,44 @@ void gcm_ghash_avx(u64 Xi[2], const u128 Htable[16], const u8 *in, size_t len);
 #   define AES_gcm_decrypt aesni_gcm_decrypt
 #   define AES_GCM_ASM(ctx)    (ctx->ctr == aesni_ctr32_encrypt_blocks && \
                                 ctx->gcm.ghash == gcm_ghash_avx)
+
+/*
+ * VAES and VPCLMULQDQ on 512-bit registers, see aes-gcm-avx512.pl. The
+ * table holds H^32 .. H^1, the bulk functions want its last 16 entries.
+ */
+int ossl_vaes_vpclmulqdq_capable(void);
+void ossl_gcm_init_avx512(u128 Htable[32], const u64 H[2]);
+void ossl_gcm_ghash_avx512(u64 Xi[2], const u128 Htable[32],
+                           const u8 *in, size_t len);
+void ossl_aes_ctr32_encrypt_avx512(const unsigned char *in, unsigned char *out,
+                                   size_t blocks, const void *key,
+                                   const unsigned char *ivec);
+size_t ossl_aes_gcm_encrypt_avx512(const unsigned char *in, unsigned char *out,
+                                   size_t len, const void *key,
+                                   unsigned char ivec[16], u64 *Xi,
+                                   const u128 Htable[16]);
+size_t ossl_aes_gcm_decrypt_avx512(const unsigned char *in, unsigned char *out,
+                                   size_t len, const void *key,
+                                   unsigned char ivec[16], u64 *Xi,
+                                   const u128 Htable[16]);
+
+#   define AES_GCM_AVX512_CAPABLE  ossl_vaes_vpclmulqdq_capable()
+
+/*
+ * VAES XTS, see aes-xts-avx512.pl. Processes |units| data units of
+ * |unit_len| bytes each, a multiple of 16, the tweak of the first one being
+ * |iv| and those of the others following it as 128-bit little-endian numbers.
+ */
+void ossl_aes_xts_encrypt_avx512(const unsigned char *in, unsigned char *out,
+                                 size_t unit_len, size_t units,
+                                 const AES_KEY *key1, const AES_KEY *key2,
+                                 const unsigned char iv[16]);
+void ossl_aes_xts_decrypt_avx512(const unsigned char *in, unsigned char *out,
+                                 size_t unit_len, size_t units,
+                                 const AES_KEY *key1, const AES_KEY *key2,
+                                 const unsigned char iv[16]);
+
+#   define AES_XTS_AVX512_CAPABLE  ossl_vaes_vpclmulqdq_capable()
 #  endif
 
 
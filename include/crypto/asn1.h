@@ -86,6 +86,12 @@ struct evp_pkey_asn1_method_st {
                                     const PKCS8_PRIV_KEY_INFO *p8inf,
                                     OSSL_LIB_CTX *libctx,
                                     const char *propq);
+    /*
+     * Duplicate the legacy key object for the built-in default provider,
+     * which uses the same key structures.  Returns the new key or NULL if
+     * the key can't be duplicated this way and must be exported.
+     */
+    void *(*dup_to) (const EVP_PKEY *pk, OSSL_LIB_CTX *libctx);
 } /* EVP_PKEY_ASN1_METHOD */ ;
 
 DEFINE_STACK_OF_CONST(EVP_PKEY_ASN1_METHOD)
@@ -39,4 +39,6 @@ int ossl_decoder_ctx_setup_for_pkey(OSSL_DECODER_CTX *ctx,
 
 int ossl_decoder_get_number(const OSSL_DECODER *encoder);
 
+int ossl_decoder_cache_flush(OSSL_LIB_CTX *libctx);
+
 #endif
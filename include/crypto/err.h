@@ -16,5 +16,7 @@ int ossl_err_load_crypto_strings(void);
 void err_cleanup(void);
 int err_shelve_state(void **);
 void err_unshelve_state(void *);
+int ossl_err_suppress(void);
+void ossl_err_unsuppress(void);
 
 #endif
@@ -294,6 +294,7 @@ struct evp_md_st {
     OSSL_FUNC_digest_gettable_params_fn *gettable_params;
     OSSL_FUNC_digest_settable_ctx_params_fn *settable_ctx_params;
     OSSL_FUNC_digest_gettable_ctx_params_fn *gettable_ctx_params;
+    OSSL_FUNC_digest_digest_many_fn *digest_many;
 
 } /* EVP_MD */ ;
 
@@ -351,6 +352,13 @@ struct evp_cipher_st {
     OSSL_FUNC_cipher_gettable_params_fn *gettable_params;
     OSSL_FUNC_cipher_gettable_ctx_params_fn *gettable_ctx_params;
     OSSL_FUNC_cipher_settable_ctx_params_fn *settable_ctx_params;
+    OSSL_FUNC_cipher_get_aead_tag_fn *get_aead_tag;
+    OSSL_FUNC_cipher_set_aead_tag_fn *set_aead_tag;
+    OSSL_FUNC_cipher_aead_seal_fn *aead_seal;
+    OSSL_FUNC_cipher_aead_open_fn *aead_open;
+    OSSL_FUNC_cipher_aead_seal_many_fn *aead_seal_many;
+    OSSL_FUNC_cipher_aead_open_many_fn *aead_open_many;
+    OSSL_FUNC_cipher_cipher_data_units_fn *cipher_data_units;
 } /* EVP_CIPHER */ ;
 
 /* Macros to code block cipher wrappers */
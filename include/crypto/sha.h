@@ -18,5 +18,25 @@ int sha512_224_init(SHA512_CTX *);
 int sha512_256_init(SHA512_CTX *);
 int ossl_sha1_ctrl(SHA_CTX *ctx, int cmd, int mslen, void *ms);
 unsigned char *ossl_sha1(const unsigned char *d, size_t n, unsigned char *md);
+int ossl_sha1_many(size_t num, const unsigned char *const in[],
+                   const size_t inl[], unsigned char *out);
+int ossl_sha224_many(size_t num, const unsigned char *const in[],
+                     const size_t inl[], unsigned char *out);
+int ossl_sha256_many(size_t num, const unsigned char *const in[],
+                     const size_t inl[], unsigned char *out);
+# ifndef FIPS_MODULE
+int ossl_sha1_pbkdf2_many(const unsigned char *pass, size_t passlen,
+                          const unsigned char *salt, size_t saltlen,
+                          uint64_t iter, uint32_t first, size_t num,
+                          unsigned char *out);
+int ossl_sha224_pbkdf2_many(const unsigned char *pass, size_t passlen,
+                            const unsigned char *salt, size_t saltlen,
+                            uint64_t iter, uint32_t first, size_t num,
+                            unsigned char *out);
+int ossl_sha256_pbkdf2_many(const unsigned char *pass, size_t passlen,
+                            const unsigned char *salt, size_t saltlen,
+                            uint64_t iter, uint32_t first, size_t num,
+                            unsigned char *out);
+# endif
 
 #endif
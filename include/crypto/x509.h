@@ -42,6 +42,8 @@ struct X509_name_st {
     /* canonical encoding used for rapid Name comparison */
     unsigned char *canon_enc;
     int canon_enclen;
+    /* leading bytes of the SHA1 digest of canon_enc, little endian */
+    uint64_t canon_hash;
 } /* X509_NAME */ ;
 
 /* Signature info structure */
@@ -312,6 +314,7 @@ int ossl_x509_set1_time(ASN1_TIME **ptm, const ASN1_TIME *tm);
 int ossl_x509_print_ex_brief(BIO *bio, X509 *cert, unsigned long neg_cflags);
 int ossl_x509v3_cache_extensions(X509 *x);
 int ossl_x509_init_sig_info(X509 *x);
+int ossl_x509_name_eq(const X509_NAME *a, const X509_NAME *b);
 
 int ossl_x509_set0_libctx(X509 *x, OSSL_LIB_CTX *libctx, const char *propq);
 int ossl_x509_crl_set0_libctx(X509_CRL *x, OSSL_LIB_CTX *libctx,
@@ -97,6 +97,15 @@ void ossl_crypto_cleanup_all_ex_data_int(OSSL_LIB_CTX *ctx);
 int openssl_init_fork_handlers(void);
 int openssl_get_fork_id(void);
 
+/*
+ * Calls fn(arg, i) for every i from 0 to num - 1, on up to |threads| threads
+ * including the calling one, and returns 0 if any call did.  The calls are
+ * made in the calling thread when threads are not available.
+ */
+# define OSSL_CRYPTO_PARALLEL_MAX_THREADS 64
+int ossl_crypto_parallel_run(size_t num, size_t threads,
+                             int (*fn)(void *arg, size_t i), void *arg);
+
 char *ossl_safe_getenv(const char *name);
 
 extern CRYPTO_RWLOCK *memdbg_lock;
@@ -168,7 +177,8 @@ typedef struct ossl_ex_data_global_st {
 # define OSSL_LIB_CTX_PROVIDER_CONF_INDEX           16
 # define OSSL_LIB_CTX_BIO_CORE_INDEX                17
 # define OSSL_LIB_CTX_CHILD_PROVIDER_INDEX          18
-# define OSSL_LIB_CTX_MAX_INDEXES                   19
+# define OSSL_LIB_CTX_DECODER_CACHE_INDEX           19
+# define OSSL_LIB_CTX_MAX_INDEXES                   20
 
 # define OSSL_LIB_CTX_METHOD_LOW_PRIORITY          -1
 # define OSSL_LIB_CTX_METHOD_DEFAULT_PRIORITY       0
@@ -47,6 +47,9 @@ int ossl_keccak_kmac_init(KECCAK1600_CTX *ctx, unsigned char pad,
                           size_t bitlen);
 int ossl_sha3_update(KECCAK1600_CTX *ctx, const void *_inp, size_t len);
 int ossl_sha3_final(unsigned char *md, KECCAK1600_CTX *ctx);
+int ossl_sha3_many(size_t num, const unsigned char *const in[],
+                   const size_t inl[], unsigned char *out,
+                   unsigned char pad, size_t bitlen, size_t mdlen);
 
 size_t SHA3_absorb(uint64_t A[5][5], const unsigned char *inp, size_t len,
                    size_t r);
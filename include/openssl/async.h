@@ -37,6 +37,7 @@ extern "C" {
 
 typedef struct async_job_st ASYNC_JOB;
 typedef struct async_wait_ctx_st ASYNC_WAIT_CTX;
+typedef struct async_queue_st ASYNC_QUEUE;
 typedef int (*ASYNC_callback_fn)(void *arg);
 
 #define ASYNC_ERR      0
@@ -51,6 +52,7 @@ typedef int (*ASYNC_callback_fn)(void *arg);
 
 int ASYNC_init_thread(size_t max_size, size_t init_size);
 void ASYNC_cleanup_thread(void);
+int ASYNC_set_stack_size(size_t size);
 
 #ifdef OSSL_ASYNC_FD
 ASYNC_WAIT_CTX *ASYNC_WAIT_CTX_new(void);
@@ -76,6 +78,14 @@ int ASYNC_WAIT_CTX_get_changed_fds(ASYNC_WAIT_CTX *ctx, OSSL_ASYNC_FD *addfd,
                                    size_t *numaddfds, OSSL_ASYNC_FD *delfd,
                                    size_t *numdelfds);
 int ASYNC_WAIT_CTX_clear_fd(ASYNC_WAIT_CTX *ctx, const void *key);
+int ASYNC_WAIT_CTX_set_queue(ASYNC_WAIT_CTX *ctx, ASYNC_QUEUE *queue,
+                             void *item);
+
+ASYNC_QUEUE *ASYNC_QUEUE_new(void);
+void ASYNC_QUEUE_free(ASYNC_QUEUE *queue);
+int ASYNC_QUEUE_get_fd(ASYNC_QUEUE *queue, OSSL_ASYNC_FD *fd);
+int ASYNC_QUEUE_push(ASYNC_QUEUE *queue, void *item);
+size_t ASYNC_QUEUE_drain(ASYNC_QUEUE *queue, void **items, size_t max_items);
 #endif
 
 int ASYNC_is_capable(void);
@@ -283,6 +283,7 @@ OSSL_CORE_MAKE_FUNC(int, provider_self_test, (void *provctx))
 # define OSSL_FUNC_DIGEST_GETTABLE_PARAMS           11
 # define OSSL_FUNC_DIGEST_SETTABLE_CTX_PARAMS       12
 # define OSSL_FUNC_DIGEST_GETTABLE_CTX_PARAMS       13
+# define OSSL_FUNC_DIGEST_DIGEST_MANY               14
 
 OSSL_CORE_MAKE_FUNC(void *, digest_newctx, (void *provctx))
 OSSL_CORE_MAKE_FUNC(int, digest_init, (void *dctx, const OSSL_PARAM params[]))
@@ -294,6 +295,9 @@ OSSL_CORE_MAKE_FUNC(int, digest_final,
 OSSL_CORE_MAKE_FUNC(int, digest_digest,
                     (void *provctx, const unsigned char *in, size_t inl,
                      unsigned char *out, size_t *outl, size_t outsz))
+OSSL_CORE_MAKE_FUNC(int, digest_digest_many,
+                    (void *provctx, size_t num, const unsigned char *const *in,
+                     const size_t *inl, unsigned char *out, size_t outsz))
 
 OSSL_CORE_MAKE_FUNC(void, digest_freectx, (void *dctx))
 OSSL_CORE_MAKE_FUNC(void *, digest_dupctx, (void *dctx))
@@ -326,6 +330,13 @@ OSSL_CORE_MAKE_FUNC(const OSSL_PARAM *, digest_gettable_ctx_params,
 # define OSSL_FUNC_CIPHER_GETTABLE_PARAMS           12
 # define OSSL_FUNC_CIPHER_GETTABLE_CTX_PARAMS       13
 # define OSSL_FUNC_CIPHER_SETTABLE_CTX_PARAMS       14
+# define OSSL_FUNC_CIPHER_GET_AEAD_TAG              15
+# define OSSL_FUNC_CIPHER_SET_AEAD_TAG              16
+# define OSSL_FUNC_CIPHER_AEAD_SEAL                 17
+# define OSSL_FUNC_CIPHER_AEAD_OPEN                 18
+# define OSSL_FUNC_CIPHER_AEAD_SEAL_MANY            19
+# define OSSL_FUNC_CIPHER_AEAD_OPEN_MANY            20
+# define OSSL_FUNC_CIPHER_CIPHER_DATA_UNITS         21
 
 OSSL_CORE_MAKE_FUNC(void *, cipher_newctx, (void *provctx))
 OSSL_CORE_MAKE_FUNC(int, cipher_encrypt_init, (void *cctx,
@@ -364,6 +375,38 @@ OSSL_CORE_MAKE_FUNC(const OSSL_PARAM *, cipher_settable_ctx_params,
                     (void *cctx, void *provctx))
 OSSL_CORE_MAKE_FUNC(const OSSL_PARAM *, cipher_gettable_ctx_params,
                     (void *cctx, void *provctx))
+OSSL_CORE_MAKE_FUNC(int, cipher_get_aead_tag,
+                    (void *cctx, unsigned char *tag, size_t taglen))
+OSSL_CORE_MAKE_FUNC(int, cipher_set_aead_tag,
+                    (void *cctx, const unsigned char *tag, size_t taglen))
+OSSL_CORE_MAKE_FUNC(int, cipher_aead_seal,
+                    (void *cctx, const unsigned char *iv, size_t ivlen,
+                     const unsigned char *aad, size_t aadlen,
+                     const unsigned char *in, size_t inl, unsigned char *out,
+                     unsigned char *tag, size_t taglen))
+OSSL_CORE_MAKE_FUNC(int, cipher_aead_open,
+                    (void *cctx, const unsigned char *iv, size_t ivlen,
+                     const unsigned char *aad, size_t aadlen,
+                     const unsigned char *in, size_t inl, unsigned char *out,
+                     const unsigned char *tag, size_t taglen))
+OSSL_CORE_MAKE_FUNC(int, cipher_aead_seal_many,
+                    (void *cctx, size_t num,
+                     const unsigned char *const iv[], size_t ivlen,
+                     const unsigned char *const aad[], const size_t aadlen[],
+                     const unsigned char *const in[], const size_t inl[],
+                     unsigned char *const out[],
+                     unsigned char *const tag[], size_t taglen))
+OSSL_CORE_MAKE_FUNC(int, cipher_aead_open_many,
+                    (void *cctx, size_t num,
+                     const unsigned char *const iv[], size_t ivlen,
+                     const unsigned char *const aad[], const size_t aadlen[],
+                     const unsigned char *const in[], const size_t inl[],
+                     unsigned char *const out[],
+                     const unsigned char *const tag[], size_t taglen,
+                     int ok[]))
+OSSL_CORE_MAKE_FUNC(int, cipher_cipher_data_units,
+                    (void *cctx, unsigned char *out, const unsigned char *in,
+                     size_t inl, size_t unit_len, uint64_t first_unit))
 
 /* MACs */
 
@@ -129,6 +129,7 @@ extern "C" {
 #define OSSL_DIGEST_PARAM_SIZE         "size"          /* size_t */
 #define OSSL_DIGEST_PARAM_XOF          "xof"           /* int, 0 or 1 */
 #define OSSL_DIGEST_PARAM_ALGID_ABSENT "algid-absent"  /* int, 0 or 1 */
+#define OSSL_DIGEST_PARAM_THREADS      "threads"       /* uint */
 
 /* Known DIGEST names (not a complete list) */
 #define OSSL_DIGEST_NAME_MD5            "MD5"
@@ -204,6 +205,11 @@ extern "C" {
 #define OSSL_KDF_PARAM_SCRYPT_R     "r"         /* uint32_t */
 #define OSSL_KDF_PARAM_SCRYPT_P     "p"         /* uint32_t */
 #define OSSL_KDF_PARAM_SCRYPT_MAXMEM "maxmem_bytes" /* uint64_t */
+#define OSSL_KDF_PARAM_THREADS      "threads"   /* uint32_t */
+#define OSSL_KDF_PARAM_ARGON2_AD    "ad"        /* octet string */
+#define OSSL_KDF_PARAM_ARGON2_LANES "lanes"     /* uint32_t */
+#define OSSL_KDF_PARAM_ARGON2_MEMCOST "memcost" /* uint32_t */
+#define OSSL_KDF_PARAM_ARGON2_VERSION "version" /* uint32_t */
 #define OSSL_KDF_PARAM_INFO         "info"      /* octet string */
 #define OSSL_KDF_PARAM_SEED         "seed"      /* octet string */
 #define OSSL_KDF_PARAM_SSHKDF_XCGHASH "xcghash" /* octet string */
@@ -222,6 +228,9 @@ extern "C" {
 #define OSSL_KDF_PARAM_X942_USE_KEYBITS     "use-keybits"
 
 /* Known KDF names */
+#define OSSL_KDF_NAME_ARGON2D        "ARGON2D"
+#define OSSL_KDF_NAME_ARGON2I        "ARGON2I"
+#define OSSL_KDF_NAME_ARGON2ID       "ARGON2ID"
 #define OSSL_KDF_NAME_HKDF           "HKDF"
 #define OSSL_KDF_NAME_PBKDF1         "PBKDF1"
 #define OSSL_KDF_NAME_PBKDF2         "PBKDF2"
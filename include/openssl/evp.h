@@ -725,6 +725,10 @@ __owur int EVP_Digest(const void *data, size_t count,
 __owur int EVP_Q_digest(OSSL_LIB_CTX *libctx, const char *name,
                         const char *propq, const void *data, size_t datalen,
                         unsigned char *md, size_t *mdlen);
+__owur int EVP_Digest_many(const unsigned char *const data[],
+                           const size_t count[], size_t num,
+                           unsigned char *md, size_t mdsize,
+                           const EVP_MD *type);
 
 __owur int EVP_MD_CTX_copy(EVP_MD_CTX *out, const EVP_MD_CTX *in);
 __owur int EVP_DigestInit(EVP_MD_CTX *ctx, const EVP_MD *type);
@@ -885,6 +889,47 @@ int EVP_CIPHER_CTX_set_key_length(EVP_CIPHER_CTX *x, int keylen);
 int EVP_CIPHER_CTX_set_padding(EVP_CIPHER_CTX *c, int pad);
 int EVP_CIPHER_CTX_ctrl(EVP_CIPHER_CTX *ctx, int type, int arg, void *ptr);
 int EVP_CIPHER_CTX_rand_key(EVP_CIPHER_CTX *ctx, unsigned char *key);
+int EVP_CIPHER_CTX_aead_init(EVP_CIPHER_CTX *ctx,
+                             const unsigned char *iv, size_t ivlen,
+                             const unsigned char *aad, size_t aadlen);
+int EVP_CIPHER_CTX_get_aead_tag(EVP_CIPHER_CTX *ctx,
+                                unsigned char *tag, size_t taglen);
+int EVP_CIPHER_CTX_set_aead_tag(EVP_CIPHER_CTX *ctx,
+                                const unsigned char *tag, size_t taglen);
+int EVP_CIPHER_CTX_aead_seal(EVP_CIPHER_CTX *ctx,
+                             const unsigned char *iv, size_t ivlen,
+                             const unsigned char *aad, size_t aadlen,
+                             const unsigned char *in, size_t inl,
+                             unsigned char *out,
+                             unsigned char *tag, size_t taglen);
+int EVP_CIPHER_CTX_aead_open(EVP_CIPHER_CTX *ctx,
+                             const unsigned char *iv, size_t ivlen,
+                             const unsigned char *aad, size_t aadlen,
+                             const unsigned char *in, size_t inl,
+                             unsigned char *out,
+                             const unsigned char *tag, size_t taglen);
+int EVP_CIPHER_CTX_aead_seal_many(EVP_CIPHER_CTX *ctx, size_t num,
+                                  const unsigned char *const iv[],
+                                  size_t ivlen,
+                                  const unsigned char *const aad[],
+                                  const size_t aadlen[],
+                                  const unsigned char *const in[],
+                                  const size_t inl[],
+                                  unsigned char *const out[],
+                                  unsigned char *const tag[], size_t taglen);
+int EVP_CIPHER_CTX_aead_open_many(EVP_CIPHER_CTX *ctx, size_t num,
+                                  const unsigned char *const iv[],
+                                  size_t ivlen,
+                                  const unsigned char *const aad[],
+                                  const size_t aadlen[],
+                                  const unsigned char *const in[],
+                                  const size_t inl[],
+                                  unsigned char *const out[],
+                                  const unsigned char *const tag[],
+                                  size_t taglen, int ok[]);
+int EVP_CIPHER_CTX_cipher_data_units(EVP_CIPHER_CTX *ctx, unsigned char *out,
+                                     const unsigned char *in, size_t inl,
+                                     size_t unit_len, uint64_t first_unit);
 int EVP_CIPHER_get_params(EVP_CIPHER *cipher, OSSL_PARAM params[]);
 int EVP_CIPHER_CTX_set_params(EVP_CIPHER_CTX *ctx, const OSSL_PARAM params[]);
 int EVP_CIPHER_CTX_get_params(EVP_CIPHER_CTX *ctx, OSSL_PARAM params[]);
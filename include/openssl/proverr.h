@@ -63,7 +63,9 @@
 # define PROV_R_INVALID_IV_LENGTH                         109
 # define PROV_R_INVALID_KEY                               158
 # define PROV_R_INVALID_KEY_LENGTH                        105
+# define PROV_R_INVALID_LANES                             230
 # define PROV_R_INVALID_MAC                               151
+# define PROV_R_INVALID_MEMORY_SIZE                       231
 # define PROV_R_INVALID_MGF1_MD                           167
 # define PROV_R_INVALID_MODE                              125
 # define PROV_R_INVALID_OUTPUT_LENGTH                     217
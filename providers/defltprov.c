@@ -137,8 +137,14 @@ static const OSSL_ALGORITHM deflt_digests[] = {
      */
     { PROV_NAMES_BLAKE2S_256, "provider=default", ossl_blake2s256_functions },
     { PROV_NAMES_BLAKE2B_512, "provider=default", ossl_blake2b512_functions },
+    { PROV_NAMES_BLAKE2SP_256, "provider=default", ossl_blake2sp256_functions },
+    { PROV_NAMES_BLAKE2BP_512, "provider=default", ossl_blake2bp512_functions },
 #endif /* OPENSSL_NO_BLAKE2 */
 
+#ifndef OPENSSL_NO_BLAKE3
+    { PROV_NAMES_BLAKE3_256, "provider=default", ossl_blake3_256_functions },
+#endif /* OPENSSL_NO_BLAKE3 */
+
 #ifndef OPENSSL_NO_SM3
     { PROV_NAMES_SM3, "provider=default", ossl_sm3_functions },
 #endif /* OPENSSL_NO_SM3 */
@@ -332,6 +338,11 @@ static const OSSL_ALGORITHM deflt_kdfs[] = {
     { PROV_NAMES_SCRYPT, "provider=default", ossl_kdf_scrypt_functions },
 #endif
     { PROV_NAMES_KRB5KDF, "provider=default", ossl_kdf_krb5kdf_functions },
+#ifndef OPENSSL_NO_ARGON2
+    { PROV_NAMES_ARGON2D, "provider=default", ossl_kdf_argon2d_functions },
+    { PROV_NAMES_ARGON2I, "provider=default", ossl_kdf_argon2i_functions },
+    { PROV_NAMES_ARGON2ID, "provider=default", ossl_kdf_argon2id_functions },
+#endif
     { NULL, NULL, NULL }
 };
 
@@ -39,6 +39,11 @@ typedef struct prov_aes_gcm_ctx_st {
             int res;
         } s390x;
 #endif /* defined(OPENSSL_CPUID_OBJ) && defined(__s390__) */
+#if defined(AES_GCM_AVX512_CAPABLE)
+        struct {
+            u128 Htable[32];        /* H^32 .. H^1 */
+        } avx512;
+#endif
     } plat;
 } PROV_AES_GCM_CTX;
 
@@ -42,6 +42,8 @@ static OSSL_FUNC_cipher_get_ctx_params_fn aes_ocb_get_ctx_params;
 static OSSL_FUNC_cipher_set_ctx_params_fn aes_ocb_set_ctx_params;
 static OSSL_FUNC_cipher_gettable_ctx_params_fn cipher_ocb_gettable_ctx_params;
 static OSSL_FUNC_cipher_settable_ctx_params_fn cipher_ocb_settable_ctx_params;
+static OSSL_FUNC_cipher_get_aead_tag_fn aes_ocb_get_aead_tag;
+static OSSL_FUNC_cipher_set_aead_tag_fn aes_ocb_set_aead_tag;
 
 /*
  * The following methods could be moved into PROV_AES_OCB_HW if
@@ -367,17 +369,9 @@ static int aes_ocb_set_ctx_params(void *vctx, const OSSL_PARAM params[])
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
             return 0;
         }
-        if (p->data == NULL) {
-            /* Tag len must be 0 to 16 */
-            if (p->data_size > OCB_MAX_TAG_LEN)
-                return 0;
-            ctx->taglen = p->data_size;
-        } else {
-            if (p->data_size != ctx->taglen || ctx->base.enc)
-                return 0;
-            memcpy(ctx->tag, p->data, p->data_size);
-        }
-     }
+        if (!aes_ocb_set_aead_tag(ctx, p->data, p->data_size))
+            return 0;
+    }
     p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_IVLEN);
     if (p != NULL) {
         if (!OSSL_PARAM_get_size_t(p, &sz)) {
@@ -458,11 +452,39 @@ static int aes_ocb_get_ctx_params(void *vctx, OSSL_PARAM params[])
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
             return 0;
         }
-        if (!ctx->base.enc || p->data_size != ctx->taglen) {
-            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        if (!aes_ocb_get_aead_tag(ctx, p->data, p->data_size))
             return 0;
-        }
-        memcpy(p->data, ctx->tag, ctx->taglen);
+    }
+    return 1;
+}
+
+static int aes_ocb_get_aead_tag(void *vctx, unsigned char *tag, size_t taglen)
+{
+    PROV_AES_OCB_CTX *ctx = (PROV_AES_OCB_CTX *)vctx;
+
+    if (!ctx->base.enc || taglen != ctx->taglen) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        return 0;
+    }
+    memcpy(tag, ctx->tag, ctx->taglen);
+    return 1;
+}
+
+/* A NULL |tag| only sets the tag length */
+static int aes_ocb_set_aead_tag(void *vctx, const unsigned char *tag,
+                                size_t taglen)
+{
+    PROV_AES_OCB_CTX *ctx = (PROV_AES_OCB_CTX *)vctx;
+
+    if (tag == NULL) {
+        /* Tag len must be 0 to 16 */
+        if (taglen > OCB_MAX_TAG_LEN)
+            return 0;
+        ctx->taglen = taglen;
+    } else {
+        if (taglen != ctx->taglen || ctx->base.enc)
+            return 0;
+        memcpy(ctx->tag, tag, taglen);
     }
     return 1;
 }
@@ -551,6 +573,10 @@ const OSSL_DISPATCH ossl_##aes##kbits##mode##_functions[] = {                  \
         (void (*)(void))cipher_ocb_gettable_ctx_params },                      \
     { OSSL_FUNC_CIPHER_SETTABLE_CTX_PARAMS,                                    \
         (void (*)(void))cipher_ocb_settable_ctx_params },                      \
+    { OSSL_FUNC_CIPHER_GET_AEAD_TAG,                                           \
+        (void (*)(void))aes_##mode##_get_aead_tag },                           \
+    { OSSL_FUNC_CIPHER_SET_AEAD_TAG,                                           \
+        (void (*)(void))aes_##mode##_set_aead_tag },                           \
     { 0, NULL }                                                                \
 }
 
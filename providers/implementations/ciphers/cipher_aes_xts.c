@@ -30,6 +30,7 @@ static OSSL_FUNC_cipher_decrypt_init_fn aes_xts_dinit;
 static OSSL_FUNC_cipher_update_fn aes_xts_stream_update;
 static OSSL_FUNC_cipher_final_fn aes_xts_stream_final;
 static OSSL_FUNC_cipher_cipher_fn aes_xts_cipher;
+static OSSL_FUNC_cipher_cipher_data_units_fn aes_xts_cipher_data_units;
 static OSSL_FUNC_cipher_freectx_fn aes_xts_freectx;
 static OSSL_FUNC_cipher_dupctx_fn aes_xts_dupctx;
 static OSSL_FUNC_cipher_set_ctx_params_fn aes_xts_set_ctx_params;
@@ -179,7 +180,10 @@ static int aes_xts_cipher(void *vctx, unsigned char *out, size_t *outl,
         return 0;
     }
 
-    if (ctx->stream != NULL)
+    if (ctx->units != NULL && inl % AES_BLOCK_SIZE == 0)
+        (*ctx->units)(in, out, inl, 1, ctx->xts.key1, ctx->xts.key2,
+                      ctx->base.iv);
+    else if (ctx->stream != NULL)
         (*ctx->stream)(in, out, inl, ctx->xts.key1, ctx->xts.key2, ctx->base.iv);
     else if (CRYPTO_xts128_encrypt(&ctx->xts, ctx->base.iv, in, out, inl,
                                    ctx->base.enc))
@@ -189,6 +193,64 @@ static int aes_xts_cipher(void *vctx, unsigned char *out, size_t *outl,
     return 1;
 }
 
+/*
+ * Process the data units |first_unit|, |first_unit| + 1, ... of |unit_len|
+ * bytes each, as found one after another in |in|.  The tweak of each data unit
+ * is its number as a 128-bit little-endian integer.
+ */
+static int aes_xts_cipher_data_units(void *vctx, unsigned char *out,
+                                     const unsigned char *in, size_t inl,
+                                     size_t unit_len, uint64_t first_unit)
+{
+    PROV_AES_XTS_CTX *ctx = (PROV_AES_XTS_CTX *)vctx;
+    unsigned char iv[AES_BLOCK_SIZE];
+    uint64_t unit, hi = 0;
+    size_t i;
+
+    if (!ossl_prov_is_running()
+            || ctx->xts.key1 == NULL
+            || ctx->xts.key2 == NULL
+            || out == NULL
+            || in == NULL
+            || unit_len < AES_BLOCK_SIZE
+            || inl % unit_len != 0)
+        return 0;
+
+    if (unit_len > XTS_MAX_BLOCKS_PER_DATA_UNIT * AES_BLOCK_SIZE) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_XTS_DATA_UNIT_IS_TOO_LARGE);
+        return 0;
+    }
+
+    memset(iv, 0, sizeof(iv));
+    for (unit = first_unit, i = 0; i < 8; i++)
+        iv[i] = (unsigned char)(unit >> (8 * i));
+
+    if (ctx->units != NULL && unit_len % AES_BLOCK_SIZE == 0) {
+        if (inl > 0)
+            (*ctx->units)(in, out, unit_len, inl / unit_len, ctx->xts.key1,
+                          ctx->xts.key2, iv);
+        return 1;
+    }
+
+    for (; inl > 0; inl -= unit_len, in += unit_len, out += unit_len) {
+        if (ctx->stream != NULL)
+            (*ctx->stream)(in, out, unit_len, ctx->xts.key1, ctx->xts.key2,
+                           iv);
+        else if (CRYPTO_xts128_encrypt(&ctx->xts, iv, in, out, unit_len,
+                                       ctx->base.enc))
+            return 0;
+
+        /* Next data unit number, carrying into the upper half of the tweak */
+        if (++unit == 0)
+            hi++;
+        for (i = 0; i < 8; i++) {
+            iv[i] = (unsigned char)(unit >> (8 * i));
+            iv[i + 8] = (unsigned char)(hi >> (8 * i));
+        }
+    }
+    return 1;
+}
+
 static int aes_xts_stream_update(void *vctx, unsigned char *out, size_t *outl,
                                  size_t outsize, const unsigned char *in,
                                  size_t inl)
@@ -273,6 +335,8 @@ const OSSL_DISPATCH ossl_aes##kbits##xts_functions[] = {                       \
     { OSSL_FUNC_CIPHER_UPDATE, (void (*)(void))aes_xts_stream_update },        \
     { OSSL_FUNC_CIPHER_FINAL, (void (*)(void))aes_xts_stream_final },          \
     { OSSL_FUNC_CIPHER_CIPHER, (void (*)(void))aes_xts_cipher },               \
+    { OSSL_FUNC_CIPHER_CIPHER_DATA_UNITS,                                      \
+      (void (*)(void))aes_xts_cipher_data_units },                             \
     { OSSL_FUNC_CIPHER_FREECTX, (void (*)(void))aes_xts_freectx },             \
     { OSSL_FUNC_CIPHER_DUPCTX, (void (*)(void))aes_xts_dupctx },               \
     { OSSL_FUNC_CIPHER_GET_PARAMS,                                             \
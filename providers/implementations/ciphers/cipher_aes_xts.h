@@ -21,6 +21,10 @@ PROV_CIPHER_FUNC(void, xts_stream,
                  (const unsigned char *in, unsigned char *out, size_t len,
                   const AES_KEY *key1, const AES_KEY *key2,
                   const unsigned char iv[16]));
+PROV_CIPHER_FUNC(void, xts_units,
+                 (const unsigned char *in, unsigned char *out, size_t unit_len,
+                  size_t units, const AES_KEY *key1, const AES_KEY *key2,
+                  const unsigned char iv[16]));
 
 typedef struct prov_aes_xts_ctx_st {
     PROV_CIPHER_CTX base;      /* Must be first */
@@ -30,6 +34,7 @@ typedef struct prov_aes_xts_ctx_st {
     } ks1, ks2;                /* AES key schedules to use */
     XTS128_CONTEXT xts;
     OSSL_xts_stream_fn stream;
+    OSSL_xts_units_fn units;   /* Optional, runs of whole-block data units */
 } PROV_AES_XTS_CTX;
 
 const PROV_CIPHER_HW *ossl_prov_cipher_hw_aes_xts(size_t keybits);
@@ -110,6 +110,31 @@ static int cipher_hw_aesni_xts_initkey(PROV_CIPHER_CTX *ctx,
     return 1;
 }
 
+# ifdef AES_XTS_AVX512_CAPABLE
+static int cipher_hw_vaes_xts_initkey(PROV_CIPHER_CTX *ctx,
+                                      const unsigned char *key, size_t keylen)
+{
+    PROV_AES_XTS_CTX *xctx = (PROV_AES_XTS_CTX *)ctx;
+
+    /* The key schedules are the same, only whole data units go to VAES */
+    cipher_hw_aesni_xts_initkey(ctx, key, keylen);
+    xctx->units = ctx->enc ? ossl_aes_xts_encrypt_avx512
+                           : ossl_aes_xts_decrypt_avx512;
+    return 1;
+}
+
+static const PROV_CIPHER_HW vaes_xts = {
+    cipher_hw_vaes_xts_initkey,
+    NULL,
+    cipher_hw_aes_xts_copyctx
+};
+#  define PROV_CIPHER_HW_select_vaes_xts()                                     \
+if (AESNI_CAPABLE && AES_XTS_AVX512_CAPABLE)                                   \
+    return &vaes_xts;
+# else
+#  define PROV_CIPHER_HW_select_vaes_xts()
+# endif /* AES_XTS_AVX512_CAPABLE */
+
 # define PROV_CIPHER_HW_declare_xts()                                          \
 static const PROV_CIPHER_HW aesni_xts = {                                      \
     cipher_hw_aesni_xts_initkey,                                               \
@@ -117,6 +142,7 @@ static const PROV_CIPHER_HW aesni_xts = {                                      \
     cipher_hw_aes_xts_copyctx                                                  \
 };
 # define PROV_CIPHER_HW_select_xts()                                           \
+PROV_CIPHER_HW_select_vaes_xts()                                               \
 if (AESNI_CAPABLE)                                                             \
     return &aesni_xts;
 
@@ -13,7 +13,7 @@
 #include "cipher_chacha20_poly1305.h"
 #include "prov/implementations.h"
 #include "prov/providercommon.h"
-
+#include "internal/param_names.h"
 
 #define CHACHA20_POLY1305_KEYLEN CHACHA_KEY_SIZE
 #define CHACHA20_POLY1305_BLKLEN 1
@@ -32,6 +32,12 @@ static OSSL_FUNC_cipher_set_ctx_params_fn chacha20_poly1305_set_ctx_params;
 static OSSL_FUNC_cipher_cipher_fn chacha20_poly1305_cipher;
 static OSSL_FUNC_cipher_final_fn chacha20_poly1305_final;
 static OSSL_FUNC_cipher_gettable_ctx_params_fn chacha20_poly1305_gettable_ctx_params;
+static OSSL_FUNC_cipher_get_aead_tag_fn chacha20_poly1305_get_aead_tag;
+static OSSL_FUNC_cipher_set_aead_tag_fn chacha20_poly1305_set_aead_tag;
+static OSSL_FUNC_cipher_aead_seal_fn chacha20_poly1305_aead_seal;
+static OSSL_FUNC_cipher_aead_open_fn chacha20_poly1305_aead_open;
+static OSSL_FUNC_cipher_aead_seal_many_fn chacha20_poly1305_aead_seal_many;
+static OSSL_FUNC_cipher_aead_open_many_fn chacha20_poly1305_aead_open_many;
 #define chacha20_poly1305_settable_ctx_params ossl_cipher_aead_settable_ctx_params
 #define chacha20_poly1305_gettable_params ossl_cipher_generic_gettable_params
 #define chacha20_poly1305_update chacha20_poly1305_cipher
@@ -78,51 +84,165 @@ static int chacha20_poly1305_get_params(OSSL_PARAM params[])
                                           CHACHA20_POLY1305_IVLEN * 8);
 }
 
+/*
+ * The ctx parameters known to this cipher, located in a single pass over the
+ * array.  As with OSSL_PARAM_locate(), the first occurrence of a name wins.
+ */
+struct chacha20_poly1305_get_params_st {
+    OSSL_PARAM *ivlen, *keylen, *taglen, *pad, *tag;
+};
+
+struct chacha20_poly1305_set_params_st {
+    const OSSL_PARAM *keylen, *ivlen, *tag, *aad, *ivfixed;
+};
+
+static void
+chacha20_poly1305_get_params_decode(OSSL_PARAM params[],
+                                    struct chacha20_poly1305_get_params_st *r)
+{
+    OSSL_PARAM **pp;
+
+    memset(r, 0, sizeof(*r));
+    if (params == NULL)
+        return;
+    for (; params->key != NULL; params++) {
+        switch (ossl_param_find_pidx(params->key)) {
+        case PIDX_CIPHER_PARAM_IVLEN:
+            pp = &r->ivlen;
+            break;
+        case PIDX_CIPHER_PARAM_KEYLEN:
+            pp = &r->keylen;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TAGLEN:
+            pp = &r->taglen;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TLS1_AAD_PAD:
+            pp = &r->pad;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TAG:
+            pp = &r->tag;
+            break;
+        default:
+            continue;
+        }
+        if (*pp == NULL)
+            *pp = params;
+    }
+}
+
+static void
+chacha20_poly1305_set_params_decode(const OSSL_PARAM params[],
+                                    struct chacha20_poly1305_set_params_st *r)
+{
+    const OSSL_PARAM **pp;
+
+    memset(r, 0, sizeof(*r));
+    if (params == NULL)
+        return;
+    for (; params->key != NULL; params++) {
+        switch (ossl_param_find_pidx(params->key)) {
+        case PIDX_CIPHER_PARAM_KEYLEN:
+            pp = &r->keylen;
+            break;
+        case PIDX_CIPHER_PARAM_IVLEN:
+            pp = &r->ivlen;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TAG:
+            pp = &r->tag;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TLS1_AAD:
+            pp = &r->aad;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TLS1_IV_FIXED:
+            pp = &r->ivfixed;
+            break;
+        default:
+            continue;
+        }
+        if (*pp == NULL)
+            *pp = params;
+    }
+}
+
 static int chacha20_poly1305_get_ctx_params(void *vctx, OSSL_PARAM params[])
 {
     PROV_CHACHA20_POLY1305_CTX *ctx = (PROV_CHACHA20_POLY1305_CTX *)vctx;
+    struct chacha20_poly1305_get_params_st r;
     OSSL_PARAM *p;
 
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IVLEN);
+    chacha20_poly1305_get_params_decode(params, &r);
+
+    p = r.ivlen;
     if (p != NULL) {
         if (!OSSL_PARAM_set_size_t(p, ctx->nonce_len)) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_SET_PARAMETER);
             return 0;
         }
     }
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_KEYLEN);
+    p = r.keylen;
     if (p != NULL && !OSSL_PARAM_set_size_t(p, CHACHA20_POLY1305_KEYLEN)) {
         ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_SET_PARAMETER);
         return 0;
     }
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TAGLEN);
+    p = r.taglen;
     if (p != NULL && !OSSL_PARAM_set_size_t(p, ctx->tag_len)) {
         ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_SET_PARAMETER);
         return 0;
     }
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TLS1_AAD_PAD);
+    p = r.pad;
     if (p != NULL && !OSSL_PARAM_set_size_t(p, ctx->tls_aad_pad_sz)) {
         ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_SET_PARAMETER);
         return 0;
     }
 
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TAG);
+    p = r.tag;
     if (p != NULL) {
         if (p->data_type != OSSL_PARAM_OCTET_STRING) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_SET_PARAMETER);
             return 0;
         }
-        if (!ctx->base.enc) {
-            ERR_raise(ERR_LIB_PROV, PROV_R_TAG_NOT_SET);
+        if (!chacha20_poly1305_get_aead_tag(ctx, p->data, p->data_size))
             return 0;
-        }
-        if (p->data_size == 0 || p->data_size > POLY1305_BLOCK_SIZE) {
-            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+    }
+
+    return 1;
+}
+
+static int chacha20_poly1305_get_aead_tag(void *vctx, unsigned char *tag,
+                                          size_t taglen)
+{
+    PROV_CHACHA20_POLY1305_CTX *ctx = (PROV_CHACHA20_POLY1305_CTX *)vctx;
+
+    if (!ctx->base.enc) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_TAG_NOT_SET);
+        return 0;
+    }
+    if (taglen == 0 || taglen > POLY1305_BLOCK_SIZE) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        return 0;
+    }
+    memcpy(tag, ctx->tag, taglen);
+    return 1;
+}
+
+/* A NULL |tag| only sets the tag length */
+static int chacha20_poly1305_set_aead_tag(void *vctx, const unsigned char *tag,
+                                          size_t taglen)
+{
+    PROV_CHACHA20_POLY1305_CTX *ctx = (PROV_CHACHA20_POLY1305_CTX *)vctx;
+
+    if (taglen == 0 || taglen > POLY1305_BLOCK_SIZE) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        return 0;
+    }
+    if (tag != NULL) {
+        if (ctx->base.enc) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_TAG_NOT_NEEDED);
             return 0;
         }
-        memcpy(p->data, ctx->tag, p->data_size);
+        memcpy(ctx->tag, tag, taglen);
     }
-
+    ctx->tag_len = taglen;
     return 1;
 }
 
@@ -143,6 +263,7 @@ static const OSSL_PARAM *chacha20_poly1305_gettable_ctx_params
 static int chacha20_poly1305_set_ctx_params(void *vctx,
                                             const OSSL_PARAM params[])
 {
+    struct chacha20_poly1305_set_params_st r;
     const OSSL_PARAM *p;
     size_t len;
     PROV_CHACHA20_POLY1305_CTX *ctx = (PROV_CHACHA20_POLY1305_CTX *)vctx;
@@ -151,8 +272,9 @@ static int chacha20_poly1305_set_ctx_params(void *vctx,
 
     if (params == NULL)
         return 1;
+    chacha20_poly1305_set_params_decode(params, &r);
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_KEYLEN);
+    p = r.keylen;
     if (p != NULL) {
         if (!OSSL_PARAM_get_size_t(p, &len)) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
@@ -163,7 +285,7 @@ static int chacha20_poly1305_set_ctx_params(void *vctx,
             return 0;
         }
     }
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_IVLEN);
+    p = r.ivlen;
     if (p != NULL) {
         if (!OSSL_PARAM_get_size_t(p, &len)) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
@@ -176,27 +298,17 @@ static int chacha20_poly1305_set_ctx_params(void *vctx,
         ctx->nonce_len = len;
     }
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TAG);
+    p = r.tag;
     if (p != NULL) {
         if (p->data_type != OSSL_PARAM_OCTET_STRING) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
             return 0;
         }
-        if (p->data_size == 0 || p->data_size > POLY1305_BLOCK_SIZE) {
-            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        if (!chacha20_poly1305_set_aead_tag(ctx, p->data, p->data_size))
             return 0;
-        }
-        if (p->data != NULL) {
-            if (ctx->base.enc) {
-                ERR_raise(ERR_LIB_PROV, PROV_R_TAG_NOT_NEEDED);
-                return 0;
-            }
-            memcpy(ctx->tag, p->data, p->data_size);
-        }
-        ctx->tag_len = p->data_size;
     }
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TLS1_AAD);
+    p = r.aad;
     if (p != NULL) {
         if (p->data_type != OSSL_PARAM_OCTET_STRING) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
@@ -210,7 +322,7 @@ static int chacha20_poly1305_set_ctx_params(void *vctx,
         ctx->tls_aad_pad_sz = len;
     }
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TLS1_IV_FIXED);
+    p = r.ivfixed;
     if (p != NULL) {
         if (p->data_type != OSSL_PARAM_OCTET_STRING) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
@@ -309,6 +421,143 @@ static int chacha20_poly1305_final(void *vctx, unsigned char *out, size_t *outl,
     return 1;
 }
 
+/*
+ * The IV length has to be what chacha20_poly1305_initiv() takes through the
+ * init functions, so both ways of using the cipher accept the same packets.
+ */
+static int chacha20_poly1305_aead_check(PROV_CHACHA20_POLY1305_CTX *ctx,
+                                       int enc, size_t num,
+                                       const unsigned char *const iv[],
+                                       size_t ivlen,
+                                       const unsigned char *const tag[],
+                                       size_t taglen)
+{
+    size_t i;
+
+    if (!ossl_prov_is_running())
+        return 0;
+    if (!ctx->key_set) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_NO_KEY_SET);
+        return 0;
+    }
+    if (ctx->base.enc != enc) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_MODE);
+        return 0;
+    }
+    if (iv == NULL || tag == NULL) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_PASSED_NULL_PARAMETER);
+        return 0;
+    }
+    if (ivlen != CHACHA20_POLY1305_IVLEN) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_IV_LENGTH);
+        return 0;
+    }
+    if (taglen == 0 || taglen > POLY1305_BLOCK_SIZE) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        return 0;
+    }
+    for (i = 0; i < num; i++) {
+        if (iv[i] == NULL || tag[i] == NULL) {
+            ERR_raise(ERR_LIB_PROV, ERR_R_PASSED_NULL_PARAMETER);
+            return 0;
+        }
+    }
+    return 1;
+}
+
+/* Everything but the packets themselves is checked by the caller */
+static int chacha20_poly1305_aead_batch(PROV_CHACHA20_POLY1305_CTX *ctx,
+                                        int enc, size_t num,
+                                        const PROV_CHACHA20_POLY1305_BATCH *b)
+{
+    PROV_CIPHER_HW_CHACHA20_POLY1305 *hw =
+        (PROV_CIPHER_HW_CHACHA20_POLY1305 *)ctx->base.hw;
+
+    if (num != 0 && !hw->aead_many(&ctx->base, enc, num, b)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_CIPHER_OPERATION_FAILED);
+        return 0;
+    }
+    return 1;
+}
+
+static int chacha20_poly1305_aead_seal(void *vctx,
+                                       const unsigned char *iv, size_t ivlen,
+                                       const unsigned char *aad, size_t aadlen,
+                                       const unsigned char *in, size_t inl,
+                                       unsigned char *out,
+                                       unsigned char *tag, size_t taglen)
+{
+    PROV_CHACHA20_POLY1305_BATCH b = {
+        &iv, ivlen, &aad, &aadlen, &in, &inl, &out, &tag, taglen, NULL
+    };
+
+    if (!chacha20_poly1305_aead_check(vctx, 1, 1, &iv, ivlen,
+                                      (const unsigned char *const *)&tag,
+                                      taglen))
+        return 0;
+    return chacha20_poly1305_aead_batch(vctx, 1, 1, &b);
+}
+
+static int chacha20_poly1305_aead_open(void *vctx,
+                                       const unsigned char *iv, size_t ivlen,
+                                       const unsigned char *aad, size_t aadlen,
+                                       const unsigned char *in, size_t inl,
+                                       unsigned char *out,
+                                       const unsigned char *tag, size_t taglen)
+{
+    PROV_CHACHA20_POLY1305_BATCH b = {
+        &iv, ivlen, &aad, &aadlen, &in, &inl, &out, (unsigned char *const *)&tag,
+        taglen, NULL
+    };
+
+    if (!chacha20_poly1305_aead_check(vctx, 0, 1, &iv, ivlen, &tag, taglen))
+        return 0;
+    return chacha20_poly1305_aead_batch(vctx, 0, 1, &b);
+}
+
+static int chacha20_poly1305_aead_seal_many(void *vctx, size_t num,
+                                            const unsigned char *const iv[],
+                                            size_t ivlen,
+                                            const unsigned char *const aad[],
+                                            const size_t aadlen[],
+                                            const unsigned char *const in[],
+                                            const size_t inl[],
+                                            unsigned char *const out[],
+                                            unsigned char *const tag[],
+                                            size_t taglen)
+{
+    PROV_CHACHA20_POLY1305_BATCH b = {
+        iv, ivlen, aad, aadlen, in, inl, out, tag, taglen, NULL
+    };
+
+    if (!chacha20_poly1305_aead_check(vctx, 1, num, iv, ivlen,
+                                      (const unsigned char *const *)tag,
+                                      taglen))
+        return 0;
+    return chacha20_poly1305_aead_batch(vctx, 1, num, &b);
+}
+
+static int chacha20_poly1305_aead_open_many(void *vctx, size_t num,
+                                            const unsigned char *const iv[],
+                                            size_t ivlen,
+                                            const unsigned char *const aad[],
+                                            const size_t aadlen[],
+                                            const unsigned char *const in[],
+                                            const size_t inl[],
+                                            unsigned char *const out[],
+                                            const unsigned char *const tag[],
+                                            size_t taglen, int ok[])
+{
+    PROV_CHACHA20_POLY1305_BATCH b = {
+        iv, ivlen, aad, aadlen, in, inl, out, (unsigned char *const *)tag,
+        taglen, ok
+    };
+
+    if (!chacha20_poly1305_aead_check(vctx, 0, num, iv, ivlen, tag, taglen))
+        return 0;
+    return chacha20_poly1305_aead_batch(vctx, 0, num, &b);
+}
+
 /* ossl_chacha20_ossl_poly1305_functions */
 const OSSL_DISPATCH ossl_chacha20_ossl_poly1305_functions[] = {
     { OSSL_FUNC_CIPHER_NEWCTX, (void (*)(void))chacha20_poly1305_newctx },
@@ -330,6 +579,18 @@ const OSSL_DISPATCH ossl_chacha20_ossl_poly1305_functions[] = {
         (void (*)(void))chacha20_poly1305_set_ctx_params },
     { OSSL_FUNC_CIPHER_SETTABLE_CTX_PARAMS,
         (void (*)(void))chacha20_poly1305_settable_ctx_params },
+    { OSSL_FUNC_CIPHER_GET_AEAD_TAG,
+        (void (*)(void))chacha20_poly1305_get_aead_tag },
+    { OSSL_FUNC_CIPHER_SET_AEAD_TAG,
+        (void (*)(void))chacha20_poly1305_set_aead_tag },
+    { OSSL_FUNC_CIPHER_AEAD_SEAL,
+        (void (*)(void))chacha20_poly1305_aead_seal },
+    { OSSL_FUNC_CIPHER_AEAD_OPEN,
+        (void (*)(void))chacha20_poly1305_aead_open },
+    { OSSL_FUNC_CIPHER_AEAD_SEAL_MANY,
+        (void (*)(void))chacha20_poly1305_aead_seal_many },
+    { OSSL_FUNC_CIPHER_AEAD_OPEN_MANY,
+        (void (*)(void))chacha20_poly1305_aead_open_many },
     { 0, NULL }
 };
 
@@ -25,11 +25,29 @@ typedef struct {
     struct { uint64_t aad, text; } len;
     unsigned int aad : 1;
     unsigned int mac_inited : 1;
+    unsigned int key_set : 1;
     size_t tag_len, nonce_len;
     size_t tls_payload_length;
     size_t tls_aad_pad_sz;
 } PROV_CHACHA20_POLY1305_CTX;
 
+/*
+ * Arguments of a batch of one-shot AEAD operations under one key, see
+ * EVP_CIPHER_CTX_aead_seal_many().  |aad| may be NULL and so may |ok|.
+ */
+typedef struct {
+    const unsigned char *const *iv;
+    size_t ivlen;
+    const unsigned char *const *aad;
+    const size_t *aadlen;
+    const unsigned char *const *in;
+    const size_t *inl;
+    unsigned char *const *out;
+    unsigned char *const *tag;
+    size_t taglen;
+    int *ok;
+} PROV_CHACHA20_POLY1305_BATCH;
+
 typedef struct prov_cipher_hw_chacha_aead_st {
     PROV_CIPHER_HW base; /* must be first */
     int (*aead_cipher)(PROV_CIPHER_CTX *dat, unsigned char *out, size_t *outl,
@@ -38,6 +56,9 @@ typedef struct prov_cipher_hw_chacha_aead_st {
     int (*tls_init)(PROV_CIPHER_CTX *ctx, unsigned char *aad, size_t alen);
     int (*tls_iv_set_fixed)(PROV_CIPHER_CTX *ctx, unsigned char *fixed,
                             size_t flen);
+    /* Returns 1 if all |num| packets were sealed or opened successfully */
+    int (*aead_many)(PROV_CIPHER_CTX *ctx, int enc, size_t num,
+                     const PROV_CHACHA20_POLY1305_BATCH *b);
 } PROV_CIPHER_HW_CHACHA20_POLY1305;
 
 const PROV_CIPHER_HW *ossl_prov_cipher_hw_chacha20_poly1305(size_t keybits);
@@ -68,9 +68,12 @@ static int chacha20_poly1305_initkey(PROV_CIPHER_CTX *bctx,
     ctx->tls_payload_length = NO_TLS_PAYLOAD_LENGTH;
 
     if (bctx->enc)
-        return ossl_chacha20_einit(&ctx->chacha, key, keylen, NULL, 0, NULL);
+        ctx->key_set = ossl_chacha20_einit(&ctx->chacha, key, keylen,
+                                           NULL, 0, NULL);
     else
-        return ossl_chacha20_dinit(&ctx->chacha, key, keylen, NULL, 0, NULL);
+        ctx->key_set = ossl_chacha20_dinit(&ctx->chacha, key, keylen,
+                                           NULL, 0, NULL);
+    return ctx->key_set;
 }
 
 static int chacha20_poly1305_initiv(PROV_CIPHER_CTX *bctx)
@@ -111,6 +114,12 @@ static int chacha20_poly1305_initiv(PROV_CIPHER_CTX *bctx)
 #  define XOR128_HELPERS
 void *xor128_encrypt_n_pad(void *out, const void *inp, void *otp, size_t len);
 void *xor128_decrypt_n_pad(void *out, const void *inp, void *otp, size_t len);
+#  define CHACHA20_POLY1305_8XLANES
+void ChaCha20_8xlanes(unsigned char out[8][CHACHA_BLK_SIZE],
+                      unsigned int state[12][8]);
+int poly1305_blocks_8xlanes(uint64_t h[5][8], uint64_t r[9][8],
+                            const unsigned char *inp, size_t blocks,
+                            const uint64_t start[8]);
 static const unsigned char zero[4 * CHACHA_BLK_SIZE] = { 0 };
 # else
 static const unsigned char zero[2 * CHACHA_BLK_SIZE] = { 0 };
@@ -400,13 +409,407 @@ err:
     return rv;
 }
 
+static void chacha20_poly1305_lengths(unsigned char out[POLY1305_BLOCK_SIZE],
+                                      uint64_t aadlen, uint64_t textlen)
+{
+    int i;
+
+    for (i = 0; i < 8; i++) {
+        out[i] = (unsigned char)(aadlen >> (8 * i));
+        out[8 + i] = (unsigned char)(textlen >> (8 * i));
+    }
+}
+
+/* The initial counter block of a one-shot operation with nonce |iv| */
+static void chacha20_poly1305_counter(unsigned int counter[4],
+                                      const unsigned char *iv, size_t ivlen)
+{
+    unsigned char nonce[CHACHA20_POLY1305_IVLEN] = { 0 };
+
+    /* pad on the left, as chacha20_poly1305_initiv() does */
+    memcpy(nonce + CHACHA20_POLY1305_IVLEN - ivlen, iv, ivlen);
+    counter[0] = 0;
+    counter[1] = CHACHA_U8TOU32(nonce);
+    counter[2] = CHACHA_U8TOU32(nonce + 4);
+    counter[3] = CHACHA_U8TOU32(nonce + 8);
+}
+
+/*
+ * Seals or opens packet |i| of |b|.  Unlike chacha20_poly1305_aead_cipher()
+ * this uses nothing but the key of the context, so it doesn't disturb an
+ * operation in progress.
+ */
+static int chacha20_poly1305_one(PROV_CHACHA20_POLY1305_CTX *ctx, int enc,
+                                 const PROV_CHACHA20_POLY1305_BATCH *b,
+                                 size_t i)
+{
+    POLY1305 poly;
+    unsigned int counter[4];
+    unsigned char buf[CHACHA_BLK_SIZE];
+    const unsigned char *aad = b->aad != NULL ? b->aad[i] : NULL;
+    size_t aadlen = b->aad != NULL ? b->aadlen[i] : 0;
+    size_t rem, inl = b->inl[i];
+    int ret = 1;
+
+    chacha20_poly1305_counter(counter, b->iv[i], b->ivlen);
+    ChaCha20_ctr32(buf, zero, CHACHA_BLK_SIZE, ctx->chacha.key.d, counter);
+    Poly1305_Init(&poly, buf);
+    counter[0] = 1;
+
+    Poly1305_Update(&poly, aad, aadlen);
+    if ((rem = aadlen % POLY1305_BLOCK_SIZE) != 0)
+        Poly1305_Update(&poly, zero, POLY1305_BLOCK_SIZE - rem);
+    if (enc) {
+        ChaCha20_ctr32(b->out[i], b->in[i], inl, ctx->chacha.key.d, counter);
+        Poly1305_Update(&poly, b->out[i], inl);
+    } else {
+        Poly1305_Update(&poly, b->in[i], inl);
+        ChaCha20_ctr32(b->out[i], b->in[i], inl, ctx->chacha.key.d, counter);
+    }
+    if ((rem = inl % POLY1305_BLOCK_SIZE) != 0)
+        Poly1305_Update(&poly, zero, POLY1305_BLOCK_SIZE - rem);
+    chacha20_poly1305_lengths(buf, aadlen, inl);
+    Poly1305_Update(&poly, buf, POLY1305_BLOCK_SIZE);
+    Poly1305_Final(&poly, buf);
+
+    if (enc) {
+        memcpy(b->tag[i], buf, b->taglen);
+    } else if (CRYPTO_memcmp(buf, b->tag[i], b->taglen) != 0) {
+        OPENSSL_cleanse(b->out[i], inl);
+        ret = 0;
+    }
+    OPENSSL_cleanse(buf, sizeof(buf));
+    if (b->ok != NULL)
+        b->ok[i] = ret;
+    return ret;
+}
+
+#ifdef CHACHA20_POLY1305_8XLANES
+/*
+ * Short packets are sealed or opened eight at a time, with the key stream
+ * blocks of all of them spread over the lanes of ChaCha20_8xlanes() and
+ * with one Poly1305 lane per packet.  Longer packets are better off with
+ * the single packet code, which is just as wide.
+ */
+# define LANES           8
+# define LANE_MAX_LEN    512        /* AAD and text */
+# define LANE_MAX_ROWS   (LANE_MAX_LEN / POLY1305_BLOCK_SIZE + 3)
+# define LANES_MIN       2          /* fewer go one by one */
+
+typedef struct {
+    unsigned int state[12][LANES];
+    unsigned char ks[LANES][CHACHA_BLK_SIZE];
+    unsigned char otk[LANES][POLY1305_KEY_SIZE];
+    uint64_t h[5][LANES];
+    uint64_t r[9][LANES];
+    uint64_t start[LANES];
+    unsigned char inp[LANE_MAX_ROWS][LANES][POLY1305_BLOCK_SIZE];
+} CHACHA20_POLY1305_LANES;
+
+static int chacha20_poly1305_8xlanes_capable(void)
+{
+    return (OPENSSL_ia32cap_P[2] & (1 << 5)) != 0   /* AVX2 */
+           /* returns 0 if the assembler couldn't do AVX2 */
+           && poly1305_blocks_8xlanes(NULL, NULL, NULL, 0, NULL);
+}
+
+static int chacha20_poly1305_lane_fits(const PROV_CHACHA20_POLY1305_BATCH *b,
+                                       size_t i)
+{
+    size_t aadlen = b->aad != NULL ? b->aadlen[i] : 0;
+
+    return b->inl[i] <= LANE_MAX_LEN && aadlen <= LANE_MAX_LEN - b->inl[i];
+}
+
+/* Number of Poly1305 blocks of packet |i|, the lengths block included */
+static size_t chacha20_poly1305_lane_rows(const PROV_CHACHA20_POLY1305_BATCH *b,
+                                          size_t i)
+{
+    size_t aadlen = b->aad != NULL ? b->aadlen[i] : 0;
+
+    return (aadlen + POLY1305_BLOCK_SIZE - 1) / POLY1305_BLOCK_SIZE
+           + (b->inl[i] + POLY1305_BLOCK_SIZE - 1) / POLY1305_BLOCK_SIZE + 1;
+}
+
+static size_t lane_copy(CHACHA20_POLY1305_LANES *l, size_t lane, size_t row,
+                        const unsigned char *data, size_t len)
+{
+    for (; len >= POLY1305_BLOCK_SIZE; len -= POLY1305_BLOCK_SIZE) {
+        memcpy(l->inp[row++][lane], data, POLY1305_BLOCK_SIZE);
+        data += POLY1305_BLOCK_SIZE;
+    }
+    if (len != 0)
+        memcpy(l->inp[row++][lane], data, len);    /* rest is zero */
+    return row;
+}
+
+/*
+ * Lays out the Poly1305 input of packet pkt[i] in lane i, right aligned so
+ * that all packets end in the last of |rows| rows.
+ */
+static void lane_poly1305_input(CHACHA20_POLY1305_LANES *l, int enc,
+                                const PROV_CHACHA20_POLY1305_BATCH *b,
+                                const size_t pkt[], size_t n, size_t rows)
+{
+    size_t i, p, row;
+
+    memset(l->inp, 0, rows * sizeof(l->inp[0]));
+    for (i = 0; i < n; i++) {
+        p = pkt[i];
+        row = rows - chacha20_poly1305_lane_rows(b, p);
+        l->start[i] = row;
+        if (b->aad != NULL)
+            row = lane_copy(l, i, row, b->aad[p], b->aadlen[p]);
+        row = lane_copy(l, i, row, enc ? b->out[p] : b->in[p], b->inl[p]);
+        chacha20_poly1305_lengths(l->inp[row][i],
+                                  b->aad != NULL ? b->aadlen[p] : 0,
+                                  b->inl[p]);
+    }
+    for (; i < LANES; i++)
+        l->start[i] = rows;
+}
+
+/* Splits the clamped r of lane |i| into base 2^26 limbs */
+static void lane_poly1305_key(CHACHA20_POLY1305_LANES *l, size_t i)
+{
+    const unsigned char *k = l->otk[i];
+    uint64_t r0, r1, r2, r3, r4;
+
+    r0 = CHACHA_U8TOU32(k) & 0x3ffffff;
+    r1 = (CHACHA_U8TOU32(k + 3) >> 2) & 0x3ffff03;
+    r2 = (CHACHA_U8TOU32(k + 6) >> 4) & 0x3ffc0ff;
+    r3 = (CHACHA_U8TOU32(k + 9) >> 6) & 0x3f03fff;
+    r4 = (CHACHA_U8TOU32(k + 12) >> 8) & 0x00fffff;
+
+    l->r[0][i] = r0;
+    l->r[1][i] = r1;
+    l->r[2][i] = r1 * 5;
+    l->r[3][i] = r2;
+    l->r[4][i] = r2 * 5;
+    l->r[5][i] = r3;
+    l->r[6][i] = r3 * 5;
+    l->r[7][i] = r4;
+    l->r[8][i] = r4 * 5;
+}
+
+/* Fully reduces the accumulator of lane |i| and adds s to it */
+static void lane_poly1305_emit(const CHACHA20_POLY1305_LANES *l, size_t i,
+                               unsigned char mac[POLY1305_BLOCK_SIZE])
+{
+    const unsigned char *s = l->otk[i] + 16;
+    uint64_t h0 = l->h[0][i], h1 = l->h[1][i], h2 = l->h[2][i];
+    uint64_t h3 = l->h[3][i], h4 = l->h[4][i];
+    uint64_t g0, g1, g2, g3, g4, mask, f;
+    int j;
+
+    for (j = 0; j < 2; j++) {
+        h1 += h0 >> 26; h0 &= 0x3ffffff;
+        h2 += h1 >> 26; h1 &= 0x3ffffff;
+        h3 += h2 >> 26; h2 &= 0x3ffffff;
+        h4 += h3 >> 26; h3 &= 0x3ffffff;
+        h0 += (h4 >> 26) * 5; h4 &= 0x3ffffff;
+    }
+    h1 += h0 >> 26; h0 &= 0x3ffffff;
+
+    /* compute h + -p */
+    g0 = h0 + 5;
+    g1 = h1 + (g0 >> 26); g0 &= 0x3ffffff;
+    g2 = h2 + (g1 >> 26); g1 &= 0x3ffffff;
+    g3 = h3 + (g2 >> 26); g2 &= 0x3ffffff;
+    g4 = h4 + (g3 >> 26) - ((uint64_t)1 << 26); g3 &= 0x3ffffff;
+
+    /* select h if h < p, or h + -p if h >= p */
+    mask = (g4 >> 63) - 1;
+    h0 = (h0 & ~mask) | (g0 & mask);
+    h1 = (h1 & ~mask) | (g1 & mask);
+    h2 = (h2 & ~mask) | (g2 & mask);
+    h3 = (h3 & ~mask) | (g3 & mask);
+    h4 = (h4 & ~mask) | (g4 & mask);
+
+    /* h = h % 2^128, + s */
+    f = ((h0 | (h1 << 26)) & 0xffffffff) + (uint64_t)CHACHA_U8TOU32(s);
+    mac[0] = (unsigned char)f; mac[1] = (unsigned char)(f >> 8);
+    mac[2] = (unsigned char)(f >> 16); mac[3] = (unsigned char)(f >> 24);
+    f = (f >> 32) + (((h1 >> 6) | (h2 << 20)) & 0xffffffff)
+        + CHACHA_U8TOU32(s + 4);
+    mac[4] = (unsigned char)f; mac[5] = (unsigned char)(f >> 8);
+    mac[6] = (unsigned char)(f >> 16); mac[7] = (unsigned char)(f >> 24);
+    f = (f >> 32) + (((h2 >> 12) | (h3 << 14)) & 0xffffffff)
+        + CHACHA_U8TOU32(s + 8);
+    mac[8] = (unsigned char)f; mac[9] = (unsigned char)(f >> 8);
+    mac[10] = (unsigned char)(f >> 16); mac[11] = (unsigned char)(f >> 24);
+    f = (f >> 32) + (((h3 >> 18) | (h4 << 8)) & 0xffffffff)
+        + CHACHA_U8TOU32(s + 12);
+    mac[12] = (unsigned char)f; mac[13] = (unsigned char)(f >> 8);
+    mac[14] = (unsigned char)(f >> 16); mac[15] = (unsigned char)(f >> 24);
+}
+
+static void lane_xor(unsigned char *out, const unsigned char *in,
+                     const unsigned char *ks, size_t len)
+{
+    uint64_t a, b;
+    size_t j;
+
+    for (j = 0; j + sizeof(a) <= len; j += sizeof(a)) {
+        memcpy(&a, in + j, sizeof(a));
+        memcpy(&b, ks + j, sizeof(b));
+        a ^= b;
+        memcpy(out + j, &a, sizeof(a));
+    }
+    for (; j < len; j++)
+        out[j] = in[j] ^ ks[j];
+}
+
+/* Consumes the first |k| key stream blocks in |l| */
+static void lane_key_stream(CHACHA20_POLY1305_LANES *l,
+                            const PROV_CHACHA20_POLY1305_BATCH *b,
+                            const size_t pkt[], const size_t slot_lane[],
+                            const size_t slot_blk[], size_t k)
+{
+    size_t s, i, off, len;
+
+    for (s = 0; s < k; s++) {
+        i = slot_lane[s];
+        if (slot_blk[s] == 0) {
+            memcpy(l->otk[i], l->ks[s], POLY1305_KEY_SIZE);
+            continue;
+        }
+        off = (slot_blk[s] - 1) * CHACHA_BLK_SIZE;
+        len = b->inl[pkt[i]] - off;
+        if (len > CHACHA_BLK_SIZE)
+            len = CHACHA_BLK_SIZE;
+        lane_xor(b->out[pkt[i]] + off, b->in[pkt[i]] + off, l->ks[s], len);
+    }
+}
+
+/* Seals or opens the |n| packets of |b| listed in |pkt| */
+static int chacha20_poly1305_lanes(PROV_CHACHA20_POLY1305_CTX *ctx, int enc,
+                                   const PROV_CHACHA20_POLY1305_BATCH *b,
+                                   const size_t pkt[], size_t n)
+{
+    CHACHA20_POLY1305_LANES l;
+    unsigned int counter[4];
+    unsigned char mac[POLY1305_BLOCK_SIZE];
+    size_t slot_lane[LANES], slot_blk[LANES];
+    size_t i, j, p, k, blk, nblk, rows = 0;
+    int ok, ret = 1;
+
+    if (n < LANES_MIN) {
+        for (i = 0; i < n; i++)
+            ret &= chacha20_poly1305_one(ctx, enc, b, pkt[i]);
+        return ret;
+    }
+
+    for (i = 0; i < n; i++) {
+        k = chacha20_poly1305_lane_rows(b, pkt[i]);
+        if (k > rows)
+            rows = k;
+    }
+    /* the ciphertext is hashed before it is decrypted, maybe in place */
+    if (!enc)
+        lane_poly1305_input(&l, enc, b, pkt, n, rows);
+
+    /*
+     * The key is the same in all lanes.  Key stream block 0 of a packet is
+     * its Poly1305 key, the rest encrypt or decrypt it.
+     */
+    for (i = 0; i < 8; i++)
+        for (j = 0; j < LANES; j++)
+            l.state[i][j] = ctx->chacha.key.d[i];
+    memset(l.state[8], 0, 4 * sizeof(l.state[8]));
+    for (i = 0, k = 0; i < n; i++) {
+        p = pkt[i];
+        chacha20_poly1305_counter(counter, b->iv[p], b->ivlen);
+        nblk = 1 + (b->inl[p] + CHACHA_BLK_SIZE - 1) / CHACHA_BLK_SIZE;
+        for (blk = 0; blk < nblk; blk++) {
+            l.state[8][k] = (unsigned int)blk;
+            l.state[9][k] = counter[1];
+            l.state[10][k] = counter[2];
+            l.state[11][k] = counter[3];
+            slot_lane[k] = i;
+            slot_blk[k] = blk;
+            if (++k == LANES) {
+                ChaCha20_8xlanes(l.ks, l.state);
+                lane_key_stream(&l, b, pkt, slot_lane, slot_blk, k);
+                k = 0;
+            }
+        }
+    }
+    if (k != 0) {
+        ChaCha20_8xlanes(l.ks, l.state);
+        lane_key_stream(&l, b, pkt, slot_lane, slot_blk, k);
+    }
+
+    if (enc)
+        lane_poly1305_input(&l, enc, b, pkt, n, rows);
+    memset(l.h, 0, sizeof(l.h));
+    memset(l.r, 0, sizeof(l.r));
+    for (i = 0; i < n; i++)
+        lane_poly1305_key(&l, i);
+    poly1305_blocks_8xlanes(l.h, l.r, l.inp[0][0], rows, l.start);
+
+    for (i = 0; i < n; i++) {
+        p = pkt[i];
+        lane_poly1305_emit(&l, i, mac);
+        ok = 1;
+        if (enc) {
+            memcpy(b->tag[p], mac, b->taglen);
+        } else if (CRYPTO_memcmp(mac, b->tag[p], b->taglen) != 0) {
+            OPENSSL_cleanse(b->out[p], b->inl[p]);
+            ok = 0;
+        }
+        if (b->ok != NULL)
+            b->ok[p] = ok;
+        ret &= ok;
+    }
+
+    OPENSSL_cleanse(l.state, sizeof(l.state));
+    OPENSSL_cleanse(l.ks, sizeof(l.ks));
+    OPENSSL_cleanse(l.otk, sizeof(l.otk));
+    OPENSSL_cleanse(l.r, sizeof(l.r));
+    OPENSSL_cleanse(mac, sizeof(mac));
+    return ret;
+}
+#endif /* CHACHA20_POLY1305_8XLANES */
+
+static int chacha20_poly1305_aead_many(PROV_CIPHER_CTX *bctx, int enc,
+                                       size_t num,
+                                       const PROV_CHACHA20_POLY1305_BATCH *b)
+{
+    PROV_CHACHA20_POLY1305_CTX *ctx = (PROV_CHACHA20_POLY1305_CTX *)bctx;
+    size_t i;
+    int ret = 1;
+#ifdef CHACHA20_POLY1305_8XLANES
+    size_t n = 0, pkt[LANES];
+    int lanes = num >= LANES_MIN && chacha20_poly1305_8xlanes_capable();
+
+    for (i = 0; i < num; i++) {
+        if (lanes && chacha20_poly1305_lane_fits(b, i)) {
+            pkt[n++] = i;
+            if (n == LANES) {
+                ret &= chacha20_poly1305_lanes(ctx, enc, b, pkt, n);
+                n = 0;
+            }
+        } else {
+            ret &= chacha20_poly1305_one(ctx, enc, b, i);
+        }
+    }
+    ret &= chacha20_poly1305_lanes(ctx, enc, b, pkt, n);
+#else
+    for (i = 0; i < num; i++)
+        ret &= chacha20_poly1305_one(ctx, enc, b, i);
+#endif
+    return ret;
+}
+
 static const PROV_CIPHER_HW_CHACHA20_POLY1305 chacha20poly1305_hw =
 {
     { chacha20_poly1305_initkey, NULL },
     chacha20_poly1305_aead_cipher,
     chacha20_poly1305_initiv,
     chacha_poly1305_tls_init,
-    chacha_poly1305_tls_iv_set_fixed
+    chacha_poly1305_tls_iv_set_fixed,
+    chacha20_poly1305_aead_many
 };
 
 const PROV_CIPHER_HW *ossl_prov_cipher_hw_chacha20_poly1305(size_t keybits)
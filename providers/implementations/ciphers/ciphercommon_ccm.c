@@ -80,20 +80,8 @@ int ossl_ccm_set_ctx_params(void *vctx, const OSSL_PARAM params[])
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
             return 0;
         }
-        if ((p->data_size & 1) || (p->data_size < 4) || p->data_size > 16) {
-            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        if (!ossl_ccm_set_aead_tag(ctx, p->data, p->data_size))
             return 0;
-        }
-
-        if (p->data != NULL) {
-            if (ctx->enc) {
-                ERR_raise(ERR_LIB_PROV, PROV_R_TAG_NOT_NEEDED);
-                return 0;
-            }
-            memcpy(ctx->buf, p->data, p->data_size);
-            ctx->tag_set = 1;
-        }
-        ctx->m = p->data_size;
     }
 
     p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_IVLEN);
@@ -202,23 +190,57 @@ int ossl_ccm_get_ctx_params(void *vctx, OSSL_PARAM params[])
 
     p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TAG);
     if (p != NULL) {
-        if (!ctx->enc || !ctx->tag_set) {
-            ERR_raise(ERR_LIB_PROV, PROV_R_TAG_NOT_SET);
-            return 0;
-        }
         if (p->data_type != OSSL_PARAM_OCTET_STRING) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_SET_PARAMETER);
             return 0;
         }
-        if (!ctx->hw->gettag(ctx, p->data, p->data_size))
+        if (!ossl_ccm_get_aead_tag(ctx, p->data, p->data_size))
             return 0;
-        ctx->tag_set = 0;
-        ctx->iv_set = 0;
-        ctx->len_set = 0;
     }
     return 1;
 }
 
+/*
+ * Tag accessors shared by the OSSL_CIPHER_PARAM_AEAD_TAG parameter and
+ * EVP_CIPHER_CTX_get_aead_tag() and friends.  Setting a NULL tag only sets
+ * the tag length.
+ */
+int ossl_ccm_get_aead_tag(void *vctx, unsigned char *tag, size_t taglen)
+{
+    PROV_CCM_CTX *ctx = (PROV_CCM_CTX *)vctx;
+
+    if (!ctx->enc || !ctx->tag_set) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_TAG_NOT_SET);
+        return 0;
+    }
+    if (!ctx->hw->gettag(ctx, tag, taglen))
+        return 0;
+    ctx->tag_set = 0;
+    ctx->iv_set = 0;
+    ctx->len_set = 0;
+    return 1;
+}
+
+int ossl_ccm_set_aead_tag(void *vctx, const unsigned char *tag, size_t taglen)
+{
+    PROV_CCM_CTX *ctx = (PROV_CCM_CTX *)vctx;
+
+    if ((taglen & 1) || (taglen < 4) || taglen > 16) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        return 0;
+    }
+    if (tag != NULL) {
+        if (ctx->enc) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_TAG_NOT_NEEDED);
+            return 0;
+        }
+        memcpy(ctx->buf, tag, taglen);
+        ctx->tag_set = 1;
+    }
+    ctx->m = taglen;
+    return 1;
+}
+
 static int ccm_init(void *vctx, const unsigned char *key, size_t keylen,
                     const unsigned char *iv, size_t ivlen,
                     const OSSL_PARAM params[], int enc)
@@ -439,6 +461,72 @@ err:
     return rv;
 }
 
+/*
+ * One-shot AEAD.  The message length is known up front, so the nonce, AAD
+ * and payload can be processed without the usual length setting call.  The
+ * tag length is the one the key was set up with.
+ */
+static int ccm_aead_oneshot(PROV_CCM_CTX *ctx, int enc,
+                            const unsigned char *iv, size_t ivlen,
+                            const unsigned char *aad, size_t aadlen,
+                            const unsigned char *in, size_t inl,
+                            unsigned char *out,
+                            unsigned char *tag, size_t taglen)
+{
+    int rv;
+
+    if (!ossl_prov_is_running())
+        return 0;
+    if (!ctx->key_set) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_NO_KEY_SET);
+        return 0;
+    }
+    if (ctx->enc != enc || ctx->tls_aad_len != UNINITIALISED_SIZET) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_MODE);
+        return 0;
+    }
+    if (iv == NULL || ivlen != ccm_get_ivlen(ctx)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_IV_LENGTH);
+        return 0;
+    }
+    if (tag == NULL || taglen != ctx->m) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        return 0;
+    }
+
+    memcpy(ctx->iv, iv, ivlen);
+    rv = ccm_set_iv(ctx, inl)
+         && (aadlen == 0 || ctx->hw->setaad(ctx, aad, aadlen))
+         && (enc ? ctx->hw->auth_encrypt(ctx, in, out, inl, tag, taglen)
+                 : ctx->hw->auth_decrypt(ctx, in, out, inl, tag, taglen));
+
+    /* The nonce is used up either way */
+    ctx->iv_set = 0;
+    ctx->tag_set = 0;
+    ctx->len_set = 0;
+    if (!rv)
+        ERR_raise(ERR_LIB_PROV, PROV_R_CIPHER_OPERATION_FAILED);
+    return rv;
+}
+
+int ossl_ccm_aead_seal(void *vctx, const unsigned char *iv, size_t ivlen,
+                       const unsigned char *aad, size_t aadlen,
+                       const unsigned char *in, size_t inl, unsigned char *out,
+                       unsigned char *tag, size_t taglen)
+{
+    return ccm_aead_oneshot((PROV_CCM_CTX *)vctx, 1, iv, ivlen, aad, aadlen,
+                            in, inl, out, tag, taglen);
+}
+
+int ossl_ccm_aead_open(void *vctx, const unsigned char *iv, size_t ivlen,
+                       const unsigned char *aad, size_t aadlen,
+                       const unsigned char *in, size_t inl, unsigned char *out,
+                       const unsigned char *tag, size_t taglen)
+{
+    return ccm_aead_oneshot((PROV_CCM_CTX *)vctx, 0, iv, ivlen, aad, aadlen,
+                            in, inl, out, (unsigned char *)tag, taglen);
+}
+
 void ossl_ccm_initctx(PROV_CCM_CTX *ctx, size_t keybits, const PROV_CCM_HW *hw)
 {
     ctx->keylen = keybits / 8;
@@ -15,6 +15,7 @@
 #include "prov/ciphercommon_gcm.h"
 #include "prov/providercommon.h"
 #include "prov/provider_ctx.h"
+#include "internal/param_names.h"
 
 static int gcm_tls_init(PROV_GCM_CTX *dat, unsigned char *aad, size_t aad_len);
 static int gcm_tls_iv_set_fixed(PROV_GCM_CTX *ctx, unsigned char *iv,
@@ -133,23 +134,114 @@ static int setivinv(PROV_GCM_CTX *ctx, unsigned char *in, size_t inl)
     return 1;
 }
 
+/*
+ * The parameters known to ossl_gcm_get_ctx_params() and
+ * ossl_gcm_set_ctx_params(), located in a single pass over the array.  As
+ * with OSSL_PARAM_locate(), the first occurrence of a name wins.
+ */
+struct gcm_get_params_st {
+    OSSL_PARAM *ivlen, *keylen, *taglen, *iv, *updiv, *pad, *tag, *ivgen;
+};
+
+struct gcm_set_params_st {
+    const OSSL_PARAM *tag, *ivlen, *aad, *ivfixed, *ivinv;
+};
+
+static void gcm_get_params_decode(OSSL_PARAM params[],
+                                  struct gcm_get_params_st *r)
+{
+    OSSL_PARAM **pp;
+
+    memset(r, 0, sizeof(*r));
+    if (params == NULL)
+        return;
+    for (; params->key != NULL; params++) {
+        switch (ossl_param_find_pidx(params->key)) {
+        case PIDX_CIPHER_PARAM_IVLEN:
+            pp = &r->ivlen;
+            break;
+        case PIDX_CIPHER_PARAM_KEYLEN:
+            pp = &r->keylen;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TAGLEN:
+            pp = &r->taglen;
+            break;
+        case PIDX_CIPHER_PARAM_IV:
+            pp = &r->iv;
+            break;
+        case PIDX_CIPHER_PARAM_UPDATED_IV:
+            pp = &r->updiv;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TLS1_AAD_PAD:
+            pp = &r->pad;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TAG:
+            pp = &r->tag;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TLS1_GET_IV_GEN:
+            pp = &r->ivgen;
+            break;
+        default:
+            continue;
+        }
+        if (*pp == NULL)
+            *pp = params;
+    }
+}
+
+static void gcm_set_params_decode(const OSSL_PARAM params[],
+                                  struct gcm_set_params_st *r)
+{
+    const OSSL_PARAM **pp;
+
+    memset(r, 0, sizeof(*r));
+    if (params == NULL)
+        return;
+    for (; params->key != NULL; params++) {
+        switch (ossl_param_find_pidx(params->key)) {
+        case PIDX_CIPHER_PARAM_AEAD_TAG:
+            pp = &r->tag;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_IVLEN:
+            pp = &r->ivlen;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TLS1_AAD:
+            pp = &r->aad;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TLS1_IV_FIXED:
+            pp = &r->ivfixed;
+            break;
+        case PIDX_CIPHER_PARAM_AEAD_TLS1_SET_IV_INV:
+            pp = &r->ivinv;
+            break;
+        default:
+            continue;
+        }
+        if (*pp == NULL)
+            *pp = params;
+    }
+}
+
 int ossl_gcm_get_ctx_params(void *vctx, OSSL_PARAM params[])
 {
     PROV_GCM_CTX *ctx = (PROV_GCM_CTX *)vctx;
+    struct gcm_get_params_st r;
     OSSL_PARAM *p;
     size_t sz;
 
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IVLEN);
+    gcm_get_params_decode(params, &r);
+
+    p = r.ivlen;
     if (p != NULL && !OSSL_PARAM_set_size_t(p, ctx->ivlen)) {
         ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_SET_PARAMETER);
         return 0;
     }
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_KEYLEN);
+    p = r.keylen;
     if (p != NULL && !OSSL_PARAM_set_size_t(p, ctx->keylen)) {
         ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_SET_PARAMETER);
         return 0;
     }
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TAGLEN);
+    p = r.taglen;
     if (p != NULL) {
         size_t taglen = (ctx->taglen != UNINITIALISED_SIZET) ? ctx->taglen :
                          GCM_TAG_MAX_SIZE;
@@ -160,7 +252,7 @@ int ossl_gcm_get_ctx_params(void *vctx, OSSL_PARAM params[])
         }
     }
 
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_IV);
+    p = r.iv;
     if (p != NULL) {
         if (ctx->iv_state == IV_STATE_UNINITIALISED)
             return 0;
@@ -175,7 +267,7 @@ int ossl_gcm_get_ctx_params(void *vctx, OSSL_PARAM params[])
         }
     }
 
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_UPDATED_IV);
+    p = r.updiv;
     if (p != NULL) {
         if (ctx->iv_state == IV_STATE_UNINITIALISED)
             return 0;
@@ -190,12 +282,12 @@ int ossl_gcm_get_ctx_params(void *vctx, OSSL_PARAM params[])
         }
     }
 
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TLS1_AAD_PAD);
+    p = r.pad;
     if (p != NULL && !OSSL_PARAM_set_size_t(p, ctx->tls_aad_pad_sz)) {
         ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_SET_PARAMETER);
         return 0;
     }
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TAG);
+    p = r.tag;
     if (p != NULL) {
         sz = p->data_size;
         if (sz == 0
@@ -210,7 +302,7 @@ int ossl_gcm_get_ctx_params(void *vctx, OSSL_PARAM params[])
             return 0;
         }
     }
-    p = OSSL_PARAM_locate(params, OSSL_CIPHER_PARAM_AEAD_TLS1_GET_IV_GEN);
+    p = r.ivgen;
     if (p != NULL) {
         if (p->data == NULL
             || p->data_type != OSSL_PARAM_OCTET_STRING
@@ -223,14 +315,16 @@ int ossl_gcm_get_ctx_params(void *vctx, OSSL_PARAM params[])
 int ossl_gcm_set_ctx_params(void *vctx, const OSSL_PARAM params[])
 {
     PROV_GCM_CTX *ctx = (PROV_GCM_CTX *)vctx;
+    struct gcm_set_params_st r;
     const OSSL_PARAM *p;
     size_t sz;
     void *vp;
 
     if (params == NULL)
         return 1;
+    gcm_set_params_decode(params, &r);
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TAG);
+    p = r.tag;
     if (p != NULL) {
         vp = ctx->buf;
         if (!OSSL_PARAM_get_octet_string(p, &vp, EVP_GCM_TLS_TAG_LEN, &sz)) {
@@ -244,7 +338,7 @@ int ossl_gcm_set_ctx_params(void *vctx, const OSSL_PARAM params[])
         ctx->taglen = sz;
     }
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_IVLEN);
+    p = r.ivlen;
     if (p != NULL) {
         if (!OSSL_PARAM_get_size_t(p, &sz)) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
@@ -257,7 +351,7 @@ int ossl_gcm_set_ctx_params(void *vctx, const OSSL_PARAM params[])
         ctx->ivlen = sz;
     }
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TLS1_AAD);
+    p = r.aad;
     if (p != NULL) {
         if (p->data_type != OSSL_PARAM_OCTET_STRING) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
@@ -271,7 +365,7 @@ int ossl_gcm_set_ctx_params(void *vctx, const OSSL_PARAM params[])
         ctx->tls_aad_pad_sz = sz;
     }
 
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TLS1_IV_FIXED);
+    p = r.ivfixed;
     if (p != NULL) {
         if (p->data_type != OSSL_PARAM_OCTET_STRING) {
             ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
@@ -282,7 +376,7 @@ int ossl_gcm_set_ctx_params(void *vctx, const OSSL_PARAM params[])
             return 0;
         }
     }
-    p = OSSL_PARAM_locate_const(params, OSSL_CIPHER_PARAM_AEAD_TLS1_SET_IV_INV);
+    p = r.ivinv;
     if (p != NULL) {
         if (p->data == NULL
             || p->data_type != OSSL_PARAM_OCTET_STRING
@@ -294,6 +388,113 @@ int ossl_gcm_set_ctx_params(void *vctx, const OSSL_PARAM params[])
     return 1;
 }
 
+/*
+ * Direct tag accessors for EVP_CIPHER_CTX_get_aead_tag() and friends, with the
+ * same checks as the OSSL_CIPHER_PARAM_AEAD_TAG parameter.
+ */
+int ossl_gcm_get_aead_tag(void *vctx, unsigned char *tag, size_t taglen)
+{
+    PROV_GCM_CTX *ctx = (PROV_GCM_CTX *)vctx;
+
+    if (tag == NULL
+        || taglen == 0
+        || taglen > EVP_GCM_TLS_TAG_LEN
+        || !ctx->enc
+        || ctx->taglen == UNINITIALISED_SIZET) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG);
+        return 0;
+    }
+    memcpy(tag, ctx->buf, taglen);
+    return 1;
+}
+
+int ossl_gcm_set_aead_tag(void *vctx, const unsigned char *tag, size_t taglen)
+{
+    PROV_GCM_CTX *ctx = (PROV_GCM_CTX *)vctx;
+
+    if (tag == NULL || taglen > EVP_GCM_TLS_TAG_LEN) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
+        return 0;
+    }
+    if (taglen == 0 || ctx->enc) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG);
+        return 0;
+    }
+    memcpy(ctx->buf, tag, taglen);
+    ctx->taglen = taglen;
+    return 1;
+}
+
+/*
+ * One-shot AEAD: set the IV, then hash the AAD and encrypt or decrypt the
+ * whole message in one go using the same hardware specific oneshot method
+ * as the TLS record code.  On decryption the tag is checked and the output
+ * is wiped if it doesn't match.
+ */
+static int gcm_aead_oneshot(PROV_GCM_CTX *ctx, int enc,
+                            const unsigned char *iv, size_t ivlen,
+                            const unsigned char *aad, size_t aadlen,
+                            const unsigned char *in, size_t inl,
+                            unsigned char *out,
+                            unsigned char *tag, size_t taglen)
+{
+    if (!ossl_prov_is_running())
+        return 0;
+    if (!ctx->key_set) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_NO_KEY_SET);
+        return 0;
+    }
+    if (ctx->enc != enc) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_MODE);
+        return 0;
+    }
+    if (iv == NULL || ivlen < ctx->ivlen_min || ivlen > sizeof(ctx->iv)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_IV_LENGTH);
+        return 0;
+    }
+    if (tag == NULL || taglen == 0 || taglen > EVP_GCM_TLS_TAG_LEN) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_TAG_LENGTH);
+        return 0;
+    }
+
+    ctx->ivlen = ivlen;
+    memcpy(ctx->iv, iv, ivlen);
+    ctx->iv_state = IV_STATE_FINISHED;
+    if (!ctx->hw->setiv(ctx, ctx->iv, ctx->ivlen))
+        return 0;
+
+    /* The full tag is always computed when encrypting, into |buf| */
+    if (!ctx->hw->oneshot(ctx, (unsigned char *)aad, aadlen, in, inl, out,
+                          enc ? ctx->buf : tag,
+                          enc ? EVP_GCM_TLS_TAG_LEN : taglen)) {
+        if (!enc)
+            OPENSSL_cleanse(out, inl);
+        ERR_raise(ERR_LIB_PROV, PROV_R_CIPHER_OPERATION_FAILED);
+        return 0;
+    }
+    if (enc)
+        memcpy(tag, ctx->buf, taglen);
+    return 1;
+}
+
+int ossl_gcm_aead_seal(void *vctx, const unsigned char *iv, size_t ivlen,
+                       const unsigned char *aad, size_t aadlen,
+                       const unsigned char *in, size_t inl, unsigned char *out,
+                       unsigned char *tag, size_t taglen)
+{
+    return gcm_aead_oneshot((PROV_GCM_CTX *)vctx, 1, iv, ivlen, aad, aadlen,
+                            in, inl, out, tag, taglen);
+}
+
+int ossl_gcm_aead_open(void *vctx, const unsigned char *iv, size_t ivlen,
+                       const unsigned char *aad, size_t aadlen,
+                       const unsigned char *in, size_t inl, unsigned char *out,
+                       const unsigned char *tag, size_t taglen)
+{
+    return gcm_aead_oneshot((PROV_GCM_CTX *)vctx, 0, iv, ivlen, aad, aadlen,
+                            in, inl, out, (unsigned char *)tag, taglen);
+}
+
 int ossl_gcm_stream_update(void *vctx, unsigned char *out, size_t *outl,
                            size_t outsize, const unsigned char *in, size_t inl)
 {
@@ -48,18 +48,103 @@ int ossl_gcm_cipher_final(PROV_GCM_CTX *ctx, unsigned char *tag)
     return 1;
 }
 
+/*
+ * Short messages are common in TLS and RPC framing, and for them the
+ * separate CRYPTO_gcm128_aad(), _encrypt_ctr32() and _finish() calls,
+ * each hashing its own few blocks and reducing at least once, cost more
+ * than the encryption. gcm_one_shot_short() runs the counter mode on the
+ * whole message and then hashes the padded AAD, ciphertext and length block
+ * with a single call to the GHASH function, which aggregates as many blocks
+ * per reduction as its table of powers of H allows.
+ */
+#define GCM_SHORT_MAX_LEN       512
+#define GCM_SHORT_MAX_AAD_LEN   64
+
+static int gcm_one_shot_short(PROV_GCM_CTX *ctx, const unsigned char *aad,
+                              size_t aad_len, const unsigned char *in,
+                              size_t in_len, unsigned char *out,
+                              unsigned char *tag, size_t tag_len)
+{
+    GCM128_CONTEXT *gcm = &ctx->gcm;
+    unsigned char hbuf[GCM_SHORT_MAX_AAD_LEN + GCM_SHORT_MAX_LEN + 16];
+    unsigned char ctr[16], ks[16];
+    size_t apad = (aad_len + 15) & ~(size_t)15;
+    size_t cpad = (in_len + 15) & ~(size_t)15;
+    size_t blocks = in_len / 16, tail = in_len % 16, i;
+    unsigned char *c = hbuf + apad, *len = c + cpad;
+    uint64_t abits = (uint64_t)aad_len * 8, cbits = (uint64_t)in_len * 8;
+    uint32_t n;
+    int ret = 1;
+
+    if (aad_len > 0)
+        memcpy(hbuf, aad, aad_len);
+    memset(hbuf + aad_len, 0, apad - aad_len);
+    if (!ctx->enc) {
+        memcpy(c, in, in_len);
+        memset(c + in_len, 0, cpad - in_len);
+    }
+
+    if (blocks > 0)
+        ctx->ctr(in, out, blocks, ctx->ks, gcm->Yi.c);
+    memcpy(ctr, gcm->Yi.c, sizeof(ctr));
+    n = ((uint32_t)ctr[12] << 24 | (uint32_t)ctr[13] << 16
+         | (uint32_t)ctr[14] << 8 | ctr[15]) + (uint32_t)blocks;
+    ctr[12] = (unsigned char)(n >> 24);
+    ctr[13] = (unsigned char)(n >> 16);
+    ctr[14] = (unsigned char)(n >> 8);
+    ctr[15] = (unsigned char)n;
+    if (tail > 0) {
+        gcm->block(ctr, ks, gcm->key);
+        for (i = 0; i < tail; i++)
+            out[blocks * 16 + i] = in[blocks * 16 + i] ^ ks[i];
+        OPENSSL_cleanse(ks, sizeof(ks));
+    }
+
+    if (ctx->enc) {
+        memcpy(c, out, in_len);
+        memset(c + in_len, 0, cpad - in_len);
+    }
+    for (i = 0; i < 8; i++) {
+        len[i] = (unsigned char)(abits >> (56 - 8 * i));
+        len[8 + i] = (unsigned char)(cbits >> (56 - 8 * i));
+    }
+
+    gcm->len.u[0] = aad_len;
+    gcm->len.u[1] = in_len;
+    gcm->Xi.u[0] = gcm->Xi.u[1] = 0;
+    ctx->ghash(gcm->Xi.u, ctx->Htable, hbuf, apad + cpad + 16);
+    gcm->Xi.u[0] ^= gcm->EK0.u[0];
+    gcm->Xi.u[1] ^= gcm->EK0.u[1];
+
+    if (ctx->enc) {
+        memcpy(tag, gcm->Xi.c, GCM_TAG_MAX_SIZE);
+        ctx->taglen = GCM_TAG_MAX_SIZE;
+    } else {
+        ctx->taglen = tag_len;
+        ret = CRYPTO_memcmp(gcm->Xi.c, tag, tag_len) == 0;
+    }
+    return ret;
+}
+
 int ossl_gcm_one_shot(PROV_GCM_CTX *ctx, unsigned char *aad, size_t aad_len,
                       const unsigned char *in, size_t in_len,
                       unsigned char *out, unsigned char *tag, size_t tag_len)
 {
     int ret = 0;
 
+    /* Only straight after the IV is set, with nothing hashed yet */
+    if (in_len <= GCM_SHORT_MAX_LEN && aad_len <= GCM_SHORT_MAX_AAD_LEN
+            && ctx->ctr != NULL && ctx->ghash != NULL
+            && ctx->gcm.len.u[0] == 0 && ctx->gcm.len.u[1] == 0)
+        return gcm_one_shot_short(ctx, aad, aad_len, in, in_len, out,
+                                  tag, tag_len);
+
     /* Use saved AAD */
     if (!ctx->hw->aadupdate(ctx, aad, aad_len))
         goto err;
     if (!ctx->hw->cipherupdate(ctx, in, in_len, out))
         goto err;
-    ctx->taglen = GCM_TAG_MAX_SIZE;
+    ctx->taglen = tag_len;
     if (!ctx->hw->cipherfinal(ctx, tag))
         goto err;
     ret = 1;
@@ -39,3 +39,15 @@ IMPLEMENT_digest_functions(blake2b512, BLAKE2B_CTX,
                            BLAKE2B_BLOCKBYTES, BLAKE2B_DIGEST_LENGTH, 0,
                            ossl_blake2b512_init, ossl_blake2b_update,
                            ossl_blake2b_final)
+
+/* ossl_blake2sp256_functions */
+IMPLEMENT_digest_functions(blake2sp256, BLAKE2SP_CTX,
+                           BLAKE2S_BLOCKBYTES, BLAKE2S_DIGEST_LENGTH, 0,
+                           ossl_blake2sp256_init, ossl_blake2sp_update,
+                           ossl_blake2sp_final)
+
+/* ossl_blake2bp512_functions */
+IMPLEMENT_digest_functions(blake2bp512, BLAKE2BP_CTX,
+                           BLAKE2B_BLOCKBYTES, BLAKE2B_DIGEST_LENGTH, 0,
+                           ossl_blake2bp512_init, ossl_blake2bp_update,
+                           ossl_blake2bp_final)
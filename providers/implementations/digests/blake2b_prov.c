@@ -172,6 +172,13 @@ static void blake2b_compress(BLAKE2B_CTX *S,
      */
     assert(len < BLAKE2B_BLOCKBYTES || len % BLAKE2B_BLOCKBYTES == 0);
 
+#if defined(BLAKE2_ASM)
+    if ((blake2_x86_64_caps() & BLAKE2_X86_64_AVX2) != 0) {
+        blake2b_compress_avx2(S, blocks, len);
+        return;
+    }
+#endif
+
     /*
      * Since last block is always processed with separate call,
      * |len| not being multiple of complete blocks can be observed
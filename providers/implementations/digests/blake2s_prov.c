@@ -165,6 +165,13 @@ static void blake2s_compress(BLAKE2S_CTX *S,
      */
     assert(len < BLAKE2S_BLOCKBYTES || len % BLAKE2S_BLOCKBYTES == 0);
 
+#if defined(BLAKE2_ASM)
+    if ((blake2_x86_64_caps() & BLAKE2_X86_64_SSE41) != 0) {
+        blake2s_compress_sse41(S, blocks, len);
+        return;
+    }
+#endif
+
     /*
      * Since last block is always processed with separate call,
      * |len| not being multiple of complete blocks can be observed
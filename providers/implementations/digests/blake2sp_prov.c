@@ -0,0 +1,166 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * BLAKE2sp, the 8-way parallel BLAKE2s tree mode described in the BLAKE2
+ * paper and implemented by the reference code at https://blake2.net.
+ */
+
+#include <string.h>
+#include <openssl/crypto.h>
+#include "blake2_impl.h"
+#include "prov/blake2.h"
+
+/* Sets up the parameters of leaf |offset| (depth 0) or the root (depth 1) */
+static void blake2sp_param_init(BLAKE2S_PARAM *P, uint64_t offset,
+                                uint8_t depth)
+{
+    ossl_blake2s_param_init(P);
+    P->fanout = BLAKE2SP_PARALLELISM;
+    P->depth = 2;
+    store48(P->node_offset, offset);
+    P->node_depth = depth;
+    P->inner_length = BLAKE2S_OUTBYTES;
+}
+
+/* The last leaf and the root are flagged in the final block they compress */
+static ossl_inline void blake2s_set_lastnode(BLAKE2S_CTX *S)
+{
+    S->f[1] = -1;
+}
+
+int ossl_blake2sp256_init(void *ctx)
+{
+    BLAKE2SP_CTX *c = ctx;
+    BLAKE2S_PARAM P;
+    size_t i;
+
+    for (i = 0; i < BLAKE2SP_PARALLELISM; i++) {
+        blake2sp_param_init(&P, i, 0);
+        ossl_blake2s_init(&c->leaf[i], &P);
+    }
+    c->buflen = 0;
+    return 1;
+}
+
+/*
+ * Hashes |num| runs of one block for every leaf.  None of them is the last
+ * block of its leaf, which the caller makes sure of.
+ */
+static void blake2sp_compress(BLAKE2SP_CTX *c, const uint8_t *in, size_t num)
+{
+    size_t i, j;
+
+    if (num == 0)
+        return;
+
+#if defined(BLAKE2_ASM)
+    /* All the leaves take the same number of blocks, so share a counter */
+    if ((blake2_x86_64_caps() & BLAKE2_X86_64_LANES) != 0
+            && c->leaf[0].buflen == 0) {
+        uint32_t H[8][BLAKE2SP_PARALLELISM];
+
+        for (i = 0; i < 8; i++)
+            for (j = 0; j < BLAKE2SP_PARALLELISM; j++)
+                H[i][j] = c->leaf[j].h[i];
+        blake2s_compress_x8(H, c->leaf[0].t, in, num);
+        for (j = 0; j < BLAKE2SP_PARALLELISM; j++) {
+            for (i = 0; i < 8; i++)
+                c->leaf[j].h[i] = H[i][j];
+            c->leaf[j].t[0] = c->leaf[0].t[0];
+            c->leaf[j].t[1] = c->leaf[0].t[1];
+        }
+        OPENSSL_cleanse(H, sizeof(H));
+        return;
+    }
+#endif
+
+    for (i = 0; i < num; i++, in += BLAKE2P_RUNBYTES)
+        for (j = 0; j < BLAKE2SP_PARALLELISM; j++)
+            ossl_blake2s_update(&c->leaf[j], in + j * BLAKE2S_BLOCKBYTES,
+                                BLAKE2S_BLOCKBYTES);
+}
+
+/*
+ * Absorb the input data into the leaves.  Always returns 1.
+ *
+ * Each leaf has to keep its last block back for the final, so a run is only
+ * hashed once at least one more full run follows it.  This leaves between
+ * one and two runs of data in the buffer.
+ */
+int ossl_blake2sp_update(BLAKE2SP_CTX *c, const void *data, size_t datalen)
+{
+    const uint8_t *in = data;
+    size_t fill, num;
+
+    if (datalen < sizeof(c->buf) - c->buflen) {
+        memcpy(c->buf + c->buflen, in, datalen);
+        c->buflen += datalen;
+        return 1;
+    }
+
+    if (c->buflen > 0) {
+        fill = sizeof(c->buf) - c->buflen;
+        memcpy(c->buf + c->buflen, in, fill);
+        in += fill;
+        datalen -= fill;
+        if (datalen < BLAKE2P_RUNBYTES) {
+            blake2sp_compress(c, c->buf, 1);
+            memcpy(c->buf, c->buf + BLAKE2P_RUNBYTES, BLAKE2P_RUNBYTES);
+            memcpy(c->buf + BLAKE2P_RUNBYTES, in, datalen);
+            c->buflen = BLAKE2P_RUNBYTES + datalen;
+            return 1;
+        }
+        blake2sp_compress(c, c->buf, 2);
+    }
+
+    num = datalen / BLAKE2P_RUNBYTES - 1;
+    blake2sp_compress(c, in, num);
+    in += num * BLAKE2P_RUNBYTES;
+    datalen -= num * BLAKE2P_RUNBYTES;
+
+    memcpy(c->buf, in, datalen);
+    c->buflen = datalen;
+    return 1;
+}
+
+/*
+ * Calculate the final hash and save it in md.
+ * Always returns 1.
+ */
+int ossl_blake2sp_final(unsigned char *md, BLAKE2SP_CTX *c)
+{
+    uint8_t hash[BLAKE2SP_PARALLELISM][BLAKE2S_OUTBYTES];
+    BLAKE2S_CTX root;
+    BLAKE2S_PARAM P;
+    size_t i, j, left;
+
+    for (i = 0; i < BLAKE2SP_PARALLELISM; i++) {
+        /* Hand every leaf what is left of its blocks in the buffer */
+        for (j = i * BLAKE2S_BLOCKBYTES; j < c->buflen; j += BLAKE2P_RUNBYTES) {
+            left = c->buflen - j;
+            if (left > BLAKE2S_BLOCKBYTES)
+                left = BLAKE2S_BLOCKBYTES;
+            ossl_blake2s_update(&c->leaf[i], c->buf + j, left);
+        }
+        if (i == BLAKE2SP_PARALLELISM - 1)
+            blake2s_set_lastnode(&c->leaf[i]);
+        ossl_blake2s_final(hash[i], &c->leaf[i]);
+    }
+
+    blake2sp_param_init(&P, 0, 1);
+    ossl_blake2s_init(&root, &P);
+    ossl_blake2s_update(&root, hash, sizeof(hash));
+    blake2s_set_lastnode(&root);
+    ossl_blake2s_final(md, &root);
+
+    OPENSSL_cleanse(hash, sizeof(hash));
+    OPENSSL_cleanse(c, sizeof(*c));
+    return 1;
+}
@@ -0,0 +1,772 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * BLAKE3, derived from the reference implementation at
+ * https://github.com/BLAKE3-team/BLAKE3.
+ *
+ * The input is split into 1024 byte chunks, each hashed like a small BLAKE2s
+ * with 7 rounds, and the chunk chaining values (CVs) are merged pairwise in
+ * a binary tree.  Whole subtrees of the input handed to a single update are
+ * hashed BLAKE3_SIMD_DEGREE chunks or parent nodes at a time, and split over
+ * several threads when the "threads" parameter allows it.
+ */
+
+#include <string.h>
+#include <openssl/core_names.h>
+#include <openssl/crypto.h>
+#include <openssl/err.h>
+#include <openssl/params.h>
+#include <openssl/proverr.h>
+#include "internal/cryptlib.h"
+#include "blake2_impl.h"
+#include "prov/blake3.h"
+#include "prov/digestcommon.h"
+#include "prov/implementations.h"
+
+#define CHUNK_START         (1 << 0)
+#define CHUNK_END           (1 << 1)
+#define PARENT              (1 << 2)
+#define ROOT                (1 << 3)
+
+static const uint32_t blake3_IV[8] = {
+    0x6A09E667U, 0xBB67AE85U, 0x3C6EF372U, 0xA54FF53AU,
+    0x510E527FU, 0x9B05688CU, 0x1F83D9ABU, 0x5BE0CD19U
+};
+
+static const uint8_t blake3_schedule[7][16] = {
+    {  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15 },
+    {  2,  6,  3, 10,  7,  0,  4, 13,  1, 11, 12,  5,  9, 14, 15,  8 },
+    {  3,  4, 10, 12, 13,  2,  7, 14,  6,  5,  9,  0, 11, 15,  8,  1 },
+    { 10,  7, 12,  9, 14,  3, 13, 15,  4,  0, 11,  2,  5,  8,  1,  6 },
+    { 12, 13,  9, 11, 15, 10, 14,  8,  7,  2,  5,  3,  0,  1,  6,  4 },
+    {  9, 14, 11,  5,  8, 12, 15,  1, 13,  3,  0, 10,  2,  6,  4,  7 },
+    { 11, 15,  5,  0,  1,  9,  8,  6, 14, 10,  2, 12,  3,  4,  7, 13 },
+};
+
+/* The input to the final compression of a node, kept until its use is known */
+typedef struct {
+    uint32_t input_cv[8];
+    uint8_t  block[BLAKE3_BLOCK_LEN];
+    uint8_t  block_len;
+    uint64_t counter;
+    uint8_t  flags;
+} BLAKE3_OUTPUT;
+
+static void blake3_compress_pre(uint32_t v[16], const uint32_t cv[8],
+                                const uint8_t block[BLAKE3_BLOCK_LEN],
+                                uint8_t block_len, uint64_t counter,
+                                uint8_t flags)
+{
+    uint32_t m[16];
+    size_t i;
+
+    for (i = 0; i < 16; ++i)
+        m[i] = load32(block + i * sizeof(m[i]));
+    for (i = 0; i < 8; ++i)
+        v[i] = cv[i];
+    v[8] = blake3_IV[0];
+    v[9] = blake3_IV[1];
+    v[10] = blake3_IV[2];
+    v[11] = blake3_IV[3];
+    v[12] = (uint32_t)counter;
+    v[13] = (uint32_t)(counter >> 32);
+    v[14] = block_len;
+    v[15] = flags;
+
+#define G(r,i,a,b,c,d) \
+    do { \
+        a = a + b + m[blake3_schedule[r][2*i+0]]; \
+        d = rotr32(d ^ a, 16); \
+        c = c + d; \
+        b = rotr32(b ^ c, 12); \
+        a = a + b + m[blake3_schedule[r][2*i+1]]; \
+        d = rotr32(d ^ a, 8); \
+        c = c + d; \
+        b = rotr32(b ^ c, 7); \
+    } while (0)
+#define ROUND(r)  \
+    do { \
+        G(r,0,v[ 0],v[ 4],v[ 8],v[12]); \
+        G(r,1,v[ 1],v[ 5],v[ 9],v[13]); \
+        G(r,2,v[ 2],v[ 6],v[10],v[14]); \
+        G(r,3,v[ 3],v[ 7],v[11],v[15]); \
+        G(r,4,v[ 0],v[ 5],v[10],v[15]); \
+        G(r,5,v[ 1],v[ 6],v[11],v[12]); \
+        G(r,6,v[ 2],v[ 7],v[ 8],v[13]); \
+        G(r,7,v[ 3],v[ 4],v[ 9],v[14]); \
+    } while (0)
+#if defined(OPENSSL_SMALL_FOOTPRINT)
+    /* 3x size reduction on x86_64, almost 7x on ARMv8, 9x on ARMv4 */
+    for (i = 0; i < 7; i++)
+        ROUND(i);
+#else
+    ROUND(0);
+    ROUND(1);
+    ROUND(2);
+    ROUND(3);
+    ROUND(4);
+    ROUND(5);
+    ROUND(6);
+#endif
+#undef G
+#undef ROUND
+}
+
+static void blake3_compress_in_place(uint32_t cv[8],
+                                     const uint8_t block[BLAKE3_BLOCK_LEN],
+                                     uint8_t block_len, uint64_t counter,
+                                     uint8_t flags)
+{
+    uint32_t v[16];
+    size_t i;
+
+    blake3_compress_pre(v, cv, block, block_len, counter, flags);
+    for (i = 0; i < 8; ++i)
+        cv[i] = v[i] ^ v[i + 8];
+}
+
+/* The 64 bytes of root output block |counter| */
+static void blake3_compress_xof(const uint32_t cv[8],
+                                const uint8_t block[BLAKE3_BLOCK_LEN],
+                                uint8_t block_len, uint64_t counter,
+                                uint8_t flags, uint8_t out[64])
+{
+    uint32_t v[16];
+    size_t i;
+
+    blake3_compress_pre(v, cv, block, block_len, counter, flags);
+    for (i = 0; i < 8; ++i) {
+        store32(out + i * 4, v[i] ^ v[i + 8]);
+        store32(out + 32 + i * 4, v[i + 8] ^ cv[i]);
+    }
+}
+
+static void blake3_hash_one(const uint8_t *in, size_t blocks,
+                            const uint32_t key[8], uint64_t counter,
+                            uint8_t flags, uint8_t flags_start,
+                            uint8_t flags_end, uint8_t out[BLAKE3_OUT_LEN])
+{
+    uint32_t cv[8];
+    uint8_t block_flags = flags | flags_start;
+    size_t i;
+
+    memcpy(cv, key, sizeof(cv));
+    for (; blocks > 0; blocks--, in += BLAKE3_BLOCK_LEN) {
+        if (blocks == 1)
+            block_flags |= flags_end;
+        blake3_compress_in_place(cv, in, BLAKE3_BLOCK_LEN, counter,
+                                 block_flags);
+        block_flags = flags;
+    }
+    for (i = 0; i < 8; ++i)
+        store32(out + i * 4, cv[i]);
+}
+
+/*
+ * Hashes |num| inputs of |blocks| whole blocks each, the chunks or parent
+ * nodes of one level of the tree, into consecutive CVs at |out|.  The
+ * counter is that of the first input, and counts up for the others if
+ * |increment| is set.
+ */
+static void blake3_hash_many(const uint8_t *const *in, size_t num,
+                             size_t blocks, const uint32_t key[8],
+                             uint64_t counter, int increment, uint8_t flags,
+                             uint8_t flags_start, uint8_t flags_end,
+                             uint8_t *out)
+{
+#if defined(BLAKE3_ASM)
+    unsigned int caps = blake3_x86_64_caps();
+
+    /* Even two inputs are hashed faster with the idle lanes doing nothing */
+    if (num > 1 && (caps & (BLAKE3_X86_64_AVX2 | BLAKE3_X86_64_VL)) != 0) {
+        uint32_t H[8][BLAKE3_SIMD_DEGREE], ctr[2][BLAKE3_SIMD_DEGREE];
+        const uint8_t *lane[BLAKE3_SIMD_DEGREE];
+        uint64_t c;
+        size_t i, j, n;
+
+        while (num > 0) {
+            n = num < BLAKE3_SIMD_DEGREE ? num : BLAKE3_SIMD_DEGREE;
+            for (j = 0; j < BLAKE3_SIMD_DEGREE; j++) {
+                lane[j] = in[j < n ? j : 0];
+                c = counter + (increment ? j : 0);
+                ctr[0][j] = (uint32_t)c;
+                ctr[1][j] = (uint32_t)(c >> 32);
+                for (i = 0; i < 8; i++)
+                    H[i][j] = key[i];
+            }
+            if ((caps & BLAKE3_X86_64_VL) != 0)
+                blake3_hash_x8_avx512vl(H, ctr, lane, blocks,
+                                        flags | flags_start << 8
+                                        | flags_end << 16);
+            else
+                blake3_hash_x8_avx2(H, ctr, lane, blocks,
+                                    flags | flags_start << 8
+                                    | flags_end << 16);
+            for (j = 0; j < n; j++, out += BLAKE3_OUT_LEN)
+                for (i = 0; i < 8; i++)
+                    store32(out + i * 4, H[i][j]);
+            in += n;
+            num -= n;
+            if (increment)
+                counter += n;
+        }
+        return;
+    }
+#endif
+
+    for (; num > 0; num--, in++, out += BLAKE3_OUT_LEN) {
+        blake3_hash_one(*in, blocks, key, counter, flags, flags_start,
+                        flags_end, out);
+        if (increment)
+            counter++;
+    }
+}
+
+static void blake3_output_cv(const BLAKE3_OUTPUT *o, uint8_t cv[32])
+{
+    uint32_t w[8];
+    size_t i;
+
+    memcpy(w, o->input_cv, sizeof(w));
+    blake3_compress_in_place(w, o->block, o->block_len, o->counter, o->flags);
+    for (i = 0; i < 8; ++i)
+        store32(cv + i * 4, w[i]);
+}
+
+static void blake3_output_root(const BLAKE3_OUTPUT *o, uint8_t *out,
+                               size_t outlen)
+{
+    uint8_t wide[64];
+    uint64_t counter = 0;
+    size_t n;
+
+    while (outlen > 0) {
+        blake3_compress_xof(o->input_cv, o->block, o->block_len, counter++,
+                            o->flags | ROOT, wide);
+        n = outlen < sizeof(wide) ? outlen : sizeof(wide);
+        memcpy(out, wide, n);
+        out += n;
+        outlen -= n;
+    }
+    OPENSSL_cleanse(wide, sizeof(wide));
+}
+
+static void blake3_parent_output(BLAKE3_OUTPUT *o,
+                                 const uint8_t block[BLAKE3_BLOCK_LEN],
+                                 const uint32_t key[8], uint8_t flags)
+{
+    memcpy(o->input_cv, key, sizeof(o->input_cv));
+    memcpy(o->block, block, BLAKE3_BLOCK_LEN);
+    o->block_len = BLAKE3_BLOCK_LEN;
+    o->counter = 0;
+    o->flags = flags | PARENT;
+}
+
+static void chunk_state_init(BLAKE3_CHUNK_STATE *s, const uint32_t key[8],
+                             uint64_t chunk_counter, uint8_t flags)
+{
+    memcpy(s->cv, key, sizeof(s->cv));
+    s->chunk_counter = chunk_counter;
+    memset(s->buf, 0, sizeof(s->buf));
+    s->buf_len = 0;
+    s->blocks_compressed = 0;
+    s->flags = flags;
+}
+
+static size_t chunk_state_len(const BLAKE3_CHUNK_STATE *s)
+{
+    return BLAKE3_BLOCK_LEN * (size_t)s->blocks_compressed + s->buf_len;
+}
+
+static uint8_t chunk_state_start_flag(const BLAKE3_CHUNK_STATE *s)
+{
+    return s->blocks_compressed == 0 ? CHUNK_START : 0;
+}
+
+static void chunk_state_update(BLAKE3_CHUNK_STATE *s, const uint8_t *in,
+                               size_t len)
+{
+    size_t take;
+
+    /* The last block is kept back, it gets CHUNK_END if nothing follows */
+    if (s->buf_len > 0) {
+        take = BLAKE3_BLOCK_LEN - s->buf_len;
+        if (take > len)
+            take = len;
+        memcpy(s->buf + s->buf_len, in, take);
+        s->buf_len += (uint8_t)take;
+        in += take;
+        len -= take;
+        if (len == 0)
+            return;
+        blake3_compress_in_place(s->cv, s->buf, BLAKE3_BLOCK_LEN,
+                                 s->chunk_counter,
+                                 s->flags | chunk_state_start_flag(s));
+        s->blocks_compressed++;
+        s->buf_len = 0;
+        memset(s->buf, 0, sizeof(s->buf));
+    }
+
+    while (len > BLAKE3_BLOCK_LEN) {
+        blake3_compress_in_place(s->cv, in, BLAKE3_BLOCK_LEN, s->chunk_counter,
+                                 s->flags | chunk_state_start_flag(s));
+        s->blocks_compressed++;
+        in += BLAKE3_BLOCK_LEN;
+        len -= BLAKE3_BLOCK_LEN;
+    }
+
+    memcpy(s->buf, in, len);
+    s->buf_len = (uint8_t)len;
+}
+
+static void chunk_state_output(const BLAKE3_CHUNK_STATE *s, BLAKE3_OUTPUT *o)
+{
+    memcpy(o->input_cv, s->cv, sizeof(o->input_cv));
+    memcpy(o->block, s->buf, sizeof(o->block));
+    o->block_len = s->buf_len;
+    o->counter = s->chunk_counter;
+    o->flags = s->flags | chunk_state_start_flag(s) | CHUNK_END;
+}
+
+static ossl_inline uint64_t round_down_to_power_of_2(uint64_t x)
+{
+    while ((x & (x - 1)) != 0)
+        x &= x - 1;
+    return x;
+}
+
+/* The length of the left subtree of an input of |len| > 1024 bytes */
+static ossl_inline size_t left_len(size_t len)
+{
+    size_t full_chunks = (len - 1) / BLAKE3_CHUNK_LEN;
+
+    return (size_t)round_down_to_power_of_2(full_chunks) * BLAKE3_CHUNK_LEN;
+}
+
+/*
+ * Hashes up to BLAKE3_SIMD_DEGREE chunks, the last of which may be partial,
+ * and returns the number of CVs written to |out|.
+ */
+static size_t compress_chunks_parallel(const uint8_t *in, size_t len,
+                                       const uint32_t key[8],
+                                       uint64_t chunk_counter, uint8_t flags,
+                                       uint8_t *out)
+{
+    const uint8_t *chunks[BLAKE3_SIMD_DEGREE];
+    BLAKE3_CHUNK_STATE s;
+    BLAKE3_OUTPUT o;
+    size_t n = 0;
+
+    for (; len >= BLAKE3_CHUNK_LEN; len -= BLAKE3_CHUNK_LEN) {
+        chunks[n++] = in;
+        in += BLAKE3_CHUNK_LEN;
+    }
+    blake3_hash_many(chunks, n, BLAKE3_CHUNK_LEN / BLAKE3_BLOCK_LEN, key,
+                     chunk_counter, 1, flags, CHUNK_START, CHUNK_END, out);
+    if (len == 0)
+        return n;
+
+    chunk_state_init(&s, key, chunk_counter + n, flags);
+    chunk_state_update(&s, in, len);
+    chunk_state_output(&s, &o);
+    blake3_output_cv(&o, out + n * BLAKE3_OUT_LEN);
+    return n + 1;
+}
+
+/*
+ * Hashes pairs of the |num| CVs at |cvs| into their parents, and returns the
+ * number of CVs written to |out|, a lone last CV being passed up as it is.
+ */
+static size_t compress_parents_parallel(const uint8_t *cvs, size_t num,
+                                        const uint32_t key[8], uint8_t flags,
+                                        uint8_t *out)
+{
+    const uint8_t *parents[BLAKE3_SIMD_DEGREE];
+    size_t n;
+
+    for (n = 0; 2 * n + 1 < num; n++)
+        parents[n] = cvs + 2 * n * BLAKE3_OUT_LEN;
+    blake3_hash_many(parents, n, 1, key, 0, 0, flags | PARENT, 0, 0, out);
+    if (num == 2 * n)
+        return n;
+
+    memcpy(out + n * BLAKE3_OUT_LEN, cvs + 2 * n * BLAKE3_OUT_LEN,
+           BLAKE3_OUT_LEN);
+    return n + 1;
+}
+
+/*
+ * Hashes a subtree of |len| bytes as far as BLAKE3_SIMD_DEGREE wide levels
+ * allow, and returns the number of CVs left, at most BLAKE3_SIMD_DEGREE and
+ * at least two unless the input is a single chunk.
+ */
+static size_t compress_subtree_wide(const uint8_t *in, size_t len,
+                                    const uint32_t key[8],
+                                    uint64_t chunk_counter, uint8_t flags,
+                                    uint8_t *out)
+{
+    uint8_t cvs[2 * BLAKE3_SIMD_DEGREE * BLAKE3_OUT_LEN];
+    size_t left, left_n, right_n;
+
+    if (len <= BLAKE3_SIMD_DEGREE * BLAKE3_CHUNK_LEN)
+        return compress_chunks_parallel(in, len, key, chunk_counter, flags,
+                                        out);
+
+    left = left_len(len);
+    left_n = compress_subtree_wide(in, left, key, chunk_counter, flags, cvs);
+    right_n = compress_subtree_wide(in + left, len - left, key,
+                                    chunk_counter + left / BLAKE3_CHUNK_LEN,
+                                    flags,
+                                    cvs + BLAKE3_SIMD_DEGREE * BLAKE3_OUT_LEN);
+
+    /*
+     * The left subtree is a power of two of at least BLAKE3_SIMD_DEGREE
+     * chunks, so it always fills its half of |cvs|.
+     */
+    return compress_parents_parallel(cvs, left_n + right_n, key, flags, out);
+}
+
+/*
+ * Hashes a subtree of more than one chunk into the two CVs of its children.
+ * The parent itself is left to the caller, as it might be the root.
+ */
+static void compress_subtree_to_parent_node(const uint8_t *in, size_t len,
+                                            const uint32_t key[8],
+                                            uint64_t chunk_counter,
+                                            uint8_t flags,
+                                            uint8_t out[2 * BLAKE3_OUT_LEN])
+{
+    uint8_t cvs[BLAKE3_SIMD_DEGREE * BLAKE3_OUT_LEN];
+    uint8_t parents[BLAKE3_SIMD_DEGREE * BLAKE3_OUT_LEN / 2];
+    size_t n;
+
+    n = compress_subtree_wide(in, len, key, chunk_counter, flags, cvs);
+    while (n > 2) {
+        n = compress_parents_parallel(cvs, n, key, flags, parents);
+        memcpy(cvs, parents, n * BLAKE3_OUT_LEN);
+    }
+    memcpy(out, cvs, 2 * BLAKE3_OUT_LEN);
+}
+
+/* One of the equal power of two parts of a subtree hashed by a thread */
+typedef struct {
+    const uint8_t *in;
+    size_t part_len;
+    const uint32_t *key;
+    uint64_t chunk_counter;
+    uint8_t flags;
+    uint8_t *cvs;
+} BLAKE3_THREAD_JOB;
+
+static int blake3_thread_part(void *vjob, size_t i)
+{
+    BLAKE3_THREAD_JOB *job = vjob;
+    uint8_t pair[2 * BLAKE3_OUT_LEN];
+    BLAKE3_OUTPUT o;
+
+    compress_subtree_to_parent_node(job->in + i * job->part_len,
+                                    job->part_len, job->key,
+                                    job->chunk_counter
+                                    + i * (job->part_len / BLAKE3_CHUNK_LEN),
+                                    job->flags, pair);
+    blake3_parent_output(&o, pair, job->key, job->flags);
+    blake3_output_cv(&o, job->cvs + i * BLAKE3_OUT_LEN);
+    return 1;
+}
+
+/*
+ * As compress_subtree_to_parent_node() for a whole power of two number of
+ * chunks, split over the threads when it is large enough.
+ */
+static void compress_subtree_threads(BLAKE3_CTX *c, const uint8_t *in,
+                                     size_t len, uint8_t out[2 * BLAKE3_OUT_LEN])
+{
+    uint8_t cvs[OSSL_CRYPTO_PARALLEL_MAX_THREADS * BLAKE3_OUT_LEN];
+    BLAKE3_THREAD_JOB job;
+    size_t parts = 2, n, i;
+
+    if (c->threads < 2 || len < 2 * BLAKE3_THREAD_MIN_LEN) {
+        compress_subtree_to_parent_node(in, len, c->key, c->chunk.chunk_counter,
+                                        c->chunk.flags, out);
+        return;
+    }
+
+    /* As many parts as threads, rounded up so that they all stay equal */
+    while (parts < c->threads && parts < OSSL_CRYPTO_PARALLEL_MAX_THREADS
+           && len / (2 * parts) >= BLAKE3_THREAD_MIN_LEN)
+        parts *= 2;
+
+    job.in = in;
+    job.part_len = len / parts;
+    job.key = c->key;
+    job.chunk_counter = c->chunk.chunk_counter;
+    job.flags = c->chunk.flags;
+    job.cvs = cvs;
+    ossl_crypto_parallel_run(parts, c->threads, blake3_thread_part, &job);
+
+    /* Merge the parts level by level, up to 2 * BLAKE3_SIMD_DEGREE at once */
+    for (n = parts; n > 2; n /= 2)
+        for (i = 0; i < n; i += 2 * BLAKE3_SIMD_DEGREE)
+            compress_parents_parallel(cvs + i * BLAKE3_OUT_LEN,
+                                      n < 2 * BLAKE3_SIMD_DEGREE
+                                      ? n : 2 * BLAKE3_SIMD_DEGREE,
+                                      c->key, c->chunk.flags,
+                                      cvs + i / 2 * BLAKE3_OUT_LEN);
+    memcpy(out, cvs, 2 * BLAKE3_OUT_LEN);
+}
+
+/*
+ * Merges the completed subtrees on the CV stack, leaving one CV for each
+ * 1 bit in the number of chunks hashed so far.
+ */
+static void blake3_merge_cv_stack(BLAKE3_CTX *c, uint64_t total_len)
+{
+    size_t post_merge_len = 0;
+    BLAKE3_OUTPUT o;
+    uint8_t *parent;
+
+    for (; total_len != 0; total_len &= total_len - 1)
+        post_merge_len++;
+    while (c->cv_stack_len > post_merge_len) {
+        parent = c->cv_stack + (c->cv_stack_len - 2) * BLAKE3_OUT_LEN;
+        blake3_parent_output(&o, parent, c->key, c->chunk.flags);
+        blake3_output_cv(&o, parent);
+        c->cv_stack_len--;
+    }
+}
+
+/* A CV is only merged with the stack once more input shows it isn't the root */
+static void blake3_push_cv(BLAKE3_CTX *c, const uint8_t cv[BLAKE3_OUT_LEN],
+                           uint64_t chunk_counter)
+{
+    blake3_merge_cv_stack(c, chunk_counter);
+    memcpy(c->cv_stack + c->cv_stack_len * BLAKE3_OUT_LEN, cv, BLAKE3_OUT_LEN);
+    c->cv_stack_len++;
+}
+
+int ossl_blake3_init(BLAKE3_CTX *c)
+{
+    memcpy(c->key, blake3_IV, sizeof(c->key));
+    chunk_state_init(&c->chunk, c->key, 0, 0);
+    c->cv_stack_len = 0;
+    return 1;
+}
+
+/*
+ * Add the input data to the hash, always returns 1.
+ */
+int ossl_blake3_update(BLAKE3_CTX *c, const void *data, size_t datalen)
+{
+    const uint8_t *in = data;
+    uint8_t cvs[2 * BLAKE3_OUT_LEN];
+    BLAKE3_CHUNK_STATE s;
+    BLAKE3_OUTPUT o;
+    size_t take, subtree_len;
+    uint64_t subtree_chunks;
+
+    if (datalen == 0)
+        return 1;
+
+    /* Finish the chunk in progress first */
+    if (chunk_state_len(&c->chunk) > 0) {
+        take = BLAKE3_CHUNK_LEN - chunk_state_len(&c->chunk);
+        if (take > datalen)
+            take = datalen;
+        chunk_state_update(&c->chunk, in, take);
+        in += take;
+        datalen -= take;
+        if (datalen == 0)
+            return 1;
+        chunk_state_output(&c->chunk, &o);
+        blake3_output_cv(&o, cvs);
+        blake3_push_cv(c, cvs, c->chunk.chunk_counter);
+        chunk_state_init(&c->chunk, c->key, c->chunk.chunk_counter + 1,
+                         c->chunk.flags);
+    }
+
+    /*
+     * Then hash the largest complete subtrees that fit the input and line up
+     * with the chunks hashed so far, always keeping some input back for the
+     * last chunk, which might be the root.
+     */
+    while (datalen > BLAKE3_CHUNK_LEN) {
+        subtree_len = (size_t)round_down_to_power_of_2(datalen);
+        while (((subtree_len - 1)
+                & (c->chunk.chunk_counter * BLAKE3_CHUNK_LEN)) != 0)
+            subtree_len /= 2;
+        subtree_chunks = subtree_len / BLAKE3_CHUNK_LEN;
+        if (subtree_len <= BLAKE3_CHUNK_LEN) {
+            chunk_state_init(&s, c->key, c->chunk.chunk_counter,
+                             c->chunk.flags);
+            chunk_state_update(&s, in, subtree_len);
+            chunk_state_output(&s, &o);
+            blake3_output_cv(&o, cvs);
+            blake3_push_cv(c, cvs, s.chunk_counter);
+        } else {
+            compress_subtree_threads(c, in, subtree_len, cvs);
+            blake3_push_cv(c, cvs, c->chunk.chunk_counter);
+            blake3_push_cv(c, cvs + BLAKE3_OUT_LEN,
+                           c->chunk.chunk_counter + subtree_chunks / 2);
+        }
+        c->chunk.chunk_counter += subtree_chunks;
+        in += subtree_len;
+        datalen -= subtree_len;
+    }
+
+    if (datalen > 0) {
+        chunk_state_update(&c->chunk, in, datalen);
+        blake3_merge_cv_stack(c, c->chunk.chunk_counter);
+    }
+    return 1;
+}
+
+/*
+ * Calculate |mdlen| bytes of output and save them in md.
+ * Always returns 1.
+ */
+int ossl_blake3_final(unsigned char *md, size_t mdlen, BLAKE3_CTX *c)
+{
+    uint8_t block[BLAKE3_BLOCK_LEN];
+    BLAKE3_OUTPUT o;
+    size_t n;
+
+    /* Fold the CV stack into the root node, from the right */
+    if (c->cv_stack_len == 0 || chunk_state_len(&c->chunk) > 0) {
+        n = c->cv_stack_len;
+        chunk_state_output(&c->chunk, &o);
+    } else {
+        n = c->cv_stack_len - 2;
+        blake3_parent_output(&o, c->cv_stack + n * BLAKE3_OUT_LEN, c->key,
+                             c->chunk.flags);
+    }
+    while (n > 0) {
+        n--;
+        memcpy(block, c->cv_stack + n * BLAKE3_OUT_LEN, BLAKE3_OUT_LEN);
+        blake3_output_cv(&o, block + BLAKE3_OUT_LEN);
+        blake3_parent_output(&o, block, c->key, c->chunk.flags);
+    }
+    blake3_output_root(&o, md, mdlen);
+
+    OPENSSL_cleanse(block, sizeof(block));
+    OPENSSL_cleanse(&o, sizeof(o));
+    return 1;
+}
+
+static OSSL_FUNC_digest_newctx_fn blake3_newctx;
+static OSSL_FUNC_digest_freectx_fn blake3_freectx;
+static OSSL_FUNC_digest_dupctx_fn blake3_dupctx;
+static OSSL_FUNC_digest_init_fn blake3_internal_init;
+static OSSL_FUNC_digest_final_fn blake3_internal_final;
+static OSSL_FUNC_digest_set_ctx_params_fn blake3_set_ctx_params;
+static OSSL_FUNC_digest_settable_ctx_params_fn blake3_settable_ctx_params;
+
+static void *blake3_newctx(void *provctx)
+{
+    BLAKE3_CTX *ctx = ossl_prov_is_running() ? OPENSSL_zalloc(sizeof(*ctx))
+                                             : NULL;
+
+    if (ctx == NULL)
+        return NULL;
+    ctx->xoflen = BLAKE3_OUT_LEN;
+    ctx->threads = 1;
+    return ctx;
+}
+
+static void blake3_freectx(void *vctx)
+{
+    BLAKE3_CTX *ctx = (BLAKE3_CTX *)vctx;
+
+    OPENSSL_clear_free(ctx, sizeof(*ctx));
+}
+
+static void *blake3_dupctx(void *ctx)
+{
+    BLAKE3_CTX *in = (BLAKE3_CTX *)ctx;
+    BLAKE3_CTX *ret = ossl_prov_is_running() ? OPENSSL_malloc(sizeof(*ret))
+                                             : NULL;
+
+    if (ret != NULL)
+        *ret = *in;
+    return ret;
+}
+
+static int blake3_internal_init(void *ctx, const OSSL_PARAM params[])
+{
+    return ossl_prov_is_running()
+           && ossl_blake3_init(ctx)
+           && blake3_set_ctx_params(ctx, params);
+}
+
+static int blake3_internal_final(void *vctx, unsigned char *out, size_t *outl,
+                                 size_t outsz)
+{
+    BLAKE3_CTX *ctx = (BLAKE3_CTX *)vctx;
+
+    if (!ossl_prov_is_running() || outsz < ctx->xoflen
+            || !ossl_blake3_final(out, ctx->xoflen, ctx))
+        return 0;
+    *outl = ctx->xoflen;
+    return 1;
+}
+
+static const OSSL_PARAM known_blake3_settable_ctx_params[] = {
+    {OSSL_DIGEST_PARAM_XOFLEN, OSSL_PARAM_UNSIGNED_INTEGER, NULL, 0, 0},
+    {OSSL_DIGEST_PARAM_THREADS, OSSL_PARAM_UNSIGNED_INTEGER, NULL, 0, 0},
+    OSSL_PARAM_END
+};
+static const OSSL_PARAM *blake3_settable_ctx_params(ossl_unused void *ctx,
+                                                    ossl_unused void *provctx)
+{
+    return known_blake3_settable_ctx_params;
+}
+
+static int blake3_set_ctx_params(void *vctx, const OSSL_PARAM params[])
+{
+    const OSSL_PARAM *p;
+    BLAKE3_CTX *ctx = (BLAKE3_CTX *)vctx;
+
+    if (ctx == NULL)
+        return 0;
+    if (params == NULL)
+        return 1;
+
+    p = OSSL_PARAM_locate_const(params, OSSL_DIGEST_PARAM_XOFLEN);
+    if (p != NULL && !OSSL_PARAM_get_size_t(p, &ctx->xoflen)) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
+        return 0;
+    }
+    p = OSSL_PARAM_locate_const(params, OSSL_DIGEST_PARAM_THREADS);
+    if (p != NULL) {
+        if (!OSSL_PARAM_get_uint(p, &ctx->threads)) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_FAILED_TO_GET_PARAMETER);
+            return 0;
+        }
+        if (ctx->threads == 0)
+            ctx->threads = 1;
+    }
+    return 1;
+}
+
+/* ossl_blake3_256_functions */
+PROV_FUNC_DIGEST_GET_PARAM(blake3_256, BLAKE3_BLOCK_LEN, BLAKE3_OUT_LEN,
+                           PROV_DIGEST_FLAG_XOF)
+const OSSL_DISPATCH ossl_blake3_256_functions[] = {
+    { OSSL_FUNC_DIGEST_NEWCTX, (void (*)(void))blake3_newctx },
+    { OSSL_FUNC_DIGEST_INIT, (void (*)(void))blake3_internal_init },
+    { OSSL_FUNC_DIGEST_UPDATE, (void (*)(void))ossl_blake3_update },
+    { OSSL_FUNC_DIGEST_FINAL, (void (*)(void))blake3_internal_final },
+    { OSSL_FUNC_DIGEST_FREECTX, (void (*)(void))blake3_freectx },
+    { OSSL_FUNC_DIGEST_DUPCTX, (void (*)(void))blake3_dupctx },
+    { OSSL_FUNC_DIGEST_SET_CTX_PARAMS, (void (*)(void))blake3_set_ctx_params },
+    { OSSL_FUNC_DIGEST_SETTABLE_CTX_PARAMS,
+      (void (*)(void))blake3_settable_ctx_params },
+    PROV_DISPATCH_FUNC_DIGEST_GET_PARAMS(blake3_256),
+    { 0, NULL }
+};
@@ -57,21 +57,38 @@ static int sha1_set_ctx_params(void *vctx, const OSSL_PARAM params[])
     return 1;
 }
 
+static OSSL_FUNC_digest_init_fn sha1_internal_init;
+static int sha1_internal_init(void *ctx, const OSSL_PARAM params[])
+{
+    return ossl_prov_is_running()
+           && SHA1_Init(ctx)
+           && sha1_set_ctx_params(ctx, params);
+}
+
+PROV_FUNC_DIGEST_MANY(sha1, SHA_DIGEST_LENGTH, ossl_sha1_many)
+
 /* ossl_sha1_functions */
-IMPLEMENT_digest_functions_with_settable_ctx(
-    sha1, SHA_CTX, SHA_CBLOCK, SHA_DIGEST_LENGTH, SHA2_FLAGS,
-    SHA1_Init, SHA1_Update, SHA1_Final,
-    sha1_settable_ctx_params, sha1_set_ctx_params)
+PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_START(sha1, SHA_CTX, SHA_CBLOCK,
+                                          SHA_DIGEST_LENGTH, SHA2_FLAGS,
+                                          SHA1_Update, SHA1_Final),
+    { OSSL_FUNC_DIGEST_INIT, (void (*)(void))sha1_internal_init },
+    { OSSL_FUNC_DIGEST_SETTABLE_CTX_PARAMS,
+      (void (*)(void))sha1_settable_ctx_params },
+    { OSSL_FUNC_DIGEST_SET_CTX_PARAMS, (void (*)(void))sha1_set_ctx_params },
+    PROV_DISPATCH_FUNC_DIGEST_MANY(sha1),
+PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_END
 
 /* ossl_sha224_functions */
-IMPLEMENT_digest_functions(sha224, SHA256_CTX,
-                           SHA256_CBLOCK, SHA224_DIGEST_LENGTH, SHA2_FLAGS,
-                           SHA224_Init, SHA224_Update, SHA224_Final)
+IMPLEMENT_digest_functions_with_many(sha224, SHA256_CTX,
+                                     SHA256_CBLOCK, SHA224_DIGEST_LENGTH,
+                                     SHA2_FLAGS, SHA224_Init, SHA224_Update,
+                                     SHA224_Final, ossl_sha224_many)
 
 /* ossl_sha256_functions */
-IMPLEMENT_digest_functions(sha256, SHA256_CTX,
-                           SHA256_CBLOCK, SHA256_DIGEST_LENGTH, SHA2_FLAGS,
-                           SHA256_Init, SHA256_Update, SHA256_Final)
+IMPLEMENT_digest_functions_with_many(sha256, SHA256_CTX,
+                                     SHA256_CBLOCK, SHA256_DIGEST_LENGTH,
+                                     SHA2_FLAGS, SHA256_Init, SHA256_Update,
+                                     SHA256_Final, ossl_sha256_many)
 
 /* ossl_sha384_functions */
 IMPLEMENT_digest_functions(sha384, SHA512_CTX,
@@ -228,6 +228,21 @@ static void *uname##_newctx(void *provctx)                                     \
     return ctx;                                                                \
 }
 
+#if defined(S390_SHA3)
+/* KIMD is faster than hashing in lanes, so leave batches to EVP */
+# define SHA3_digest_many(name, bitlen, mdsize, pad)
+# define SHA3_DISPATCH_MANY(name)
+#else
+# define SHA3_digest_many(name, bitlen, mdsize, pad)                           \
+static int name##_many(size_t num, const unsigned char *const *in,             \
+                       const size_t *inl, unsigned char *out)                  \
+{                                                                              \
+    return ossl_sha3_many(num, in, inl, out, pad, bitlen, mdsize);             \
+}                                                                              \
+PROV_FUNC_DIGEST_MANY(name, mdsize, name##_many)
+# define SHA3_DISPATCH_MANY(name) PROV_DISPATCH_FUNC_DIGEST_MANY(name),
+#endif
+
 #define PROV_FUNC_SHA3_DIGEST_COMMON(name, bitlen, blksize, dgstsize, flags)   \
 PROV_FUNC_DIGEST_GET_PARAM(name, blksize, dgstsize, flags)                     \
 const OSSL_DISPATCH ossl_##name##_functions[] = {                              \
@@ -241,6 +256,7 @@ const OSSL_DISPATCH ossl_##name##_functions[] = {                              \
 #define PROV_FUNC_SHA3_DIGEST(name, bitlen, blksize, dgstsize, flags)          \
     PROV_FUNC_SHA3_DIGEST_COMMON(name, bitlen, blksize, dgstsize, flags),      \
     { OSSL_FUNC_DIGEST_INIT, (void (*)(void))keccak_init },                    \
+    SHA3_DISPATCH_MANY(name)                                                   \
     PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_END
 
 #define PROV_FUNC_SHAKE_DIGEST(name, bitlen, blksize, dgstsize, flags)         \
@@ -249,6 +265,7 @@ const OSSL_DISPATCH ossl_##name##_functions[] = {                              \
     { OSSL_FUNC_DIGEST_SET_CTX_PARAMS, (void (*)(void))shake_set_ctx_params }, \
     { OSSL_FUNC_DIGEST_SETTABLE_CTX_PARAMS,                                    \
      (void (*)(void))shake_settable_ctx_params },                              \
+    SHA3_DISPATCH_MANY(name)                                                   \
     PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_END
 
 static void keccak_freectx(void *vctx)
@@ -299,17 +316,21 @@ static int shake_set_ctx_params(void *vctx, const OSSL_PARAM params[])
 
 #define IMPLEMENT_SHA3_functions(bitlen)                                       \
     SHA3_newctx(sha3, SHA3_##bitlen, sha3_##bitlen, bitlen, '\x06')            \
+    SHA3_digest_many(sha3_##bitlen, bitlen, SHA3_MDSIZE(bitlen), '\x06')       \
     PROV_FUNC_SHA3_DIGEST(sha3_##bitlen, bitlen,                               \
                           SHA3_BLOCKSIZE(bitlen), SHA3_MDSIZE(bitlen),         \
                           SHA3_FLAGS)
 
 #define IMPLEMENT_SHAKE_functions(bitlen)                                      \
     SHA3_newctx(shake, SHAKE_##bitlen, shake_##bitlen, bitlen, '\x1f')         \
+    SHA3_digest_many(shake_##bitlen, bitlen, SHA3_MDSIZE(bitlen), '\x1f')      \
     PROV_FUNC_SHAKE_DIGEST(shake_##bitlen, bitlen,                             \
                           SHA3_BLOCKSIZE(bitlen), SHA3_MDSIZE(bitlen),         \
                           SHAKE_FLAGS)
 #define IMPLEMENT_KMAC_functions(bitlen)                                       \
     KMAC_newctx(keccak_kmac_##bitlen, bitlen, '\x04')                          \
+    SHA3_digest_many(keccak_kmac_##bitlen, bitlen, KMAC_MDSIZE(bitlen),        \
+                     '\x04')                                                   \
     PROV_FUNC_SHAKE_DIGEST(keccak_kmac_##bitlen, bitlen,                       \
                            SHA3_BLOCKSIZE(bitlen), KMAC_MDSIZE(bitlen),        \
                            KMAC_FLAGS)
@@ -7,6 +7,7 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <string.h>
 #include <openssl/core.h>
 #include <openssl/core_dispatch.h>
 #include <openssl/core_names.h>
@@ -19,6 +20,7 @@
 #include <openssl/proverr.h>
 #include "internal/asn1.h"
 #include "internal/sizes.h"
+#include "crypto/ec.h"
 #include "prov/bio.h"
 #include "prov/implementations.h"
 #include "endecoder_local.h"
@@ -26,9 +28,14 @@
 static OSSL_FUNC_decoder_newctx_fn epki2pki_newctx;
 static OSSL_FUNC_decoder_freectx_fn epki2pki_freectx;
 static OSSL_FUNC_decoder_decode_fn epki2pki_decode;
+static OSSL_FUNC_decoder_decode_fn pki2typepki_decode;
+
+static int pki2typepki_dispatch(unsigned char *der, long der_len,
+                                OSSL_CALLBACK *data_cb, void *data_cbarg);
 
 /*
- * Context used for EncryptedPrivateKeyInfo to PrivateKeyInfo decoding.
+ * Context used for EncryptedPrivateKeyInfo to PrivateKeyInfo decoding, as
+ * well as PrivateKeyInfo to type specific PrivateKeyInfo decoding.
  */
 struct epki2pki_ctx_st {
     PROV_CTX *provctx;
@@ -65,7 +72,6 @@ static int epki2pki_decode(void *vctx, OSSL_CORE_BIO *cin, int selection,
     const unsigned char *pder = NULL;
     long der_len = 0;
     X509_SIG *p8 = NULL;
-    PKCS8_PRIV_KEY_INFO *p8inf = NULL;
     const X509_ALGOR *alg = NULL;
     BIO *in = ossl_bio_new_from_core_bio(ctx->provctx, cin);
     int ok = (asn1_d2i_read_bio(in, &mem) >= 0);
@@ -114,8 +120,44 @@ static int epki2pki_decode(void *vctx, OSSL_CORE_BIO *cin, int selection,
         ERR_pop_to_mark();
     }
 
+    if (ok)
+        ok = pki2typepki_dispatch(der, der_len, data_cb, data_cbarg);
+    OPENSSL_free(der);
+    return ok;
+}
+
+/*
+ * The key type is found from the PrivateKeyInfo algorithm identifier, so
+ * that only the decoders for that key type get to see the data, rather than
+ * every PrivateKeyInfo decoder parsing it in turn.
+ */
+static int pki2typepki_decode(void *vctx, OSSL_CORE_BIO *cin, int selection,
+                              OSSL_CALLBACK *data_cb, void *data_cbarg,
+                              OSSL_PASSPHRASE_CALLBACK *pw_cb, void *pw_cbarg)
+{
+    struct epki2pki_ctx_st *ctx = vctx;
+    unsigned char *der = NULL;
+    long der_len = 0;
+    int ok;
+
+    /* We return "empty handed".  This is not an error. */
+    if (!ossl_read_der(ctx->provctx, cin, &der, &der_len))
+        return 1;
+
+    ok = pki2typepki_dispatch(der, der_len, data_cb, data_cbarg);
+    OPENSSL_free(der);
+    return ok;
+}
+
+static int pki2typepki_dispatch(unsigned char *der, long der_len,
+                                OSSL_CALLBACK *data_cb, void *data_cbarg)
+{
+    const unsigned char *pder = der;
+    PKCS8_PRIV_KEY_INFO *p8inf = NULL;
+    const X509_ALGOR *alg = NULL;
+    int ok = 1;
+
     ERR_set_mark();
-    pder = der;
     p8inf = d2i_PKCS8_PRIV_KEY_INFO(NULL, &pder, der_len);
     ERR_pop_to_mark();
 
@@ -128,6 +170,13 @@ static int epki2pki_decode(void *vctx, OSSL_CORE_BIO *cin, int selection,
         OSSL_PARAM params[5], *p = params;
         int objtype = OSSL_OBJECT_PKEY;
 
+#ifndef OPENSSL_NO_SM2
+        /* SM2 abuses the EC oid, so this could actually be SM2 */
+        if (OBJ_obj2nid(alg->algorithm) == NID_X9_62_id_ecPublicKey
+                && ossl_x509_algor_is_sm2(alg))
+            strcpy(keytype, "SM2");
+        else
+#endif
         OBJ_obj2txt(keytype, sizeof(keytype), alg->algorithm, 0);
 
         *p++ = OSSL_PARAM_construct_utf8_string(OSSL_OBJECT_PARAM_DATA_TYPE,
@@ -142,7 +191,6 @@ static int epki2pki_decode(void *vctx, OSSL_CORE_BIO *cin, int selection,
         ok = data_cb(params, data_cbarg);
     }
     PKCS8_PRIV_KEY_INFO_free(p8inf);
-    OPENSSL_free(der);
     return ok;
 }
 
@@ -152,3 +200,10 @@ const OSSL_DISPATCH ossl_EncryptedPrivateKeyInfo_der_to_der_decoder_functions[]
     { OSSL_FUNC_DECODER_DECODE, (void (*)(void))epki2pki_decode },
     { 0, NULL }
 };
+
+const OSSL_DISPATCH ossl_PrivateKeyInfo_der_to_der_decoder_functions[] = {
+    { OSSL_FUNC_DECODER_NEWCTX, (void (*)(void))epki2pki_newctx },
+    { OSSL_FUNC_DECODER_FREECTX, (void (*)(void))epki2pki_freectx },
+    { OSSL_FUNC_DECODER_DECODE, (void (*)(void))pki2typepki_decode },
+    { 0, NULL }
+};
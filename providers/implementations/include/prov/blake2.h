@@ -82,8 +82,50 @@ struct blake2b_ctx_st {
 typedef struct blake2s_ctx_st BLAKE2S_CTX;
 typedef struct blake2b_ctx_st BLAKE2B_CTX;
 
+/*
+ * BLAKE2bp and BLAKE2sp spread the input over four BLAKE2b or eight BLAKE2s
+ * leaves, one block each in turn, and hash the leaf digests in a root node.
+ * A run of one block for every leaf is 512 bytes in both.
+ */
+#define BLAKE2BP_PARALLELISM 4
+#define BLAKE2SP_PARALLELISM 8
+#define BLAKE2P_RUNBYTES     512
+
+struct blake2bp_ctx_st {
+    BLAKE2B_CTX leaf[BLAKE2BP_PARALLELISM];
+    uint8_t  buf[2 * BLAKE2P_RUNBYTES];
+    size_t   buflen;
+};
+
+struct blake2sp_ctx_st {
+    BLAKE2S_CTX leaf[BLAKE2SP_PARALLELISM];
+    uint8_t  buf[2 * BLAKE2P_RUNBYTES];
+    size_t   buflen;
+};
+
+typedef struct blake2bp_ctx_st BLAKE2BP_CTX;
+typedef struct blake2sp_ctx_st BLAKE2SP_CTX;
+
+#if defined(BLAKE2_ASM)
+/* crypto/blake2/asm/blake2-x86_64.pl, bits of blake2_x86_64_caps() */
+# define BLAKE2_X86_64_SSE41 0x1        /* blake2s_compress_sse41() */
+# define BLAKE2_X86_64_AVX2  0x2        /* blake2b_compress_avx2() */
+# define BLAKE2_X86_64_LANES 0x4        /* blake2b_compress_x4() and
+                                         * blake2s_compress_x8() */
+
+unsigned int blake2_x86_64_caps(void);
+void blake2b_compress_avx2(BLAKE2B_CTX *S, const void *in, size_t len);
+void blake2s_compress_sse41(BLAKE2S_CTX *S, const void *in, size_t len);
+void blake2b_compress_x4(uint64_t H[8][BLAKE2BP_PARALLELISM], uint64_t t[2],
+                         const void *in, size_t num);
+void blake2s_compress_x8(uint32_t H[8][BLAKE2SP_PARALLELISM], uint32_t t[2],
+                         const void *in, size_t num);
+#endif
+
 int ossl_blake2s256_init(void *ctx);
 int ossl_blake2b512_init(void *ctx);
+int ossl_blake2sp256_init(void *ctx);
+int ossl_blake2bp512_init(void *ctx);
 
 int ossl_blake2b_init(BLAKE2B_CTX *c, const BLAKE2B_PARAM *P);
 int ossl_blake2b_init_key(BLAKE2B_CTX *c, const BLAKE2B_PARAM *P,
@@ -117,4 +159,9 @@ void ossl_blake2s_param_set_personal(BLAKE2S_PARAM *P, const uint8_t *personal,
 void ossl_blake2s_param_set_salt(BLAKE2S_PARAM *P, const uint8_t *salt,
                                  size_t length);
 
+int ossl_blake2bp_update(BLAKE2BP_CTX *c, const void *data, size_t datalen);
+int ossl_blake2bp_final(unsigned char *md, BLAKE2BP_CTX *c);
+int ossl_blake2sp_update(BLAKE2SP_CTX *c, const void *data, size_t datalen);
+int ossl_blake2sp_final(unsigned char *md, BLAKE2SP_CTX *c);
+
 #endif /* OSSL_PROV_BLAKE2_H */
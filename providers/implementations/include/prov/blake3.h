@@ -0,0 +1,76 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#ifndef OSSL_PROV_BLAKE3_H
+# define OSSL_PROV_BLAKE3_H
+
+# include <openssl/opensslconf.h>
+
+# include <openssl/e_os2.h>
+# include <stddef.h>
+
+# define BLAKE3_KEY_LEN        32
+# define BLAKE3_OUT_LEN        32
+# define BLAKE3_BLOCK_LEN      64
+# define BLAKE3_CHUNK_LEN      1024
+# define BLAKE3_MAX_DEPTH      54
+
+/* Number of chunks or parent nodes hashed side by side */
+# define BLAKE3_SIMD_DEGREE    8
+
+/*
+ * Inputs at least this long per thread are split over the threads set with
+ * the "threads" parameter, smaller ones are not worth starting threads for.
+ */
+# define BLAKE3_THREAD_MIN_LEN (256 * 1024)
+
+struct blake3_chunk_state_st {
+    uint32_t cv[8];
+    uint64_t chunk_counter;
+    uint8_t  buf[BLAKE3_BLOCK_LEN];
+    uint8_t  buf_len;
+    uint8_t  blocks_compressed;
+    uint8_t  flags;
+};
+
+typedef struct blake3_chunk_state_st BLAKE3_CHUNK_STATE;
+
+struct blake3_ctx_st {
+    uint32_t key[8];
+    BLAKE3_CHUNK_STATE chunk;
+    uint8_t  cv_stack_len;
+    /* One more than the depth, the update keeps a subtree as two CVs */
+    uint8_t  cv_stack[(BLAKE3_MAX_DEPTH + 1) * BLAKE3_OUT_LEN];
+    size_t   xoflen;
+    unsigned int threads;
+};
+
+typedef struct blake3_ctx_st BLAKE3_CTX;
+
+#if defined(BLAKE3_ASM)
+/* crypto/blake3/asm/blake3-x86_64.pl, bits of blake3_x86_64_caps() */
+# define BLAKE3_X86_64_AVX2  0x1        /* blake3_hash_x8_avx2() */
+# define BLAKE3_X86_64_VL    0x2        /* blake3_hash_x8_avx512vl() */
+
+unsigned int blake3_x86_64_caps(void);
+void blake3_hash_x8_avx2(uint32_t H[8][BLAKE3_SIMD_DEGREE],
+                         uint32_t ctr[2][BLAKE3_SIMD_DEGREE],
+                         const uint8_t *const in[BLAKE3_SIMD_DEGREE],
+                         size_t blocks, unsigned int flags);
+void blake3_hash_x8_avx512vl(uint32_t H[8][BLAKE3_SIMD_DEGREE],
+                             uint32_t ctr[2][BLAKE3_SIMD_DEGREE],
+                             const uint8_t *const in[BLAKE3_SIMD_DEGREE],
+                             size_t blocks, unsigned int flags);
+#endif
+
+int ossl_blake3_init(BLAKE3_CTX *c);
+int ossl_blake3_update(BLAKE3_CTX *c, const void *data, size_t datalen);
+int ossl_blake3_final(unsigned char *md, size_t mdlen, BLAKE3_CTX *c);
+
+#endif /* OSSL_PROV_BLAKE3_H */
@@ -43,5 +43,11 @@ const OSSL_DISPATCH ossl_##alg##kbits##lc##_functions[] = {                    \
       (void (*)(void))ossl_cipher_aead_gettable_ctx_params },                  \
     { OSSL_FUNC_CIPHER_SETTABLE_CTX_PARAMS,                                    \
       (void (*)(void))ossl_cipher_aead_settable_ctx_params },                  \
+    { OSSL_FUNC_CIPHER_GET_AEAD_TAG,                                           \
+      (void (*)(void))ossl_##lc##_get_aead_tag },                              \
+    { OSSL_FUNC_CIPHER_SET_AEAD_TAG,                                           \
+      (void (*)(void))ossl_##lc##_set_aead_tag },                              \
+    { OSSL_FUNC_CIPHER_AEAD_SEAL, (void (*)(void))ossl_##lc##_aead_seal },     \
+    { OSSL_FUNC_CIPHER_AEAD_OPEN, (void (*)(void))ossl_##lc##_aead_open },     \
     { 0, NULL }                                                                \
 }
@@ -77,6 +77,14 @@ typedef struct prov_gcm_ctx_st {
     GCM128_CONTEXT gcm;
     ctr128_f ctr;
     const void *ks;
+
+    /*
+     * GHASH function and the table of powers of H it uses, for hashing
+     * whole short messages in ossl_gcm_one_shot(). |ghash| is NULL if the
+     * platform has none.
+     */
+    void (*ghash)(u64 Xi[2], const u128 Htable[16], const u8 *in, size_t len);
+    const u128 *Htable;
 } PROV_GCM_CTX;
 
 PROV_CIPHER_FUNC(int, GCM_setkey, (PROV_GCM_CTX *ctx, const unsigned char *key,
@@ -109,6 +117,10 @@ OSSL_FUNC_cipher_set_ctx_params_fn ossl_gcm_set_ctx_params;
 OSSL_FUNC_cipher_cipher_fn ossl_gcm_cipher;
 OSSL_FUNC_cipher_update_fn ossl_gcm_stream_update;
 OSSL_FUNC_cipher_final_fn ossl_gcm_stream_final;
+OSSL_FUNC_cipher_get_aead_tag_fn ossl_gcm_get_aead_tag;
+OSSL_FUNC_cipher_set_aead_tag_fn ossl_gcm_set_aead_tag;
+OSSL_FUNC_cipher_aead_seal_fn ossl_gcm_aead_seal;
+OSSL_FUNC_cipher_aead_open_fn ossl_gcm_aead_open;
 void ossl_gcm_initctx(void *provctx, PROV_GCM_CTX *ctx, size_t keybits,
                       const PROV_GCM_HW *hw, size_t ivlen_min);
 
@@ -127,4 +139,6 @@ int ossl_gcm_cipher_update(PROV_GCM_CTX *ctx, const unsigned char *in,
     fn_set_enc_key(key, keylen * 8, ks);                                       \
     CRYPTO_gcm128_init(&ctx->gcm, ks, (block128_f)fn_block);                   \
     ctx->ctr = (ctr128_f)fn_ctr;                                               \
+    ctx->ghash = ctx->gcm.ghash;                                               \
+    ctx->Htable = ctx->gcm.Htable;                                             \
     ctx->key_set = 1;
@@ -35,6 +35,21 @@ static int name##_get_params(OSSL_PARAM params[])                              \
 { OSSL_FUNC_DIGEST_GETTABLE_PARAMS,                                            \
   (void (*)(void))ossl_digest_default_gettable_params }
 
+/* Hashes |num| messages into consecutive |dgstsize| byte digests */
+#define PROV_FUNC_DIGEST_MANY(name, dgstsize, many)                            \
+static OSSL_FUNC_digest_digest_many_fn name##_digest_many;                     \
+static int name##_digest_many(ossl_unused void *provctx, size_t num,           \
+                              const unsigned char *const *in,                  \
+                              const size_t *inl, unsigned char *out,           \
+                              size_t outsz)                                    \
+{                                                                              \
+    return ossl_prov_is_running() && outsz / (dgstsize) >= num                 \
+           && many(num, in, inl, out);                                         \
+}
+
+#define PROV_DISPATCH_FUNC_DIGEST_MANY(name)                                   \
+{ OSSL_FUNC_DIGEST_DIGEST_MANY, (void (*)(void))name##_digest_many }
+
 # define PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_START(                            \
     name, CTX, blksize, dgstsize, flags, upd, fin)                             \
 static OSSL_FUNC_digest_newctx_fn name##_newctx;                               \
@@ -112,6 +127,21 @@ PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_START(name, CTX, blksize, dgstsize, flags, \
 PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_END
 
 
+# define IMPLEMENT_digest_functions_with_many(                                 \
+    name, CTX, blksize, dgstsize, flags, init, upd, fin, many)                 \
+static OSSL_FUNC_digest_init_fn name##_internal_init;                          \
+static int name##_internal_init(void *ctx,                                     \
+                                ossl_unused const OSSL_PARAM params[])         \
+{                                                                              \
+    return ossl_prov_is_running() && init(ctx);                                \
+}                                                                              \
+PROV_FUNC_DIGEST_MANY(name, dgstsize, many)                                    \
+PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_START(name, CTX, blksize, dgstsize, flags, \
+                                          upd, fin),                           \
+    { OSSL_FUNC_DIGEST_INIT, (void (*)(void))name##_internal_init },           \
+    PROV_DISPATCH_FUNC_DIGEST_MANY(name),                                      \
+PROV_DISPATCH_FUNC_DIGEST_CONSTRUCT_END
+
 const OSSL_PARAM *ossl_digest_default_gettable_params(void *provctx);
 int ossl_digest_default_get_params(OSSL_PARAM params[], size_t blksz,
                                    size_t paramsz, unsigned long flags);
@@ -234,6 +234,9 @@
  */
 #define PROV_NAMES_BLAKE2S_256 "BLAKE2S-256:BLAKE2s256:1.3.6.1.4.1.1722.12.2.2.8"
 #define PROV_NAMES_BLAKE2B_512 "BLAKE2B-512:BLAKE2b512:1.3.6.1.4.1.1722.12.2.1.16"
+#define PROV_NAMES_BLAKE2SP_256 "BLAKE2SP-256:BLAKE2sp256"
+#define PROV_NAMES_BLAKE2BP_512 "BLAKE2BP-512:BLAKE2bp512"
+#define PROV_NAMES_BLAKE3_256 "BLAKE3-256:BLAKE3"
 #define PROV_NAMES_SM3 "SM3:1.2.156.10197.1.401"
 #define PROV_NAMES_MD5 "MD5:SSL3-MD5:1.2.840.113549.2.5"
 #define PROV_NAMES_MD5_SHA1 "MD5-SHA1"
@@ -262,6 +265,9 @@
 #define PROV_NAMES_SCRYPT "SCRYPT:id-scrypt:1.3.6.1.4.1.11591.4.11"
 #define PROV_DESCS_SCRYPT_SIGN "OpenSSL SCRYPT via EVP_PKEY implementation"
 #define PROV_NAMES_KRB5KDF "KRB5KDF"
+#define PROV_NAMES_ARGON2D "ARGON2D"
+#define PROV_NAMES_ARGON2I "ARGON2I"
+#define PROV_NAMES_ARGON2ID "ARGON2ID"
 
 /*-
  * MACs
@@ -0,0 +1,793 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * The Argon2d, Argon2i and Argon2id memory-hard KDFs of RFC 9106.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <openssl/crypto.h>
+#include <openssl/kdf.h>
+#include <openssl/err.h>
+#include <openssl/core_names.h>
+#include <openssl/params.h>
+#include <openssl/proverr.h>
+#include "internal/cryptlib.h"
+#include "internal/numbers.h"
+#include "prov/blake2.h"
+#include "prov/implementations.h"
+#include "prov/provider_ctx.h"
+#include "prov/providercommon.h"
+
+#ifndef OPENSSL_NO_ARGON2
+
+# if defined(OPENSSL_SYS_LINUX)
+#  include <sys/mman.h>
+#  if defined(MADV_HUGEPAGE) && (defined(MAP_ANONYMOUS) || defined(MAP_ANON))
+#   define ARGON2_HUGEPAGES
+#   ifndef MAP_ANONYMOUS
+#    define MAP_ANONYMOUS MAP_ANON
+#   endif
+#  endif
+# endif
+
+# define ARGON2_BLOCK_SIZE          1024
+# define ARGON2_QWORDS_IN_BLOCK     (ARGON2_BLOCK_SIZE / 8)
+# define ARGON2_ADDRESSES_IN_BLOCK  128
+# define ARGON2_SYNC_POINTS         4
+# define ARGON2_PREHASH_DIGEST_LEN  64
+# define ARGON2_PREHASH_SEED_LEN    (ARGON2_PREHASH_DIGEST_LEN + 8)
+
+# define ARGON2_VERSION_10          0x10
+# define ARGON2_VERSION_13          0x13
+
+# define ARGON2_MIN_OUTLEN          4
+# define ARGON2_MIN_SALT_LEN        8
+# define ARGON2_MIN_LANES           1
+# define ARGON2_MAX_LANES           0xFFFFFF
+
+/* The primitive type, also hashed into H0 and the address blocks */
+# define ARGON2_D                   0
+# define ARGON2_I                   1
+# define ARGON2_ID                  2
+
+/* The memory is mapped with transparent huge pages from this size on */
+# define ARGON2_HUGEPAGE_SIZE       (2 * 1024 * 1024)
+
+typedef struct {
+    uint64_t v[ARGON2_QWORDS_IN_BLOCK];
+} ARGON2_BLOCK;
+
+typedef void (*ARGON2_FILL_BLOCK_FN)(const ARGON2_BLOCK *prev,
+                                     const ARGON2_BLOCK *ref,
+                                     ARGON2_BLOCK *next, int with_xor);
+
+# if defined(ARGON2_ASM)
+/* crypto/argon2/asm/argon2-x86_64.pl, bits of argon2_x86_64_caps() */
+#  define ARGON2_X86_64_AVX2    0x1     /* argon2_fill_block_avx2() */
+#  define ARGON2_X86_64_VL      0x2     /* argon2_fill_block_avx512vl() */
+
+unsigned int argon2_x86_64_caps(void);
+void argon2_fill_block_avx2(const ARGON2_BLOCK *prev, const ARGON2_BLOCK *ref,
+                            ARGON2_BLOCK *next, int with_xor);
+void argon2_fill_block_avx512vl(const ARGON2_BLOCK *prev,
+                                const ARGON2_BLOCK *ref,
+                                ARGON2_BLOCK *next, int with_xor);
+# endif
+
+static OSSL_FUNC_kdf_newctx_fn kdf_argon2d_new;
+static OSSL_FUNC_kdf_newctx_fn kdf_argon2i_new;
+static OSSL_FUNC_kdf_newctx_fn kdf_argon2id_new;
+static OSSL_FUNC_kdf_freectx_fn kdf_argon2_free;
+static OSSL_FUNC_kdf_reset_fn kdf_argon2_reset;
+static OSSL_FUNC_kdf_derive_fn kdf_argon2_derive;
+static OSSL_FUNC_kdf_settable_ctx_params_fn kdf_argon2_settable_ctx_params;
+static OSSL_FUNC_kdf_set_ctx_params_fn kdf_argon2_set_ctx_params;
+static OSSL_FUNC_kdf_gettable_ctx_params_fn kdf_argon2_gettable_ctx_params;
+static OSSL_FUNC_kdf_get_ctx_params_fn kdf_argon2_get_ctx_params;
+
+typedef struct {
+    int type;
+    unsigned char *pass;
+    size_t pass_len;
+    unsigned char *salt;
+    size_t salt_len;
+    unsigned char *secret;
+    size_t secret_len;
+    unsigned char *ad;
+    size_t ad_len;
+    uint32_t t_cost;
+    uint32_t m_cost;
+    uint32_t lanes;
+    uint32_t threads;
+    uint32_t version;
+} KDF_ARGON2;
+
+/* The memory of one derivation and the slice being filled */
+typedef struct {
+    ARGON2_BLOCK *memory;
+    size_t maplen;              /* non-zero if |memory| was mapped */
+    uint32_t memory_blocks;
+    uint32_t segment_length;
+    uint32_t lane_length;
+    uint32_t lanes;
+    uint32_t passes;
+    uint32_t version;
+    int type;
+    uint32_t pass;
+    uint32_t slice;
+    ARGON2_FILL_BLOCK_FN fill_block;
+} ARGON2_INSTANCE;
+
+static void kdf_argon2_init(KDF_ARGON2 *ctx, int type);
+
+static void *kdf_argon2_new(void *provctx, int type)
+{
+    KDF_ARGON2 *ctx;
+
+    if (!ossl_prov_is_running())
+        return NULL;
+
+    ctx = OPENSSL_zalloc(sizeof(*ctx));
+    if (ctx == NULL) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+        return NULL;
+    }
+    kdf_argon2_init(ctx, type);
+    return ctx;
+}
+
+static void *kdf_argon2d_new(void *provctx)
+{
+    return kdf_argon2_new(provctx, ARGON2_D);
+}
+
+static void *kdf_argon2i_new(void *provctx)
+{
+    return kdf_argon2_new(provctx, ARGON2_I);
+}
+
+static void *kdf_argon2id_new(void *provctx)
+{
+    return kdf_argon2_new(provctx, ARGON2_ID);
+}
+
+static void kdf_argon2_cleanup(KDF_ARGON2 *ctx)
+{
+    OPENSSL_free(ctx->salt);
+    OPENSSL_free(ctx->ad);
+    OPENSSL_clear_free(ctx->pass, ctx->pass_len);
+    OPENSSL_clear_free(ctx->secret, ctx->secret_len);
+    memset(ctx, 0, sizeof(*ctx));
+}
+
+static void kdf_argon2_free(void *vctx)
+{
+    KDF_ARGON2 *ctx = (KDF_ARGON2 *)vctx;
+
+    if (ctx != NULL) {
+        kdf_argon2_cleanup(ctx);
+        OPENSSL_free(ctx);
+    }
+}
+
+static void kdf_argon2_reset(void *vctx)
+{
+    KDF_ARGON2 *ctx = (KDF_ARGON2 *)vctx;
+    int type = ctx->type;
+
+    kdf_argon2_cleanup(ctx);
+    kdf_argon2_init(ctx, type);
+}
+
+static void kdf_argon2_init(KDF_ARGON2 *ctx, int type)
+{
+    /* The first recommended option of RFC 9106 section 4, with 64 MiB */
+    ctx->type = type;
+    ctx->t_cost = 3;
+    ctx->m_cost = 64 * 1024;
+    ctx->lanes = 4;
+    ctx->threads = 1;
+    ctx->version = ARGON2_VERSION_13;
+}
+
+static int argon2_set_membuf(unsigned char **buffer, size_t *buflen,
+                             const OSSL_PARAM *p)
+{
+    OPENSSL_clear_free(*buffer, *buflen);
+    *buffer = NULL;
+    *buflen = 0;
+    if (p->data_size == 0) {
+        if ((*buffer = OPENSSL_malloc(1)) == NULL) {
+            ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+            return 0;
+        }
+    } else if (p->data != NULL) {
+        if (!OSSL_PARAM_get_octet_string(p, (void **)buffer, 0, buflen))
+            return 0;
+    }
+    return 1;
+}
+
+static ossl_inline void store32_le(unsigned char *p, uint32_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+    p[2] = (unsigned char)(v >> 16);
+    p[3] = (unsigned char)(v >> 24);
+}
+
+static void block_from_bytes(ARGON2_BLOCK *b, const unsigned char *in)
+{
+    size_t i, j;
+
+    for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++, in += 8)
+        for (b->v[i] = 0, j = 8; j-- > 0;)
+            b->v[i] = (b->v[i] << 8) | in[j];
+}
+
+static void block_to_bytes(unsigned char *out, const ARGON2_BLOCK *b)
+{
+    size_t i, j;
+
+    for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++)
+        for (j = 0; j < 8; j++)
+            *out++ = (unsigned char)(b->v[i] >> (8 * j));
+}
+
+static void blake2b_start(BLAKE2B_CTX *c, size_t outlen)
+{
+    BLAKE2B_PARAM P;
+
+    ossl_blake2b_param_init(&P);
+    ossl_blake2b_param_set_digest_length(&P, (uint8_t)outlen);
+    ossl_blake2b_init(c, &P);
+}
+
+/* The variable-length hash function H' of RFC 9106 section 3.3 */
+static void blake2b_long(unsigned char *out, size_t outlen,
+                         const unsigned char *in, size_t inlen)
+{
+    BLAKE2B_CTX c;
+    unsigned char len[4], v[BLAKE2B_OUTBYTES];
+
+    store32_le(len, (uint32_t)outlen);
+    if (outlen <= BLAKE2B_OUTBYTES) {
+        blake2b_start(&c, outlen);
+        ossl_blake2b_update(&c, len, sizeof(len));
+        ossl_blake2b_update(&c, in, inlen);
+        ossl_blake2b_final(out, &c);
+        return;
+    }
+
+    /* The first 32 bytes of every 64 byte V_i, and then all of V_r+1 */
+    blake2b_start(&c, BLAKE2B_OUTBYTES);
+    ossl_blake2b_update(&c, len, sizeof(len));
+    ossl_blake2b_update(&c, in, inlen);
+    ossl_blake2b_final(v, &c);
+    memcpy(out, v, BLAKE2B_OUTBYTES / 2);
+    out += BLAKE2B_OUTBYTES / 2;
+    outlen -= BLAKE2B_OUTBYTES / 2;
+    while (outlen > BLAKE2B_OUTBYTES) {
+        blake2b_start(&c, BLAKE2B_OUTBYTES);
+        ossl_blake2b_update(&c, v, sizeof(v));
+        ossl_blake2b_final(v, &c);
+        memcpy(out, v, BLAKE2B_OUTBYTES / 2);
+        out += BLAKE2B_OUTBYTES / 2;
+        outlen -= BLAKE2B_OUTBYTES / 2;
+    }
+    blake2b_start(&c, outlen);
+    ossl_blake2b_update(&c, v, sizeof(v));
+    ossl_blake2b_final(out, &c);
+    OPENSSL_cleanse(v, sizeof(v));
+}
+
+/* The BlaMka multiplication-hardened addition of RFC 9106 section 3.6 */
+static ossl_inline uint64_t blamka(uint64_t x, uint64_t y)
+{
+    return x + y + 2 * (x & 0xffffffff) * (y & 0xffffffff);
+}
+
+# define ROTR64(x, n)   (((x) >> (n)) | ((x) << (64 - (n))))
+
+# define GB(a, b, c, d)                 \
+    do {                                \
+        a = blamka(a, b);               \
+        d = ROTR64(d ^ a, 32);          \
+        c = blamka(c, d);               \
+        b = ROTR64(b ^ c, 24);          \
+        a = blamka(a, b);               \
+        d = ROTR64(d ^ a, 16);          \
+        c = blamka(c, d);               \
+        b = ROTR64(b ^ c, 63);          \
+    } while (0)
+
+/*
+ * The permutation P on the 16 words v[0], v[1], v[step], v[step + 1], ...:
+ * a row of the block is 16 consecutive words, a column two words of each of
+ * the eight rows.
+ */
+static ossl_inline void blamka_round(uint64_t *v, size_t step)
+{
+# define W(j)   v[((j) >> 1) * step + ((j) & 1)]
+    GB(W(0), W(4), W(8), W(12));
+    GB(W(1), W(5), W(9), W(13));
+    GB(W(2), W(6), W(10), W(14));
+    GB(W(3), W(7), W(11), W(15));
+    GB(W(0), W(5), W(10), W(15));
+    GB(W(1), W(6), W(11), W(12));
+    GB(W(2), W(7), W(8), W(13));
+    GB(W(3), W(4), W(9), W(14));
+# undef W
+}
+
+/* next = G(prev, ref), or next ^= G(prev, ref) if |with_xor| is set */
+static void fill_block(const ARGON2_BLOCK *prev, const ARGON2_BLOCK *ref,
+                       ARGON2_BLOCK *next, int with_xor)
+{
+    uint64_t R[ARGON2_QWORDS_IN_BLOCK], T[ARGON2_QWORDS_IN_BLOCK];
+    size_t i;
+
+    for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++) {
+        R[i] = prev->v[i] ^ ref->v[i];
+        T[i] = with_xor ? R[i] ^ next->v[i] : R[i];
+    }
+    for (i = 0; i < 8; i++)
+        blamka_round(R + 16 * i, 2);
+    for (i = 0; i < 8; i++)
+        blamka_round(R + 2 * i, 16);
+    for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++)
+        next->v[i] = T[i] ^ R[i];
+}
+
+/* The next 128 reference positions of the data-independent addressing */
+static void next_addresses(const ARGON2_INSTANCE *inst, ARGON2_BLOCK *address,
+                           ARGON2_BLOCK *input, const ARGON2_BLOCK *zero)
+{
+    input->v[6]++;
+    inst->fill_block(zero, input, address, 0);
+    inst->fill_block(zero, address, address, 0);
+}
+
+/* Maps J1 to a block of the reference set of RFC 9106 section 3.4.2 */
+static uint32_t index_alpha(const ARGON2_INSTANCE *inst, uint32_t index,
+                            uint32_t j1, int same_lane)
+{
+    uint32_t area, start = 0;
+    uint64_t rel;
+
+    if (inst->pass == 0) {
+        if (inst->slice == 0)
+            area = index - 1;
+        else if (same_lane)
+            area = inst->slice * inst->segment_length + index - 1;
+        else
+            area = inst->slice * inst->segment_length - (index == 0);
+    } else {
+        if (same_lane)
+            area = inst->lane_length - inst->segment_length + index - 1;
+        else
+            area = inst->lane_length - inst->segment_length - (index == 0);
+        if (inst->slice != ARGON2_SYNC_POINTS - 1)
+            start = (inst->slice + 1) * inst->segment_length;
+    }
+
+    rel = ((uint64_t)j1 * j1) >> 32;
+    rel = area - 1 - ((area * rel) >> 32);
+    return (uint32_t)((start + rel) % inst->lane_length);
+}
+
+/*
+ * Fills the segment of lane |lane| in the current slice.  The segments of a
+ * slice only refer to blocks of the earlier slices in other lanes, so each
+ * one can go on a thread of its own.
+ */
+static int fill_segment(void *vinst, size_t lane)
+{
+    const ARGON2_INSTANCE *inst = vinst;
+    ARGON2_BLOCK address, input, zero;
+    ARGON2_BLOCK *curr, *ref;
+    uint64_t pseudo_rand;
+    uint32_t ref_lane, ref_index, start = 0, i, curr_offset, prev_offset;
+    int data_independent = inst->type == ARGON2_I
+        || (inst->type == ARGON2_ID && inst->pass == 0
+            && inst->slice < ARGON2_SYNC_POINTS / 2);
+    int with_xor = inst->version != ARGON2_VERSION_10 && inst->pass != 0;
+
+    if (data_independent) {
+        memset(&zero, 0, sizeof(zero));
+        memset(&input, 0, sizeof(input));
+        input.v[0] = inst->pass;
+        input.v[1] = lane;
+        input.v[2] = inst->slice;
+        input.v[3] = inst->memory_blocks;
+        input.v[4] = inst->passes;
+        input.v[5] = inst->type;
+    }
+
+    /* The first two blocks of every lane come from H0 */
+    if (inst->pass == 0 && inst->slice == 0) {
+        start = 2;
+        if (data_independent)
+            next_addresses(inst, &address, &input, &zero);
+    }
+
+    curr_offset = (uint32_t)lane * inst->lane_length
+        + inst->slice * inst->segment_length + start;
+    if (curr_offset % inst->lane_length == 0)
+        prev_offset = curr_offset + inst->lane_length - 1;
+    else
+        prev_offset = curr_offset - 1;
+
+    for (i = start; i < inst->segment_length;
+         i++, curr_offset++, prev_offset++) {
+        if (curr_offset % inst->lane_length == 1)
+            prev_offset = curr_offset - 1;
+
+        if (data_independent) {
+            if (i % ARGON2_ADDRESSES_IN_BLOCK == 0)
+                next_addresses(inst, &address, &input, &zero);
+            pseudo_rand = address.v[i % ARGON2_ADDRESSES_IN_BLOCK];
+        } else {
+            pseudo_rand = inst->memory[prev_offset].v[0];
+        }
+
+        if (inst->pass == 0 && inst->slice == 0)
+            ref_lane = (uint32_t)lane;
+        else
+            ref_lane = (uint32_t)((pseudo_rand >> 32) % inst->lanes);
+        ref_index = index_alpha(inst, i, (uint32_t)pseudo_rand,
+                                ref_lane == lane);
+
+        ref = inst->memory + (size_t)inst->lane_length * ref_lane + ref_index;
+        curr = inst->memory + curr_offset;
+        inst->fill_block(inst->memory + prev_offset, ref, curr, with_xor);
+    }
+
+    if (data_independent)
+        OPENSSL_cleanse(&address, sizeof(address));
+    return 1;
+}
+
+/*
+ * The memory is mapped on its own with transparent huge pages when it is
+ * large enough, which saves most of the TLB misses of the random reference
+ * block reads.  Anything else comes from the heap.
+ */
+static ARGON2_BLOCK *argon2_alloc(size_t len, size_t *maplen)
+{
+# if defined(ARGON2_HUGEPAGES)
+    if (len >= ARGON2_HUGEPAGE_SIZE) {
+        size_t map = (len + ARGON2_HUGEPAGE_SIZE - 1)
+            & ~(size_t)(ARGON2_HUGEPAGE_SIZE - 1);
+        unsigned char *raw, *p;
+        size_t head;
+
+        /* Map a huge page more than needed and trim it to an aligned one */
+        if (map <= SIZE_MAX - ARGON2_HUGEPAGE_SIZE
+                && (raw = mmap(NULL, map + ARGON2_HUGEPAGE_SIZE,
+                               PROT_READ | PROT_WRITE,
+                               MAP_PRIVATE | MAP_ANONYMOUS, -1, 0))
+                   != MAP_FAILED) {
+            head = (0 - (size_t)raw) & (ARGON2_HUGEPAGE_SIZE - 1);
+            p = raw + head;
+            if (head != 0)
+                munmap(raw, head);
+            munmap(p + map, ARGON2_HUGEPAGE_SIZE - head);
+            (void)madvise(p, map, MADV_HUGEPAGE);
+            *maplen = map;
+            return (ARGON2_BLOCK *)p;
+        }
+    }
+# endif
+    *maplen = 0;
+    return OPENSSL_malloc(len);
+}
+
+static void argon2_free(ARGON2_BLOCK *memory, size_t len, size_t maplen)
+{
+    if (memory == NULL)
+        return;
+    OPENSSL_cleanse(memory, len);
+# if defined(ARGON2_HUGEPAGES)
+    if (maplen != 0) {
+        munmap(memory, maplen);
+        return;
+    }
+# endif
+    OPENSSL_free(memory);
+}
+
+static ARGON2_FILL_BLOCK_FN argon2_get_fill_block(void)
+{
+# if defined(ARGON2_ASM)
+    unsigned int caps = argon2_x86_64_caps();
+
+    if ((caps & ARGON2_X86_64_VL) != 0)
+        return argon2_fill_block_avx512vl;
+    if ((caps & ARGON2_X86_64_AVX2) != 0)
+        return argon2_fill_block_avx2;
+# endif
+    return fill_block;
+}
+
+/* H0 of RFC 9106 section 3.2, followed by room for the lane and block */
+static void argon2_initial_hash(unsigned char *seed, const KDF_ARGON2 *ctx,
+                                size_t outlen)
+{
+    BLAKE2B_CTX c;
+    unsigned char v[4];
+    const uint32_t head[6] = {
+        ctx->lanes, (uint32_t)outlen, ctx->m_cost, ctx->t_cost,
+        ctx->version, (uint32_t)ctx->type
+    };
+    const struct {
+        const unsigned char *data;
+        size_t len;
+    } inputs[4] = {
+        { ctx->pass, ctx->pass_len },
+        { ctx->salt, ctx->salt_len },
+        { ctx->secret, ctx->secret_len },
+        { ctx->ad, ctx->ad_len }
+    };
+    size_t i;
+
+    blake2b_start(&c, ARGON2_PREHASH_DIGEST_LEN);
+    for (i = 0; i < OSSL_NELEM(head); i++) {
+        store32_le(v, head[i]);
+        ossl_blake2b_update(&c, v, sizeof(v));
+    }
+    for (i = 0; i < OSSL_NELEM(inputs); i++) {
+        store32_le(v, (uint32_t)inputs[i].len);
+        ossl_blake2b_update(&c, v, sizeof(v));
+        if (inputs[i].len != 0)
+            ossl_blake2b_update(&c, inputs[i].data, inputs[i].len);
+    }
+    ossl_blake2b_final(seed, &c);
+}
+
+static int argon2_derive(const KDF_ARGON2 *ctx, unsigned char *out,
+                         size_t outlen)
+{
+    ARGON2_INSTANCE inst;
+    ARGON2_BLOCK last;
+    unsigned char seed[ARGON2_PREHASH_SEED_LEN];
+    unsigned char bytes[ARGON2_BLOCK_SIZE];
+    size_t memlen, threads;
+    uint32_t l, i;
+    int ret = 0;
+
+    memset(&inst, 0, sizeof(inst));
+    inst.lanes = ctx->lanes;
+    inst.passes = ctx->t_cost;
+    inst.version = ctx->version;
+    inst.type = ctx->type;
+    inst.segment_length = ctx->m_cost / (ctx->lanes * ARGON2_SYNC_POINTS);
+    inst.lane_length = inst.segment_length * ARGON2_SYNC_POINTS;
+    inst.memory_blocks = inst.lane_length * ctx->lanes;
+    inst.fill_block = argon2_get_fill_block();
+
+    memlen = (size_t)inst.memory_blocks * sizeof(ARGON2_BLOCK);
+    if (memlen / sizeof(ARGON2_BLOCK) != inst.memory_blocks) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_MEMORY_SIZE);
+        return 0;
+    }
+    inst.memory = argon2_alloc(memlen, &inst.maplen);
+    if (inst.memory == NULL) {
+        ERR_raise(ERR_LIB_PROV, ERR_R_MALLOC_FAILURE);
+        return 0;
+    }
+
+    argon2_initial_hash(seed, ctx, outlen);
+    for (l = 0; l < inst.lanes; l++) {
+        for (i = 0; i < 2; i++) {
+            store32_le(seed + ARGON2_PREHASH_DIGEST_LEN, i);
+            store32_le(seed + ARGON2_PREHASH_DIGEST_LEN + 4, l);
+            blake2b_long(bytes, sizeof(bytes), seed, sizeof(seed));
+            block_from_bytes(&inst.memory[(size_t)l * inst.lane_length + i],
+                             bytes);
+        }
+    }
+
+    threads = ctx->threads < inst.lanes ? ctx->threads : inst.lanes;
+    for (inst.pass = 0; inst.pass < inst.passes; inst.pass++)
+        for (inst.slice = 0; inst.slice < ARGON2_SYNC_POINTS; inst.slice++)
+            if (!ossl_crypto_parallel_run(inst.lanes, threads,
+                                          fill_segment, &inst))
+                goto err;
+
+    /* The XOR of the last blocks of all lanes */
+    last = inst.memory[inst.lane_length - 1];
+    for (l = 1; l < inst.lanes; l++) {
+        const ARGON2_BLOCK *b =
+            &inst.memory[(size_t)l * inst.lane_length + inst.lane_length - 1];
+
+        for (i = 0; i < ARGON2_QWORDS_IN_BLOCK; i++)
+            last.v[i] ^= b->v[i];
+    }
+    block_to_bytes(bytes, &last);
+    blake2b_long(out, outlen, bytes, sizeof(bytes));
+    ret = 1;
+
+ err:
+    OPENSSL_cleanse(seed, sizeof(seed));
+    OPENSSL_cleanse(bytes, sizeof(bytes));
+    OPENSSL_cleanse(&last, sizeof(last));
+    argon2_free(inst.memory, memlen, inst.maplen);
+    return ret;
+}
+
+static int kdf_argon2_derive(void *vctx, unsigned char *key, size_t keylen,
+                             const OSSL_PARAM params[])
+{
+    KDF_ARGON2 *ctx = (KDF_ARGON2 *)vctx;
+
+    if (!ossl_prov_is_running() || !kdf_argon2_set_ctx_params(ctx, params))
+        return 0;
+
+    if (ctx->pass == NULL) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_MISSING_PASS);
+        return 0;
+    }
+    if (ctx->salt == NULL) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_MISSING_SALT);
+        return 0;
+    }
+    if (ctx->salt_len < ARGON2_MIN_SALT_LEN) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_SALT_LENGTH);
+        return 0;
+    }
+    if (keylen < ARGON2_MIN_OUTLEN || keylen > UINT32_MAX) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_KEY_LENGTH);
+        return 0;
+    }
+    /* Two blocks in every segment at least */
+    if (ctx->m_cost / ctx->lanes < 2 * ARGON2_SYNC_POINTS) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_MEMORY_SIZE);
+        return 0;
+    }
+
+    return argon2_derive(ctx, key, keylen);
+}
+
+static int kdf_argon2_set_ctx_params(void *vctx, const OSSL_PARAM params[])
+{
+    const OSSL_PARAM *p;
+    KDF_ARGON2 *ctx = vctx;
+    uint32_t u32_value;
+
+    if (params == NULL)
+        return 1;
+
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_PASSWORD)) != NULL)
+        if (!argon2_set_membuf(&ctx->pass, &ctx->pass_len, p))
+            return 0;
+
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_SALT)) != NULL)
+        if (!argon2_set_membuf(&ctx->salt, &ctx->salt_len, p))
+            return 0;
+
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_SECRET)) != NULL)
+        if (!argon2_set_membuf(&ctx->secret, &ctx->secret_len, p))
+            return 0;
+
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_ARGON2_AD))
+        != NULL)
+        if (!argon2_set_membuf(&ctx->ad, &ctx->ad_len, p))
+            return 0;
+
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_ITER)) != NULL) {
+        if (!OSSL_PARAM_get_uint32(p, &u32_value))
+            return 0;
+        if (u32_value < 1) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_ITERATION_COUNT);
+            return 0;
+        }
+        ctx->t_cost = u32_value;
+    }
+
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_ARGON2_LANES))
+        != NULL) {
+        if (!OSSL_PARAM_get_uint32(p, &u32_value))
+            return 0;
+        if (u32_value < ARGON2_MIN_LANES || u32_value > ARGON2_MAX_LANES) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_LANES);
+            return 0;
+        }
+        ctx->lanes = u32_value;
+    }
+
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_ARGON2_MEMCOST))
+        != NULL) {
+        if (!OSSL_PARAM_get_uint32(p, &u32_value))
+            return 0;
+        if (u32_value < 2 * ARGON2_SYNC_POINTS) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_MEMORY_SIZE);
+            return 0;
+        }
+        ctx->m_cost = u32_value;
+    }
+
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_ARGON2_VERSION))
+        != NULL) {
+        if (!OSSL_PARAM_get_uint32(p, &u32_value))
+            return 0;
+        if (u32_value != ARGON2_VERSION_10 && u32_value != ARGON2_VERSION_13) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_NOT_SUPPORTED);
+            return 0;
+        }
+        ctx->version = u32_value;
+    }
+
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_THREADS)) != NULL) {
+        if (!OSSL_PARAM_get_uint32(p, &u32_value))
+            return 0;
+        ctx->threads = u32_value > 0 ? u32_value : 1;
+    }
+    return 1;
+}
+
+static const OSSL_PARAM *kdf_argon2_settable_ctx_params(ossl_unused void *ctx,
+                                                        ossl_unused void *p_ctx)
+{
+    static const OSSL_PARAM known_settable_ctx_params[] = {
+        OSSL_PARAM_octet_string(OSSL_KDF_PARAM_PASSWORD, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_KDF_PARAM_SALT, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_KDF_PARAM_SECRET, NULL, 0),
+        OSSL_PARAM_octet_string(OSSL_KDF_PARAM_ARGON2_AD, NULL, 0),
+        OSSL_PARAM_uint32(OSSL_KDF_PARAM_ITER, NULL),
+        OSSL_PARAM_uint32(OSSL_KDF_PARAM_ARGON2_LANES, NULL),
+        OSSL_PARAM_uint32(OSSL_KDF_PARAM_ARGON2_MEMCOST, NULL),
+        OSSL_PARAM_uint32(OSSL_KDF_PARAM_ARGON2_VERSION, NULL),
+        OSSL_PARAM_uint32(OSSL_KDF_PARAM_THREADS, NULL),
+        OSSL_PARAM_END
+    };
+    return known_settable_ctx_params;
+}
+
+static int kdf_argon2_get_ctx_params(void *vctx, OSSL_PARAM params[])
+{
+    OSSL_PARAM *p;
+
+    if ((p = OSSL_PARAM_locate(params, OSSL_KDF_PARAM_SIZE)) != NULL)
+        return OSSL_PARAM_set_size_t(p, UINT32_MAX);
+    return -2;
+}
+
+static const OSSL_PARAM *kdf_argon2_gettable_ctx_params(ossl_unused void *ctx,
+                                                        ossl_unused void *p_ctx)
+{
+    static const OSSL_PARAM known_gettable_ctx_params[] = {
+        OSSL_PARAM_size_t(OSSL_KDF_PARAM_SIZE, NULL),
+        OSSL_PARAM_END
+    };
+    return known_gettable_ctx_params;
+}
+
+# define ARGON2_FUNCTIONS(alg)                                                 \
+const OSSL_DISPATCH ossl_kdf_##alg##_functions[] = {                           \
+    { OSSL_FUNC_KDF_NEWCTX, (void(*)(void))kdf_##alg##_new },                  \
+    { OSSL_FUNC_KDF_FREECTX, (void(*)(void))kdf_argon2_free },                 \
+    { OSSL_FUNC_KDF_RESET, (void(*)(void))kdf_argon2_reset },                  \
+    { OSSL_FUNC_KDF_DERIVE, (void(*)(void))kdf_argon2_derive },                \
+    { OSSL_FUNC_KDF_SETTABLE_CTX_PARAMS,                                       \
+      (void(*)(void))kdf_argon2_settable_ctx_params },                         \
+    { OSSL_FUNC_KDF_SET_CTX_PARAMS, (void(*)(void))kdf_argon2_set_ctx_params },\
+    { OSSL_FUNC_KDF_GETTABLE_CTX_PARAMS,                                       \
+      (void(*)(void))kdf_argon2_gettable_ctx_params },                         \
+    { OSSL_FUNC_KDF_GET_CTX_PARAMS, (void(*)(void))kdf_argon2_get_ctx_params },\
+    { 0, NULL }                                                                \
+}
+
+ARGON2_FUNCTIONS(argon2d);
+ARGON2_FUNCTIONS(argon2i);
+ARGON2_FUNCTIONS(argon2id);
+
+#endif
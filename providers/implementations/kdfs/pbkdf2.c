@@ -23,7 +23,9 @@
 #include <openssl/proverr.h>
 #include "internal/cryptlib.h"
 #include "internal/numbers.h"
+#include "internal/provider.h"
 #include "crypto/evp.h"
+#include "crypto/sha.h"
 #include "prov/provider_ctx.h"
 #include "prov/providercommon.h"
 #include "prov/implementations.h"
@@ -36,6 +38,9 @@
 #define KDF_PBKDF2_MIN_ITERATIONS 1000
 #define KDF_PBKDF2_MIN_SALT_LEN   (128 / 8)
 
+/* Output blocks derived side by side by the multi-lane HMAC code */
+#define KDF_PBKDF2_LANES 8
+
 static OSSL_FUNC_kdf_newctx_fn kdf_pbkdf2_new;
 static OSSL_FUNC_kdf_freectx_fn kdf_pbkdf2_free;
 static OSSL_FUNC_kdf_reset_fn kdf_pbkdf2_reset;
@@ -45,10 +50,11 @@ static OSSL_FUNC_kdf_set_ctx_params_fn kdf_pbkdf2_set_ctx_params;
 static OSSL_FUNC_kdf_gettable_ctx_params_fn kdf_pbkdf2_gettable_ctx_params;
 static OSSL_FUNC_kdf_get_ctx_params_fn kdf_pbkdf2_get_ctx_params;
 
-static int  pbkdf2_derive(const char *pass, size_t passlen,
+static int  pbkdf2_derive(void *provctx, const char *pass, size_t passlen,
                           const unsigned char *salt, int saltlen, uint64_t iter,
                           const EVP_MD *digest, unsigned char *key,
-                          size_t keylen, int extra_checks);
+                          size_t keylen, int extra_checks,
+                          uint32_t threads);
 
 typedef struct {
     void *provctx;
@@ -59,6 +65,7 @@ typedef struct {
     uint64_t iter;
     PROV_DIGEST digest;
     int lower_bound_checks;
+    uint32_t threads;
 } KDF_PBKDF2;
 
 static void kdf_pbkdf2_init(KDF_PBKDF2 *ctx);
@@ -120,6 +127,7 @@ static void kdf_pbkdf2_init(KDF_PBKDF2 *ctx)
         ossl_prov_digest_reset(&ctx->digest);
     ctx->iter = PKCS5_DEFAULT_ITER;
     ctx->lower_bound_checks = ossl_kdf_pbkdf2_default_checks;
+    ctx->threads = 1;
 }
 
 static int pbkdf2_set_membuf(unsigned char **buffer, size_t *buflen,
@@ -159,9 +167,10 @@ static int kdf_pbkdf2_derive(void *vctx, unsigned char *key, size_t keylen,
     }
 
     md = ossl_prov_digest_md(&ctx->digest);
-    return pbkdf2_derive((char *)ctx->pass, ctx->pass_len,
+    return pbkdf2_derive(ctx->provctx, (char *)ctx->pass, ctx->pass_len,
                          ctx->salt, ctx->salt_len, ctx->iter,
-                         md, key, keylen, ctx->lower_bound_checks);
+                         md, key, keylen, ctx->lower_bound_checks,
+                         ctx->threads);
 }
 
 static int kdf_pbkdf2_set_ctx_params(void *vctx, const OSSL_PARAM params[])
@@ -171,6 +180,9 @@ static int kdf_pbkdf2_set_ctx_params(void *vctx, const OSSL_PARAM params[])
     OSSL_LIB_CTX *provctx = PROV_LIBCTX_OF(ctx->provctx);
     int pkcs5;
     uint64_t iter, min_iter;
+#ifndef FIPS_MODULE
+    uint32_t threads;
+#endif
 
     if (params == NULL)
         return 1;
@@ -208,6 +220,14 @@ static int kdf_pbkdf2_set_ctx_params(void *vctx, const OSSL_PARAM params[])
         }
         ctx->iter = iter;
     }
+
+#ifndef FIPS_MODULE
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_THREADS)) != NULL) {
+        if (!OSSL_PARAM_get_uint32(p, &threads))
+            return 0;
+        ctx->threads = threads > 0 ? threads : 1;
+    }
+#endif
     return 1;
 }
 
@@ -221,6 +241,9 @@ static const OSSL_PARAM *kdf_pbkdf2_settable_ctx_params(ossl_unused void *ctx,
         OSSL_PARAM_octet_string(OSSL_KDF_PARAM_SALT, NULL, 0),
         OSSL_PARAM_uint64(OSSL_KDF_PARAM_ITER, NULL),
         OSSL_PARAM_int(OSSL_KDF_PARAM_PKCS5, NULL),
+#ifndef FIPS_MODULE
+        OSSL_PARAM_uint32(OSSL_KDF_PARAM_THREADS, NULL),
+#endif
         OSSL_PARAM_END
     };
     return known_settable_ctx_params;
@@ -259,69 +282,93 @@ const OSSL_DISPATCH ossl_kdf_pbkdf2_functions[] = {
     { 0, NULL }
 };
 
+typedef int pbkdf2_many_fn(const unsigned char *pass, size_t passlen,
+                           const unsigned char *salt, size_t saltlen,
+                           uint64_t iter, uint32_t first, size_t num,
+                           unsigned char *out);
+
 /*
- * This is an implementation of PKCS#5 v2.0 password based encryption key
- * derivation function PBKDF2. SHA1 version verified against test vectors
- * posted by Peter Gutmann to the PKCS-TNG mailing list.
- *
- * The constraints specified by SP800-132 have been added i.e.
- *  - Check the range of the key length.
- *  - Minimum iteration count of 1000.
- *  - Randomly-generated portion of the salt shall be at least 128 bits.
+ * The output blocks are independent of each other, so they are handed out in
+ * shares of |group| blocks, which may be derived on separate threads.
  */
-static int pbkdf2_derive(const char *pass, size_t passlen,
-                         const unsigned char *salt, int saltlen, uint64_t iter,
-                         const EVP_MD *digest, unsigned char *key,
-                         size_t keylen, int lower_bound_checks)
+typedef struct {
+    const char *pass;
+    size_t passlen;
+    const unsigned char *salt;
+    int saltlen;
+    uint64_t iter;
+    const EVP_MD *digest;
+    pbkdf2_many_fn *many;       /* multi-lane HMAC for the digest, or NULL */
+    unsigned char *key;
+    size_t keylen;
+    size_t mdlen;
+    size_t group;
+} PBKDF2_JOB;
+
+/*
+ * Returns the multi-lane HMAC code for |digest| if it can be used here.  It
+ * takes the place of |digest|, so that has to be our own implementation and
+ * not one from another provider.  The FIPS provider never uses it.
+ */
+static pbkdf2_many_fn *pbkdf2_get_many(void *provctx, const EVP_MD *digest)
+{
+    pbkdf2_many_fn *many = NULL;
+#ifndef FIPS_MODULE
+    const OSSL_PROVIDER *prov = EVP_MD_get0_provider(digest);
+
+    if (prov == NULL || ossl_provider_ctx(prov) != provctx)
+        return NULL;
+    if (EVP_MD_is_a(digest, "SHA1"))
+        many = ossl_sha1_pbkdf2_many;
+    else if (EVP_MD_is_a(digest, "SHA2-256"))
+        many = ossl_sha256_pbkdf2_many;
+    else if (EVP_MD_is_a(digest, "SHA2-224"))
+        many = ossl_sha224_pbkdf2_many;
+    /* Without any blocks to derive this only checks for the SIMD code */
+    if (many != NULL && !many(NULL, 0, NULL, 0, 1, 1, 0, NULL))
+        many = NULL;
+#endif
+    return many;
+}
+
+/* Derives share |n| of the output blocks */
+static int pbkdf2_share(void *vjob, size_t n)
 {
+    PBKDF2_JOB *job = vjob;
     int ret = 0;
-    unsigned char digtmp[EVP_MAX_MD_SIZE], *p, itmp[4];
-    int cplen, k, tkeylen, mdlen;
+    unsigned char digtmp[EVP_MAX_MD_SIZE * KDF_PBKDF2_LANES], *p, itmp[4];
+    size_t cplen, k, tkeylen;
     uint64_t j;
-    unsigned long i = 1;
+    unsigned long i = (unsigned long)(n * job->group) + 1;
     HMAC_CTX *hctx_tpl = NULL, *hctx = NULL;
 
-    mdlen = EVP_MD_get_size(digest);
-    if (mdlen <= 0)
-        return 0;
-
-    /*
-     * This check should always be done because keylen / mdlen >= (2^32 - 1)
-     * results in an overflow of the loop counter 'i'.
-     */
-    if ((keylen / mdlen) >= KDF_PBKDF2_MAX_KEY_LEN_DIGEST_RATIO) {
-        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_KEY_LENGTH);
-        return 0;
-    }
+    p = job->key + n * job->group * job->mdlen;
+    tkeylen = job->keylen - n * job->group * job->mdlen;
+    if (tkeylen > job->group * job->mdlen)
+        tkeylen = job->group * job->mdlen;
 
-    if (lower_bound_checks) {
-        if ((keylen * 8) < KDF_PBKDF2_MIN_KEY_LEN_BITS) {
-            ERR_raise(ERR_LIB_PROV, PROV_R_KEY_SIZE_TOO_SMALL);
-            return 0;
-        }
-        if (saltlen < KDF_PBKDF2_MIN_SALT_LEN) {
-            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_SALT_LENGTH);
-            return 0;
-        }
-        if (iter < KDF_PBKDF2_MIN_ITERATIONS) {
-            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_ITERATION_COUNT);
+    if (job->many != NULL) {
+        /* group is at most KDF_PBKDF2_LANES here */
+        if (!job->many((const unsigned char *)job->pass, job->passlen,
+                       job->salt, job->saltlen, job->iter, (uint32_t)i,
+                       (tkeylen + job->mdlen - 1) / job->mdlen, digtmp))
             return 0;
-        }
+        memcpy(p, digtmp, tkeylen);
+        OPENSSL_cleanse(digtmp, sizeof(digtmp));
+        return 1;
     }
 
     hctx_tpl = HMAC_CTX_new();
     if (hctx_tpl == NULL)
         return 0;
-    p = key;
-    tkeylen = keylen;
-    if (!HMAC_Init_ex(hctx_tpl, pass, passlen, digest, NULL))
+    if (!HMAC_Init_ex(hctx_tpl, job->pass, job->passlen, job->digest, NULL))
         goto err;
     hctx = HMAC_CTX_new();
     if (hctx == NULL)
         goto err;
     while (tkeylen) {
-        if (tkeylen > mdlen)
-            cplen = mdlen;
+        if (tkeylen > job->mdlen)
+            cplen = job->mdlen;
         else
             cplen = tkeylen;
         /*
@@ -334,15 +381,15 @@ static int pbkdf2_derive(const char *pass, size_t passlen,
         itmp[3] = (unsigned char)(i & 0xff);
         if (!HMAC_CTX_copy(hctx, hctx_tpl))
             goto err;
-        if (!HMAC_Update(hctx, salt, saltlen)
+        if (!HMAC_Update(hctx, job->salt, job->saltlen)
                 || !HMAC_Update(hctx, itmp, 4)
                 || !HMAC_Final(hctx, digtmp, NULL))
             goto err;
         memcpy(p, digtmp, cplen);
-        for (j = 1; j < iter; j++) {
+        for (j = 1; j < job->iter; j++) {
             if (!HMAC_CTX_copy(hctx, hctx_tpl))
                 goto err;
-            if (!HMAC_Update(hctx, digtmp, mdlen)
+            if (!HMAC_Update(hctx, digtmp, job->mdlen)
                     || !HMAC_Final(hctx, digtmp, NULL))
                 goto err;
             for (k = 0; k < cplen; k++)
@@ -355,7 +402,84 @@ static int pbkdf2_derive(const char *pass, size_t passlen,
     ret = 1;
 
 err:
+    OPENSSL_cleanse(digtmp, sizeof(digtmp));
     HMAC_CTX_free(hctx);
     HMAC_CTX_free(hctx_tpl);
     return ret;
 }
+
+/*
+ * This is an implementation of PKCS#5 v2.0 password based encryption key
+ * derivation function PBKDF2. SHA1 version verified against test vectors
+ * posted by Peter Gutmann to the PKCS-TNG mailing list.
+ *
+ * The constraints specified by SP800-132 have been added i.e.
+ *  - Check the range of the key length.
+ *  - Minimum iteration count of 1000.
+ *  - Randomly-generated portion of the salt shall be at least 128 bits.
+ */
+static int pbkdf2_derive(void *provctx, const char *pass, size_t passlen,
+                         const unsigned char *salt, int saltlen, uint64_t iter,
+                         const EVP_MD *digest, unsigned char *key,
+                         size_t keylen, int lower_bound_checks,
+                         uint32_t threads)
+{
+    PBKDF2_JOB job;
+    size_t nblocks;
+    int mdlen;
+
+    mdlen = EVP_MD_get_size(digest);
+    if (mdlen <= 0)
+        return 0;
+
+    /*
+     * This check should always be done because keylen / mdlen >= (2^32 - 1)
+     * results in an overflow of the loop counter 'i'.
+     */
+    if ((keylen / mdlen) >= KDF_PBKDF2_MAX_KEY_LEN_DIGEST_RATIO) {
+        ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_KEY_LENGTH);
+        return 0;
+    }
+
+    if (lower_bound_checks) {
+        if ((keylen * 8) < KDF_PBKDF2_MIN_KEY_LEN_BITS) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_KEY_SIZE_TOO_SMALL);
+            return 0;
+        }
+        if (saltlen < KDF_PBKDF2_MIN_SALT_LEN) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_SALT_LENGTH);
+            return 0;
+        }
+        if (iter < KDF_PBKDF2_MIN_ITERATIONS) {
+            ERR_raise(ERR_LIB_PROV, PROV_R_INVALID_ITERATION_COUNT);
+            return 0;
+        }
+    }
+
+    if (keylen == 0)
+        return 1;
+
+    /*
+     * The blocks are shared out over the threads.  With more than one, and
+     * with our SHA-1, SHA-224 and SHA-256, up to eight blocks go through the
+     * multi-lane HMAC together.
+     */
+    job.pass = pass;
+    job.passlen = passlen;
+    job.salt = salt;
+    job.saltlen = saltlen;
+    job.iter = iter;
+    job.digest = digest;
+    job.key = key;
+    job.keylen = keylen;
+    job.mdlen = mdlen;
+    nblocks = (keylen + mdlen - 1) / mdlen;
+    if (threads > nblocks)
+        threads = (uint32_t)nblocks;
+    job.many = threads > 1 ? pbkdf2_get_many(provctx, digest) : NULL;
+    job.group = (nblocks + threads - 1) / threads;
+    if (job.many != NULL && job.group > KDF_PBKDF2_LANES)
+        job.group = KDF_PBKDF2_LANES;
+    return ossl_crypto_parallel_run((nblocks + job.group - 1) / job.group,
+                                    threads, pbkdf2_share, &job);
+}
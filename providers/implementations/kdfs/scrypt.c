@@ -16,6 +16,7 @@
 #include <openssl/core_names.h>
 #include <openssl/proverr.h>
 #include "crypto/evp.h"
+#include "internal/cryptlib.h"
 #include "internal/numbers.h"
 #include "prov/implementations.h"
 #include "prov/provider_ctx.h"
@@ -36,8 +37,8 @@ static OSSL_FUNC_kdf_get_ctx_params_fn kdf_scrypt_get_ctx_params;
 static int scrypt_alg(const char *pass, size_t passlen,
                       const unsigned char *salt, size_t saltlen,
                       uint64_t N, uint64_t r, uint64_t p, uint64_t maxmem,
-                      unsigned char *key, size_t keylen, EVP_MD *sha256,
-                      OSSL_LIB_CTX *libctx, const char *propq);
+                      uint32_t threads, unsigned char *key, size_t keylen,
+                      EVP_MD *sha256, OSSL_LIB_CTX *libctx, const char *propq);
 
 typedef struct {
     OSSL_LIB_CTX *libctx;
@@ -49,6 +50,7 @@ typedef struct {
     uint64_t N;
     uint64_t r, p;
     uint64_t maxmem_bytes;
+    uint32_t threads;
     EVP_MD *sha256;
 } KDF_SCRYPT;
 
@@ -102,6 +104,7 @@ static void kdf_scrypt_init(KDF_SCRYPT *ctx)
     ctx->r = 8;
     ctx->p = 1;
     ctx->maxmem_bytes = 1025 * 1024 * 1024;
+    ctx->threads = 1;
 }
 
 static int scrypt_set_membuf(unsigned char **buffer, size_t *buflen,
@@ -170,8 +173,8 @@ static int kdf_scrypt_derive(void *vctx, unsigned char *key, size_t keylen,
 
     return scrypt_alg((char *)ctx->pass, ctx->pass_len, ctx->salt,
                       ctx->salt_len, ctx->N, ctx->r, ctx->p,
-                      ctx->maxmem_bytes, key, keylen, ctx->sha256,
-                      ctx->libctx, ctx->propq);
+                      ctx->maxmem_bytes, ctx->threads, key, keylen,
+                      ctx->sha256, ctx->libctx, ctx->propq);
 }
 
 static int is_power_of_two(uint64_t value)
@@ -184,6 +187,7 @@ static int kdf_scrypt_set_ctx_params(void *vctx, const OSSL_PARAM params[])
     const OSSL_PARAM *p;
     KDF_SCRYPT *ctx = vctx;
     uint64_t u64_value;
+    uint32_t u32_value;
 
     if (params == NULL)
         return 1;
@@ -226,6 +230,12 @@ static int kdf_scrypt_set_ctx_params(void *vctx, const OSSL_PARAM params[])
         ctx->maxmem_bytes = u64_value;
     }
 
+    if ((p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_THREADS)) != NULL) {
+        if (!OSSL_PARAM_get_uint32(p, &u32_value))
+            return 0;
+        ctx->threads = u32_value > 0 ? u32_value : 1;
+    }
+
     p = OSSL_PARAM_locate_const(params, OSSL_KDF_PARAM_PROPERTIES);
     if (p != NULL) {
         if (p->data_type != OSSL_PARAM_UTF8_STRING
@@ -246,6 +256,7 @@ static const OSSL_PARAM *kdf_scrypt_settable_ctx_params(ossl_unused void *ctx,
         OSSL_PARAM_uint32(OSSL_KDF_PARAM_SCRYPT_R, NULL),
         OSSL_PARAM_uint32(OSSL_KDF_PARAM_SCRYPT_P, NULL),
         OSSL_PARAM_uint64(OSSL_KDF_PARAM_SCRYPT_MAXMEM, NULL),
+        OSSL_PARAM_uint32(OSSL_KDF_PARAM_THREADS, NULL),
         OSSL_PARAM_utf8_string(OSSL_KDF_PARAM_PROPERTIES, NULL, 0),
         OSSL_PARAM_END
     };
@@ -385,6 +396,31 @@ static void scryptROMix(unsigned char *B, uint64_t r, uint64_t N,
     }
 }
 
+/*
+ * The p ROMix lanes are independent of each other.  Each share is a run of
+ * them, hashed with a scratch area of its own so shares can go on separate
+ * threads.
+ */
+typedef struct {
+    unsigned char *B;
+    unsigned char *scratch;     /* |shares| areas of |Vlen| bytes */
+    uint64_t N, r, p, Vlen;
+    size_t shares;
+} SCRYPT_JOB;
+
+static int scrypt_share(void *vjob, size_t n)
+{
+    SCRYPT_JOB *job = vjob;
+    uint32_t *X = (uint32_t *)(job->scratch + n * job->Vlen);
+    uint32_t *T = X + 32 * job->r;
+    uint32_t *V = T + 32 * job->r;
+    uint64_t i;
+
+    for (i = n * job->p / job->shares; i < (n + 1) * job->p / job->shares; i++)
+        scryptROMix(job->B + 128 * job->r * i, job->r, job->N, X, T, V);
+    return 1;
+}
+
 #ifndef SIZE_MAX
 # define SIZE_MAX    ((size_t)-1)
 #endif
@@ -408,12 +444,12 @@ static void scryptROMix(unsigned char *B, uint64_t r, uint64_t N,
 static int scrypt_alg(const char *pass, size_t passlen,
                       const unsigned char *salt, size_t saltlen,
                       uint64_t N, uint64_t r, uint64_t p, uint64_t maxmem,
-                      unsigned char *key, size_t keylen, EVP_MD *sha256,
-                      OSSL_LIB_CTX *libctx, const char *propq)
+                      uint32_t threads, unsigned char *key, size_t keylen,
+                      EVP_MD *sha256, OSSL_LIB_CTX *libctx, const char *propq)
 {
     int rv = 0;
     unsigned char *B;
-    uint32_t *X, *V, *T;
+    SCRYPT_JOB job;
     uint64_t i, Blen, Vlen;
 
     /* Sanity check parameters */
@@ -485,20 +521,34 @@ static int scrypt_alg(const char *pass, size_t passlen,
     if (key == NULL)
         return 1;
 
-    B = OPENSSL_malloc((size_t)(Blen + Vlen));
+    /*
+     * Every thread needs its own V, X and T, so use no more threads than
+     * there are lanes, or than there is memory for.
+     */
+    job.shares = threads;
+    if (job.shares > OSSL_CRYPTO_PARALLEL_MAX_THREADS)
+        job.shares = OSSL_CRYPTO_PARALLEL_MAX_THREADS;
+    if (job.shares > p)
+        job.shares = (size_t)p;
+    if (job.shares > (maxmem - Blen) / Vlen)
+        job.shares = (size_t)((maxmem - Blen) / Vlen);
+
+    B = OPENSSL_malloc((size_t)(Blen + job.shares * Vlen));
     if (B == NULL) {
         ERR_raise(ERR_LIB_EVP, ERR_R_MALLOC_FAILURE);
         return 0;
     }
-    X = (uint32_t *)(B + Blen);
-    T = X + 32 * r;
-    V = T + 32 * r;
     if (ossl_pkcs5_pbkdf2_hmac_ex(pass, passlen, salt, saltlen, 1, sha256,
                                   (int)Blen, B, libctx, propq) == 0)
         goto err;
 
-    for (i = 0; i < p; i++)
-        scryptROMix(B + 128 * r * i, r, N, X, T, V);
+    job.B = B;
+    job.scratch = B + Blen;
+    job.N = N;
+    job.r = r;
+    job.p = p;
+    job.Vlen = Vlen;
+    ossl_crypto_parallel_run(job.shares, job.shares, scrypt_share, &job);
 
     if (ossl_pkcs5_pbkdf2_hmac_ex(pass, passlen, B, (int)Blen, 1, sha256,
                                   keylen, key, libctx, propq) == 0)
@@ -508,7 +558,7 @@ static int scrypt_alg(const char *pass, size_t passlen,
     if (rv == 0)
         ERR_raise(ERR_LIB_EVP, EVP_R_PBKDF2_ERROR);
 
-    OPENSSL_clear_free(B, (size_t)(Blen + Vlen));
+    OPENSSL_clear_free(B, (size_t)(Blen + job.shares * Vlen));
     return rv;
 }
 
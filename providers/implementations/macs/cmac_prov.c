@@ -46,6 +46,7 @@ struct cmac_data_st {
     void *provctx;
     CMAC_CTX *ctx;
     PROV_CIPHER cipher;
+    int keyed;                  /* The subkeys in |ctx| are ready for use */
 };
 
 static void *cmac_new(void *provctx)
@@ -93,6 +94,7 @@ static void *cmac_dup(void *vsrc)
         cmac_free(dst);
         return NULL;
     }
+    dst->keyed = src->keyed;
     return dst;
 }
 
@@ -110,6 +112,7 @@ static int cmac_setkey(struct cmac_data_st *macctx,
                        ossl_prov_cipher_cipher(&macctx->cipher),
                        ossl_prov_cipher_engine(&macctx->cipher));
     ossl_prov_cipher_reset(&macctx->cipher);
+    macctx->keyed = rv;
     return rv;
 }
 
@@ -122,6 +125,12 @@ static int cmac_init(void *vmacctx, const unsigned char *key,
         return 0;
     if (key != NULL)
         return cmac_setkey(macctx, key, keylen);
+    /*
+     * Without a new key or cipher, restart with the subkeys derived when the
+     * key was set
+     */
+    if (macctx->keyed && ossl_prov_cipher_cipher(&macctx->cipher) == NULL)
+        return CMAC_Init(macctx->ctx, NULL, 0, NULL, NULL);
     return 1;
 }
 
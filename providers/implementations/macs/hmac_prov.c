@@ -147,6 +147,25 @@ static int hmac_block_size(struct hmac_data_st *macctx)
     return EVP_MD_block_size(md);
 }
 
+/*
+ * The inner and outer pad digests of the current key are kept in the
+ * HMAC_CTX, so a new computation with the same key and digest only has to
+ * copy the inner state rather than hash both pads again.
+ */
+static int hmac_key_is_current(struct hmac_data_st *macctx,
+                               const unsigned char *key, size_t keylen)
+{
+    const EVP_MD *digest = ossl_prov_digest_md(&macctx->digest);
+
+    return macctx->key != NULL
+           && macctx->tls_data_size == 0
+           && digest != NULL
+           && digest == HMAC_CTX_get_md(macctx->ctx)
+           && (key == NULL
+               || (keylen == macctx->keylen
+                   && CRYPTO_memcmp(key, macctx->key, keylen) == 0));
+}
+
 static int hmac_setkey(struct hmac_data_st *macctx,
                        const unsigned char *key, size_t keylen)
 {
@@ -163,9 +182,15 @@ static int hmac_setkey(struct hmac_data_st *macctx,
 
     digest = ossl_prov_digest_md(&macctx->digest);
     /* HMAC_Init_ex doesn't tolerate all zero params, so we must be careful */
-    if (key != NULL || (macctx->tls_data_size == 0 && digest != NULL))
-        return HMAC_Init_ex(macctx->ctx, key, keylen, digest,
-                            ossl_prov_digest_engine(&macctx->digest));
+    if ((key != NULL || (macctx->tls_data_size == 0 && digest != NULL))
+        && !HMAC_Init_ex(macctx->ctx, key, keylen, digest,
+                         ossl_prov_digest_engine(&macctx->digest))) {
+        /* Don't let a later init mistake the pads for this key's */
+        OPENSSL_secure_clear_free(macctx->key, macctx->keylen);
+        macctx->key = NULL;
+        macctx->keylen = 0;
+        return 0;
+    }
     return 1;
 }
 
@@ -177,6 +202,9 @@ static int hmac_init(void *vmacctx, const unsigned char *key,
     if (!ossl_prov_is_running() || !hmac_set_ctx_params(macctx, params))
         return 0;
 
+    /* Restart from the precomputed pads if the key hasn't changed */
+    if (hmac_key_is_current(macctx, key, keylen))
+        return HMAC_Init_ex(macctx->ctx, NULL, 0, NULL, NULL);
     if (key != NULL && !hmac_setkey(macctx, key, keylen))
         return 0;
     return 1;
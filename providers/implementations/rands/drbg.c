@@ -112,6 +112,15 @@ static unsigned int get_parent_reseed_count(PROV_DRBG *drbg)
     void *parent = drbg->parent;
     unsigned int r = 0;
 
+    /*
+     * A parent that locks with ossl_drbg_lock() is a PROV_DRBG from this
+     * provider.  Its reseed counter is only ever accessed atomically, so it
+     * can be read without taking the parent's lock, which is shared by all
+     * the per-thread children of the primary DRBG.
+     */
+    if (drbg->parent_lock == ossl_drbg_lock)
+        return tsan_load(&((PROV_DRBG *)parent)->reseed_counter);
+
     *params = OSSL_PARAM_construct_uint(OSSL_DRBG_PARAM_RESEED_COUNTER, &r);
     if (!ossl_drbg_lock_parent(drbg)) {
         ERR_raise(ERR_LIB_PROV, PROV_R_UNABLE_TO_LOCK_PARENT);
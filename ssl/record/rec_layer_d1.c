@@ -15,12 +15,13 @@
 #include "record_local.h"
 #include "internal/packet.h"
 #include "internal/cryptlib.h"
+#include "internal/sockets.h"
 
 int DTLS_RECORD_LAYER_new(RECORD_LAYER *rl)
 {
     DTLS_RECORD_LAYER *d;
 
-    if ((d = OPENSSL_malloc(sizeof(*d))) == NULL) {
+    if ((d = OPENSSL_zalloc(sizeof(*d))) == NULL) {
         ERR_raise(ERR_LIB_SSL, ERR_R_MALLOC_FAILURE);
         return 0;
     }
@@ -65,6 +66,7 @@ void DTLS_RECORD_LAYER_clear(RECORD_LAYER *rl)
     pqueue *unprocessed_rcds;
     pqueue *processed_rcds;
     pqueue *buffered_app_data;
+    size_t i;
 
     d = rl->d;
 
@@ -93,6 +95,10 @@ void DTLS_RECORD_LAYER_clear(RECORD_LAYER *rl)
         pitem_free(item);
     }
 
+    OPENSSL_free(d->dgram_buf);
+    for (i = 0; i < DTLS1_DGRAM_BATCH; i++)
+        BIO_ADDR_free(d->dgram_peers[i]);
+
     unprocessed_rcds = d->unprocessed_rcds.q;
     processed_rcds = d->processed_rcds.q;
     buffered_app_data = d->buffered_app_data.q;
@@ -311,6 +317,101 @@ int dtls1_process_buffered_records(SSL *s)
     return 1;
 }
 
+/*
+ * Receive up to DTLS1_DGRAM_BATCH datagrams of at most |len| bytes each with
+ * a single BIO_recvmmsg().  Returns 1 on success, 0 if the read BIO doesn't
+ * support batched reads and -1 on error or if the read should be retried.
+ */
+static int dtls1_recv_datagrams(SSL *s, size_t len)
+{
+    DTLS_RECORD_LAYER *d = s->rlayer.d;
+    BIO_MSG *m;
+    size_t i;
+
+    if (d->dgram_buf != NULL && d->dgram_len != len) {
+        OPENSSL_free(d->dgram_buf);
+        d->dgram_buf = NULL;
+    }
+    if (d->dgram_buf == NULL) {
+        if ((d->dgram_buf = OPENSSL_malloc(DTLS1_DGRAM_BATCH * len)) == NULL) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_MALLOC_FAILURE);
+            return -1;
+        }
+        d->dgram_len = len;
+    }
+    for (i = 0; i < DTLS1_DGRAM_BATCH; i++) {
+        if (d->dgram_peers[i] == NULL
+                && (d->dgram_peers[i] = BIO_ADDR_new()) == NULL) {
+            SSLfatal(s, SSL_AD_INTERNAL_ERROR, ERR_R_MALLOC_FAILURE);
+            return -1;
+        }
+        m = &d->dgrams[i];
+        m->data = d->dgram_buf + i * len;
+        m->data_len = len;
+        m->peer = d->dgram_peers[i];
+        m->flags = 0;
+    }
+
+    d->next_dgram = d->num_dgrams = 0;
+    ERR_set_mark();
+    if (!BIO_recvmmsg(s->rbio, d->dgrams, sizeof(d->dgrams[0]),
+                      DTLS1_DGRAM_BATCH, 0, &d->num_dgrams)) {
+        unsigned long err = ERR_peek_last_error();
+
+        if (ERR_GET_LIB(err) == ERR_LIB_BIO
+                && ERR_GET_REASON(err) == BIO_R_UNSUPPORTED_METHOD) {
+            ERR_pop_to_mark();
+            return 0;
+        }
+        ERR_clear_last_mark();
+        return -1;
+    }
+    ERR_clear_last_mark();
+    return 1;
+}
+
+/*
+ * Read the next datagram into |buf|, which has room for |len| bytes.  When
+ * read_ahead is set and the read BIO is a datagram socket, datagrams are
+ * received in batches with BIO_recvmmsg() and handed out here one at a time;
+ * otherwise this is a plain BIO_read().  Whether the socket can do more than
+ * one datagram per system call is left to the BIO.  Return values are as for
+ * BIO_read().
+ */
+int dtls1_read_datagram(SSL *s, unsigned char *buf, size_t len)
+{
+    DTLS_RECORD_LAYER *d = s->rlayer.d;
+    BIO_MSG *m;
+    int ret;
+
+    for (;;) {
+        if (d->next_dgram == d->num_dgrams) {
+            if (!s->rlayer.read_ahead
+                    || BIO_method_type(s->rbio) != BIO_TYPE_DGRAM)
+                return BIO_read(s->rbio, buf, len);
+            if ((ret = dtls1_recv_datagrams(s, len)) == 0)
+                return BIO_read(s->rbio, buf, len);
+            if (ret < 0)
+                return ret;
+        }
+
+        m = &d->dgrams[d->next_dgram++];
+        /*
+         * A datagram that didn't fit can't hold a valid record, so drop it
+         * rather than parse what is left of it
+         */
+        if ((m->flags & BIO_MSG_TRUNCATED) != 0 || m->data_len > len)
+            continue;
+
+        /* Keep track of the peer the way BIO_read() on the socket does */
+        if (BIO_ADDR_family(m->peer) != AF_UNSPEC
+                && !BIO_dgram_get_connected(s->rbio))
+            (void)BIO_dgram_set_peer(s->rbio, m->peer);
+        memcpy(buf, m->data, m->data_len);
+        return (int)m->data_len;
+    }
+}
+
 /*-
  * Return up to 'len' payload bytes received in 'type' records.
  * 'type' is one of the following:
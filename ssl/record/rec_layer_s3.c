@@ -77,7 +77,8 @@ void RECORD_LAYER_release(RECORD_LAYER *rl)
 /* Checks if we have unprocessed read ahead data pending */
 int RECORD_LAYER_read_pending(const RECORD_LAYER *rl)
 {
-    return SSL3_BUFFER_get_left(&rl->rbuf) != 0;
+    return SSL3_BUFFER_get_left(&rl->rbuf) != 0
+           || (rl->d != NULL && rl->d->next_dgram < rl->d->num_dgrams);
 }
 
 /* Checks if we have decrypted unread record data pending */
@@ -295,7 +296,10 @@ int ssl3_read_n(SSL *s, size_t n, size_t max, int extend, int clearold,
         clear_sys_error();
         if (s->rbio != NULL) {
             s->rwstate = SSL_READING;
-            ret = BIO_read(s->rbio, pkt + len + left, max - left);
+            if (SSL_IS_DTLS(s))
+                ret = dtls1_read_datagram(s, pkt + len + left, max - left);
+            else
+                ret = BIO_read(s->rbio, pkt + len + left, max - left);
             if (ret >= 0)
                 bioread = ret;
             if (ret <= 0
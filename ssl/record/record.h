@@ -1,5 +1,5 @@
 /*
- * Copyright 1995-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 1995-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -31,6 +31,9 @@ typedef struct ssl3_buffer_st {
 
 #define SEQ_NUM_SIZE                            8
 
+/* Maximum number of datagrams DTLS reads ahead with one BIO_recvmmsg() */
+#define DTLS1_DGRAM_BATCH                       8
+
 typedef struct ssl3_record_st {
     /* Record layer version */
     /* r */
@@ -116,6 +119,17 @@ typedef struct dtls_record_layer_st {
     /* save last and current sequence numbers for retransmissions */
     unsigned char last_write_sequence[8];
     unsigned char curr_write_sequence[8];
+    /*
+     * Datagrams read ahead with BIO_recvmmsg(): |num_dgrams| of them were
+     * received into |dgram_buf|, the ones from |next_dgram| on have not been
+     * passed to the record layer yet
+     */
+    unsigned char *dgram_buf;
+    size_t dgram_len;
+    BIO_MSG dgrams[DTLS1_DGRAM_BATCH];
+    BIO_ADDR *dgram_peers[DTLS1_DGRAM_BATCH];
+    size_t next_dgram;
+    size_t num_dgrams;
 } DTLS_RECORD_LAYER;
 
 /*****************************************************************************
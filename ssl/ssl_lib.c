@@ -838,6 +838,7 @@ SSL *SSL_new(SSL_CTX *ctx)
 
     s->async_cb = ctx->async_cb;
     s->async_cb_arg = ctx->async_cb_arg;
+    s->async_queue = ctx->async_queue;
 
     s->job = NULL;
 
@@ -1691,6 +1692,8 @@ int SSL_get_changed_async_fds(SSL *s, OSSL_ASYNC_FD *addfd, size_t *numaddfds,
                                           numdelfds);
 }
 
+static int ssl_async_wait_ctx_cb(void *arg);
+
 int SSL_CTX_set_async_callback(SSL_CTX *ctx, SSL_async_callback_fn callback)
 {
     ctx->async_cb = callback;
@@ -1715,6 +1718,26 @@ int SSL_set_async_callback_arg(SSL *s, void *arg)
     return 1;
 }
 
+int SSL_CTX_set_async_queue(SSL_CTX *ctx, ASYNC_QUEUE *queue)
+{
+    ctx->async_queue = queue;
+    return 1;
+}
+
+int SSL_set_async_queue(SSL *s, ASYNC_QUEUE *queue)
+{
+    s->async_queue = queue;
+    if (s->waitctx == NULL)
+        return 1;
+    if (!ASYNC_WAIT_CTX_set_queue(s->waitctx, queue, s))
+        return 0;
+    /* Without a queue, completions go back to the async callback */
+    if (queue == NULL && s->async_cb != NULL)
+        return ASYNC_WAIT_CTX_set_callback(s->waitctx, ssl_async_wait_ctx_cb,
+                                           s);
+    return 1;
+}
+
 int SSL_get_async_status(SSL *s, int *status)
 {
     ASYNC_WAIT_CTX *ctx = s->waitctx;
@@ -1765,10 +1788,14 @@ static int ssl_start_async_job(SSL *s, struct ssl_async_args *args,
         s->waitctx = ASYNC_WAIT_CTX_new();
         if (s->waitctx == NULL)
             return -1;
-        if (s->async_cb != NULL
-            && !ASYNC_WAIT_CTX_set_callback
-                 (s->waitctx, ssl_async_wait_ctx_cb, s))
+        if (s->async_queue != NULL) {
+            if (!ASYNC_WAIT_CTX_set_queue(s->waitctx, s->async_queue, s))
+                return -1;
+        } else if (s->async_cb != NULL
+                   && !ASYNC_WAIT_CTX_set_callback
+                        (s->waitctx, ssl_async_wait_ctx_cb, s)) {
             return -1;
+        }
     }
     switch (ASYNC_start_job(&s->job, s->waitctx, &ret, func, args,
                             sizeof(struct ssl_async_args))) {
@@ -3285,6 +3312,8 @@ SSL_CTX *SSL_CTX_new_ex(OSSL_LIB_CTX *libctx, const char *propq,
         || (RAND_priv_bytes_ex(libctx, ret->ext.secure->tick_aes_key,
                                sizeof(ret->ext.secure->tick_aes_key), 0) <= 0))
         ret->options |= SSL_OP_NO_TICKET;
+    else if (!ssl_ctx_init_ticket_hmac(ret))
+        goto err;
 
     if (RAND_priv_bytes_ex(libctx, ret->ext.cookie_hmac_key,
                            sizeof(ret->ext.cookie_hmac_key), 0) <= 0)
@@ -3439,6 +3468,7 @@ void SSL_CTX_free(SSL_CTX *a)
     OPENSSL_free(a->ext.supportedgroups);
     OPENSSL_free(a->ext.supported_groups_default);
     OPENSSL_free(a->ext.alpn);
+    EVP_MAC_CTX_free(a->ext.tick_hmac_ctx);
     OPENSSL_secure_free(a->ext.secure);
 
     ssl_evp_md_free(a->md5);
@@ -805,6 +805,8 @@ HMAC_CTX *ssl_hmac_get0_HMAC_CTX(SSL_HMAC *ctx);
 # endif
 EVP_MAC_CTX *ssl_hmac_get0_EVP_MAC_CTX(SSL_HMAC *ctx);
 int ssl_hmac_init(SSL_HMAC *ctx, void *key, size_t len, char *md);
+int ssl_hmac_init_ticket(SSL_HMAC *ctx, SSL_CTX *tctx);
+int ssl_ctx_init_ticket_hmac(SSL_CTX *ctx);
 int ssl_hmac_update(SSL_HMAC *ctx, const unsigned char *data, size_t len);
 int ssl_hmac_final(SSL_HMAC *ctx, unsigned char *md, size_t *len,
                    size_t max_size);
@@ -1034,6 +1036,8 @@ struct ssl_ctx_st {
         /* RFC 4507 session ticket keys */
         unsigned char tick_key_name[TLSEXT_KEYNAME_LENGTH];
         SSL_CTX_EXT_SECURE *secure;
+        /* HMAC context keyed with secure->tick_hmac_key, copied per ticket */
+        EVP_MAC_CTX *tick_hmac_ctx;
 # ifndef OPENSSL_NO_DEPRECATED_3_0
         /* Callback to support customisation of ticket key setting */
         int (*ticket_key_cb) (SSL *ssl,
@@ -1179,6 +1183,7 @@ struct ssl_ctx_st {
     /* Callback for SSL async handling */
     SSL_async_callback_fn async_cb;
     void *async_cb_arg;
+    ASYNC_QUEUE *async_queue;
 
     char *propq;
 
@@ -1786,6 +1791,7 @@ struct ssl_st {
     /* Callback for SSL async handling */
     SSL_async_callback_fn async_cb;
     void *async_cb_arg;
+    ASYNC_QUEUE *async_queue;
 
     /*
      * Signature algorithms shared by client and server: cached because these
@@ -1867,9 +1867,7 @@ SSL_TICKET_STATUS tls_decrypt_ticket(SSL *s, const unsigned char *etick,
         aes256cbc = EVP_CIPHER_fetch(s->ctx->libctx, "AES-256-CBC",
                                      s->ctx->propq);
         if (aes256cbc == NULL
-            || ssl_hmac_init(hctx, tctx->ext.secure->tick_hmac_key,
-                             sizeof(tctx->ext.secure->tick_hmac_key),
-                             "SHA256") <= 0
+            || ssl_hmac_init_ticket(hctx, tctx) <= 0
             || EVP_DecryptInit_ex(ctx, aes256cbc, NULL,
                                   tctx->ext.secure->tick_aes_key,
                                   etick + TLSEXT_KEYNAME_LENGTH) <= 0) {
@@ -3387,6 +3385,9 @@ SSL_HMAC *ssl_hmac_new(const SSL_CTX *ctx)
         return ret;
     }
 #endif
+    /* With the default ticket keys ssl_hmac_init_ticket() sets up a context */
+    if (ctx->ext.ticket_key_evp_cb == NULL)
+        return ret;
     mac = EVP_MAC_fetch(ctx->libctx, "HMAC", ctx->propq);
     if (mac == NULL || (ret->ctx = EVP_MAC_CTX_new(mac)) == NULL)
         goto err;
@@ -3432,6 +3433,90 @@ int ssl_hmac_init(SSL_HMAC *ctx, void *key, size_t len, char *md)
     return 0;
 }
 
+/*
+ * Set up |ctx| for the default ticket keys of |tctx|, which doesn't involve
+ * any fetching or key setup if the keyed context is there to be copied.
+ * The keys may be replaced by another thread, so the copy is made under the
+ * lock of |tctx|.
+ */
+int ssl_hmac_init_ticket(SSL_HMAC *ctx, SSL_CTX *tctx)
+{
+    EVP_MAC_CTX *mctx = NULL;
+    EVP_MAC *mac;
+    int copied = 0;
+
+    if (!CRYPTO_THREAD_read_lock(tctx->lock))
+        return 0;
+    if (tctx->ext.tick_hmac_ctx != NULL) {
+        mctx = EVP_MAC_CTX_dup(tctx->ext.tick_hmac_ctx);
+        copied = 1;
+    }
+    CRYPTO_THREAD_unlock(tctx->lock);
+
+    if (copied) {
+        if (mctx == NULL)
+            return 0;
+        EVP_MAC_CTX_free(ctx->ctx);
+        ctx->ctx = mctx;
+        return 1;
+    }
+
+    /* No keyed context to copy, key one for this ticket */
+    if (ctx->ctx == NULL
+#ifndef OPENSSL_NO_DEPRECATED_3_0
+            && ctx->old_ctx == NULL
+#endif
+            ) {
+        mac = EVP_MAC_fetch(tctx->libctx, "HMAC", tctx->propq);
+        if (mac == NULL)
+            return 0;
+        ctx->ctx = EVP_MAC_CTX_new(mac);
+        EVP_MAC_free(mac);
+        if (ctx->ctx == NULL)
+            return 0;
+    }
+    return ssl_hmac_init(ctx, tctx->ext.secure->tick_hmac_key,
+                         sizeof(tctx->ext.secure->tick_hmac_key), "SHA256");
+}
+
+/*
+ * (Re)create the keyed ticket HMAC context after the ticket keys of |ctx|
+ * are set.  Failing to create it is not fatal, each ticket then keys its
+ * own context.  Tickets may be issued on |ctx| at the same time, so the old
+ * context is only replaced under the lock.
+ */
+int ssl_ctx_init_ticket_hmac(SSL_CTX *ctx)
+{
+    EVP_MAC *mac;
+    EVP_MAC_CTX *mctx = NULL, *old;
+    OSSL_PARAM params[2];
+
+    ERR_set_mark();
+    mac = EVP_MAC_fetch(ctx->libctx, "HMAC", ctx->propq);
+    if (mac != NULL && (mctx = EVP_MAC_CTX_new(mac)) != NULL) {
+        params[0] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST,
+                                                     "SHA256", 0);
+        params[1] = OSSL_PARAM_construct_end();
+        if (!EVP_MAC_init(mctx, ctx->ext.secure->tick_hmac_key,
+                          sizeof(ctx->ext.secure->tick_hmac_key), params)) {
+            EVP_MAC_CTX_free(mctx);
+            mctx = NULL;
+        }
+    }
+    EVP_MAC_free(mac);
+    ERR_pop_to_mark();
+
+    if (!CRYPTO_THREAD_write_lock(ctx->lock)) {
+        EVP_MAC_CTX_free(mctx);
+        return 0;
+    }
+    old = ctx->ext.tick_hmac_ctx;
+    ctx->ext.tick_hmac_ctx = mctx;
+    CRYPTO_THREAD_unlock(ctx->lock);
+    EVP_MAC_CTX_free(old);
+    return 1;
+}
+
 int ssl_hmac_update(SSL_HMAC *ctx, const unsigned char *data, size_t len)
 {
     if (ctx->ctx != NULL)
@@ -7,7 +7,9 @@
  * https://www.openssl.org/source/license.html
  */
 
+#include <string.h>
 #include <openssl/evp.h>
+#include "internal/nelem.h"
 #include "testutil.h"
 
 static const unsigned char gcm_key[] = {
@@ -116,6 +118,153 @@ static int badkeylen_test(void)
     return ret;
 }
 
+/*
+ * Run the KAT through EVP_CIPHER_CTX_aead_init() and the AEAD tag functions,
+ * reusing the same contexts for a second message to check that each call
+ * starts a fresh operation.
+ */
+static int aead_api_test(void)
+{
+    EVP_CIPHER_CTX *ectx = NULL, *dctx = NULL;
+    unsigned char ct[32], pt[32], tag[16], badtag[16];
+    int i, ctlen, ptlen, outlen, ret = 0;
+
+    memcpy(badtag, gcm_tag, sizeof(badtag));
+    badtag[0] ^= 1;
+
+    if (!TEST_ptr(ectx = EVP_CIPHER_CTX_new())
+        || !TEST_ptr(dctx = EVP_CIPHER_CTX_new())
+        || !TEST_true(EVP_EncryptInit_ex(ectx, EVP_aes_256_gcm(), NULL,
+                                         gcm_key, NULL))
+        || !TEST_true(EVP_DecryptInit_ex(dctx, EVP_aes_256_gcm(), NULL,
+                                         gcm_key, NULL)))
+        goto err;
+
+    for (i = 0; i < 2; i++) {
+        if (!TEST_true(EVP_CIPHER_CTX_aead_init(ectx, gcm_iv, sizeof(gcm_iv),
+                                                gcm_aad, sizeof(gcm_aad)))
+            || !TEST_true(EVP_EncryptUpdate(ectx, ct, &ctlen, gcm_pt,
+                                            sizeof(gcm_pt)))
+            || !TEST_true(EVP_EncryptFinal_ex(ectx, ct + ctlen, &outlen))
+            || !TEST_true(EVP_CIPHER_CTX_get_aead_tag(ectx, tag, sizeof(tag)))
+            || !TEST_mem_eq(gcm_ct, sizeof(gcm_ct), ct, ctlen + outlen)
+            || !TEST_mem_eq(gcm_tag, sizeof(gcm_tag), tag, sizeof(tag)))
+            goto err;
+
+        /* Tags can't be set when encrypting or fetched when decrypting */
+        if (!TEST_false(EVP_CIPHER_CTX_set_aead_tag(ectx, tag, sizeof(tag)))
+            || !TEST_false(EVP_CIPHER_CTX_get_aead_tag(dctx, tag, sizeof(tag))))
+            goto err;
+
+        if (!TEST_true(EVP_CIPHER_CTX_aead_init(dctx, gcm_iv, sizeof(gcm_iv),
+                                                gcm_aad, sizeof(gcm_aad)))
+            || !TEST_true(EVP_DecryptUpdate(dctx, pt, &ptlen, gcm_ct,
+                                            sizeof(gcm_ct)))
+            || !TEST_true(EVP_CIPHER_CTX_set_aead_tag(dctx, gcm_tag,
+                                                      sizeof(gcm_tag)))
+            || !TEST_true(EVP_DecryptFinal_ex(dctx, pt + ptlen, &outlen))
+            || !TEST_mem_eq(gcm_pt, sizeof(gcm_pt), pt, ptlen + outlen))
+            goto err;
+
+        if (!TEST_true(EVP_CIPHER_CTX_aead_init(dctx, gcm_iv, sizeof(gcm_iv),
+                                                gcm_aad, sizeof(gcm_aad)))
+            || !TEST_true(EVP_DecryptUpdate(dctx, pt, &ptlen, gcm_ct,
+                                            sizeof(gcm_ct)))
+            || !TEST_true(EVP_CIPHER_CTX_set_aead_tag(dctx, badtag,
+                                                      sizeof(badtag)))
+            || !TEST_false(EVP_DecryptFinal_ex(dctx, pt + ptlen, &outlen)))
+            goto err;
+    }
+    ret = 1;
+ err:
+    EVP_CIPHER_CTX_free(ectx);
+    EVP_CIPHER_CTX_free(dctx);
+    return ret;
+}
+
+/*
+ * EVP_CIPHER_CTX_aead_init() with an IV that isn't of the default length must
+ * give the same result as setting the IV length with a ctrl first.  CCM only
+ * takes its AAD once the message length is known, so that is fed separately.
+ */
+static const char *aead_ivlen_ciphers[] = { "AES-256-GCM", "AES-256-CCM" };
+static const size_t aead_ivlens[] = { 16, 12 };
+
+static int aead_crypt(EVP_CIPHER_CTX *ctx, int enc, int use_ctrl, int ccm,
+                      const unsigned char *iv, int ivlen,
+                      const unsigned char *in, int inl, unsigned char *out,
+                      unsigned char *tag, int taglen)
+{
+    int outl, tmpl;
+
+    if (use_ctrl) {
+        if (!TEST_int_gt(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_SET_IVLEN,
+                                             ivlen, NULL), 0)
+            || !TEST_true(EVP_CipherInit_ex(ctx, NULL, NULL, NULL, iv, enc)))
+            return 0;
+    } else if (!TEST_true(EVP_CIPHER_CTX_aead_init(ctx, iv, ivlen, NULL, 0))) {
+        return 0;
+    }
+    if (!enc && !TEST_true(EVP_CIPHER_CTX_set_aead_tag(ctx, tag, taglen)))
+        return 0;
+    if (ccm && !TEST_true(EVP_CipherUpdate(ctx, NULL, &outl, NULL, inl)))
+        return 0;
+    if (!TEST_true(EVP_CipherUpdate(ctx, NULL, &outl, gcm_aad,
+                                    sizeof(gcm_aad)))
+        || !TEST_true(EVP_CipherUpdate(ctx, out, &outl, in, inl))
+        || !TEST_int_eq(outl, inl))
+        return 0;
+    /* CCM has no final step when decrypting */
+    if (!ccm || enc) {
+        if (!TEST_true(EVP_CipherFinal_ex(ctx, out + outl, &tmpl))
+            || !TEST_int_eq(tmpl, 0))
+            return 0;
+    }
+    return !enc || TEST_true(EVP_CIPHER_CTX_get_aead_tag(ctx, tag, taglen));
+}
+
+static int aead_api_ivlen_test(int idx)
+{
+    EVP_CIPHER_CTX *rctx = NULL, *ectx = NULL, *dctx = NULL;
+    EVP_CIPHER *cipher = NULL;
+    unsigned char iv[16], ct[2][sizeof(gcm_pt)], pt[sizeof(gcm_pt)];
+    unsigned char tag[2][16];
+    int ccm = idx == 1, ivlen = (int)aead_ivlens[idx], taglen, ret = 0;
+
+    memset(iv, 0x5a, sizeof(iv));
+    if (!TEST_ptr(cipher = EVP_CIPHER_fetch(NULL, aead_ivlen_ciphers[idx],
+                                            NULL))
+        || !TEST_ptr(rctx = EVP_CIPHER_CTX_new())
+        || !TEST_ptr(ectx = EVP_CIPHER_CTX_new())
+        || !TEST_ptr(dctx = EVP_CIPHER_CTX_new())
+        || !TEST_true(EVP_EncryptInit_ex(rctx, cipher, NULL, gcm_key, NULL))
+        || !TEST_true(EVP_EncryptInit_ex(ectx, cipher, NULL, gcm_key, NULL))
+        || !TEST_true(EVP_DecryptInit_ex(dctx, cipher, NULL, gcm_key, NULL))
+        || !TEST_int_ne(EVP_CIPHER_CTX_get_iv_length(ectx), ivlen)
+        || !TEST_int_gt(taglen = EVP_CIPHER_CTX_get_tag_length(ectx), 0))
+        goto err;
+
+    /* A reference with the ctrl, then the same through aead_init() */
+    if (!aead_crypt(rctx, 1, 1, ccm, iv, ivlen, gcm_pt, sizeof(gcm_pt),
+                    ct[0], tag[0], taglen)
+        || !aead_crypt(ectx, 1, 0, ccm, iv, ivlen, gcm_pt, sizeof(gcm_pt),
+                       ct[1], tag[1], taglen)
+        || !TEST_int_eq(EVP_CIPHER_CTX_get_iv_length(ectx), ivlen)
+        || !TEST_mem_eq(ct[0], sizeof(ct[0]), ct[1], sizeof(ct[1]))
+        || !TEST_mem_eq(tag[0], taglen, tag[1], taglen)
+        || !aead_crypt(dctx, 0, 0, ccm, iv, ivlen, ct[1], sizeof(ct[1]),
+                       pt, tag[1], taglen)
+        || !TEST_mem_eq(gcm_pt, sizeof(gcm_pt), pt, sizeof(pt)))
+        goto err;
+    ret = 1;
+ err:
+    EVP_CIPHER_CTX_free(rctx);
+    EVP_CIPHER_CTX_free(ectx);
+    EVP_CIPHER_CTX_free(dctx);
+    EVP_CIPHER_free(cipher);
+    return ret;
+}
+
 #ifdef FIPS_MODULE
 static int ivgen_test(void)
 {
@@ -133,6 +282,8 @@ int setup_tests(void)
 {
     ADD_TEST(kat_test);
     ADD_TEST(badkeylen_test);
+    ADD_TEST(aead_api_test);
+    ADD_ALL_TESTS(aead_api_ivlen_test, OSSL_NELEM(aead_ivlen_ciphers));
 #ifdef FIPS_MODULE
     ADD_TEST(ivgen_test);
 #endif /* FIPS_MODULE */
@@ -1,5 +1,5 @@
 /*
- * Copyright 2015-2020 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2015-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -16,6 +16,10 @@
 #include <openssl/async.h>
 #include <openssl/crypto.h>
 
+#ifdef OPENSSL_SYS_UNIX
+# include <poll.h>
+#endif
+
 static int ctr = 0;
 static ASYNC_JOB *currjob = NULL;
 
@@ -35,6 +39,53 @@ static int add_two(void *args)
     return 2;
 }
 
+static int big_stack(void *args)
+{
+    volatile unsigned char buf[128 * 1024];
+    size_t i;
+    int ret = 0;
+
+    for (i = 0; i < sizeof(buf); i++)
+        buf[i] = (unsigned char)i;
+    ASYNC_pause_job();
+    for (i = 0; i < sizeof(buf); i++)
+        ret += buf[i] == (unsigned char)i;
+
+    return ret == sizeof(buf) ? **(int **)args : 0;
+}
+
+static ASYNC_callback_fn queue_cbs[3];
+static void *queue_cbargs[3];
+
+/* Behave like an engine that supports the callback mechanism */
+static int pause_for_callback(void *args)
+{
+    int idx = *(int *)args;
+    ASYNC_WAIT_CTX *waitctx = ASYNC_get_wait_ctx(ASYNC_get_current_job());
+
+    if (!ASYNC_WAIT_CTX_get_callback(waitctx, &queue_cbs[idx],
+                                     &queue_cbargs[idx]))
+        return 0;
+    ASYNC_WAIT_CTX_set_status(waitctx, ASYNC_STATUS_OK);
+    ASYNC_pause_job();
+
+    return idx + 1;
+}
+
+static int queue_fd_ready(ASYNC_QUEUE *queue)
+{
+#ifdef OPENSSL_SYS_UNIX
+    struct pollfd pfd;
+
+    if (!ASYNC_QUEUE_get_fd(queue, &pfd.fd))
+        return -1;
+    pfd.events = POLLIN;
+    return poll(&pfd, 1, 0);
+#else
+    return -1;
+#endif
+}
+
 static int save_current(void *args)
 {
     currjob = ASYNC_get_current_job();
@@ -221,6 +272,116 @@ static int test_ASYNC_start_job(void)
     return 1;
 }
 
+static int test_ASYNC_set_stack_size(void)
+{
+    ASYNC_JOB *job = NULL;
+    int funcret, val = 42, *valp = &val;
+    unsigned char small[1] = { 0 };
+    ASYNC_WAIT_CTX *waitctx = NULL;
+
+    /* Too small to run anything, or too big to round up to whole pages */
+    if (       ASYNC_set_stack_size(1)
+            || ASYNC_set_stack_size(4096)
+            || ASYNC_set_stack_size((size_t)-1)) {
+        fprintf(stderr, "test_ASYNC_set_stack_size() accepted a bad size\n");
+        return 0;
+    }
+
+    if (       !ASYNC_set_stack_size(256 * 1024)
+            || !ASYNC_init_thread(1, 0)
+            || (waitctx = ASYNC_WAIT_CTX_new()) == NULL
+            /* Leave a small argument buffer behind in the pooled job */
+            || ASYNC_start_job(&job, waitctx, &funcret, only_pause, small,
+                               sizeof(small)) != ASYNC_PAUSE
+            || ASYNC_start_job(&job, waitctx, &funcret, only_pause, small,
+                               sizeof(small)) != ASYNC_FINISH
+            || ASYNC_start_job(&job, waitctx, &funcret, big_stack, &valp,
+                               sizeof(valp)) != ASYNC_PAUSE
+            || ASYNC_start_job(&job, waitctx, &funcret, big_stack, &valp,
+                               sizeof(valp)) != ASYNC_FINISH
+            || funcret != 42) {
+        fprintf(stderr, "test_ASYNC_set_stack_size() failed\n");
+        ASYNC_WAIT_CTX_free(waitctx);
+        ASYNC_cleanup_thread();
+        ASYNC_set_stack_size(0);
+        return 0;
+    }
+
+    ASYNC_WAIT_CTX_free(waitctx);
+    ASYNC_cleanup_thread();
+    ASYNC_set_stack_size(0);
+    return 1;
+}
+
+static int test_ASYNC_QUEUE(void)
+{
+    ASYNC_QUEUE *queue = NULL;
+    ASYNC_JOB *jobs[3] = { NULL, NULL, NULL };
+    ASYNC_WAIT_CTX *waitctx[3] = { NULL, NULL, NULL };
+    void *items[40];
+    int funcret, i, ret = 0;
+
+    if (!ASYNC_init_thread(3, 0)
+            || (queue = ASYNC_QUEUE_new()) == NULL)
+        goto err;
+
+    for (i = 0; i < 3; i++) {
+        if ((waitctx[i] = ASYNC_WAIT_CTX_new()) == NULL
+                || !ASYNC_WAIT_CTX_set_queue(waitctx[i], queue, waitctx[i])
+                || ASYNC_start_job(&jobs[i], waitctx[i], &funcret,
+                                   pause_for_callback, &i, sizeof(i))
+                   != ASYNC_PAUSE)
+            goto err;
+    }
+    if (ASYNC_QUEUE_drain(queue, items, 40) != 0
+            || queue_fd_ready(queue) > 0)
+        goto err;
+
+    /* Complete two of the jobs out of order */
+    queue_cbs[2](queue_cbargs[2]);
+    queue_cbs[0](queue_cbargs[0]);
+    if (queue_fd_ready(queue) == 0
+            || ASYNC_QUEUE_drain(queue, items, 40) != 2
+            || items[0] != waitctx[2]
+            || items[1] != waitctx[0]
+            || queue_fd_ready(queue) > 0
+            || ASYNC_start_job(&jobs[2], waitctx[2], &funcret,
+                               pause_for_callback, NULL, 0) != ASYNC_FINISH
+            || funcret != 3
+            || ASYNC_start_job(&jobs[0], waitctx[0], &funcret,
+                               pause_for_callback, NULL, 0) != ASYNC_FINISH
+            || funcret != 1)
+        goto err;
+
+    queue_cbs[1](queue_cbargs[1]);
+    if (ASYNC_QUEUE_drain(queue, items, 1) != 1
+            || items[0] != waitctx[1]
+            || ASYNC_start_job(&jobs[1], waitctx[1], &funcret,
+                               pause_for_callback, NULL, 0) != ASYNC_FINISH
+            || funcret != 2)
+        goto err;
+
+    /* The ring grows and keeps its order across a wrap around */
+    for (i = 0; i < 40; i++)
+        if (!ASYNC_QUEUE_push(queue, &items[i]))
+            goto err;
+    if (ASYNC_QUEUE_drain(queue, items, 40) != 40)
+        goto err;
+    for (i = 0; i < 40; i++)
+        if (items[i] != &items[i])
+            goto err;
+
+    ret = 1;
+ err:
+    if (!ret)
+        fprintf(stderr, "test_ASYNC_QUEUE() failed\n");
+    for (i = 0; i < 3; i++)
+        ASYNC_WAIT_CTX_free(waitctx[i]);
+    ASYNC_QUEUE_free(queue);
+    ASYNC_cleanup_thread();
+    return ret;
+}
+
 static int test_ASYNC_get_current_job(void)
 {
     ASYNC_JOB *job = NULL;
@@ -422,6 +583,8 @@ int main(int argc, char **argv)
         if (!test_ASYNC_init_thread()
                 || !test_ASYNC_callback_status()
                 || !test_ASYNC_start_job()
+                || !test_ASYNC_set_stack_size()
+                || !test_ASYNC_QUEUE()
                 || !test_ASYNC_get_current_job()
                 || !test_ASYNC_WAIT_CTX_get_all_fds()
                 || !test_ASYNC_block_pause()
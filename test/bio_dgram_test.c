@@ -0,0 +1,295 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+#include <string.h>
+#include <openssl/bio.h>
+#include <openssl/err.h>
+#include "internal/nelem.h"
+#include "internal/sockets.h"
+#include "testutil.h"
+
+#if !defined(OPENSSL_NO_DGRAM) && !defined(OPENSSL_NO_SOCK)
+
+#define NUM_MSGS 3
+
+/* A caller structure that embeds BIO_MSG, to exercise the stride */
+typedef struct {
+    BIO_MSG msg;
+    int tag;
+} MY_MSG;
+
+static int make_dgram_bio(BIO **bio, BIO_ADDR **addr)
+{
+    static const unsigned char loopback[4] = { 127, 0, 0, 1 };
+    BIO_ADDR *bind_addr = NULL;
+    union BIO_sock_info_u info;
+    int fd = -1, ret = 0;
+
+    *bio = NULL;
+    *addr = NULL;
+    if (!TEST_ptr(bind_addr = BIO_ADDR_new())
+        || !TEST_true(BIO_ADDR_rawmake(bind_addr, AF_INET, loopback,
+                                       sizeof(loopback), 0))
+        || !TEST_int_ge(fd = BIO_socket(AF_INET, SOCK_DGRAM, 0, 0), 0)
+        || !TEST_true(BIO_bind(fd, bind_addr, 0))
+        || !TEST_ptr(*addr = BIO_ADDR_new()))
+        goto err;
+
+    info.addr = *addr;
+    if (!TEST_true(BIO_sock_info(fd, BIO_SOCK_INFO_ADDRESS, &info))
+        || !TEST_ptr(*bio = BIO_new_dgram(fd, BIO_CLOSE)))
+        goto err;
+    fd = -1;
+    ret = 1;
+ err:
+    if (fd >= 0)
+        BIO_closesocket(fd);
+    if (!ret) {
+        BIO_ADDR_free(*addr);
+        *addr = NULL;
+    }
+    BIO_ADDR_free(bind_addr);
+    return ret;
+}
+
+static int test_bio_dgram_mmsg(void)
+{
+    BIO *b1 = NULL, *b2 = NULL;
+    BIO_ADDR *addr1 = NULL, *addr2 = NULL;
+    BIO_ADDR *peers[NUM_MSGS + 1] = { NULL };
+    MY_MSG tx[NUM_MSGS], rx[NUM_MSGS + 1];
+    unsigned char txbuf[NUM_MSGS][16], rxbuf[NUM_MSGS + 1][32];
+    size_t i, processed, total;
+    int ret = 0;
+
+    if (!TEST_true(make_dgram_bio(&b1, &addr1))
+        || !TEST_true(make_dgram_bio(&b2, &addr2)))
+        goto err;
+
+    memset(tx, 0, sizeof(tx));
+    memset(rx, 0, sizeof(rx));
+    for (i = 0; i < NUM_MSGS; i++) {
+        memset(txbuf[i], 'a' + (int)i, sizeof(txbuf[i]));
+        tx[i].msg.data = txbuf[i];
+        tx[i].msg.data_len = sizeof(txbuf[i]) - i;
+        tx[i].msg.peer = addr2;
+    }
+    for (i = 0; i < NUM_MSGS + 1; i++) {
+        if (!TEST_ptr(peers[i] = BIO_ADDR_new()))
+            goto err;
+        rx[i].tag = (int)i;
+    }
+
+    if (!TEST_true(BIO_sendmmsg(b1, &tx[0].msg, sizeof(tx[0]), NUM_MSGS, 0,
+                                &processed))
+        || !TEST_size_t_eq(processed, NUM_MSGS))
+        goto err;
+
+    /* Loopback datagrams are queued once sent, but don't count on that */
+    for (total = 0; total < NUM_MSGS; total += processed) {
+        for (i = total; i < NUM_MSGS + 1; i++) {
+            rx[i].msg.data = rxbuf[i];
+            rx[i].msg.data_len = sizeof(rxbuf[i]);
+            rx[i].msg.peer = peers[i];
+        }
+        if (!TEST_true(BIO_recvmmsg(b2, &rx[total].msg, sizeof(rx[0]),
+                                    NUM_MSGS + 1 - total, 0, &processed))
+            || !TEST_size_t_gt(processed, 0))
+            goto err;
+    }
+    if (!TEST_size_t_eq(total, NUM_MSGS))
+        goto err;
+
+    for (i = 0; i < NUM_MSGS; i++) {
+        if (!TEST_mem_eq(rx[i].msg.data, rx[i].msg.data_len,
+                         tx[i].msg.data, tx[i].msg.data_len)
+            || !TEST_int_eq(BIO_ADDR_family(rx[i].msg.peer), AF_INET)
+            || !TEST_int_eq(BIO_ADDR_rawport(rx[i].msg.peer),
+                            BIO_ADDR_rawport(addr1))
+            || !TEST_int_eq(rx[i].tag, (int)i))
+            goto err;
+    }
+
+    /* Nothing is left, so a non-blocking receive must ask for a retry */
+    if (!TEST_true(BIO_socket_nbio(BIO_get_fd(b2, NULL), 1))
+        || !TEST_false(BIO_recvmmsg(b2, &rx[0].msg, sizeof(rx[0]), 1, 0,
+                                    &processed))
+        || !TEST_size_t_eq(processed, 0)
+        || !TEST_true(BIO_should_retry(b2))
+        || !TEST_true(BIO_should_read(b2)))
+        goto err;
+
+    /* Callers can tell whether the peer of the BIO is fixed */
+    if (!TEST_false(BIO_dgram_get_connected(b2))
+        || !TEST_int_gt(BIO_ctrl_set_connected(b2, addr1), 0)
+        || !TEST_true(BIO_dgram_get_connected(b2))
+        || !TEST_int_gt(BIO_ctrl_set_connected(b2, NULL), 0)
+        || !TEST_false(BIO_dgram_get_connected(b2)))
+        goto err;
+
+    ret = 1;
+ err:
+    for (i = 0; i < NUM_MSGS + 1; i++)
+        BIO_ADDR_free(peers[i]);
+    BIO_ADDR_free(addr1);
+    BIO_ADDR_free(addr2);
+    BIO_free(b1);
+    BIO_free(b2);
+    return ret;
+}
+
+/* A datagram that doesn't fit is cut short and flagged as truncated */
+static int test_bio_dgram_mmsg_truncated(void)
+{
+    BIO *b1 = NULL, *b2 = NULL;
+    BIO_ADDR *addr1 = NULL, *addr2 = NULL;
+    BIO_MSG tx[2], rx[2];
+    unsigned char txbuf[2][32], rxbuf[2][16];
+    size_t i, processed, total;
+    int ret = 0;
+
+    if (!TEST_true(make_dgram_bio(&b1, &addr1))
+        || !TEST_true(make_dgram_bio(&b2, &addr2)))
+        goto err;
+
+    memset(tx, 0, sizeof(tx));
+    memset(rx, 0, sizeof(rx));
+    for (i = 0; i < 2; i++) {
+        memset(txbuf[i], 'a' + (int)i, sizeof(txbuf[i]));
+        tx[i].data = txbuf[i];
+        tx[i].peer = addr2;
+    }
+    tx[0].data_len = sizeof(txbuf[0]);
+    tx[1].data_len = sizeof(rxbuf[1]) / 2;
+
+    if (!TEST_true(BIO_sendmmsg(b1, tx, sizeof(tx[0]), 2, 0, &processed))
+        || !TEST_size_t_eq(processed, 2))
+        goto err;
+
+    for (total = 0; total < 2; total += processed) {
+        for (i = total; i < 2; i++) {
+            rx[i].data = rxbuf[i];
+            rx[i].data_len = sizeof(rxbuf[i]);
+            rx[i].flags = 0;
+        }
+        if (!TEST_true(BIO_recvmmsg(b2, &rx[total], sizeof(rx[0]), 2 - total,
+                                    0, &processed)))
+            goto err;
+    }
+
+    if (!TEST_mem_eq(rx[0].data, rx[0].data_len, txbuf[0], sizeof(rxbuf[0]))
+        || !TEST_mem_eq(rx[1].data, rx[1].data_len,
+                        tx[1].data, tx[1].data_len)
+        || !TEST_false(rx[1].flags & BIO_MSG_TRUNCATED))
+        goto err;
+# if defined(OPENSSL_SYS_LINUX) || defined(OPENSSL_SYS_WINDOWS)
+    if (!TEST_true(rx[0].flags & BIO_MSG_TRUNCATED))
+        goto err;
+# endif
+
+    ret = 1;
+ err:
+    BIO_ADDR_free(addr1);
+    BIO_ADDR_free(addr2);
+    BIO_free(b1);
+    BIO_free(b2);
+    return ret;
+}
+
+#define MAX_MSGS_PER_CALL 64
+
+/* No more than MAX_MSGS_PER_CALL datagrams are moved by a single call */
+static int test_bio_dgram_mmsg_limit(void)
+{
+    BIO *b1 = NULL, *b2 = NULL;
+    BIO_ADDR *addr1 = NULL, *addr2 = NULL;
+    BIO_MSG msg[MAX_MSGS_PER_CALL + 1];
+    unsigned char buf[MAX_MSGS_PER_CALL + 1][4];
+    size_t i, processed, total;
+    int ret = 0;
+
+    if (!TEST_true(make_dgram_bio(&b1, &addr1))
+        || !TEST_true(make_dgram_bio(&b2, &addr2)))
+        goto err;
+
+    memset(msg, 0, sizeof(msg));
+    for (i = 0; i < OSSL_NELEM(msg); i++) {
+        memset(buf[i], (int)i, sizeof(buf[i]));
+        msg[i].data = buf[i];
+        msg[i].data_len = sizeof(buf[i]);
+        msg[i].peer = addr2;
+    }
+
+    if (!TEST_true(BIO_sendmmsg(b1, msg, sizeof(msg[0]), OSSL_NELEM(msg), 0,
+                                &processed))
+        || !TEST_size_t_eq(processed, MAX_MSGS_PER_CALL)
+        || !TEST_true(BIO_sendmmsg(b1, &msg[processed], sizeof(msg[0]),
+                                   OSSL_NELEM(msg) - processed, 0,
+                                   &processed))
+        || !TEST_size_t_eq(processed, 1))
+        goto err;
+
+    for (total = 0; total < OSSL_NELEM(msg); total += processed) {
+        for (i = 0; i < OSSL_NELEM(msg); i++) {
+            msg[i].data_len = sizeof(buf[i]);
+            msg[i].peer = NULL;
+        }
+        if (!TEST_true(BIO_recvmmsg(b2, msg, sizeof(msg[0]), OSSL_NELEM(msg),
+                                    0, &processed))
+            || !TEST_size_t_le(processed, MAX_MSGS_PER_CALL))
+            goto err;
+    }
+    if (!TEST_size_t_eq(total, OSSL_NELEM(msg)))
+        goto err;
+
+    ret = 1;
+ err:
+    BIO_ADDR_free(addr1);
+    BIO_ADDR_free(addr2);
+    BIO_free(b1);
+    BIO_free(b2);
+    return ret;
+}
+
+static int test_bio_mmsg_unsupported(void)
+{
+    BIO *b = NULL;
+    BIO_MSG msg;
+    unsigned char buf[8] = { 0 };
+    size_t processed = 1;
+    int ret = 0;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.data = buf;
+    msg.data_len = sizeof(buf);
+
+    if (!TEST_ptr(b = BIO_new(BIO_s_mem()))
+        || !TEST_false(BIO_sendmmsg(b, &msg, sizeof(msg), 1, 0, &processed))
+        || !TEST_size_t_eq(processed, 0)
+        || !TEST_int_eq(ERR_GET_REASON(ERR_get_error()),
+                        BIO_R_UNSUPPORTED_METHOD))
+        goto err;
+
+    ret = 1;
+ err:
+    BIO_free(b);
+    return ret;
+}
+#endif
+
+int setup_tests(void)
+{
+#if !defined(OPENSSL_NO_DGRAM) && !defined(OPENSSL_NO_SOCK)
+    ADD_TEST(test_bio_dgram_mmsg);
+    ADD_TEST(test_bio_dgram_mmsg_truncated);
+    ADD_TEST(test_bio_dgram_mmsg_limit);
+    ADD_TEST(test_bio_mmsg_unsupported);
+#endif
+    return 1;
+}
@@ -0,0 +1,258 @@
+/*
+ * Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+ *
+ * Licensed under the Apache License 2.0 (the "License").  You may not use
+ * this file except in compliance with the License.  You can obtain a copy
+ * in the file LICENSE in the source distribution or at
+ * https://www.openssl.org/source/license.html
+ */
+
+/*
+ * Check that a PrivateKeyInfo is only handed to the decoder for the type of
+ * key it holds.  A provider with counting PrivateKeyInfo decoders for several
+ * key types is placed behind the default provider's PrivateKeyInfo to type
+ * specific PrivateKeyInfo decoder.
+ */
+
+#include <string.h>
+#include <openssl/core.h>
+#include <openssl/core_dispatch.h>
+#include <openssl/provider.h>
+#include <openssl/decoder.h>
+#include <openssl/encoder.h>
+#include <openssl/evp.h>
+#include <openssl/rsa.h>
+#include "internal/nelem.h"
+#include "testutil.h"
+
+static const struct {
+    const char *keytype;
+    const char *group;
+    const char *names;
+} keys[] = {
+    { "RSA", NULL, "RSA:rsaEncryption:1.2.840.113549.1.1.1" },
+    { "RSA-PSS", NULL, "RSA-PSS:RSASSA-PSS:1.2.840.113549.1.1.10" },
+#ifndef OPENSSL_NO_EC
+    { "EC", "P-256", "EC:id-ecPublicKey:1.2.840.10045.2.1" },
+    { "ED25519", NULL, "ED25519:1.3.101.112" },
+    { "X25519", NULL, "X25519:1.3.101.110" },
+# ifndef OPENSSL_NO_SM2
+    { "SM2", NULL, "SM2:1.2.156.10197.1.301" },
+# endif
+#endif
+};
+
+#define NUM_KEYS OSSL_NELEM(keys)
+
+static int decode_calls[NUM_KEYS];
+
+static void count_freectx(void *ctx)
+{
+}
+
+static int count_decode(void *ctx, OSSL_CORE_BIO *cin, int selection,
+                        OSSL_CALLBACK *object_cb, void *object_cbarg,
+                        OSSL_PASSPHRASE_CALLBACK *pw_cb, void *pw_cbarg)
+{
+    (*(int *)ctx)++;
+    /* Return "empty handed", which is not an error */
+    return 1;
+}
+
+#define COUNT_DECODER(n)                                                \
+    static void *count_newctx_##n(void *provctx)                        \
+    {                                                                   \
+        return &decode_calls[n];                                        \
+    }                                                                   \
+    static const OSSL_DISPATCH count_functions_##n[] = {                \
+        { OSSL_FUNC_DECODER_NEWCTX, (void (*)(void))count_newctx_##n }, \
+        { OSSL_FUNC_DECODER_FREECTX, (void (*)(void))count_freectx },   \
+        { OSSL_FUNC_DECODER_DECODE, (void (*)(void))count_decode },     \
+        { 0, NULL }                                                     \
+    }
+
+COUNT_DECODER(0);
+COUNT_DECODER(1);
+#ifndef OPENSSL_NO_EC
+COUNT_DECODER(2);
+COUNT_DECODER(3);
+COUNT_DECODER(4);
+# ifndef OPENSSL_NO_SM2
+COUNT_DECODER(5);
+# endif
+#endif
+
+#define COUNT_PROPS "provider=count-decoders,input=der,structure=PrivateKeyInfo"
+
+static OSSL_ALGORITHM count_decoders[NUM_KEYS + 1];
+
+static const OSSL_ALGORITHM *count_query(void *provctx, int operation_id,
+                                         int *no_cache)
+{
+    *no_cache = 0;
+    return operation_id == OSSL_OP_DECODER ? count_decoders : NULL;
+}
+
+static const OSSL_DISPATCH count_dispatch_table[] = {
+    { OSSL_FUNC_PROVIDER_QUERY_OPERATION, (void (*)(void))count_query },
+    { 0, NULL }
+};
+
+static int count_provider_init(const OSSL_CORE_HANDLE *handle,
+                               const OSSL_DISPATCH *in,
+                               const OSSL_DISPATCH **out,
+                               void **provctx)
+{
+    static const OSSL_DISPATCH *functions[] = {
+        count_functions_0,
+        count_functions_1,
+#ifndef OPENSSL_NO_EC
+        count_functions_2,
+        count_functions_3,
+        count_functions_4,
+# ifndef OPENSSL_NO_SM2
+        count_functions_5,
+# endif
+#endif
+    };
+    size_t i;
+
+    for (i = 0; i < NUM_KEYS; i++) {
+        count_decoders[i].algorithm_names = keys[i].names;
+        count_decoders[i].property_definition = COUNT_PROPS;
+        count_decoders[i].implementation = functions[i];
+    }
+    *provctx = NULL;
+    *out = count_dispatch_table;
+    return 1;
+}
+
+static OSSL_LIB_CTX *libctx = NULL;
+static OSSL_PROVIDER *deflprov = NULL;
+static OSSL_PROVIDER *countprov = NULL;
+
+static EVP_PKEY *make_key(size_t idx)
+{
+    EVP_PKEY_CTX *ctx;
+    EVP_PKEY *pkey = NULL;
+
+    if (!TEST_ptr(ctx = EVP_PKEY_CTX_new_from_name(libctx, keys[idx].keytype,
+                                                   NULL))
+            || !TEST_int_gt(EVP_PKEY_keygen_init(ctx), 0)
+            || (keys[idx].group != NULL
+                && !TEST_int_gt(EVP_PKEY_CTX_set_group_name(ctx,
+                                                            keys[idx].group),
+                                0))
+            || (strncmp(keys[idx].keytype, "RSA", 3) == 0
+                && !TEST_int_gt(EVP_PKEY_CTX_set_rsa_keygen_bits(ctx, 1024),
+                                0))
+            || !TEST_int_gt(EVP_PKEY_keygen(ctx, &pkey), 0)) {
+        EVP_PKEY_free(pkey);
+        pkey = NULL;
+    }
+    EVP_PKEY_CTX_free(ctx);
+    return pkey;
+}
+
+/* Add |name| with |propq| to |dctx| */
+static int add_decoder(OSSL_DECODER_CTX *dctx, const char *name,
+                       const char *propq)
+{
+    OSSL_DECODER *decoder = OSSL_DECODER_fetch(libctx, name, propq);
+    int ok = TEST_ptr(decoder)
+             && TEST_true(OSSL_DECODER_CTX_add_decoder(dctx, decoder));
+
+    OSSL_DECODER_free(decoder);
+    return ok;
+}
+
+static int test_pkcs8_dispatch(int idx)
+{
+    EVP_PKEY *pkey = NULL, *decoded = NULL;
+    OSSL_ENCODER_CTX *ectx = NULL;
+    OSSL_DECODER_CTX *dctx = NULL;
+    unsigned char *der = NULL;
+    const unsigned char *p;
+    size_t derlen = 0, len, i;
+    int ok = 0;
+
+    memset(decode_calls, 0, sizeof(decode_calls));
+    if (!TEST_ptr(pkey = make_key(idx))
+            || !TEST_ptr(ectx = OSSL_ENCODER_CTX_new_for_pkey(pkey,
+                                                      EVP_PKEY_KEYPAIR,
+                                                      "DER", "PrivateKeyInfo",
+                                                      NULL))
+            || !TEST_true(OSSL_ENCODER_to_data(ectx, &der, &derlen)))
+        goto err;
+
+    /*
+     * The decoders are tried from the last one added, so the type dispatch
+     * decoder sees the input first and the counting decoders are only reached
+     * through it.  Nothing is constructed, so decoding itself fails.
+     */
+    if (!TEST_ptr(dctx = OSSL_DECODER_CTX_new())
+            || !TEST_true(OSSL_DECODER_CTX_set_input_type(dctx, "DER"))
+            || !TEST_true(OSSL_DECODER_CTX_set_input_structure(dctx,
+                                                               "PrivateKeyInfo")))
+        goto err;
+    for (i = 0; i < NUM_KEYS; i++)
+        if (!add_decoder(dctx, keys[i].keytype, "provider=count-decoders"))
+            goto err;
+    if (!add_decoder(dctx, "DER",
+                     "provider=default,input=der,structure=PrivateKeyInfo"))
+        goto err;
+
+    p = der;
+    len = derlen;
+    (void)OSSL_DECODER_from_data(dctx, &p, &len);
+    for (i = 0; i < NUM_KEYS; i++)
+        if (!TEST_int_eq(decode_calls[i], i == (size_t)idx)) {
+            TEST_note("%s key reached the %s decoder %d times",
+                      keys[idx].keytype, keys[i].keytype, decode_calls[i]);
+            goto err;
+        }
+
+    /* The full decoder chain still produces a key of the right type */
+    OSSL_DECODER_CTX_free(dctx);
+    p = der;
+    len = derlen;
+    if (!TEST_ptr(dctx = OSSL_DECODER_CTX_new_for_pkey(&decoded, "DER",
+                                                       "PrivateKeyInfo", NULL,
+                                                       EVP_PKEY_KEYPAIR,
+                                                       libctx,
+                                                       "provider=default"))
+            || !TEST_true(OSSL_DECODER_from_data(dctx, &p, &len))
+            || !TEST_true(EVP_PKEY_is_a(decoded, keys[idx].keytype))
+            || !TEST_int_eq(EVP_PKEY_eq(pkey, decoded), 1))
+        goto err;
+
+    ok = 1;
+ err:
+    OSSL_DECODER_CTX_free(dctx);
+    OSSL_ENCODER_CTX_free(ectx);
+    OPENSSL_free(der);
+    EVP_PKEY_free(decoded);
+    EVP_PKEY_free(pkey);
+    return ok;
+}
+
+int setup_tests(void)
+{
+    if (!TEST_ptr(libctx = OSSL_LIB_CTX_new())
+            || !TEST_true(OSSL_PROVIDER_add_builtin(libctx, "count-decoders",
+                                                    count_provider_init))
+            || !TEST_ptr(deflprov = OSSL_PROVIDER_load(libctx, "default"))
+            || !TEST_ptr(countprov = OSSL_PROVIDER_load(libctx,
+                                                        "count-decoders")))
+        return 0;
+
+    ADD_ALL_TESTS(test_pkcs8_dispatch, NUM_KEYS);
+    return 1;
+}
+
+void cleanup_tests(void)
+{
+    OSSL_PROVIDER_unload(countprov);
+    OSSL_PROVIDER_unload(deflprov);
+    OSSL_LIB_CTX_free(libctx);
+}
@@ -13,6 +13,7 @@
 #include <openssl/ssl.h>
 #include <openssl/err.h>
 
+#include "internal/sockets.h"
 #include "helpers/ssltestlib.h"
 #include "testutil.h"
 
@@ -442,6 +443,133 @@ static int test_just_finished(void)
     return testresult;
 }
 
+#if !defined(OPENSSL_NO_DGRAM) && !defined(OPENSSL_NO_SOCK)
+/* Create a UDP socket on the loopback address */
+static int make_udp_socket(int *fd, BIO_ADDR *addr)
+{
+    static const unsigned char loopback[4] = { 127, 0, 0, 1 };
+    union BIO_sock_info_u info;
+
+    info.addr = addr;
+    if (!TEST_true(BIO_ADDR_rawmake(addr, AF_INET, loopback,
+                                    sizeof(loopback), 0))
+            || !TEST_int_ge(*fd = BIO_socket(AF_INET, SOCK_DGRAM, 0, 0), 0)
+            || !TEST_true(BIO_bind(*fd, addr, 0))
+            || !TEST_true(BIO_sock_info(*fd, BIO_SOCK_INFO_ADDRESS, &info)))
+        return 0;
+    return 1;
+}
+
+/*
+ * Connect |fd| to |peer| in non-blocking mode and wrap it in a datagram BIO
+ * that is set as both the read and write BIO of |s|
+ */
+static int set_udp_bio(SSL *s, int fd, BIO_ADDR *peer)
+{
+    BIO *bio;
+
+    if (!TEST_true(BIO_connect(fd, peer, BIO_SOCK_NONBLOCK))
+            || !TEST_ptr(bio = BIO_new_dgram(fd, BIO_NOCLOSE)))
+        return 0;
+    if (!TEST_int_gt(BIO_ctrl_set_connected(bio, peer), 0)) {
+        BIO_free(bio);
+        return 0;
+    }
+    SSL_set_bio(s, bio, bio);
+    return 1;
+}
+
+#define NUM_DGRAMS  3
+
+/*
+ * Test that DTLS with read_ahead set reads datagrams in batches when the read
+ * BIO supports BIO_recvmmsg() and still reads them one at a time otherwise.
+ * Test 0: UDP sockets
+ * Test 1: Memory BIOs
+ */
+static int test_dtls_read_ahead_batch(int idx)
+{
+    SSL_CTX *sctx = NULL, *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    BIO_ADDR *caddr = NULL, *saddr = NULL;
+    int cfd = -1, sfd = -1;
+    char msg[] = "Datagram 0";
+    char buf[sizeof(msg)];
+    size_t i, written, readbytes;
+    int testresult = 0;
+
+    if (!TEST_true(create_ssl_ctx_pair(NULL, DTLS_server_method(),
+                                       DTLS_client_method(),
+                                       DTLS1_VERSION, 0,
+                                       &sctx, &cctx, cert, privkey)))
+        return 0;
+
+#ifdef OPENSSL_NO_DTLS1_2
+    /* Default sigalgs are SHA1 based in <DTLS1.2 which is in security level 0 */
+    if (!TEST_true(SSL_CTX_set_cipher_list(sctx, "DEFAULT:@SECLEVEL=0"))
+            || !TEST_true(SSL_CTX_set_cipher_list(cctx,
+                                                  "DEFAULT:@SECLEVEL=0")))
+        goto end;
+#endif
+
+    if (idx == 0) {
+        if (!TEST_ptr(caddr = BIO_ADDR_new())
+                || !TEST_ptr(saddr = BIO_ADDR_new())
+                || !make_udp_socket(&cfd, caddr)
+                || !make_udp_socket(&sfd, saddr)
+                || !TEST_ptr(serverssl = SSL_new(sctx))
+                || !TEST_ptr(clientssl = SSL_new(cctx))
+                || !set_udp_bio(serverssl, sfd, caddr)
+                || !set_udp_bio(clientssl, cfd, saddr))
+            goto end;
+    } else if (!TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL))) {
+        goto end;
+    }
+    SSL_set_read_ahead(serverssl, 1);
+    DTLS_set_timer_cb(clientssl, timer_cb);
+    DTLS_set_timer_cb(serverssl, timer_cb);
+
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl, SSL_ERROR_NONE)))
+        goto end;
+
+    for (i = 0; i < NUM_DGRAMS; i++) {
+        msg[sizeof(msg) - 2] = (char)('0' + i);
+        if (!TEST_true(SSL_write_ex(clientssl, msg, sizeof(msg), &written)))
+            goto end;
+    }
+
+    for (i = 0; i < NUM_DGRAMS; i++) {
+        msg[sizeof(msg) - 2] = (char)('0' + i);
+        if (!TEST_true(SSL_read_ex(serverssl, buf, sizeof(buf), &readbytes))
+                || !TEST_mem_eq(buf, readbytes, msg, sizeof(msg)))
+            goto end;
+        /* Over UDP the rest of the datagrams were received in one go */
+        if (i == 0
+                && !TEST_int_eq(SSL_has_pending(serverssl), idx == 0))
+            goto end;
+    }
+    if (!TEST_false(SSL_has_pending(serverssl))
+            || !TEST_int_eq(ERR_peek_error(), 0))
+        goto end;
+
+    testresult = 1;
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    if (cfd >= 0)
+        BIO_closesocket(cfd);
+    if (sfd >= 0)
+        BIO_closesocket(sfd);
+    BIO_ADDR_free(caddr);
+    BIO_ADDR_free(saddr);
+
+    return testresult;
+}
+#endif
+
 OPT_TEST_DECLARE_USAGE("certfile privkeyfile\n")
 
 int setup_tests(void)
@@ -462,6 +590,9 @@ int setup_tests(void)
     ADD_TEST(test_cookie);
     ADD_TEST(test_dtls_duplicate_records);
     ADD_TEST(test_just_finished);
+#if !defined(OPENSSL_NO_DGRAM) && !defined(OPENSSL_NO_SOCK)
+    ADD_ALL_TESTS(test_dtls_read_ahead_batch, 2);
+#endif
 
     return 1;
 }
@@ -12,6 +12,7 @@
 #include <openssl/err.h>
 #include <openssl/macros.h>
 
+#include "crypto/err.h"
 #include "testutil.h"
 
 #if defined(OPENSSL_SYS_WINDOWS)
@@ -334,6 +335,108 @@ static int test_clear_error(void)
     return res;
 }
 
+/*
+ * While errors are suppressed nothing new is recorded, but marks keep working
+ * on the errors that were already there, whether they were set before or
+ * during suppression.
+ */
+static int test_suppress_marks(void)
+{
+    unsigned long mallocfail, internal, unsupported;
+    int suppressed = 0, res = 0;
+
+    ERR_clear_error();
+
+    /* Nothing is recorded, so there is nothing to put a mark on either */
+    if (!TEST_true(suppressed = ossl_err_suppress()))
+        return 0;
+    ERR_raise(ERR_LIB_CRYPTO, ERR_R_MALLOC_FAILURE);
+    if (!TEST_ulong_eq(ERR_peek_error(), 0)
+            || !TEST_false(ERR_set_mark()))
+        goto err;
+    ossl_err_unsuppress();
+    suppressed = 0;
+
+    ERR_raise(ERR_LIB_CRYPTO, ERR_R_MALLOC_FAILURE);
+    mallocfail = ERR_peek_last_error();
+    if (!TEST_true(ERR_set_mark()))
+        goto err;
+    ERR_raise(ERR_LIB_CRYPTO, ERR_R_INTERNAL_ERROR);
+    internal = ERR_peek_last_error();
+
+    /* A mark set while suppressed goes on the last error recorded before */
+    if (!TEST_true(suppressed = ossl_err_suppress()))
+        goto err;
+    ERR_raise(ERR_LIB_CRYPTO, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
+    if (!TEST_ulong_eq(ERR_peek_last_error(), internal)
+            || !TEST_true(ERR_set_mark()))
+        goto err;
+    ERR_raise(ERR_LIB_CRYPTO, ERR_R_SHOULD_NOT_HAVE_BEEN_CALLED);
+    if (!TEST_true(ERR_pop_to_mark())
+            || !TEST_ulong_eq(ERR_peek_last_error(), internal))
+        goto err;
+    ossl_err_unsuppress();
+    suppressed = 0;
+
+    /* The outer mark removes what came after it, and no more */
+    ERR_raise(ERR_LIB_CRYPTO, ERR_R_UNSUPPORTED);
+    unsupported = ERR_peek_last_error();
+    if (!TEST_ulong_ne(unsupported, internal)
+            || !TEST_true(ERR_pop_to_mark())
+            || !TEST_ulong_eq(ERR_peek_last_error(), mallocfail)
+            || !TEST_ulong_eq(ERR_get_error(), mallocfail)
+            || !TEST_ulong_eq(ERR_peek_error(), 0))
+        goto err;
+    res = 1;
+ err:
+    if (suppressed)
+        ossl_err_unsuppress();
+    ERR_clear_error();
+    return res;
+}
+
+/*
+ * The file, function and data strings of an error slot are reused when the
+ * slot is raised again, make sure nothing from the previous error leaks into
+ * the next one.
+ */
+static int test_reused_slot_strings(void)
+{
+    const char *file, *func, *data;
+    int line, res = 0;
+
+    ERR_new();
+    ERR_set_debug("a_rather_long_file_name.c", 1, "a_rather_long_function");
+    ERR_set_error(ERR_LIB_NONE, ERR_R_INTERNAL_ERROR, "%s", "long data");
+    ERR_clear_error();
+
+    ERR_new();
+    ERR_set_debug("b.c", 2, "f");
+    ERR_set_error(ERR_LIB_NONE, ERR_R_INTERNAL_ERROR, "d");
+    if (!TEST_ulong_ne(ERR_peek_error_all(&file, &line, &func, &data, NULL), 0)
+            || !TEST_str_eq(file, "b.c")
+            || !TEST_int_eq(line, 2)
+            || !TEST_str_eq(func, "f")
+            || !TEST_str_eq(data, "d"))
+        goto err;
+    ERR_clear_error();
+
+    ERR_new();
+    ERR_set_debug(NULL, 3, NULL);
+    ERR_set_error(ERR_LIB_NONE, ERR_R_INTERNAL_ERROR, NULL);
+    if (!TEST_ulong_ne(ERR_peek_error_all(&file, &line, &func, &data, NULL), 0)
+            || !TEST_str_eq(file, "")
+            || !TEST_int_eq(line, 3)
+            || !TEST_str_eq(func, "")
+            || !TEST_str_eq(data, ""))
+        goto err;
+
+    res = 1;
+ err:
+    ERR_clear_error();
+    return res;
+}
+
 int setup_tests(void)
 {
     ADD_TEST(preserves_system_error);
@@ -344,5 +447,7 @@ int setup_tests(void)
 #endif
     ADD_TEST(test_marks);
     ADD_TEST(test_clear_error);
+    ADD_TEST(test_reused_slot_strings);
+    ADD_TEST(test_suppress_marks);
     return 1;
 }
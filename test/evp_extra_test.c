@@ -904,9 +904,221 @@ static int test_EC_priv_only_legacy(void)
 
     return ret;
 }
+
+/*
+ * Test that a legacy EC key that is changed after it has been used with a
+ * provider is not used in its old form by later operations
+ */
+static int test_EC_legacy_key_change(void)
+{
+    int ret = 0, i;
+    EC_KEY *eckey = NULL;
+    EVP_PKEY *pkey = NULL, *verify_pkey = NULL;
+    EVP_MD_CTX *ctx = NULL;
+    unsigned char sig[256];
+    size_t siglen;
+
+    eckey = EC_KEY_new_by_curve_name_ex(testctx, testpropq,
+                                        NID_X9_62_prime256v1);
+    if (!TEST_ptr(eckey)
+        || !TEST_true(EC_KEY_generate_key(eckey))
+        || !TEST_ptr(pkey = EVP_PKEY_new())
+        || !TEST_true(EVP_PKEY_set1_EC_KEY(pkey, eckey)))
+        goto err;
+
+    for (i = 0; i < 2; i++) {
+        /* The second round uses a different key in the same EC_KEY */
+        if (i > 0 && !TEST_true(EC_KEY_generate_key(eckey)))
+            goto err;
+
+        siglen = sizeof(sig);
+        if (!TEST_ptr(ctx = EVP_MD_CTX_new())
+            || !TEST_true(EVP_DigestSignInit_ex(ctx, NULL, "SHA256", testctx,
+                                                testpropq, pkey, NULL))
+            || !TEST_true(EVP_DigestSign(ctx, sig, &siglen,
+                                         kMsg, sizeof(kMsg))))
+            goto err;
+        EVP_MD_CTX_free(ctx);
+        ctx = NULL;
+
+        /* Verify with a separate copy of the current key */
+        if (!TEST_ptr(verify_pkey = EVP_PKEY_new())
+            || !TEST_true(EVP_PKEY_assign_EC_KEY(verify_pkey,
+                                                 EC_KEY_dup(eckey)))
+            || !TEST_ptr(ctx = EVP_MD_CTX_new())
+            || !TEST_true(EVP_DigestVerifyInit_ex(ctx, NULL, "SHA256",
+                                                  testctx, testpropq,
+                                                  verify_pkey, NULL))
+            || !TEST_int_eq(EVP_DigestVerify(ctx, sig, siglen,
+                                             kMsg, sizeof(kMsg)), 1))
+            goto err;
+        EVP_MD_CTX_free(ctx);
+        ctx = NULL;
+        EVP_PKEY_free(verify_pkey);
+        verify_pkey = NULL;
+    }
+
+    ret = 1;
+ err:
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(verify_pkey);
+    EVP_PKEY_free(pkey);
+    EC_KEY_free(eckey);
+    return ret;
+}
 # endif /* OPENSSL_NO_DEPRECATED_3_0 */
 #endif /* OPENSSL_NO_EC */
 
+#ifndef OPENSSL_NO_DEPRECATED_3_0
+/* Replace the key material of |to| with a copy of that of |from| */
+static int copy_rsa_key(RSA *to, const RSA *from)
+{
+    const BIGNUM *n, *e, *d, *p, *q, *dmp1, *dmq1, *iqmp;
+    BIGNUM *n2 = NULL, *e2 = NULL, *d2 = NULL, *p2 = NULL, *q2 = NULL;
+    BIGNUM *dmp12 = NULL, *dmq12 = NULL, *iqmp2 = NULL;
+
+    RSA_get0_key(from, &n, &e, &d);
+    RSA_get0_factors(from, &p, &q);
+    RSA_get0_crt_params(from, &dmp1, &dmq1, &iqmp);
+    if (!TEST_ptr(n2 = BN_dup(n)) || !TEST_ptr(e2 = BN_dup(e))
+        || !TEST_ptr(d2 = BN_dup(d))
+        || !TEST_true(RSA_set0_key(to, n2, e2, d2)))
+        goto err;
+    n2 = e2 = d2 = NULL;
+    if (!TEST_ptr(p2 = BN_dup(p)) || !TEST_ptr(q2 = BN_dup(q))
+        || !TEST_true(RSA_set0_factors(to, p2, q2)))
+        goto err;
+    p2 = q2 = NULL;
+    if (!TEST_ptr(dmp12 = BN_dup(dmp1)) || !TEST_ptr(dmq12 = BN_dup(dmq1))
+        || !TEST_ptr(iqmp2 = BN_dup(iqmp))
+        || !TEST_true(RSA_set0_crt_params(to, dmp12, dmq12, iqmp2)))
+        goto err;
+    return 1;
+ err:
+    BN_free(n2);
+    BN_free(e2);
+    BN_free(d2);
+    BN_free(p2);
+    BN_free(q2);
+    BN_free(dmp12);
+    BN_free(dmq12);
+    BN_free(iqmp2);
+    return 0;
+}
+
+/*
+ * Test that a legacy RSA key that is changed after it has been used with a
+ * provider is not used in its old form by later operations
+ */
+static int test_RSA_legacy_key_change(void)
+{
+    int ret = 0, i;
+    const unsigned char *p = kExampleRSAKeyDER;
+    RSA *rsa = NULL, *newrsa = NULL;
+    EVP_PKEY *pkey = NULL, *newpkey = NULL, *verify_pkey = NULL;
+    EVP_MD_CTX *ctx = NULL;
+    unsigned char sig[256];
+    size_t siglen;
+
+    if (!TEST_ptr(rsa = d2i_RSAPrivateKey(NULL, &p, sizeof(kExampleRSAKeyDER)))
+        || !TEST_ptr(newpkey = EVP_PKEY_Q_keygen(testctx, testpropq, "RSA",
+                                                 (size_t)1024))
+        || !TEST_ptr(newrsa = EVP_PKEY_get1_RSA(newpkey))
+        || !TEST_ptr(pkey = EVP_PKEY_new())
+        || !TEST_true(EVP_PKEY_set1_RSA(pkey, rsa)))
+        goto err;
+
+    for (i = 0; i < 2; i++) {
+        /* The second round uses a different key in the same RSA */
+        if (i > 0 && !copy_rsa_key(rsa, newrsa))
+            goto err;
+
+        siglen = sizeof(sig);
+        if (!TEST_ptr(ctx = EVP_MD_CTX_new())
+            || !TEST_true(EVP_DigestSignInit_ex(ctx, NULL, "SHA256", testctx,
+                                                testpropq, pkey, NULL))
+            || !TEST_true(EVP_DigestSign(ctx, sig, &siglen,
+                                         kMsg, sizeof(kMsg))))
+            goto err;
+        EVP_MD_CTX_free(ctx);
+        ctx = NULL;
+
+        /* Verify with a separate copy of the current public key */
+        if (!TEST_ptr(verify_pkey = EVP_PKEY_new())
+            || !TEST_true(EVP_PKEY_assign_RSA(verify_pkey,
+                                              RSAPublicKey_dup(rsa)))
+            || !TEST_ptr(ctx = EVP_MD_CTX_new())
+            || !TEST_true(EVP_DigestVerifyInit_ex(ctx, NULL, "SHA256",
+                                                  testctx, testpropq,
+                                                  verify_pkey, NULL))
+            || !TEST_int_eq(EVP_DigestVerify(ctx, sig, siglen,
+                                             kMsg, sizeof(kMsg)), 1))
+            goto err;
+        EVP_MD_CTX_free(ctx);
+        ctx = NULL;
+        EVP_PKEY_free(verify_pkey);
+        verify_pkey = NULL;
+    }
+
+    ret = 1;
+ err:
+    EVP_MD_CTX_free(ctx);
+    EVP_PKEY_free(verify_pkey);
+    EVP_PKEY_free(pkey);
+    EVP_PKEY_free(newpkey);
+    RSA_free(newrsa);
+    RSA_free(rsa);
+    return ret;
+}
+
+/*
+ * Test that an operation initialised with a legacy RSA key keeps using the
+ * key as it was, when the legacy key is changed before the operation is done
+ */
+static int test_RSA_legacy_key_change_in_use(void)
+{
+    int ret = 0;
+    const unsigned char *p = kExampleRSAKeyDER;
+    RSA *rsa = NULL, *newrsa = NULL;
+    EVP_PKEY *pkey = NULL, *newpkey = NULL, *verify_pkey = NULL;
+    EVP_MD_CTX *ctx = NULL, *vctx = NULL;
+    unsigned char sig[256];
+    size_t siglen = sizeof(sig);
+
+    if (!TEST_ptr(rsa = d2i_RSAPrivateKey(NULL, &p, sizeof(kExampleRSAKeyDER)))
+        || !TEST_ptr(newpkey = EVP_PKEY_Q_keygen(testctx, testpropq, "RSA",
+                                                 (size_t)1024))
+        || !TEST_ptr(newrsa = EVP_PKEY_get1_RSA(newpkey))
+        || !TEST_ptr(pkey = EVP_PKEY_new())
+        || !TEST_true(EVP_PKEY_set1_RSA(pkey, rsa))
+        || !TEST_ptr(verify_pkey = EVP_PKEY_new())
+        || !TEST_true(EVP_PKEY_assign_RSA(verify_pkey, RSAPublicKey_dup(rsa)))
+        || !TEST_ptr(ctx = EVP_MD_CTX_new())
+        || !TEST_true(EVP_DigestSignInit_ex(ctx, NULL, "SHA256", testctx,
+                                            testpropq, pkey, NULL))
+        /* This frees the key material the operation was initialised with */
+        || !copy_rsa_key(rsa, newrsa)
+        || !TEST_true(EVP_DigestSign(ctx, sig, &siglen, kMsg, sizeof(kMsg)))
+        || !TEST_ptr(vctx = EVP_MD_CTX_new())
+        || !TEST_true(EVP_DigestVerifyInit_ex(vctx, NULL, "SHA256", testctx,
+                                              testpropq, verify_pkey, NULL))
+        || !TEST_int_eq(EVP_DigestVerify(vctx, sig, siglen,
+                                         kMsg, sizeof(kMsg)), 1))
+        goto err;
+
+    ret = 1;
+ err:
+    EVP_MD_CTX_free(ctx);
+    EVP_MD_CTX_free(vctx);
+    EVP_PKEY_free(verify_pkey);
+    EVP_PKEY_free(pkey);
+    EVP_PKEY_free(newpkey);
+    RSA_free(newrsa);
+    RSA_free(rsa);
+    return ret;
+}
+#endif /* OPENSSL_NO_DEPRECATED_3_0 */
+
 /*
  * n = 0 => test using legacy cipher
  * n = 1 => test using fetched cipher
@@ -2564,6 +2776,74 @@ static int test_pkey_ctx_fail_without_provider(int tst)
     return ret;
 }
 
+/*
+ * Check that the decoder chain that OSSL_DECODER_CTX_new_for_pkey() keeps
+ * in the library context follows provider activation and deactivation.
+ */
+static int test_decoder_cache_provider_change(void)
+{
+    OSSL_LIB_CTX *tmpctx = OSSL_LIB_CTX_new();
+    OSSL_PROVIDER *tmpnullprov = NULL, *tmpdefprov = NULL;
+    OSSL_DECODER_CTX *dctx = NULL;
+    EVP_PKEY *pkey = NULL;
+    const unsigned char *data;
+    size_t data_len;
+    int i, ret = 0;
+
+    if (!TEST_ptr(tmpctx)
+        || !TEST_ptr(tmpnullprov = OSSL_PROVIDER_load(tmpctx, "null")))
+        goto err;
+
+    /* No keymgmt is available, so no decoder can be used */
+    dctx = OSSL_DECODER_CTX_new_for_pkey(&pkey, "DER", NULL, "RSA", 0,
+                                         tmpctx, NULL);
+    if (!TEST_ptr(dctx)
+        || !TEST_int_eq(OSSL_DECODER_CTX_get_num_decoders(dctx), 0))
+        goto err;
+    OSSL_DECODER_CTX_free(dctx);
+    dctx = NULL;
+
+    if (!TEST_ptr(tmpdefprov = OSSL_PROVIDER_load(tmpctx, "default")))
+        goto err;
+
+    /* The first round builds the chain, the second one uses the cache */
+    for (i = 0; i < 2; i++) {
+        data = kExampleRSAKeyDER;
+        data_len = sizeof(kExampleRSAKeyDER);
+        dctx = OSSL_DECODER_CTX_new_for_pkey(&pkey, "DER", NULL, "RSA", 0,
+                                             tmpctx, NULL);
+        if (!TEST_ptr(dctx)
+            || !TEST_int_gt(OSSL_DECODER_CTX_get_num_decoders(dctx), 0)
+            || !TEST_true(OSSL_DECODER_from_data(dctx, &data, &data_len))
+            || !TEST_ptr(pkey)
+            || !TEST_true(EVP_PKEY_is_a(pkey, "RSA")))
+            goto err;
+        OSSL_DECODER_CTX_free(dctx);
+        dctx = NULL;
+        EVP_PKEY_free(pkey);
+        pkey = NULL;
+    }
+
+    if (!TEST_true(OSSL_PROVIDER_unload(tmpdefprov)))
+        goto err;
+    tmpdefprov = NULL;
+
+    dctx = OSSL_DECODER_CTX_new_for_pkey(&pkey, "DER", NULL, "RSA", 0,
+                                         tmpctx, NULL);
+    if (!TEST_ptr(dctx)
+        || !TEST_int_eq(OSSL_DECODER_CTX_get_num_decoders(dctx), 0))
+        goto err;
+
+    ret = 1;
+ err:
+    OSSL_DECODER_CTX_free(dctx);
+    EVP_PKEY_free(pkey);
+    OSSL_PROVIDER_unload(tmpdefprov);
+    OSSL_PROVIDER_unload(tmpnullprov);
+    OSSL_LIB_CTX_free(tmpctx);
+    return ret;
+}
+
 static int test_rand_agglomeration(void)
 {
     EVP_RAND *rand;
@@ -3368,6 +3648,692 @@ static int test_gcm_reinit(int idx)
 }
 
 
+static const char *aead_oneshot_ciphers[] = {
+    "AES-128-GCM",
+    "AES-256-GCM",
+    "AES-256-CCM",
+#ifndef OPENSSL_NO_OCB
+    "AES-128-OCB",
+#endif
+#if !defined(OPENSSL_NO_CHACHA) && !defined(OPENSSL_NO_POLY1305)
+    "ChaCha20-Poly1305",
+#endif
+};
+
+/*
+ * EVP_CIPHER_CTX_aead_seal() and EVP_CIPHER_CTX_aead_open() must agree with
+ * the streaming calls, whether the provider implements them directly (GCM,
+ * CCM, ChaCha20-Poly1305) or they are emulated (OCB).
+ */
+static int test_aead_seal_open(int idx)
+{
+    static const unsigned char key[32] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+        0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+        0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+    };
+    static const unsigned char iv[12] = {
+        0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88
+    };
+    static const unsigned char aad[] = "additional data";
+    static const unsigned char msg[] = "It was the best of times, it was the worst of times";
+    static const unsigned char zeros[sizeof(msg)] = { 0 };
+    unsigned char ref[80], ct[80], pt[80], reftag[16], tag[16];
+    EVP_CIPHER *cipher = NULL;
+    EVP_CIPHER_CTX *ectx = NULL, *dctx = NULL;
+    int ivlen, taglen, outl, tmpl, i, ret = 0;
+
+    if (!TEST_ptr(cipher = EVP_CIPHER_fetch(testctx, aead_oneshot_ciphers[idx],
+                                            testpropq))
+        || !TEST_ptr(ectx = EVP_CIPHER_CTX_new())
+        || !TEST_ptr(dctx = EVP_CIPHER_CTX_new())
+        || !TEST_true(EVP_EncryptInit_ex(ectx, cipher, NULL, key, NULL))
+        || !TEST_true(EVP_DecryptInit_ex(dctx, cipher, NULL, key, NULL))
+        || !TEST_int_gt(ivlen = EVP_CIPHER_CTX_get_iv_length(ectx), 0)
+        || !TEST_int_le(ivlen, (int)sizeof(iv)))
+        goto err;
+    /* ChaCha20-Poly1305 doesn't report a tag length until one is set */
+    if ((taglen = EVP_CIPHER_CTX_get_tag_length(ectx)) <= 0)
+        taglen = sizeof(tag);
+
+    /* Reference result from the streaming calls */
+    if (!TEST_true(EVP_EncryptInit_ex(ectx, NULL, NULL, NULL, iv))
+        || (EVP_CIPHER_get_mode(cipher) == EVP_CIPH_CCM_MODE
+            && !TEST_true(EVP_EncryptUpdate(ectx, NULL, &tmpl, NULL,
+                                            sizeof(msg))))
+        || !TEST_true(EVP_EncryptUpdate(ectx, NULL, &tmpl, aad, sizeof(aad)))
+        || !TEST_true(EVP_EncryptUpdate(ectx, ref, &outl, msg, sizeof(msg)))
+        || !TEST_true(EVP_EncryptFinal_ex(ectx, ref + outl, &tmpl))
+        || !TEST_int_eq(outl + tmpl, (int)sizeof(msg))
+        || !TEST_true(EVP_CIPHER_CTX_ctrl(ectx, EVP_CTRL_AEAD_GET_TAG, taglen,
+                                          reftag)))
+        goto err;
+
+    /* Twice over, to check the contexts can be reused */
+    for (i = 0; i < 2; i++) {
+        memset(tag, 0, sizeof(tag));
+        if (!TEST_true(EVP_CIPHER_CTX_aead_seal(ectx, iv, ivlen,
+                                                aad, sizeof(aad),
+                                                msg, sizeof(msg), ct,
+                                                tag, taglen))
+            || !TEST_mem_eq(ct, sizeof(msg), ref, sizeof(msg))
+            || !TEST_mem_eq(tag, taglen, reftag, taglen)
+            || !TEST_true(EVP_CIPHER_CTX_aead_open(dctx, iv, ivlen,
+                                                   aad, sizeof(aad),
+                                                   ct, sizeof(msg), pt,
+                                                   tag, taglen))
+            || !TEST_mem_eq(pt, sizeof(msg), msg, sizeof(msg)))
+            goto err;
+    }
+
+    /* A bad tag must fail and leave no plaintext behind */
+    tag[0] ^= 1;
+    if (!TEST_false(EVP_CIPHER_CTX_aead_open(dctx, iv, ivlen, aad, sizeof(aad),
+                                             ct, sizeof(msg), pt,
+                                             tag, taglen))
+        || !TEST_mem_eq(pt, sizeof(msg), zeros, sizeof(msg)))
+        goto err;
+
+    /* Each context only goes one way */
+    if (!TEST_false(EVP_CIPHER_CTX_aead_seal(dctx, iv, ivlen, aad, sizeof(aad),
+                                             msg, sizeof(msg), ct,
+                                             tag, taglen))
+        || !TEST_false(EVP_CIPHER_CTX_aead_open(ectx, iv, ivlen,
+                                                aad, sizeof(aad),
+                                                ct, sizeof(msg), pt,
+                                                tag, taglen)))
+        goto err;
+
+    ret = 1;
+ err:
+    EVP_CIPHER_CTX_free(ectx);
+    EVP_CIPHER_CTX_free(dctx);
+    EVP_CIPHER_free(cipher);
+    return ret;
+}
+
+/* Streaming encryption of one packet, for reference */
+static int aead_stream_seal(EVP_CIPHER_CTX *ctx, const unsigned char *iv,
+                            const unsigned char *aad, size_t aadlen,
+                            const unsigned char *in, size_t inl,
+                            unsigned char *out, unsigned char *tag, int taglen)
+{
+    int outl, tmpl;
+
+    return TEST_true(EVP_EncryptInit_ex(ctx, NULL, NULL, NULL, iv))
+           && (EVP_CIPHER_get_mode(EVP_CIPHER_CTX_get0_cipher(ctx))
+               != EVP_CIPH_CCM_MODE
+               || TEST_true(EVP_EncryptUpdate(ctx, NULL, &tmpl, NULL,
+                                              (int)inl)))
+           && (aadlen == 0
+               || TEST_true(EVP_EncryptUpdate(ctx, NULL, &tmpl, aad,
+                                              (int)aadlen)))
+           && TEST_true(EVP_EncryptUpdate(ctx, out, &outl, in, (int)inl))
+           && TEST_true(EVP_EncryptFinal_ex(ctx, out + outl, &tmpl))
+           && TEST_true(EVP_CIPHER_CTX_ctrl(ctx, EVP_CTRL_AEAD_GET_TAG, taglen,
+                                            tag));
+}
+
+/*
+ * EVP_CIPHER_CTX_aead_seal() and EVP_CIPHER_CTX_aead_open() on messages and
+ * AAD straddling the limits up to which GCM hashes everything with a single
+ * call (512 and 64 bytes), which covers the higher powers of H and more than
+ * one chunk of the AVX-512 GHASH.
+ */
+static int test_aead_seal_open_lengths(int idx)
+{
+    static const unsigned char key[32] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+        0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+        0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+    };
+    static const unsigned char iv[12] = {
+        0xca, 0xfe, 0xba, 0xbe, 0xfa, 0xce, 0xdb, 0xad, 0xde, 0xca, 0xf8, 0x88
+    };
+    static const size_t lens[] = { 0, 15, 16, 511, 512, 513 };
+    static const size_t aadlens[] = { 0, 13, 64, 65 };
+    unsigned char msg[513], ref[513], ct[513], pt[513], aad[65];
+    unsigned char reftag[16], tag[16];
+    EVP_CIPHER *cipher = NULL;
+    EVP_CIPHER_CTX *ectx = NULL, *dctx = NULL;
+    size_t i, j, k, inl, aadlen;
+    int ivlen, taglen, ret = 0;
+
+    for (k = 0; k < sizeof(msg); k++)
+        msg[k] = (unsigned char)(k * 3 + 1);
+    for (k = 0; k < sizeof(aad); k++)
+        aad[k] = (unsigned char)(0xa0 + k);
+
+    if (!TEST_ptr(cipher = EVP_CIPHER_fetch(testctx, aead_oneshot_ciphers[idx],
+                                            testpropq))
+        || !TEST_ptr(ectx = EVP_CIPHER_CTX_new())
+        || !TEST_ptr(dctx = EVP_CIPHER_CTX_new())
+        || !TEST_true(EVP_EncryptInit_ex(ectx, cipher, NULL, key, NULL))
+        || !TEST_true(EVP_DecryptInit_ex(dctx, cipher, NULL, key, NULL))
+        || !TEST_int_gt(ivlen = EVP_CIPHER_CTX_get_iv_length(ectx), 0)
+        || !TEST_int_le(ivlen, (int)sizeof(iv)))
+        goto err;
+    if ((taglen = EVP_CIPHER_CTX_get_tag_length(ectx)) <= 0)
+        taglen = sizeof(tag);
+
+    for (i = 0; i < OSSL_NELEM(lens); i++) {
+        inl = lens[i];
+        for (j = 0; j < OSSL_NELEM(aadlens); j++) {
+            aadlen = aadlens[j];
+            memset(ct, 0, sizeof(ct));
+            memset(pt, 0, sizeof(pt));
+            memset(tag, 0, sizeof(tag));
+            if (!aead_stream_seal(ectx, iv, aad, aadlen, msg, inl, ref,
+                                  reftag, taglen)
+                || !TEST_true(EVP_CIPHER_CTX_aead_seal(ectx, iv, ivlen,
+                                                       aad, aadlen, msg, inl,
+                                                       ct, tag, taglen))
+                || !TEST_mem_eq(ct, inl, ref, inl)
+                || !TEST_mem_eq(tag, taglen, reftag, taglen)
+                || !TEST_true(EVP_CIPHER_CTX_aead_open(dctx, iv, ivlen,
+                                                       aad, aadlen, ct, inl,
+                                                       pt, tag, taglen))
+                || !TEST_mem_eq(pt, inl, msg, inl)) {
+                TEST_info("%zu bytes, %zu bytes of AAD", inl, aadlen);
+                goto err;
+            }
+
+            /* The tag covers the AAD */
+            if (aadlen > 0) {
+                aad[aadlen - 1] ^= 1;
+                if (!TEST_false(EVP_CIPHER_CTX_aead_open(dctx, iv, ivlen,
+                                                         aad, aadlen, ct, inl,
+                                                         pt, tag, taglen))) {
+                    TEST_info("%zu bytes, %zu bytes of AAD", inl, aadlen);
+                    goto err;
+                }
+                aad[aadlen - 1] ^= 1;
+            }
+        }
+    }
+
+    ret = 1;
+ err:
+    EVP_CIPHER_CTX_free(ectx);
+    EVP_CIPHER_CTX_free(dctx);
+    EVP_CIPHER_free(cipher);
+    return ret;
+}
+
+/*
+ * EVP_CIPHER_CTX_aead_seal_many() and EVP_CIPHER_CTX_aead_open_many() must
+ * agree with the streaming calls on every packet.  The lengths straddle the
+ * block sizes and the limit up to which ChaCha20-Poly1305 processes packets
+ * side by side, and some packets are too long for it.
+ */
+#define AEAD_MANY_NUM   21
+#define AEAD_MANY_MAX   640
+
+static int test_aead_seal_open_many(int idx)
+{
+    static const unsigned char key[32] = {
+        0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+        0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17,
+        0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f
+    };
+    static const size_t lens[AEAD_MANY_NUM] = {
+        0, 1, 15, 16, 17, 63, 64, 65, 100, 128, 200,
+        255, 256, 300, 400, 496, 497, 511, 512, 513, 600
+    };
+    static unsigned char msg[AEAD_MANY_NUM][AEAD_MANY_MAX];
+    static unsigned char ref[AEAD_MANY_NUM][AEAD_MANY_MAX];
+    static unsigned char ct[AEAD_MANY_NUM][AEAD_MANY_MAX];
+    unsigned char ivs[AEAD_MANY_NUM][16], reftag[AEAD_MANY_NUM][16];
+    unsigned char tags[AEAD_MANY_NUM][16], aadbuf[64];
+    const unsigned char *iv[AEAD_MANY_NUM], *aad[AEAD_MANY_NUM];
+    const unsigned char *in[AEAD_MANY_NUM], *cin[AEAD_MANY_NUM];
+    const unsigned char *ctag[AEAD_MANY_NUM];
+    unsigned char *out[AEAD_MANY_NUM], *tag[AEAD_MANY_NUM];
+    size_t aadlen[AEAD_MANY_NUM], inl[AEAD_MANY_NUM], i, j;
+    int ok[AEAD_MANY_NUM];
+    EVP_CIPHER *cipher = NULL;
+    EVP_CIPHER_CTX *ectx = NULL, *dctx = NULL;
+    int ivlen, taglen, pass, ret = 0;
+
+    for (j = 0; j < sizeof(aadbuf); j++)
+        aadbuf[j] = (unsigned char)(0xa0 + j);
+    for (i = 0; i < AEAD_MANY_NUM; i++) {
+        for (j = 0; j < lens[i]; j++)
+            msg[i][j] = (unsigned char)(i * 31 + j);
+        for (j = 0; j < sizeof(ivs[i]); j++)
+            ivs[i][j] = (unsigned char)(i + j * 7);
+        iv[i] = ivs[i];
+        aad[i] = aadbuf;
+        aadlen[i] = (i * 13) % (sizeof(aadbuf) + 1);
+        in[i] = msg[i];
+        inl[i] = lens[i];
+        out[i] = ct[i];
+        cin[i] = ct[i];
+        tag[i] = tags[i];
+        ctag[i] = tags[i];
+    }
+
+    if (!TEST_ptr(cipher = EVP_CIPHER_fetch(testctx, aead_oneshot_ciphers[idx],
+                                            testpropq))
+        || !TEST_ptr(ectx = EVP_CIPHER_CTX_new())
+        || !TEST_ptr(dctx = EVP_CIPHER_CTX_new())
+        || !TEST_true(EVP_EncryptInit_ex(ectx, cipher, NULL, key, NULL))
+        || !TEST_true(EVP_DecryptInit_ex(dctx, cipher, NULL, key, NULL))
+        || !TEST_int_gt(ivlen = EVP_CIPHER_CTX_get_iv_length(ectx), 0)
+        || !TEST_int_le(ivlen, (int)sizeof(ivs[0])))
+        goto err;
+    if ((taglen = EVP_CIPHER_CTX_get_tag_length(ectx)) <= 0)
+        taglen = sizeof(tags[0]);
+
+    /* Once with and once without AAD */
+    for (pass = 0; pass < 2; pass++) {
+        for (i = 0; i < AEAD_MANY_NUM; i++)
+            if (!aead_stream_seal(ectx, iv[i], aad[i], pass ? 0 : aadlen[i],
+                                  in[i], inl[i], ref[i], reftag[i], taglen))
+                goto err;
+
+        memset(ct, 0, sizeof(ct));
+        memset(tags, 0, sizeof(tags));
+        if (!TEST_true(EVP_CIPHER_CTX_aead_seal_many(ectx, AEAD_MANY_NUM,
+                                                     iv, ivlen,
+                                                     pass ? NULL : aad, aadlen,
+                                                     in, inl, out,
+                                                     tag, taglen)))
+            goto err;
+        for (i = 0; i < AEAD_MANY_NUM; i++)
+            if (!TEST_mem_eq(ct[i], inl[i], ref[i], inl[i])
+                || !TEST_mem_eq(tags[i], taglen, reftag[i], taglen)) {
+                TEST_info("packet %zu, %zu bytes", i, inl[i]);
+                goto err;
+            }
+
+        /* Decrypt in place, with one packet tampered with */
+        tags[5][0] ^= 1;
+        if (!TEST_false(EVP_CIPHER_CTX_aead_open_many(dctx, AEAD_MANY_NUM,
+                                                      iv, ivlen,
+                                                      pass ? NULL : aad,
+                                                      aadlen,
+                                                      cin, inl, out, ctag,
+                                                      taglen,
+                                                      ok)))
+            goto err;
+        for (i = 0; i < AEAD_MANY_NUM; i++) {
+            if (i == 5) {
+                if (!TEST_false(ok[i]))
+                    goto err;
+                for (j = 0; j < inl[i]; j++)
+                    if (!TEST_int_eq(ct[i][j], 0))
+                        goto err;
+            } else if (!TEST_true(ok[i])
+                       || !TEST_mem_eq(ct[i], inl[i], msg[i], inl[i])) {
+                TEST_info("packet %zu, %zu bytes", i, inl[i]);
+                goto err;
+            }
+        }
+    }
+
+    /* Nothing to do is fine */
+    if (!TEST_true(EVP_CIPHER_CTX_aead_seal_many(ectx, 0, iv, ivlen, NULL,
+                                                 NULL, in, inl, out,
+                                                 tag, taglen)))
+        goto err;
+
+    /* A missing IV or tag is an error */
+    iv[3] = NULL;
+    if (!TEST_false(EVP_CIPHER_CTX_aead_seal_many(ectx, AEAD_MANY_NUM,
+                                                  iv, ivlen, NULL, NULL,
+                                                  in, inl, out, tag, taglen)))
+        goto err;
+    iv[3] = ivs[3];
+    tag[4] = NULL;
+    ctag[4] = NULL;
+    if (!TEST_false(EVP_CIPHER_CTX_aead_seal_many(ectx, AEAD_MANY_NUM,
+                                                  iv, ivlen, NULL, NULL,
+                                                  in, inl, out, tag, taglen))
+        || !TEST_false(EVP_CIPHER_CTX_aead_open_many(dctx, AEAD_MANY_NUM,
+                                                     iv, ivlen, NULL, NULL,
+                                                     cin, inl, out, ctag,
+                                                     taglen, ok)))
+        goto err;
+    tag[4] = tags[4];
+    ctag[4] = tags[4];
+
+    /* ChaCha20-Poly1305 only takes the IV length its init functions take */
+    if (strcmp(aead_oneshot_ciphers[idx], "ChaCha20-Poly1305") == 0
+        && !TEST_false(EVP_CIPHER_CTX_aead_seal_many(ectx, AEAD_MANY_NUM,
+                                                     iv, ivlen - 1, NULL,
+                                                     NULL, in, inl, out,
+                                                     tag, taglen)))
+        goto err;
+
+    ret = 1;
+ err:
+    EVP_CIPHER_CTX_free(ectx);
+    EVP_CIPHER_CTX_free(dctx);
+    EVP_CIPHER_free(cipher);
+    return ret;
+}
+
+static const struct {
+    const char *xts;
+    const char *ecb;
+} xts_ciphers[] = {
+    { "AES-128-XTS", "AES-128-ECB" },
+    { "AES-256-XTS", "AES-256-ECB" }
+};
+
+/* One XTS block: |out| = E(|in| ^ |t|) ^ |t| */
+static int xts_ref_block(EVP_CIPHER_CTX *ecb, const unsigned char t[16],
+                         const unsigned char in[16], unsigned char out[16])
+{
+    unsigned char buf[16];
+    int i, outl;
+
+    for (i = 0; i < 16; i++)
+        buf[i] = in[i] ^ t[i];
+    if (!TEST_true(EVP_CipherUpdate(ecb, out, &outl, buf, sizeof(buf)))
+        || !TEST_int_eq(outl, 16))
+        return 0;
+    for (i = 0; i < 16; i++)
+        out[i] ^= t[i];
+    return 1;
+}
+
+/* Multiply the tweak by alpha */
+static void xts_ref_double(unsigned char t[16])
+{
+    int i, carry = t[15] >> 7;
+
+    for (i = 15; i > 0; i--)
+        t[i] = (unsigned char)(t[i] << 1 | t[i - 1] >> 7);
+    t[0] = (unsigned char)(t[0] << 1 ^ (carry ? 0x87 : 0));
+}
+
+/*
+ * XTS of one data unit as described in IEEE Std 1619, on top of the ECB
+ * contexts |ecb1|, keyed with the first key in the direction of |enc|, and
+ * |ecb2|, keyed with the second key for encryption.  It doesn't share any
+ * code with the XTS implementations of the providers.
+ */
+static int xts_ref_unit(EVP_CIPHER_CTX *ecb1, EVP_CIPHER_CTX *ecb2, int enc,
+                        const unsigned char iv[16], const unsigned char *in,
+                        unsigned char *out, size_t len)
+{
+    unsigned char t[16], t_next[16], cc[16], pp[16];
+    size_t full = len / 16, rem = len % 16, i;
+    int outl;
+
+    if (!TEST_true(EVP_CipherUpdate(ecb2, t, &outl, iv, 16)))
+        return 0;
+    /* With ciphertext stealing, the last full block is handled below */
+    if (rem != 0)
+        full--;
+    for (i = 0; i < full; i++, in += 16, out += 16) {
+        if (!xts_ref_block(ecb1, t, in, out))
+            return 0;
+        xts_ref_double(t);
+    }
+    if (rem == 0)
+        return 1;
+
+    memcpy(t_next, t, sizeof(t));
+    xts_ref_double(t_next);
+    if (enc) {
+        if (!xts_ref_block(ecb1, t, in, cc))
+            return 0;
+        memcpy(pp, in + 16, rem);
+        memcpy(pp + rem, cc + rem, 16 - rem);
+        memcpy(out + 16, cc, rem);
+        return xts_ref_block(ecb1, t_next, pp, out);
+    }
+    if (!xts_ref_block(ecb1, t_next, in, pp))
+        return 0;
+    memcpy(cc, in + 16, rem);
+    memcpy(cc + rem, pp + rem, 16 - rem);
+    memcpy(out + 16, pp, rem);
+    return xts_ref_block(ecb1, t, cc, out);
+}
+
+/*
+ * EVP_CIPHER_CTX_cipher_data_units() must agree with a reference
+ * implementation of XTS on top of ECB, for each data unit.  The data unit
+ * lengths straddle the number of blocks processed side by side and include
+ * ones that need ciphertext stealing, and the numbers straddle 2^64.  The
+ * IEEE Std 1619 vectors in evpciph_aes_common.txt cover the single data unit
+ * calls.
+ */
+#define XTS_UNITS_NUM   9
+#define XTS_UNITS_MAX   (XTS_UNITS_NUM * 4112)
+
+static int test_xts_data_units(int idx)
+{
+    static const size_t unit_lens[] = {
+        16, 48, 64, 80, 240, 256, 272, 512, 4096, 4112, 17, 100, 4100
+    };
+    static const uint64_t first_units[] = {
+        0, 0x123456789, (uint64_t)-5
+    };
+    static unsigned char msg[XTS_UNITS_MAX], ref[XTS_UNITS_MAX];
+    static unsigned char buf[XTS_UNITS_MAX];
+    unsigned char key[64], iv[16];
+    EVP_CIPHER *cipher = NULL, *ecb = NULL;
+    EVP_CIPHER_CTX *ectx = NULL, *dctx = NULL;
+    EVP_CIPHER_CTX *ecb1 = NULL, *ecb2 = NULL, *dcb1 = NULL;
+    size_t i, j, k, l, num, unit_len, inl, keylen;
+    uint64_t first, unit, hi;
+    int enc, ret = 0;
+
+    for (i = 0; i < sizeof(key); i++)
+        key[i] = (unsigned char)(i * 11 + 3);
+    for (i = 0; i < sizeof(msg); i++)
+        msg[i] = (unsigned char)(i * 7 + (i >> 8));
+
+    if (!TEST_ptr(cipher = EVP_CIPHER_fetch(testctx, xts_ciphers[idx].xts,
+                                            testpropq))
+        || !TEST_ptr(ecb = EVP_CIPHER_fetch(testctx, xts_ciphers[idx].ecb,
+                                            testpropq))
+        || !TEST_ptr(ectx = EVP_CIPHER_CTX_new())
+        || !TEST_ptr(dctx = EVP_CIPHER_CTX_new())
+        || !TEST_ptr(ecb1 = EVP_CIPHER_CTX_new())
+        || !TEST_ptr(ecb2 = EVP_CIPHER_CTX_new())
+        || !TEST_ptr(dcb1 = EVP_CIPHER_CTX_new())
+        || !TEST_true(EVP_EncryptInit_ex(ectx, cipher, NULL, key, NULL))
+        || !TEST_true(EVP_DecryptInit_ex(dctx, cipher, NULL, key, NULL)))
+        goto err;
+    keylen = EVP_CIPHER_get_key_length(ecb);
+    if (!TEST_true(EVP_EncryptInit_ex(ecb1, ecb, NULL, key, NULL))
+        || !TEST_true(EVP_DecryptInit_ex(dcb1, ecb, NULL, key, NULL))
+        || !TEST_true(EVP_EncryptInit_ex(ecb2, ecb, NULL, key + keylen, NULL))
+        || !TEST_true(EVP_CIPHER_CTX_set_padding(ecb1, 0))
+        || !TEST_true(EVP_CIPHER_CTX_set_padding(dcb1, 0))
+        || !TEST_true(EVP_CIPHER_CTX_set_padding(ecb2, 0)))
+        goto err;
+
+    for (i = 0; i < OSSL_NELEM(unit_lens); i++) {
+        unit_len = unit_lens[i];
+        for (j = 0; j < OSSL_NELEM(first_units); j++) {
+            first = first_units[j];
+            for (num = 0; num <= XTS_UNITS_NUM; num++) {
+                inl = num * unit_len;
+                for (enc = 1; enc >= 0; enc--) {
+                    for (unit = first, hi = 0, k = 0; k < num; k++) {
+                        for (l = 0; l < 8; l++) {
+                            iv[l] = (unsigned char)(unit >> (8 * l));
+                            iv[l + 8] = (unsigned char)(hi >> (8 * l));
+                        }
+                        if (!xts_ref_unit(enc ? ecb1 : dcb1, ecb2, enc, iv,
+                                          msg + k * unit_len,
+                                          ref + k * unit_len, unit_len))
+                            goto err;
+                        if (++unit == 0)
+                            hi++;
+                    }
+
+                    memset(buf, 0, sizeof(buf));
+                    if (!TEST_true(EVP_CIPHER_CTX_cipher_data_units(enc ? ectx
+                                                                        : dctx,
+                                                                    buf, msg,
+                                                                    inl,
+                                                                    unit_len,
+                                                                    first))
+                        || !TEST_mem_eq(buf, inl, ref, inl)) {
+                        TEST_info("%s %zu data units of %zu bytes from %llu",
+                                  enc ? "encrypting" : "decrypting", num,
+                                  unit_len, (unsigned long long)first);
+                        goto err;
+                    }
+                }
+
+                /* Round trip, in place */
+                memcpy(buf, msg, inl);
+                if (!TEST_true(EVP_CIPHER_CTX_cipher_data_units(ectx, buf, buf,
+                                                                inl, unit_len,
+                                                                first))
+                    || !TEST_true(EVP_CIPHER_CTX_cipher_data_units(dctx, buf,
+                                                                   buf, inl,
+                                                                   unit_len,
+                                                                   first))
+                    || !TEST_mem_eq(buf, inl, msg, inl))
+                    goto err;
+            }
+        }
+    }
+
+    /* The input must be whole data units */
+    if (!TEST_false(EVP_CIPHER_CTX_cipher_data_units(ectx, buf, msg, 1000, 512,
+                                                     0)))
+        goto err;
+
+    ret = 1;
+ err:
+    EVP_CIPHER_CTX_free(ectx);
+    EVP_CIPHER_CTX_free(dctx);
+    EVP_CIPHER_CTX_free(ecb1);
+    EVP_CIPHER_CTX_free(ecb2);
+    EVP_CIPHER_CTX_free(dcb1);
+    EVP_CIPHER_free(cipher);
+    EVP_CIPHER_free(ecb);
+    return ret;
+}
+
+static const char *digest_many_mds[] = {
+    "SHA1", "SHA224", "SHA256", "SHA512", "SHA3-224", "SHA3-256", "SHA3-512",
+    "SHAKE128", "SHAKE256"
+};
+
+/*
+ * EVP_Digest_many() must match EVP_Digest() on every message, including the
+ * lengths around the padding boundaries and messages of very different
+ * lengths sharing a batch.
+ */
+static int test_digest_many(int idx)
+{
+    static const size_t lens[] = {
+        0, 1, 55, 56, 63, 64, 65, 119, 120, 127, 128, 129, 200, 1000, 4096,
+        5000, 3, 64 * 17, 64 * 17 + 56, 2, 700, 0, 71, 72, 135, 136, 137,
+        167, 168, 144 * 3, 136 * 5 + 1
+    };
+    const unsigned char *data[OSSL_NELEM(lens)];
+    unsigned char *buf = NULL, *md = NULL;
+    unsigned char ref[EVP_MAX_MD_SIZE];
+    unsigned int reflen;
+    EVP_MD *type = NULL;
+    size_t i, num = OSSL_NELEM(lens), mdlen;
+    int ret = 0;
+
+    if (!TEST_ptr(type = EVP_MD_fetch(testctx, digest_many_mds[idx],
+                                      testpropq))
+        || !TEST_ptr(buf = OPENSSL_malloc(5000 + num)))
+        goto err;
+    mdlen = EVP_MD_get_size(type);
+    if (!TEST_ptr(md = OPENSSL_malloc(num * mdlen)))
+        goto err;
+    for (i = 0; i < 5000 + num; i++)
+        buf[i] = (unsigned char)(i * 7 + (i >> 8));
+    /* Empty messages are passed without any data */
+    for (i = 0; i < num; i++)
+        data[i] = lens[i] == 0 ? NULL : buf + i;
+
+    /* All at once, then a single message */
+    if (!TEST_true(EVP_Digest_many(data, lens, num, md, num * mdlen, type)))
+        goto err;
+    for (i = 0; i < num; i++) {
+        if (!TEST_true(EVP_Digest(data[i], lens[i], ref, &reflen, type, NULL))
+            || !TEST_mem_eq(md + i * mdlen, mdlen, ref, reflen)) {
+            TEST_info("message %zu of length %zu", i, lens[i]);
+            goto err;
+        }
+    }
+    memset(md, 0, mdlen);
+    if (!TEST_true(EVP_Digest_many(data + 1, lens + 1, 1, md, mdlen, type))
+        || !TEST_true(EVP_Digest(data[1], lens[1], ref, &reflen, type, NULL))
+        || !TEST_mem_eq(md, mdlen, ref, reflen))
+        goto err;
+
+    /* Nothing to do, or too little room for the digests */
+    if (!TEST_true(EVP_Digest_many(data, lens, 0, md, 0, type))
+        || !TEST_false(EVP_Digest_many(data, lens, num, md,
+                                       num * mdlen - 1, type)))
+        goto err;
+
+    ret = 1;
+ err:
+    OPENSSL_free(buf);
+    OPENSSL_free(md);
+    EVP_MD_free(type);
+    return ret;
+}
+
+#ifndef OPENSSL_NO_BLAKE3
+/*
+ * BLAKE3 hashed on several threads must give the same output as on one,
+ * whichever way the input is split over the updates.
+ */
+static int test_blake3_threads(void)
+{
+    static const unsigned int threads[] = { 1, 4, 3 };
+    static const size_t first[] = { 0, 0, 7 };
+    const size_t len = 3 * 1024 * 1024 + 1234;
+    unsigned char *buf = NULL;
+    unsigned char md[3][64];
+    EVP_MD_CTX *ctx = NULL;
+    EVP_MD *type = NULL;
+    OSSL_PARAM params[2];
+    unsigned int th;
+    size_t i;
+    int ret = 0;
+
+    if (!TEST_ptr(type = EVP_MD_fetch(testctx, "BLAKE3", testpropq))
+        || !TEST_ptr(ctx = EVP_MD_CTX_new())
+        || !TEST_ptr(buf = OPENSSL_malloc(len)))
+        goto err;
+    for (i = 0; i < len; i++)
+        buf[i] = (unsigned char)(i * 7 + (i >> 8));
+
+    for (i = 0; i < OSSL_NELEM(threads); i++) {
+        th = threads[i];
+        params[0] = OSSL_PARAM_construct_uint(OSSL_DIGEST_PARAM_THREADS, &th);
+        params[1] = OSSL_PARAM_construct_end();
+        if (!TEST_true(EVP_DigestInit_ex2(ctx, type, params))
+            || !TEST_true(EVP_DigestUpdate(ctx, buf, first[i]))
+            || !TEST_true(EVP_DigestUpdate(ctx, buf + first[i],
+                                           len - first[i]))
+            || !TEST_true(EVP_DigestFinalXOF(ctx, md[i], sizeof(md[i]))))
+            goto err;
+    }
+    if (!TEST_mem_eq(md[0], sizeof(md[0]), md[1], sizeof(md[1]))
+        || !TEST_mem_eq(md[0], sizeof(md[0]), md[2], sizeof(md[2])))
+        goto err;
+
+    ret = 1;
+ err:
+    OPENSSL_free(buf);
+    EVP_MD_CTX_free(ctx);
+    EVP_MD_free(type);
+    return ret;
+}
+#endif
+
 typedef enum OPTION_choice {
     OPT_ERR = -1,
     OPT_EOF = 0,
@@ -3467,10 +4433,16 @@ int setup_tests(void)
     ADD_TEST(test_EC_priv_pub);
 # ifndef OPENSSL_NO_DEPRECATED_3_0
     ADD_TEST(test_EC_priv_only_legacy);
+    ADD_TEST(test_EC_legacy_key_change);
 # endif
+#endif
+#ifndef OPENSSL_NO_DEPRECATED_3_0
+    ADD_TEST(test_RSA_legacy_key_change);
+    ADD_TEST(test_RSA_legacy_key_change_in_use);
 #endif
     ADD_ALL_TESTS(test_keygen_with_empty_template, 2);
     ADD_ALL_TESTS(test_pkey_ctx_fail_without_provider, 2);
+    ADD_TEST(test_decoder_cache_provider_change);
 
     ADD_TEST(test_rand_agglomeration);
     ADD_ALL_TESTS(test_evp_iv_aes, 12);
@@ -3487,6 +4459,15 @@ int setup_tests(void)
     ADD_ALL_TESTS(test_evp_init_seq, OSSL_NELEM(evp_init_tests));
     ADD_ALL_TESTS(test_evp_reset, OSSL_NELEM(evp_reset_tests));
     ADD_ALL_TESTS(test_gcm_reinit, OSSL_NELEM(gcm_reinit_tests));
+    ADD_ALL_TESTS(test_aead_seal_open, OSSL_NELEM(aead_oneshot_ciphers));
+    ADD_ALL_TESTS(test_aead_seal_open_lengths,
+                  OSSL_NELEM(aead_oneshot_ciphers));
+    ADD_ALL_TESTS(test_aead_seal_open_many, OSSL_NELEM(aead_oneshot_ciphers));
+    ADD_ALL_TESTS(test_xts_data_units, OSSL_NELEM(xts_ciphers));
+    ADD_ALL_TESTS(test_digest_many, OSSL_NELEM(digest_many_mds));
+#ifndef OPENSSL_NO_BLAKE3
+    ADD_TEST(test_blake3_threads);
+#endif
 
     return 1;
 }
@@ -16,8 +16,10 @@
 #include <openssl/bn.h>
 #include <openssl/core.h>
 #include <openssl/params.h>
+#include <openssl/core_names.h>
 #include "internal/numbers.h"
 #include "internal/nelem.h"
+#include "internal/param_names.h"
 #include "testutil.h"
 
 /*-
@@ -617,9 +619,35 @@ static int test_allocate_from_text(int i)
     return check_int_from_text(int_from_text_test_cases[i]);
 }
 
+static const struct {
+    const char *name;
+    int pidx;
+} pidx_test_cases[] = {
+    { OSSL_CIPHER_PARAM_AEAD_TAG,       PIDX_CIPHER_PARAM_AEAD_TAG },
+    { OSSL_CIPHER_PARAM_AEAD_TAGLEN,    PIDX_CIPHER_PARAM_AEAD_TAGLEN },
+    { OSSL_CIPHER_PARAM_IVLEN,          PIDX_CIPHER_PARAM_IVLEN },
+    /* An alias shares the index of the name it refers to */
+    { OSSL_CIPHER_PARAM_AEAD_IVLEN,     PIDX_CIPHER_PARAM_IVLEN },
+    { OSSL_KDF_PARAM_DIGEST,            PIDX_ALG_PARAM_DIGEST },
+    { OSSL_PKEY_PARAM_RSA_N,            PIDX_PKEY_PARAM_RSA_N },
+    /* Prefixes, extensions and case variants of known names are unknown */
+    { "ta",                             -1 },
+    { "tagg",                           -1 },
+    { "TAG",                            -1 },
+    { "",                               -1 },
+    { "no-such-parameter",              -1 },
+};
+
+static int test_param_find_pidx(int i)
+{
+    return TEST_int_eq(ossl_param_find_pidx(pidx_test_cases[i].name),
+                       pidx_test_cases[i].pidx);
+}
+
 int setup_tests(void)
 {
     ADD_ALL_TESTS(test_case, OSSL_NELEM(test_cases));
     ADD_ALL_TESTS(test_allocate_from_text, OSSL_NELEM(int_from_text_test_cases));
+    ADD_ALL_TESTS(test_param_find_pidx, OSSL_NELEM(pidx_test_cases));
     return 1;
 }
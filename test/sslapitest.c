@@ -33,6 +33,7 @@
 #include <openssl/param_build.h>
 #include <openssl/x509v3.h>
 #include <openssl/dh.h>
+#include <openssl/async.h>
 
 #include "helpers/ssltestlib.h"
 #include "testutil.h"
@@ -41,6 +42,7 @@
 #include "internal/ktls.h"
 #include "../ssl/ssl_local.h"
 #include "filterprov.h"
+#include "threadstest.h"
 
 #undef OSSL_NO_USABLE_TLS1_3
 #if defined(OPENSSL_NO_TLS1_3) \
@@ -2464,6 +2466,97 @@ static int test_psk_tickets(void)
     return testresult;
 }
 
+#define TICKET_KEY_ROTATIONS     200
+#define TICKET_KEY_HANDSHAKES    20
+
+static SSL_CTX *rotate_sctx = NULL;
+static int rotate_ok;
+
+static void rotate_ticket_keys(void)
+{
+    unsigned char keys[80];
+    long keylen = SSL_CTX_set_tlsext_ticket_keys(rotate_sctx, NULL, 0);
+    int i;
+
+    rotate_ok = TEST_long_gt(keylen, 0)
+                && TEST_long_le(keylen, (long)sizeof(keys));
+    for (i = 0; rotate_ok && i < TICKET_KEY_ROTATIONS; i++) {
+        memset(keys, i, sizeof(keys));
+        rotate_ok = TEST_true(SSL_CTX_set_tlsext_ticket_keys(rotate_sctx, keys,
+                                                             keylen));
+    }
+}
+
+/*
+ * Replace the default ticket keys from another thread while handshakes
+ * issue and accept tickets.  The keyed HMAC context that tickets copy must
+ * not go away underneath them.  A resumption may fail when the keys have
+ * changed in the meantime, but the handshake must still succeed.
+ * Test 0: TLSv1.2
+ * Test 1: TLSv1.3
+ */
+static int test_ticket_key_rotation(int idx)
+{
+    SSL_CTX *cctx = NULL;
+    SSL *serverssl = NULL, *clientssl = NULL;
+    SSL_SESSION *sess = NULL;
+    thread_t rotator;
+    int started = 0, testresult = 0, i;
+
+#ifdef OPENSSL_NO_TLS1_2
+    if (idx == 0)
+        return TEST_skip("No TLSv1.2 available");
+#endif
+#ifdef OSSL_NO_USABLE_TLS1_3
+    if (idx == 1)
+        return TEST_skip("No usable TLSv1.3 available");
+#endif
+
+    if (!TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                       TLS_client_method(), TLS1_VERSION,
+                                       idx == 0 ? TLS1_2_VERSION
+                                                : TLS1_3_VERSION,
+                                       &rotate_sctx, &cctx, cert, privkey)))
+        goto end;
+
+    if (!TEST_true(run_thread(&rotator, rotate_ticket_keys)))
+        goto end;
+    started = 1;
+
+    for (i = 0; i < TICKET_KEY_HANDSHAKES; i++) {
+        if (!TEST_true(create_ssl_objects(rotate_sctx, cctx, &serverssl,
+                                          &clientssl, NULL, NULL))
+                || (sess != NULL
+                    && !TEST_true(SSL_set_session(clientssl, sess)))
+                || !TEST_true(create_ssl_connection(serverssl, clientssl,
+                                                    SSL_ERROR_NONE)))
+            goto end;
+        SSL_SESSION_free(sess);
+        if (!TEST_ptr(sess = SSL_get1_session(clientssl)))
+            goto end;
+        SSL_shutdown(clientssl);
+        SSL_shutdown(serverssl);
+        SSL_free(serverssl);
+        SSL_free(clientssl);
+        serverssl = clientssl = NULL;
+    }
+
+    testresult = 1;
+ end:
+    if (started && !TEST_true(wait_for_thread(rotator)))
+        testresult = 0;
+    if (started && !rotate_ok)
+        testresult = 0;
+    SSL_SESSION_free(sess);
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(rotate_sctx);
+    SSL_CTX_free(cctx);
+    rotate_sctx = NULL;
+
+    return testresult;
+}
+
 static int test_extra_tickets(int idx)
 {
     SSL_CTX *sctx = NULL, *cctx = NULL;
@@ -9185,6 +9278,115 @@ static int test_inherit_verify_param(void)
     return testresult;
 }
 
+static ASYNC_callback_fn async_queue_cb;
+static void *async_queue_cbarg;
+static int async_queue_pauses;
+static int async_queue_ssl_cb_calls;
+
+/* Pause the handshake job the way an engine supporting callbacks would */
+static int async_queue_pause(void)
+{
+    ASYNC_JOB *job = ASYNC_get_current_job();
+    ASYNC_WAIT_CTX *waitctx;
+
+    if (job == NULL || (waitctx = ASYNC_get_wait_ctx(job)) == NULL
+            || !ASYNC_WAIT_CTX_get_callback(waitctx, &async_queue_cb,
+                                            &async_queue_cbarg))
+        return 0;
+    async_queue_pauses++;
+    ASYNC_WAIT_CTX_set_status(waitctx, ASYNC_STATUS_OK);
+    return ASYNC_pause_job();
+}
+
+static int async_queue_client_hello_cb(SSL *s, int *al, void *arg)
+{
+    return async_queue_pauses == 0 && !async_queue_pause()
+           ? SSL_CLIENT_HELLO_ERROR : SSL_CLIENT_HELLO_SUCCESS;
+}
+
+static int async_queue_cert_cb(SSL *s, void *arg)
+{
+    return async_queue_pauses != 1 || async_queue_pause();
+}
+
+static int async_queue_ssl_cb(SSL *s, void *arg)
+{
+    async_queue_ssl_cb_calls++;
+    return 1;
+}
+
+/*
+ * Test that a paused SSL_MODE_ASYNC handshake pushes its SSL object onto the
+ * completion queue, and that removing the queue again restores the async
+ * callback.
+ */
+static int test_async_queue(void)
+{
+    SSL_CTX *cctx = NULL, *sctx = NULL;
+    SSL *clientssl = NULL, *serverssl = NULL;
+    ASYNC_QUEUE *queue = NULL;
+    void *items[2];
+    int testresult = 0;
+
+    if (!ASYNC_is_capable())
+        return TEST_skip("Async jobs are not supported");
+
+    async_queue_pauses = async_queue_ssl_cb_calls = 0;
+    if (!TEST_ptr(queue = ASYNC_QUEUE_new())
+            || !TEST_true(create_ssl_ctx_pair(libctx, TLS_server_method(),
+                                              TLS_client_method(), 0, 0,
+                                              &sctx, &cctx, cert, privkey)))
+        goto end;
+
+    SSL_CTX_set_mode(sctx, SSL_MODE_ASYNC);
+    SSL_CTX_set_client_hello_cb(sctx, async_queue_client_hello_cb, NULL);
+    SSL_CTX_set_cert_cb(sctx, async_queue_cert_cb, NULL);
+    if (!TEST_true(SSL_CTX_set_async_callback(sctx, async_queue_ssl_cb))
+            || !TEST_true(SSL_CTX_set_async_queue(sctx, queue))
+            || !TEST_true(create_ssl_objects(sctx, cctx, &serverssl,
+                                             &clientssl, NULL, NULL)))
+        goto end;
+
+    /* The first pause completes through the queue */
+    if (!TEST_int_le(SSL_connect(clientssl), 0)
+            || !TEST_int_le(SSL_accept(serverssl), 0)
+            || !TEST_int_eq(SSL_get_error(serverssl, -1),
+                            SSL_ERROR_WANT_ASYNC)
+            || !TEST_int_eq(async_queue_pauses, 1)
+            || !TEST_size_t_eq(ASYNC_QUEUE_drain(queue, items, 2), 0)
+            || !TEST_true(async_queue_cb(async_queue_cbarg))
+            || !TEST_size_t_eq(ASYNC_QUEUE_drain(queue, items, 2), 1)
+            || !TEST_ptr_eq(items[0], serverssl)
+            || !TEST_int_eq(async_queue_ssl_cb_calls, 0))
+        goto end;
+
+    /* Once the queue is removed the second pause calls the async callback */
+    if (!TEST_true(SSL_set_async_queue(serverssl, NULL))
+            || !TEST_int_le(SSL_accept(serverssl), 0)
+            || !TEST_int_eq(SSL_get_error(serverssl, -1),
+                            SSL_ERROR_WANT_ASYNC)
+            || !TEST_int_eq(async_queue_pauses, 2)
+            || !TEST_true(async_queue_cb(async_queue_cbarg))
+            || !TEST_int_eq(async_queue_ssl_cb_calls, 1)
+            || !TEST_size_t_eq(ASYNC_QUEUE_drain(queue, items, 2), 0))
+        goto end;
+
+    if (!TEST_true(create_ssl_connection(serverssl, clientssl,
+                                         SSL_ERROR_NONE)))
+        goto end;
+
+    testresult = 1;
+
+ end:
+    SSL_free(serverssl);
+    SSL_free(clientssl);
+    SSL_CTX_free(sctx);
+    SSL_CTX_free(cctx);
+    ASYNC_QUEUE_free(queue);
+
+    return testresult;
+}
+
 OPT_TEST_DECLARE_USAGE("certfile privkeyfile srpvfile tmpfile provider config\n")
 
 int setup_tests(void)
@@ -9331,6 +9533,7 @@ int setup_tests(void)
     ADD_TEST(test_psk_tickets);
     ADD_ALL_TESTS(test_extra_tickets, 6);
 #endif
+    ADD_ALL_TESTS(test_ticket_key_rotation, 2);
     ADD_ALL_TESTS(test_ssl_set_bio, TOTAL_SSL_SET_BIO_TESTS);
     ADD_TEST(test_ssl_bio_pop_next_bio);
     ADD_TEST(test_ssl_bio_pop_ssl_bio);
@@ -9442,6 +9645,7 @@ int setup_tests(void)
     ADD_TEST(test_inherit_verify_param);
     ADD_TEST(test_set_alpn);
     ADD_ALL_TESTS(test_session_timeout, 1);
+    ADD_TEST(test_async_queue);
     return 1;
 
  err:
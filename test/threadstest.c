@@ -19,6 +19,7 @@
 #include <openssl/rsa.h>
 #include <openssl/aes.h>
 #include <openssl/rsa.h>
+#include <openssl/x509.h>
 #include "testutil.h"
 #include "threadstest.h"
 
@@ -349,6 +350,19 @@ static void thread_downgrade_shared_evp_pkey(void)
 #endif
 }
 
+static X509_PUBKEY *shared_x509_pubkey = NULL;
+
+static void thread_shared_x509_pubkey(void)
+{
+    EVP_PKEY *pkey = X509_PUBKEY_get0(shared_x509_pubkey);
+
+    /* The key is decoded on first use, which may happen in any thread */
+    if (!TEST_ptr(pkey)
+            || !TEST_int_eq(EVP_PKEY_eq(pkey, shared_evp_pkey), 1)
+            || !TEST_ptr_eq(X509_PUBKEY_get0(shared_x509_pubkey), pkey))
+        multi_success = 0;
+}
+
 static void thread_provider_load_unload(void)
 {
     OSSL_PROVIDER *deflt = OSSL_PROVIDER_load(multi_libctx, "default");
@@ -368,6 +382,7 @@ static void thread_provider_load_unload(void)
  * Test 3: Worker downgrading a shared EVP_PKEY
  * Test 4: Worker using a shared EVP_PKEY
  * Test 5: Worker loading and unloading a provider
+ * Test 6: Worker decoding a shared X509_PUBKEY
  */
 static int test_multi(int idx)
 {
@@ -377,6 +392,9 @@ static int test_multi(int idx)
     void (*worker)(void) = NULL;
     void (*worker2)(void) = NULL;
     EVP_MD *sha256 = NULL;
+    unsigned char *der = NULL;
+    const unsigned char *p;
+    int derlen;
 
     if (idx == 1 && !do_fips)
         return TEST_skip("FIPS not supported");
@@ -429,6 +447,17 @@ static int test_multi(int idx)
         prov = NULL;
         worker = thread_provider_load_unload;
         break;
+    case 6:
+        if (!TEST_ptr(shared_evp_pkey = load_pkey_pem(privkey, multi_libctx))
+                || !TEST_int_gt(derlen = i2d_PUBKEY(shared_evp_pkey, &der), 0)
+                || !TEST_ptr(shared_x509_pubkey =
+                             X509_PUBKEY_new_ex(multi_libctx, NULL)))
+            goto err;
+        p = der;
+        if (!TEST_ptr(d2i_X509_PUBKEY(&shared_x509_pubkey, &p, derlen)))
+            goto err;
+        worker = thread_shared_x509_pubkey;
+        break;
     default:
         TEST_error("Invalid test index");
         goto err;
@@ -457,6 +486,9 @@ static int test_multi(int idx)
     EVP_MD_free(sha256);
     OSSL_PROVIDER_unload(prov);
     OSSL_PROVIDER_unload(prov2);
+    X509_PUBKEY_free(shared_x509_pubkey);
+    shared_x509_pubkey = NULL;
+    OPENSSL_free(der);
     OSSL_LIB_CTX_free(multi_libctx);
     EVP_PKEY_free(shared_evp_pkey);
     shared_evp_pkey = NULL;
@@ -589,7 +621,7 @@ int setup_tests(void)
     ADD_TEST(test_thread_local);
     ADD_TEST(test_atomic);
     ADD_TEST(test_multi_load);
-    ADD_ALL_TESTS(test_multi, 6);
+    ADD_ALL_TESTS(test_multi, 7);
     return 1;
 }
 
@@ -1,5 +1,5 @@
 /*
- * Copyright 2016-2018 The OpenSSL Project Authors. All Rights Reserved.
+ * Copyright 2016-2021 The OpenSSL Project Authors. All Rights Reserved.
  *
  * Licensed under the Apache License 2.0 (the "License").  You may not use
  * this file except in compliance with the License.  You can obtain a copy
@@ -16,6 +16,7 @@
 #include <openssl/x509v3.h>
 #include "testutil.h"
 #include "internal/nelem.h"
+#include "crypto/x509.h"
 
 /**********************************************************************
  *
@@ -48,8 +49,96 @@ static int test_standard_exts(void)
     return good;
 }
 
+/**********************************************************************
+ *
+ * Test of the X509_NAME canonical encoding
+ *
+ ***/
+
+static X509_NAME *make_name(const char *cn, const char *ou, const char *o,
+                            int ou_first)
+{
+    X509_NAME *nm = X509_NAME_new();
+    const char *first = ou_first ? "OU" : "O";
+    const char *second = ou_first ? "O" : "OU";
+
+    /* A multi-valued RDN is added in different orders */
+    if (!TEST_ptr(nm)
+            || !TEST_true(X509_NAME_add_entry_by_txt(nm, "CN", MBSTRING_UTF8,
+                                                     (unsigned char *)cn,
+                                                     -1, -1, 0))
+            || !TEST_true(X509_NAME_add_entry_by_txt(nm, first, MBSTRING_UTF8,
+                                                     (unsigned char *)
+                                                     (ou_first ? ou : o),
+                                                     -1, -1, 0))
+            || !TEST_true(X509_NAME_add_entry_by_txt(nm, second, MBSTRING_UTF8,
+                                                     (unsigned char *)
+                                                     (ou_first ? o : ou),
+                                                     -1, -1, -1))) {
+        X509_NAME_free(nm);
+        return NULL;
+    }
+    return nm;
+}
+
+static int test_name_canon(void)
+{
+    X509_NAME *a = NULL, *b = NULL, *c = NULL;
+    OSSL_LIB_CTX *libctx = NULL;
+    unsigned long ha, hb, hfetched, hpropq;
+    int ok = 0, ok_a, ok_b, ok_fetched, ok_propq;
+
+    if (!TEST_ptr(a = make_name("Foo  Bar", " Unit", "\xc3\x84" "cme", 1))
+            || !TEST_ptr(b = make_name("foo bar ", "UNIT", "\xc3\x84" "CME", 0))
+            || !TEST_ptr(c = make_name("foo bar", "unit", "acme", 0))
+            || !TEST_ptr(libctx = OSSL_LIB_CTX_new()))
+        goto err;
+
+    if (!TEST_int_eq(X509_NAME_cmp(a, b), 0)
+            || !TEST_true(ossl_x509_name_eq(a, b))
+            || !TEST_int_ne(X509_NAME_cmp(a, c), 0)
+            || !TEST_false(ossl_x509_name_eq(a, c))
+            || !TEST_false(ossl_x509_name_eq(a, NULL)))
+        goto err;
+
+    /* The cached hash must match the one from a fetched SHA1 */
+    ha = X509_NAME_hash_ex(a, NULL, NULL, &ok_a);
+    hb = X509_NAME_hash_ex(b, NULL, NULL, &ok_b);
+    hfetched = X509_NAME_hash_ex(a, libctx, NULL, &ok_fetched);
+    hpropq = X509_NAME_hash_ex(b, NULL, "provider=default", &ok_propq);
+    if (!TEST_true(ok_a) || !TEST_true(ok_b) || !TEST_true(ok_fetched)
+            || !TEST_true(ok_propq)
+            || !TEST_ulong_eq(ha, hb)
+            || !TEST_ulong_eq(ha, hfetched)
+            || !TEST_ulong_eq(ha, hpropq))
+        goto err;
+
+    /* A hash fetched from a provider that does not offer SHA1 fails */
+    if (!TEST_ulong_eq(X509_NAME_hash_ex(c, NULL, "provider=nonexistent",
+                                         &ok_propq), 0)
+            || !TEST_false(ok_propq))
+        goto err;
+
+    /* A modified name must be re-canonicalized */
+    if (!TEST_true(X509_NAME_add_entry_by_txt(b, "C", MBSTRING_ASC,
+                                              (unsigned char *)"DE",
+                                              -1, -1, 0))
+            || !TEST_false(ossl_x509_name_eq(a, b))
+            || !TEST_ulong_ne(X509_NAME_hash_ex(b, NULL, NULL, NULL), ha))
+        goto err;
+
+    ok = 1;
+ err:
+    X509_NAME_free(a);
+    X509_NAME_free(b);
+    X509_NAME_free(c);
+    OSSL_LIB_CTX_free(libctx);
+    return ok;
+}
+
 int setup_tests(void)
 {
     ADD_TEST(test_standard_exts);
+    ADD_TEST(test_name_canon);
     return 1;
 }
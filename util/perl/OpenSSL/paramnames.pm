@@ -0,0 +1,139 @@
+#! /usr/bin/env perl
+# Copyright 2021 The OpenSSL Project Authors. All Rights Reserved.
+#
+# Licensed under the Apache License 2.0 (the "License").  You may not use
+# this file except in compliance with the License.  You can obtain a copy
+# in the file LICENSE in the source distribution or at
+# https://www.openssl.org/source/license.html
+
+package OpenSSL::paramnames;
+
+use strict;
+use warnings;
+
+use Carp;
+
+require Exporter;
+our @ISA = qw(Exporter);
+our @EXPORT_OK = qw(produce_pidx_defines produce_pidx_decoder);
+
+# Parameter names and their string values, read from core_names.h
+my %params;
+
+sub read_core_names {
+    my $file = shift;
+    my %macros;
+    my $text;
+
+    return if %params;
+
+    open my $fh, '<', $file or croak "Can't open $file: $!";
+    {
+        local $/;
+        $text = <$fh>;
+    }
+    close $fh;
+
+    # Join continuation lines and drop comments
+    $text =~ s|\\\n||g;
+    $text =~ s|/\*.*?\*/||gs;
+
+    foreach (split /\n/, $text) {
+        next unless m|^\s*#\s*define\s+OSSL_(\w+)\s+(.*?)\s*$|;
+        $macros{$1} = $2;
+    }
+
+    # Only parameter names are of interest, resolving aliases of the form
+    # #define OSSL_FOO_PARAM_BAR OSSL_ALG_PARAM_BAR
+    foreach my $name (keys %macros) {
+        next unless $name =~ m|_PARAM_|;
+
+        my $value = $macros{$name};
+        my $depth = 0;
+
+        while ($value =~ m|^OSSL_(\w+)$| && defined $macros{$1}) {
+            croak "Alias loop for OSSL_$name" if ++$depth > 10;
+            $value = $macros{$1};
+        }
+        $params{$name} = $1 if $value =~ m|^"([^"]*)"$|;
+    }
+}
+
+# The index of every distinct parameter string, in sorted order
+sub pidx_of_strings {
+    my %strings = map { $_ => 1 } values %params;
+    my $i = 0;
+
+    return map { $_ => $i++ } sort keys %strings;
+}
+
+# Produce the PIDX_ macros, one per parameter name, with aliases and names
+# that share a string getting the same index.
+sub produce_pidx_defines {
+    my $file = shift;
+
+    read_core_names($file);
+
+    my %pidx = pidx_of_strings();
+    my $out = '';
+
+    foreach my $name (sort keys %params) {
+        $out .= sprintf("#define %-47s %d\n", "PIDX_$name",
+                        $pidx{$params{$name}});
+    }
+    $out .= sprintf("#define %-47s %d\n", "PIDX_NUM", scalar keys %pidx);
+    return $out;
+}
+
+sub trie {
+    my ($indent, $depth, $pidx, @strings) = @_;
+    my $sp = ' ' x $indent;
+    my $out = '';
+
+    if (scalar @strings == 1) {
+        my $s = $strings[0];
+        my $rest = substr($s, $depth);
+
+        if ($rest eq '') {
+            return "${sp}if (s[$depth] == '\\0')\n"
+                . "${sp}    return $pidx->{$s};\n";
+        }
+        return "${sp}if (strcmp(\"$rest\", s + $depth) == 0)\n"
+            . "${sp}    return $pidx->{$s};\n";
+    }
+
+    my %byc;
+    push @{$byc{length($_) > $depth ? substr($_, $depth, 1) : ''}}, $_
+        foreach @strings;
+
+    $out .= "${sp}switch (s[$depth]) {\n";
+    $out .= "${sp}default:\n${sp}    break;\n";
+    foreach my $c (sort keys %byc) {
+        if ($c eq '') {
+            $out .= "${sp}case '\\0':\n";
+            $out .= "${sp}    return $pidx->{$byc{$c}->[0]};\n";
+            next;
+        }
+        (my $cc = $c) =~ s|(['\\])|\\$1|;
+        $out .= "${sp}case '$cc':\n";
+        $out .= trie($indent + 4, $depth + 1, $pidx, @{$byc{$c}});
+        $out .= "${sp}    break;\n";
+    }
+    $out .= "${sp}}\n";
+    return $out;
+}
+
+# Produce the body of a function that maps a parameter name in |s| to its
+# PIDX_ index, or -1 if it is unknown.  Characters are switched on one at
+# a time until only one candidate is left, which is then compared whole.
+sub produce_pidx_decoder {
+    my $file = shift;
+
+    read_core_names($file);
+
+    my %pidx = pidx_of_strings();
+
+    return trie(4, 0, \%pidx, sort keys %pidx) . "    return -1;\n";
+}
+
+1;